@@ -52,6 +52,10 @@ extern const int NUM_COLLECTIVES;
 typedef enum {
   CONTEXT_CLI,
   CONTEXT_TUNED,
+  CONTEXT_STATIC,
+  CONTEXT_ONLINE,
+  CONTEXT_MODEL,
+  CONTEXT_DTREE,
   CONTEXT_INFO
 } pgmpi_context_t;
 
@@ -65,6 +69,14 @@ typedef struct {
   alg_choice_t *alg;
 } module_alg_choices_t;
 
+/*
+ * memory a mock-up takes from the buffer manager for a call
+ */
+typedef struct {
+  size_t msg_bytes;   /* both message buffers together */
+  size_t int_bytes;   /* both int buffers together */
+} pgmpi_buf_req_t;
+
 typedef struct {
   char *cli_prefix;
   char *mpiname;
@@ -73,9 +85,29 @@ typedef struct {
   void (*parse)(const char *argv);
   void (*set_algid)(const int algid);
   module_alg_choices_t *alg_choices;
+  void (*get_buf_req)(const int algid, const MPI_Count msg_size, MPI_Datatype datatype, const int comm_size,
+      pgmpi_buf_req_t *req);   /* msg_size as passed to pgtune_get_algorithm */
 } module_t;
 
-int pgtune_get_algorithm(pgmpi_collectives_t cid, int msg_size, int comm_size, int *alg_id);
+/* returned by pgtune_get_algorithm if the call has to be timed and reported */
+#define PGMPI_ALG_MEASURE 1
+
+/**
+ * selects the algorithm for a collective call
+ * @param datatype datatype of the call, used to match datatype qualifiers of profiles
+ * @param op reduction operation of the call, MPI_OP_NULL for non-reducing collectives
+ * @return PGMPI_ALG_MEASURE if the caller has to time the call and pass the time to pgtune_report_time
+ */
+int pgtune_get_algorithm(pgmpi_collectives_t cid, MPI_Count msg_size, MPI_Datatype datatype, MPI_Op op, MPI_Comm comm,
+    int *alg_id);
+
+/**
+ * reports the local run-time of a call for which pgtune_get_algorithm returned PGMPI_ALG_MEASURE
+ * must be called by all processes of comm
+ * @param alg_id algorithm that was used for the call
+ * @param time run-time in seconds
+ */
+void pgtune_report_time(pgmpi_collectives_t cid, MPI_Count msg_size, MPI_Comm comm, int alg_id, double time);
 
 void init_pgtune_lib(int *argc, char ***argv);
 
@@ -90,6 +122,29 @@ int get_pgmpi_context();
  */
 void pgtune_override_argv_parameter(int argc, char **argv);
 
+/**
+ * arrival skew of a collective on a communicator (see --skew_interval), times in seconds
+ * the skew of a call is the time between the first and the last process entering it
+ */
+typedef struct {
+  int n_samples;
+  double last;
+  double mean;
+  double max;
+  double estimate;   /* exponentially weighted, used to select algorithms */
+} pgmpi_skew_stats_t;
+
+/**
+ * @return 0 if stats have been set, -1 if skew estimation is disabled or there are no samples yet
+ */
+int pgtune_get_skew_stats(pgmpi_collectives_t cid, MPI_Comm comm, pgmpi_skew_stats_t *stats);
+
+/**
+ * asks the tuned library to re-read its profiles
+ * the processes switch to the new profiles together at the next reload check (see --reload_interval)
+ */
+void pgtune_request_reload(void);
+
 
 #ifdef USE_PMPI
 #define PGMPI_COMM_SIZE PMPI_Comm_size
@@ -118,7 +173,10 @@ typedef struct {
   pgmpi_context_t context_id;
   void (*context_init)(void);
   void (*context_free)(void);
-  int (*context_get_algorithm)(pgmpi_collectives_t cid, int msg_size, int comm_size, int *alg_id);
+  int (*context_get_algorithm)(pgmpi_collectives_t cid, MPI_Count msg_size, MPI_Datatype datatype, MPI_Op op,
+      MPI_Comm comm, int *alg_id);
+  void (*context_report_time)(pgmpi_collectives_t cid, MPI_Count msg_size, MPI_Comm comm, int alg_id,
+      double time);   /* may be NULL if the context never measures */
 } pgmpi_context_hook_t;
 
 #ifdef __cplusplus
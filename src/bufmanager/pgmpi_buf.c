@@ -43,6 +43,10 @@ static size_t offset_int_buf2;
 static size_t total_msg_buf_size = 0;
 static size_t total_int_buf_size = 0;
 
+// sizes agreed by all processes, used to select mock-ups
+static size_t budget_msg_buf_size = 0;
+static size_t budget_int_buf_size = 0;
+
 static int msg_buf1_in_use;
 static int msg_buf2_in_use;
 static int int_buf1_in_use;
@@ -103,6 +107,9 @@ int pgmpi_allocate_buffers(const size_t size_msg_buffer, const size_t size_int_b
     ret = BUF_MALLOC_FAILED;
   }
 
+  budget_msg_buf_size = (msg_buf != NULL) ? total_msg_buf_size : 0;
+  budget_int_buf_size = (int_buf != NULL) ? total_int_buf_size : 0;
+
   msg_buf1_in_use = 0;
   msg_buf2_in_use = 0;
   int_buf1_in_use = 0;
@@ -114,9 +121,42 @@ int pgmpi_allocate_buffers(const size_t size_msg_buffer, const size_t size_int_b
 int pgmpi_free_buffers(void) {
   free(msg_buf);
   free(int_buf);
+  msg_buf = NULL;
+  int_buf = NULL;
+  budget_msg_buf_size = 0;
+  budget_int_buf_size = 0;
+  return 0;
+}
+
+int pgmpi_buffers_agree(MPI_Comm comm) {
+  unsigned long local[2], budget[2];
+
+  local[0] = budget_msg_buf_size;
+  local[1] = budget_int_buf_size;
+  if( PMPI_Allreduce(local, budget, 2, MPI_UNSIGNED_LONG, MPI_MIN, comm) != MPI_SUCCESS ) {
+    ZF_LOGE("cannot agree on buffer sizes, mock-ups that need buffers are not selected");
+    budget_msg_buf_size = 0;
+    budget_int_buf_size = 0;
+    return -1;
+  }
+  budget_msg_buf_size = budget[0];
+  budget_int_buf_size = budget[1];
+  ZF_LOGV("buffer budget %zu / %zu", budget_msg_buf_size, budget_int_buf_size);
   return 0;
 }
 
+int pgmpi_buffers_fit(const pgmpi_buf_req_t *req) {
+  return (req->msg_bytes <= budget_msg_buf_size && req->int_bytes <= budget_int_buf_size);
+}
+
+size_t pgmpi_buf_padded_scatter_bytes(const size_t count, const MPI_Aint extent, const int size) {
+  size_t padded_count;
+
+  padded_count = (count % size == 0) ? count : count + size - (count % size);
+  // padded buffer and the block scattered to each process
+  return padded_count * extent + (padded_count * extent) / size;
+}
+
 void set_max_size_msg_buf(size_t size) {
   assert(size > 0);
   total_msg_buf_size = size;
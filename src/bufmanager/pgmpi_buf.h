@@ -27,6 +27,9 @@
 #ifndef BUF_MANAGER_H_
 #define BUF_MANAGER_H_
 
+#include <mpi.h>
+#include "pgmpi_tune.h"
+
 
 enum BufferErrors {
   BUF_NO_ERROR = 0,
@@ -50,4 +53,23 @@ int pgmpi_allocate_buffers(const size_t size_msg_buffer, const size_t size_int_b
 
 int pgmpi_free_buffers(void);
 
+/*!
+  agrees on the smallest buffers of all processes of comm, so that
+  pgmpi_buffers_fit gives the same answer on all of them; collective over comm
+  \return 0 on success, -1 on error
+*/
+int pgmpi_buffers_agree(MPI_Comm comm);
+
+/*!
+  \return 1 if a mock-up with requirement req gets its buffers on all processes
+          (with pgmpi_buffers_agree), 0 otherwise
+*/
+int pgmpi_buffers_fit(const pgmpi_buf_req_t *req);
+
+/*!
+  \return bytes of the two message buffers of a mock-up that pads count
+          elements to a multiple of size and scatters them
+*/
+size_t pgmpi_buf_padded_scatter_bytes(const size_t count, const MPI_Aint extent, const int size);
+
 #endif /* BUF_MANAGER_H_ */
@@ -10,6 +10,7 @@
 #include "log/zf_log.h"
 
 #include "bufmanager/pgmpi_buf.h"
+#include "util/pgmpi_count.h"
 #include "allgather_impl.h"
 
 static const int mockup_root_rank = 0;
@@ -32,6 +33,9 @@ int MPI_Allgather_as_Allgatherv(const void *sendbuf, int sendcount,
 
   // we need two fake int buffers with size elements: aux_int_buf1, aux_int_buf2
   n = sendcount;            // send count per process
+  if (!pgmpi_count_fits_int((MPI_Count)size * n)) {   // displacements
+    return MPI_ERR_COUNT;
+  }
 
   fake_int_buf_size = size * sizeof(int);     // same size for both int buffers
   ZF_LOGV("fake_int_buf_size: %zu", fake_int_buf_size);
@@ -81,6 +85,9 @@ int MPI_Allgather_as_Allreduce(const void *sendbuf, int sendcount,
   sendbuf_size = n * type_extent;
 
   fake_buf_size = size * sendbuf_size;   // allreduce sendbuf for all processes
+  if (!pgmpi_count_fits_int(fake_buf_size)) {
+    return MPI_ERR_COUNT;
+  }
   ZF_LOGV("fake_buf_size: %zu", fake_buf_size);
   buf_status = grab_msg_buffer_1(fake_buf_size, &aux_buf1);
   ZF_LOGV("fake buffer 1 points to %p", aux_buf1);
@@ -142,6 +149,9 @@ int MPI_Allgather_as_GatherBcast(const void *sendbuf, int sendcount,
   int size;
 
   MPI_Comm_size(comm, &size);
+  if (!pgmpi_count_fits_int((MPI_Count)recvcount * size)) {
+    return MPI_ERR_COUNT;
+  }
   int bcast_count = recvcount * size;
 
   ZF_LOGV("Calling MPI_Allgather_as_GatherBcast");
@@ -151,3 +161,127 @@ int MPI_Allgather_as_GatherBcast(const void *sendbuf, int sendcount,
 
   return MPI_SUCCESS;
 }
+
+#if MPI_VERSION >= 4
+/*
+ * large-count mock-ups of MPI-4, used when the counts (or the counts derived from
+ * them) do not fit into an int
+ */
+int MPI_Allgather_as_Allgatherv_c(const void *sendbuf, MPI_Count sendcount,
+    MPI_Datatype sendtype, void *recvbuf, MPI_Count recvcount, MPI_Datatype recvtype,
+    MPI_Comm comm) {
+  int i;
+  int size;
+  MPI_Count n;
+  MPI_Count *recvcounts;
+  MPI_Aint *displs;
+  int *aux_int_buf1, *aux_int_buf2;
+  int buf_status = BUF_NO_ERROR;
+
+  MPI_Comm_size(comm, &size);
+
+  ZF_LOGV("Calling MPI_Allgather_as_Allgatherv_c");
+
+  // the int buffers hold size counts and size displacements
+  n = sendcount;            // send count per process
+  buf_status = grab_int_buffer_1(size * sizeof(MPI_Count), &aux_int_buf1);
+  if (buf_status != BUF_NO_ERROR) {
+    return MPI_ERR_NO_MEM;
+  }
+  buf_status = grab_int_buffer_2(size * sizeof(MPI_Aint), &aux_int_buf2);
+  if (buf_status != BUF_NO_ERROR) {
+    release_int_buffers();
+    return MPI_ERR_NO_MEM;
+  }
+
+  recvcounts = (MPI_Count*)aux_int_buf1;
+  displs = (MPI_Aint*)aux_int_buf2;
+
+  for (i = 0; i < size; i++) {
+    recvcounts[i] = n;
+    displs[i] = i * n;
+  }
+  PGMPI(MPI_Allgatherv_c(sendbuf, sendcount, sendtype, recvbuf, recvcounts, displs, recvtype, comm));
+
+  release_int_buffers();
+  return MPI_SUCCESS;
+}
+
+int MPI_Allgather_as_Allreduce_c(const void *sendbuf, MPI_Count sendcount,
+    MPI_Datatype sendtype, void *recvbuf, MPI_Count recvcount, MPI_Datatype recvtype,
+    MPI_Comm comm) {
+  int size, rank;
+  MPI_Aint lb, type_extent;
+  size_t fake_buf_size, sendbuf_size;
+  void *aux_buf1;
+  int buf_status = BUF_NO_ERROR;
+  MPI_Op op = MPI_BOR;
+
+  ZF_LOGV("Calling MPI_Allgather_as_Allreduce_c");
+
+  MPI_Comm_rank(comm, &rank);
+  MPI_Comm_size(comm, &size);
+  MPI_Type_get_extent(sendtype, &lb, &type_extent);
+
+  sendbuf_size = sendcount * type_extent;
+  fake_buf_size = size * sendbuf_size;   // allreduce sendbuf for all processes
+  buf_status = grab_msg_buffer_1(fake_buf_size, &aux_buf1);
+  if (buf_status != BUF_NO_ERROR) {
+    return MPI_ERR_NO_MEM;
+  }
+
+  memset(aux_buf1, 0, fake_buf_size);
+  memcpy((char*)aux_buf1 + (rank * sendbuf_size), sendbuf, sendbuf_size);
+
+  PGMPI(MPI_Allreduce_c(aux_buf1, recvbuf, (MPI_Count)fake_buf_size, MPI_CHAR, op, comm));
+
+  release_msg_buffers();
+  return MPI_SUCCESS;
+}
+
+int MPI_Allgather_as_Alltoall_c(const void *sendbuf, MPI_Count sendcount,
+    MPI_Datatype sendtype, void *recvbuf, MPI_Count recvcount, MPI_Datatype recvtype,
+    MPI_Comm comm) {
+  int i, size;
+  MPI_Aint lb, type_extent;
+  size_t fake_buf_size, sendbuf_size;
+  void *aux_buf1;
+  int buf_status = BUF_NO_ERROR;
+
+  ZF_LOGV("Calling MPI_Allgather_as_Alltoall_c");
+
+  MPI_Comm_size(comm, &size);
+  MPI_Type_get_extent(sendtype, &lb, &type_extent);
+
+  sendbuf_size = sendcount * type_extent;
+  fake_buf_size = size * sendbuf_size;   // sendbuf for all to all
+  buf_status = grab_msg_buffer_1(fake_buf_size, &aux_buf1);
+  if (buf_status != BUF_NO_ERROR) {
+    return MPI_ERR_NO_MEM;
+  }
+
+  for(i=0; i<size; i++) {
+    memcpy((char*)aux_buf1 + (i*sendbuf_size), sendbuf, sendbuf_size);
+  }
+
+  PGMPI(MPI_Alltoall_c(aux_buf1, sendcount, sendtype, recvbuf, recvcount, recvtype, comm));
+
+  release_msg_buffers();
+  return MPI_SUCCESS;
+}
+
+int MPI_Allgather_as_GatherBcast_c(const void *sendbuf, MPI_Count sendcount,
+    MPI_Datatype sendtype, void *recvbuf, MPI_Count recvcount, MPI_Datatype recvtype,
+    MPI_Comm comm) {
+  int size;
+
+  MPI_Comm_size(comm, &size);
+
+  ZF_LOGV("Calling MPI_Allgather_as_GatherBcast_c");
+
+  PGMPI(MPI_Gather_c(sendbuf, sendcount, sendtype, recvbuf, recvcount, recvtype, mockup_root_rank, comm));
+  PGMPI(MPI_Bcast_c(recvbuf, recvcount * size, recvtype, mockup_root_rank, comm));
+
+  return MPI_SUCCESS;
+}
+#endif
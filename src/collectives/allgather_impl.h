@@ -20,4 +20,22 @@ int MPI_Allgather_as_GatherBcast(const void *sendbuf, int sendcount,
     MPI_Datatype sendtype, void *recvbuf, int recvcount, MPI_Datatype recvtype,
     MPI_Comm comm);
 
+#if MPI_VERSION >= 4
+int MPI_Allgather_as_Allgatherv_c(const void *sendbuf, MPI_Count sendcount,
+    MPI_Datatype sendtype, void *recvbuf, MPI_Count recvcount, MPI_Datatype recvtype,
+    MPI_Comm comm);
+
+int MPI_Allgather_as_Allreduce_c(const void *sendbuf, MPI_Count sendcount,
+    MPI_Datatype sendtype, void *recvbuf, MPI_Count recvcount, MPI_Datatype recvtype,
+    MPI_Comm comm);
+
+int MPI_Allgather_as_Alltoall_c(const void *sendbuf, MPI_Count sendcount,
+    MPI_Datatype sendtype, void *recvbuf, MPI_Count recvcount, MPI_Datatype recvtype,
+    MPI_Comm comm);
+
+int MPI_Allgather_as_GatherBcast_c(const void *sendbuf, MPI_Count sendcount,
+    MPI_Datatype sendtype, void *recvbuf, MPI_Count recvcount, MPI_Datatype recvtype,
+    MPI_Comm comm);
+#endif
+
 #endif /* SRC_COLLECTIVES_ALLGATHER_IMPL_H_ */
@@ -10,6 +10,7 @@
 
 #include "bufmanager/pgmpi_buf.h"
 #include "allgather_impl.h"
+#include "allreduce_impl.h"
 
 static const int MIN_SCATTER_CHUNK_SIZE = 4; // number of elements
 static const int mockup_root_rank = 0;
@@ -58,7 +59,7 @@ int MPI_Allreduce_as_Reduce_scatter_block_Allgather(const void *sendbuf, void *r
     n_padding_elems = size - (n % size);
   }
 
-  fake_buf_size1 = (n + n_padding_elems) * type_extent;       // max size for the padded buffer
+  fake_buf_size1 = ((MPI_Aint)n + n_padding_elems) * type_extent;       // max size for the padded buffer
   ZF_LOGV("fake_buf_size1: %zu", fake_buf_size1);
   buf_status = grab_msg_buffer_1(fake_buf_size1, &aux_buf1);
   ZF_LOGV("fake buffer 1 points to %p", aux_buf1);
@@ -182,3 +183,137 @@ int MPI_Allreduce_as_Reduce_scatter_Allgatherv(const void *sendbuf, void *recvbu
   release_int_buffers();
   return MPI_SUCCESS;
 }
+
+#if MPI_VERSION >= 4
+/*
+ * large-count mock-ups of MPI-4, used when the counts do not fit into an int
+ */
+int MPI_Allreduce_as_Reduce_Bcast_c(const void *sendbuf, void *recvbuf, MPI_Count count,
+    MPI_Datatype datatype, MPI_Op op, MPI_Comm comm) {
+
+  ZF_LOGV("Calling MPI_Allreduce_as_Reduce_Bcast_c");
+
+  PGMPI(MPI_Reduce_c(sendbuf, recvbuf, count, datatype, op, mockup_root_rank, comm));
+  PGMPI(MPI_Bcast_c(recvbuf, count, datatype, mockup_root_rank, comm));
+
+  return MPI_SUCCESS;
+}
+
+int MPI_Allreduce_as_Reduce_scatter_block_Allgather_c(const void *sendbuf, void *recvbuf, MPI_Count count,
+    MPI_Datatype datatype, MPI_Op op, MPI_Comm comm) {
+  MPI_Count n, i;
+  MPI_Count n_padding_elems;
+  MPI_Count scattered_count;
+  int size;
+  MPI_Aint type_extent, lb;
+  size_t fake_buf_size1, fake_buf_size2;
+  void *aux_buf1, *aux_buf2;
+  int buf_status = BUF_NO_ERROR;
+  MPI_Aint padding_offset;
+
+  MPI_Comm_size(comm, &size);
+  MPI_Type_get_extent(datatype, &lb, &type_extent);
+
+  ZF_LOGV("Calling MPI_Allreduce_as_Reduce_scatter_block_Allgather_c");
+
+  n = count;            // buffer size per process
+  if (n % size == 0) {
+    n_padding_elems = 0;
+  } else {
+    n_padding_elems = size - (n % size);
+  }
+
+  fake_buf_size1 = (n + n_padding_elems) * type_extent;       // max size for the padded buffer
+  buf_status = grab_msg_buffer_1(fake_buf_size1, &aux_buf1);
+  if (buf_status != BUF_NO_ERROR) {
+    return MPI_ERR_NO_MEM;
+  }
+  fake_buf_size2 = fake_buf_size1 / size;       // max size for the scattered buffer per process
+  buf_status = grab_msg_buffer_2(fake_buf_size2, &aux_buf2);
+  if (buf_status != BUF_NO_ERROR) {
+    release_msg_buffers();
+    return MPI_ERR_NO_MEM;
+  }
+
+  scattered_count = fake_buf_size2 / type_extent;
+
+  // padded send buffer, the padding repeats the first element of sendbuf
+  memcpy(aux_buf1, sendbuf, n * type_extent);
+  padding_offset = n * type_extent;
+  for (i=0; i<n_padding_elems; i++) {
+    memcpy((char*)aux_buf1 + padding_offset, sendbuf, type_extent);
+    padding_offset += type_extent;
+  }
+
+  PGMPI(MPI_Reduce_scatter_block_c(aux_buf1, aux_buf2, scattered_count, datatype, op, comm));
+  PGMPI(MPI_Allgather_c(aux_buf2, scattered_count, datatype, aux_buf1, scattered_count, datatype, comm));
+
+  memcpy(recvbuf, aux_buf1, n * type_extent);
+
+  release_msg_buffers();
+  return MPI_SUCCESS;
+}
+
+int MPI_Allreduce_as_Reduce_scatter_Allgatherv_c(const void *sendbuf, void *recvbuf, MPI_Count count,
+    MPI_Datatype datatype, MPI_Op op, MPI_Comm comm) {
+  MPI_Count n;
+  MPI_Count nchunks;
+  int i;
+  MPI_Count *recvcounts;
+  MPI_Aint *displs;
+  int rank, size;
+  MPI_Aint type_extent, lb;
+  int *aux_int_buf1, *aux_int_buf2;
+  void *aux_buf;
+  int buf_status = BUF_NO_ERROR;
+
+  MPI_Comm_rank(comm, &rank);
+  MPI_Comm_size(comm, &size);
+  MPI_Type_get_extent(datatype, &lb, &type_extent);
+
+  ZF_LOGV("Calling MPI_Allreduce_as_Reduce_scatter_Allgatherv_c");
+
+  // the int buffers hold size counts and size displacements
+  n = count;            // buffer size per process
+  buf_status = grab_int_buffer_1(size * sizeof(MPI_Count), &aux_int_buf1);
+  if (buf_status != BUF_NO_ERROR) {
+    return MPI_ERR_NO_MEM;
+  }
+  buf_status = grab_int_buffer_2(size * sizeof(MPI_Aint), &aux_int_buf2);
+  if (buf_status != BUF_NO_ERROR) {
+    release_int_buffers();
+    return MPI_ERR_NO_MEM;
+  }
+  recvcounts = (MPI_Count*)aux_int_buf1;
+  displs = (MPI_Aint*)aux_int_buf2;
+
+  // same blocks as MPI_Allreduce_as_Reduce_scatter_Allgatherv
+  nchunks = n / MIN_SCATTER_CHUNK_SIZE;
+  for (i = 0; i < size; i++) {
+    recvcounts[i] = MIN_SCATTER_CHUNK_SIZE * (nchunks/size);
+
+    if (i < nchunks % size) {
+      recvcounts[i] += MIN_SCATTER_CHUNK_SIZE;
+    } else if (i == nchunks % size ) {
+      recvcounts[i] += n % MIN_SCATTER_CHUNK_SIZE;
+    }
+  }
+
+  displs[0] = 0;
+  for (i = 1; i < size; i++) {
+    displs[i] = displs[i - 1] + recvcounts[i - 1];
+  }
+
+  if (recvcounts[rank] > 0) {
+    aux_buf = (char*)(recvbuf) + displs[rank] * type_extent;
+  } else {
+     aux_buf = recvbuf;
+  }
+
+  PGMPI(MPI_Reduce_scatter_c(sendbuf, aux_buf, recvcounts, datatype, op, comm));
+  PGMPI(MPI_Allgatherv_c(MPI_IN_PLACE, 0, datatype, recvbuf, recvcounts, displs, datatype, comm));
+
+  release_int_buffers();
+  return MPI_SUCCESS;
+}
+#endif
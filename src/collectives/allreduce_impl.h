@@ -13,4 +13,15 @@ int MPI_Allreduce_as_Reduce_scatter_Allgatherv(const void *sendbuf, void *recvbu
 int MPI_Allreduce_as_Reduce_scatter_block_Allgather(const void *sendbuf, void *recvbuf, int count,
     MPI_Datatype datatype, MPI_Op op, MPI_Comm comm);
 
+#if MPI_VERSION >= 4
+int MPI_Allreduce_as_Reduce_Bcast_c(const void *sendbuf, void *recvbuf, MPI_Count count,
+    MPI_Datatype datatype, MPI_Op op, MPI_Comm comm);
+
+int MPI_Allreduce_as_Reduce_scatter_Allgatherv_c(const void *sendbuf, void *recvbuf, MPI_Count count,
+    MPI_Datatype datatype, MPI_Op op, MPI_Comm comm);
+
+int MPI_Allreduce_as_Reduce_scatter_block_Allgather_c(const void *sendbuf, void *recvbuf, MPI_Count count,
+    MPI_Datatype datatype, MPI_Op op, MPI_Comm comm);
+#endif
+
 #endif /* SRC_COLLECTIVES_ALLREDUCE_IMPL_H_ */
@@ -32,6 +32,7 @@
 
 #include "pgmpi_tune.h"
 #include "bufmanager/pgmpi_buf.h"
+#include "util/pgmpi_count.h"
 #include "alltoall_impl.h"
 
 
@@ -51,6 +52,9 @@ int MPI_Alltoall_as_Alltoallv(const void* sendbuf, int sendcount, MPI_Datatype s
 
   // we need two fake int buffers with size elements: aux_int_buf1, aux_int_buf2
   n = sendcount;            // buffer size per process
+  if (!pgmpi_count_fits_int((MPI_Count)size * n)) {   // displacements
+    return MPI_ERR_COUNT;
+  }
 
   fake_int_buf_size = size * sizeof(int);     // same size for both int buffers
   ZF_LOGV("fake_int_buf_size: %zu", fake_int_buf_size);
@@ -79,3 +83,46 @@ int MPI_Alltoall_as_Alltoallv(const void* sendbuf, int sendcount, MPI_Datatype s
   release_int_buffers();
   return MPI_SUCCESS;
 }
+
+#if MPI_VERSION >= 4
+/*
+ * large-count mock-up of MPI-4, used when the counts (or the displacements) do not
+ * fit into an int
+ */
+int MPI_Alltoall_as_Alltoallv_c(const void* sendbuf, MPI_Count sendcount, MPI_Datatype sendtype, void* recvbuf,
+    MPI_Count recvcount, MPI_Datatype recvtype, MPI_Comm comm) {
+  int i, size;
+  MPI_Count *counts;
+  MPI_Aint *displs;
+  int *aux_int_buf1, *aux_int_buf2;
+  int buf_status = BUF_NO_ERROR;
+
+  MPI_Comm_size(comm, &size);
+
+  ZF_LOGV("Calling MPI_Alltoall_as_Alltoallv_c");
+
+  // the int buffers hold size counts and size displacements
+  buf_status = grab_int_buffer_1(size * sizeof(MPI_Count), &aux_int_buf1);
+  if (buf_status != BUF_NO_ERROR) {
+    return MPI_ERR_NO_MEM;
+  }
+  buf_status = grab_int_buffer_2(size * sizeof(MPI_Aint), &aux_int_buf2);
+  if (buf_status != BUF_NO_ERROR) {
+    release_int_buffers();
+    return MPI_ERR_NO_MEM;
+  }
+
+  counts = (MPI_Count*)aux_int_buf1;
+  displs = (MPI_Aint*)aux_int_buf2;
+  for (i = 0; i < size; i++) {
+    counts[i] = sendcount;
+    displs[i] = i * sendcount;
+  }
+
+  // the same counts and displacements for sending and receiving
+  PGMPI(MPI_Alltoallv_c(sendbuf, counts, displs, sendtype, recvbuf, counts, displs, recvtype, comm));
+
+  release_int_buffers();
+  return MPI_SUCCESS;
+}
+#endif
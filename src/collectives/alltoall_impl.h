@@ -7,4 +7,9 @@
 int MPI_Alltoall_as_Alltoallv(const void* sendbuf, int sendcount, MPI_Datatype sendtype, void* recvbuf, int recvcount,
     MPI_Datatype recvtype, MPI_Comm comm);
 
+#if MPI_VERSION >= 4
+int MPI_Alltoall_as_Alltoallv_c(const void* sendbuf, MPI_Count sendcount, MPI_Datatype sendtype, void* recvbuf,
+    MPI_Count recvcount, MPI_Datatype recvtype, MPI_Comm comm);
+#endif
+
 #endif /* SRC_COLLECTIVES_ALLTOALL_IMPL_H_ */
@@ -31,15 +31,30 @@
 #include "log/zf_log.h"
 
 #include "pgmpi_tune.h"
+#include "bufmanager/pgmpi_buf.h"
 #include "pgmpi_algid_store.h"
 #include "collective_modules.h"
 #include "util/pgmpi_parse_cli.h"
+#include "util/pgmpi_callsite.h"
+#include "util/pgmpi_skew.h"
+#include "util/pgmpi_nesting.h"
+#include "util/pgmpi_count.h"
 #include "all_guideline_collectives.h"
 
+#ifdef PGMPI_STATIC_TUNING
+#include "pgmpi_static_decisions.h"   /* generated by pgmpi_prf2c */
+#endif
+
 /********************************/
 
 static void parse_arguments(const char *argv);
 static void set_algid(const int algid);
+static void get_buf_req(const int algid, const MPI_Count msg_size, MPI_Datatype datatype, const int comm_size,
+    pgmpi_buf_req_t *req);
+static int call_mockup(const int algid, void *buffer, int count, MPI_Datatype datatype, int root, MPI_Comm comm);
+#if MPI_VERSION >= 4
+static int call_mockup_c(const int algid, void *buffer, MPI_Count count, MPI_Datatype datatype, int root, MPI_Comm comm);
+#endif
 
 /********************************/
 
@@ -94,35 +109,36 @@ static void set_algid(const int algid) {
   }
 }
 
+/*
+ * buffers the mock-ups take from the buffer manager (see the *_impl.c files)
+ */
+static void get_buf_req(const int algid, const MPI_Count msg_size, MPI_Datatype datatype, const int comm_size,
+    pgmpi_buf_req_t *req) {
+  MPI_Aint lb, extent;
 
-void register_module_bcast(module_t *module) {
-  module->cli_prefix  = "bcast";
-  module->mpiname     = "MPI_Bcast";
-  module->cid         = CID_MPI_BCAST;
-  module->parse       = &parse_arguments;
-  module->alg_choices = &module_choices;
-  module->set_algid   = &set_algid;
-  module->is_rooted   = 1;
-}
+  MPI_Type_get_extent(datatype, &lb, &extent);
+  if( extent <= 0 ) {
+    return;
+  }
 
-void deregister_module_bcast(module_t *module) {
+  switch (algid) {
+  case BCAST_AS_ALLGATHERV:
+    req->int_bytes = 2 * pgmpi_count_array_bytes(msg_size / extent, comm_size);
+    break;
+  case BCAST_AS_SCATTER_ALLGATHER:
+    req->msg_bytes = pgmpi_buf_padded_scatter_bytes(msg_size / extent, extent, comm_size);
+    break;
+  default:
+    // no buffers needed
+    break;
+  }
 }
 
 
-int MPI_Bcast(void* buffer, int count, MPI_Datatype datatype, int root, MPI_Comm comm) {
+static int call_mockup(const int algid, void *buffer, int count, MPI_Datatype datatype, int root, MPI_Comm comm) {
   int ret_status = MPI_SUCCESS;
-  int call_default = 0;
-  int size;
-
-  ZF_LOGV("Intercepting MPI_Bcast");
 
-  MPI_Comm_size(comm, &size);
-
-  if( get_pgmpi_context() == CONTEXT_TUNED ) {
-    (void)pgtune_get_algorithm(CID_MPI_BCAST, pgmpi_convert_type_count_2_bytes(count, datatype), size, &alg_id);
-  }
-
-  switch (alg_id) {
+  switch (algid) {
   case BCAST_AS_ALLGATHERV:
     ret_status = MPI_Bcast_as_Allgatherv(buffer, count, datatype, root, comm);
     break;
@@ -143,28 +159,166 @@ int MPI_Bcast(void* buffer, int count, MPI_Datatype datatype, int root, MPI_Comm
     break;
 #endif
   case BCAST_DEFAULT:
-    call_default = 1;
+    ret_status = MPI_ERR_OTHER;   // not a mock-up
+    break;
+  default:   // call the original function
+    ZF_LOGW("cannot find alg id %d, using default", algid);
+    ret_status = MPI_ERR_OTHER;
+  }
+
+  return ret_status;
+}
+
+#if MPI_VERSION >= 4
+/*
+ * large-count mock-ups, the algorithms of other libraries only take int counts
+ */
+static int call_mockup_c(const int algid, void *buffer, MPI_Count count, MPI_Datatype datatype, int root, MPI_Comm comm) {
+  int ret_status = MPI_SUCCESS;
+
+  switch (algid) {
+  case BCAST_AS_ALLGATHERV:
+    ret_status = MPI_Bcast_as_Allgatherv_c(buffer, count, datatype, root, comm);
+    break;
+  case BCAST_AS_SCATTER_ALLGATHER:
+    ret_status = MPI_Bcast_as_Scatter_Allgather_c(buffer, count, datatype, root, comm);
+    break;
+  case BCAST_DEFAULT:
+    ret_status = MPI_ERR_OTHER;   // not a mock-up
     break;
   default:   // call the original function
-    ZF_LOGW("cannot find alg id %d, using default", alg_id);
-    call_default = 1;
+    ret_status = MPI_ERR_OTHER;
+  }
+
+  return ret_status;
+}
+#endif
+
+void register_module_bcast(module_t *module) {
+  module->cli_prefix  = "bcast";
+  module->mpiname     = "MPI_Bcast";
+  module->cid         = CID_MPI_BCAST;
+  module->parse       = &parse_arguments;
+  module->alg_choices = &module_choices;
+  module->set_algid   = &set_algid;
+  module->is_rooted   = 1;
+  module->get_buf_req = &get_buf_req;
+}
+
+void deregister_module_bcast(module_t *module) {
+}
+
+
+int MPI_Bcast(void* buffer, int count, MPI_Datatype datatype, int root, MPI_Comm comm) {
+  int call_default = 0;
+  int measure = 0;
+  double t_start = 0;
+
+  ZF_LOGV("Intercepting MPI_Bcast");
+  PGMPI_CALLSITE_ENTER();
+  PGMPI_NESTING_ENTER();
+  PGMPI_SKEW_ENTER(CID_MPI_BCAST, comm);
+
+#ifdef PGMPI_STATIC_TUNING
+  alg_id = pgmpi_static_select(CID_MPI_BCAST, pgmpi_convert_type_count_2_bytes(count, datatype), datatype,
+      MPI_OP_NULL, comm);
+#else
+  if( get_pgmpi_context() != CONTEXT_CLI ) {
+    measure = (pgtune_get_algorithm(CID_MPI_BCAST, pgmpi_convert_type_count_2_bytes(count, datatype), datatype,
+        MPI_OP_NULL, comm, &alg_id) == PGMPI_ALG_MEASURE);
   }
+#endif
 
-  if (ret_status != MPI_SUCCESS) {
-    call_default = 1;
+  if( measure ) {
+    t_start = MPI_Wtime();
   }
 
+  call_default = (call_mockup(alg_id, buffer, count, datatype, root, comm) != MPI_SUCCESS);
+
   if (call_default == 1) {
     ZF_LOGV("Calling PMPI_Bcast");
     PMPI_Bcast(buffer, count, datatype, root, comm);
   }
 
+  PGMPI_SKEW_EXIT();
+  // nested collectives of the mock-up may have changed the current call site
+  PGMPI_CALLSITE_ENTER();
+
+  // a fallback ran the default algorithm
+  if( measure ) {
+    pgtune_report_time(CID_MPI_BCAST, pgmpi_convert_type_count_2_bytes(count, datatype), comm,
+        call_default ? 0 : alg_id, MPI_Wtime() - t_start);
+  }
+
   if (PGMPI_ENABLE_ALGID_STORING) {
     pgmpi_save_algid_for_msg_size(CID_MPI_BCAST, pgmpi_convert_type_count_2_bytes(count, datatype), alg_id,
         call_default);
   }
 
-
+  PGMPI_NESTING_EXIT();
   return MPI_SUCCESS;
 }
 
+#if MPI_VERSION >= 4
+/*
+ * large-count binding of MPI-4, counts that do not fit into an int go to the large-count mock-ups
+ */
+int MPI_Bcast_c(void* buffer, MPI_Count count, MPI_Datatype datatype, int root, MPI_Comm comm) {
+  int call_default = 0;
+  int ret_status;
+  int measure = 0;
+  double t_start = 0;
+
+  ZF_LOGV("Intercepting MPI_Bcast_c");
+  PGMPI_CALLSITE_ENTER();
+  PGMPI_NESTING_ENTER();
+  PGMPI_SKEW_ENTER(CID_MPI_BCAST, comm);
+
+#ifdef PGMPI_STATIC_TUNING
+  alg_id = pgmpi_static_select(CID_MPI_BCAST, pgmpi_convert_type_count_2_bytes(count, datatype), datatype,
+      MPI_OP_NULL, comm);
+#else
+  if( get_pgmpi_context() != CONTEXT_CLI ) {
+    measure = (pgtune_get_algorithm(CID_MPI_BCAST, pgmpi_convert_type_count_2_bytes(count, datatype), datatype,
+        MPI_OP_NULL, comm, &alg_id) == PGMPI_ALG_MEASURE);
+  }
+#endif
+
+  if( measure ) {
+    t_start = MPI_Wtime();
+  }
+
+  // use the large-count mock-ups if the int ones cannot take the counts (or the counts derived from them)
+  ret_status = MPI_ERR_COUNT;
+  if( pgmpi_count_fits_int(count) ) {
+    ret_status = call_mockup(alg_id, buffer, (int)count, datatype, root, comm);
+  }
+  if( ret_status == MPI_ERR_COUNT ) {
+    ret_status = call_mockup_c(alg_id, buffer, count, datatype, root, comm);
+  }
+  call_default = (ret_status != MPI_SUCCESS);
+
+  if (call_default == 1) {
+    ZF_LOGV("Calling PMPI_Bcast_c");
+    PMPI_Bcast_c(buffer, count, datatype, root, comm);
+  }
+
+  PGMPI_SKEW_EXIT();
+  // nested collectives of the mock-up may have changed the current call site
+  PGMPI_CALLSITE_ENTER();
+
+  // a fallback ran the default algorithm
+  if( measure ) {
+    pgtune_report_time(CID_MPI_BCAST, pgmpi_convert_type_count_2_bytes(count, datatype), comm,
+        call_default ? 0 : alg_id, MPI_Wtime() - t_start);
+  }
+
+  if (PGMPI_ENABLE_ALGID_STORING) {
+    pgmpi_save_algid_for_msg_size(CID_MPI_BCAST, pgmpi_convert_type_count_2_bytes(count, datatype), alg_id,
+        call_default);
+  }
+
+  PGMPI_NESTING_EXIT();
+  return MPI_SUCCESS;
+}
+#endif
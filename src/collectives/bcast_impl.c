@@ -94,7 +94,7 @@ int MPI_Bcast_as_Scatter_Allgather(void* buffer, int count, MPI_Datatype datatyp
     n_padding_elems = size - (n % size);
   }
 
-  fake_buf_size1 = (n + n_padding_elems) * type_extent;       // max size for the padded buffer
+  fake_buf_size1 = ((MPI_Aint)n + n_padding_elems) * type_extent;       // max size for the padded buffer
   ZF_LOGV("fake_buf_size1: %zu", fake_buf_size1);
   buf_status = grab_msg_buffer_1(fake_buf_size1, &aux_buf1);
   ZF_LOGV("fake buffer 1 points to %p", aux_buf1);
@@ -133,3 +133,98 @@ int MPI_Bcast_as_Scatter_Allgather(void* buffer, int count, MPI_Datatype datatyp
   release_msg_buffers();
   return MPI_SUCCESS;
 }
+
+#if MPI_VERSION >= 4
+/*
+ * large-count mock-ups of MPI-4, used when the count does not fit into an int
+ */
+int MPI_Bcast_as_Allgatherv_c(void* buffer, MPI_Count count, MPI_Datatype datatype, int root, MPI_Comm comm) {
+  int i;
+  MPI_Count *recvcounts;
+  MPI_Aint *displs;
+  int size;
+  int *aux_int_buf1, *aux_int_buf2;
+  int buf_status = BUF_NO_ERROR;
+
+  MPI_Comm_size(comm, &size);
+
+  ZF_LOGV("Calling MPI_Bcast_as_Allgatherv_c");
+
+  // the int buffers hold size counts and size displacements
+  buf_status = grab_int_buffer_1(size * sizeof(MPI_Count), &aux_int_buf1);
+  if (buf_status != BUF_NO_ERROR) {
+    return MPI_ERR_NO_MEM;
+  }
+  buf_status = grab_int_buffer_2(size * sizeof(MPI_Aint), &aux_int_buf2);
+  if (buf_status != BUF_NO_ERROR) {
+    release_int_buffers();
+    return MPI_ERR_NO_MEM;
+  }
+
+  recvcounts = (MPI_Count*)aux_int_buf1;
+  displs = (MPI_Aint*)aux_int_buf2;
+
+  // only the root contributes (see MPI_Bcast_as_Allgatherv)
+  for (i = 0; i < size; i++) {
+    recvcounts[i] = (i == root) ? count : 0;
+    displs[i] = (i > root) ? count : 0;
+  }
+
+  PGMPI(MPI_Allgatherv_c(MPI_IN_PLACE, 0, datatype, buffer, recvcounts, displs, datatype, comm));
+
+  release_int_buffers();
+  return MPI_SUCCESS;
+}
+
+int MPI_Bcast_as_Scatter_Allgather_c(void* buffer, MPI_Count count, MPI_Datatype datatype, int root, MPI_Comm comm) {
+  MPI_Count n;
+  MPI_Count n_padding_elems;
+  MPI_Count scattered_count;
+  int rank, size;
+  MPI_Aint type_extent, lb;
+  size_t fake_buf_size1, fake_buf_size2;
+  void *aux_buf1, *aux_buf2;
+  int buf_status = BUF_NO_ERROR;
+
+  MPI_Comm_rank(comm, &rank);
+  MPI_Comm_size(comm, &size);
+  MPI_Type_get_extent(datatype, &lb, &type_extent);
+
+  ZF_LOGV("Calling MPI_Bcast_as_Scatter_Allgather_c");
+
+  n = count;            // buffer size broadcasted to all processes
+  if (n % size == 0) {
+    n_padding_elems = 0;
+  } else {
+    n_padding_elems = size - (n % size);
+  }
+
+  fake_buf_size1 = (n + n_padding_elems) * type_extent;       // max size for the padded buffer
+  buf_status = grab_msg_buffer_1(fake_buf_size1, &aux_buf1);
+  if (buf_status != BUF_NO_ERROR) {
+    return MPI_ERR_NO_MEM;
+  }
+  fake_buf_size2 = fake_buf_size1 / size;       // max size for the scattered buffer per process
+  buf_status = grab_msg_buffer_2(fake_buf_size2, &aux_buf2);
+  if (buf_status != BUF_NO_ERROR) {
+    release_msg_buffers();
+    return MPI_ERR_NO_MEM;
+  }
+
+  scattered_count = fake_buf_size2 / type_extent;
+
+  if (rank == root) { // buffer is only filled in at the root
+    memcpy(aux_buf1, buffer, n * type_extent);
+  }
+
+  PGMPI(MPI_Scatter_c(aux_buf1, scattered_count, datatype, aux_buf2, scattered_count, datatype, root, comm));
+  PGMPI(MPI_Allgather_c(aux_buf2, scattered_count, datatype, aux_buf1, scattered_count, datatype, comm));
+
+  if (rank != root) {
+    memcpy(buffer, aux_buf1, n * type_extent);
+  }
+
+  release_msg_buffers();
+  return MPI_SUCCESS;
+}
+#endif
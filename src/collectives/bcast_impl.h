@@ -8,4 +8,10 @@ int MPI_Bcast_as_Allgatherv(void* buffer, int count, MPI_Datatype datatype, int
 
 int MPI_Bcast_as_Scatter_Allgather(void* buffer, int count, MPI_Datatype datatype, int root, MPI_Comm comm);
 
+#if MPI_VERSION >= 4
+int MPI_Bcast_as_Allgatherv_c(void* buffer, MPI_Count count, MPI_Datatype datatype, int root, MPI_Comm comm);
+
+int MPI_Bcast_as_Scatter_Allgather_c(void* buffer, MPI_Count count, MPI_Datatype datatype, int root, MPI_Comm comm);
+#endif
+
 #endif /* SRC_COLLECTIVES_BCAST_IMPL_H_ */
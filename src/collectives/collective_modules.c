@@ -36,6 +36,7 @@
 #include "collective_modules.h"
 #include "util/keyvalue_store.h"
 #include "util/pgmpi_parse_cli.h"
+#include "bufmanager/pgmpi_buf.h"
 
 static module_t *modules;
 
@@ -154,3 +155,25 @@ char *pgmpi_modules_get_algname_by_algid(const module_alg_choices_t *alg_choices
   return algname;
 }
 
+int pgmpi_modules_select_fitting_alg(const pgmpi_collectives_t cid, const int *candidates, const int n_candidates,
+    const MPI_Count msg_size, MPI_Datatype datatype, const int comm_size) {
+  module_t *mod;
+  pgmpi_buf_req_t req;
+  int i;
+
+  mod = pgmpi_modules_get(cid);
+  for(i=0; i<n_candidates; i++) {
+    if( candidates[i] == 0 || mod == NULL || mod->get_buf_req == NULL ) {
+      return candidates[i];
+    }
+    req.msg_bytes = 0;
+    req.int_bytes = 0;
+    mod->get_buf_req(candidates[i], msg_size, datatype, comm_size, &req);
+    if( pgmpi_buffers_fit(&req) ) {
+      return candidates[i];
+    }
+    ZF_LOGV("alg %d of cid %d needs %zu / %zu buffer bytes, trying next candidate", candidates[i], cid,
+        req.msg_bytes, req.int_bytes);
+  }
+  return 0;
+}
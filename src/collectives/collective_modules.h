@@ -65,4 +65,14 @@ int pgmpi_modules_get_algid_by_algname(const module_alg_choices_t *alg_choices,
 
 char *pgmpi_modules_get_algname_by_algid(const module_alg_choices_t *alg_choices, const int algid);
 
+/*!
+  picks the first candidate whose buffers fit into the buffer budget, so that
+  all processes pick the same one (see pgmpi_buffers_agree)
+  \param candidates algorithm ids, best first
+  \param msg_size, datatype, comm_size arguments of the call
+  \return first fitting candidate, the default algorithm (0) if none fits
+*/
+int pgmpi_modules_select_fitting_alg(const pgmpi_collectives_t cid, const int *candidates, const int n_candidates,
+    const MPI_Count msg_size, MPI_Datatype datatype, const int comm_size);
+
 #endif /* SRC_COLLECTIVES_COLLECTIVE_MODULES_H_ */
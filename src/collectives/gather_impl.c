@@ -32,6 +32,7 @@
 #include "log/zf_log.h"
 
 #include "bufmanager/pgmpi_buf.h"
+#include "util/pgmpi_count.h"
 #include "gather_impl.h"
 
 int MPI_Gather_as_Allgather(const void* sendbuf, int sendcount, MPI_Datatype sendtype,
@@ -52,7 +53,7 @@ int MPI_Gather_as_Allgather(const void* sendbuf, int sendcount, MPI_Datatype sen
 
   // we need a fake buffer with n elements in aux_buf1
   n = sendcount;    // buffer size per process
-  fake_buf_size = size * n * type_extent;
+  fake_buf_size = (MPI_Aint)size * n * type_extent;
 
   ZF_LOGV("fake_send_size: %zu", fake_buf_size);
   buf_status = grab_msg_buffer_1(fake_buf_size, &aux_buf1);
@@ -93,6 +94,11 @@ int MPI_Gather_as_Gatherv(const void* sendbuf, int sendcount, MPI_Datatype sendt
 
   MPI_Comm_size(comm, &size);
 
+  n = sendcount;          // buffer size per process
+  if (!pgmpi_count_fits_int((MPI_Count)size * n)) {   // displacements
+    return MPI_ERR_COUNT;
+  }
+
   // we need two fake int buffers with size elements: aux_int_buf1, aux_int_buf2
   fake_int_buf_size = size * sizeof(int);     // same size for both int buffers
   ZF_LOGV("fake_int_buf_size: %zu", fake_int_buf_size);
@@ -109,7 +115,6 @@ int MPI_Gather_as_Gatherv(const void* sendbuf, int sendcount, MPI_Datatype sendt
   }
 
 
-  n = sendcount;          // buffer size per process
   recvcounts = aux_int_buf1;
   displs = aux_int_buf2;
 
@@ -147,6 +152,9 @@ int MPI_Gather_as_Reduce(const void* sendbuf, int sendcount, MPI_Datatype sendty
   // we need a fake buffer with size * n elements in aux_buf1
   n = sendcount;        // buffer size per process
   op = MPI_BOR;
+  if (!pgmpi_count_fits_int((MPI_Count)size * n * type_extent)) {   // reduced as bytes
+    return MPI_ERR_COUNT;
+  }
   count = size * n;
   fake_buf_size = count * type_extent;
 
@@ -159,10 +167,114 @@ int MPI_Gather_as_Reduce(const void* sendbuf, int sendcount, MPI_Datatype sendty
 
   memset(aux_buf1, 0, fake_buf_size);
   // copy sendbuf to the block corresponding to the current rank
-  memcpy((char*)aux_buf1 + (rank * n * type_extent), sendbuf, n * type_extent);
+  memcpy((char*)aux_buf1 + ((MPI_Aint)rank * n * type_extent), sendbuf, n * type_extent);
 
   PGMPI(MPI_Reduce(aux_buf1, recvbuf, fake_buf_size, MPI_CHAR, op, root, comm));
 
   release_msg_buffers();
   return MPI_SUCCESS;
 }
+
+#if MPI_VERSION >= 4
+/*
+ * large-count mock-ups of MPI-4, used when the counts (or the counts derived from
+ * them) do not fit into an int
+ */
+int MPI_Gather_as_Allgather_c(const void* sendbuf, MPI_Count sendcount, MPI_Datatype sendtype,
+                              void* recvbuf, MPI_Count recvcount, MPI_Datatype recvtype,
+                              int root, MPI_Comm comm) {
+  int buf_status = BUF_NO_ERROR;
+  int rank, size;
+  MPI_Aint type_extent, lb;
+  size_t fake_buf_size;
+  void *aux_buf1;
+
+  ZF_LOGV("Calling MPI_Gather_as_Allgather_c");
+
+  MPI_Comm_rank(comm, &rank);
+  MPI_Comm_size(comm, &size);
+  MPI_Type_get_extent(sendtype, &lb, &type_extent);
+
+  fake_buf_size = size * sendcount * type_extent;
+  buf_status = grab_msg_buffer_1(fake_buf_size, &aux_buf1);
+  if (buf_status != BUF_NO_ERROR) {
+    return MPI_ERR_NO_MEM;
+  }
+
+  // the receive buffer is only allocated on the root
+  PGMPI(MPI_Allgather_c(sendbuf, sendcount, sendtype, (rank == root) ? recvbuf : aux_buf1, recvcount, recvtype,
+                        comm));
+
+  release_msg_buffers();
+  return MPI_SUCCESS;
+}
+
+int MPI_Gather_as_Gatherv_c(const void* sendbuf, MPI_Count sendcount, MPI_Datatype sendtype,
+                            void* recvbuf, MPI_Count recvcount, MPI_Datatype recvtype,
+                            int root, MPI_Comm comm) {
+  int i;
+  MPI_Count *recvcounts;
+  MPI_Aint *displs;
+  int buf_status = BUF_NO_ERROR;
+  int *aux_int_buf1, *aux_int_buf2;
+  int size;
+
+  ZF_LOGV("Calling MPI_Gather_as_Gatherv_c");
+
+  MPI_Comm_size(comm, &size);
+
+  // the int buffers hold size counts and size displacements
+  buf_status = grab_int_buffer_1(size * sizeof(MPI_Count), &aux_int_buf1);
+  if (buf_status != BUF_NO_ERROR) {
+    return MPI_ERR_NO_MEM;
+  }
+  buf_status = grab_int_buffer_2(size * sizeof(MPI_Aint), &aux_int_buf2);
+  if (buf_status != BUF_NO_ERROR) {
+    release_int_buffers();
+    return MPI_ERR_NO_MEM;
+  }
+
+  recvcounts = (MPI_Count*)aux_int_buf1;
+  displs = (MPI_Aint*)aux_int_buf2;
+  for (i=0; i < size; i++) {
+    recvcounts[i] = sendcount;
+    displs[i] = i * sendcount;
+  }
+
+  PGMPI(MPI_Gatherv_c(sendbuf, sendcount, sendtype, recvbuf, recvcounts, displs, recvtype, root, comm));
+
+  release_int_buffers();
+  return MPI_SUCCESS;
+}
+
+int MPI_Gather_as_Reduce_c(const void* sendbuf, MPI_Count sendcount, MPI_Datatype sendtype,
+                           void* recvbuf, MPI_Count recvcount, MPI_Datatype recvtype,
+                           int root, MPI_Comm comm) {
+  int buf_status = BUF_NO_ERROR;
+  int rank, size;
+  MPI_Aint type_extent, lb;
+  size_t fake_buf_size;
+  void *aux_buf1;
+
+  ZF_LOGV("Calling MPI_Gather_as_Reduce_c");
+
+  MPI_Comm_rank(comm, &rank);
+  MPI_Comm_size(comm, &size);
+  MPI_Type_get_extent(sendtype, &lb, &type_extent);
+
+  fake_buf_size = size * sendcount * type_extent;
+  buf_status = grab_msg_buffer_1(fake_buf_size, &aux_buf1);
+  if (buf_status != BUF_NO_ERROR) {
+    return MPI_ERR_NO_MEM;
+  }
+
+  memset(aux_buf1, 0, fake_buf_size);
+  // copy sendbuf to the block corresponding to the current rank
+  memcpy((char*)aux_buf1 + rank * sendcount * type_extent, sendbuf, sendcount * type_extent);
+
+  PGMPI(MPI_Reduce_c(aux_buf1, recvbuf, (MPI_Count)fake_buf_size, MPI_CHAR, MPI_BOR, root, comm));
+
+  release_msg_buffers();
+  return MPI_SUCCESS;
+}
+#endif
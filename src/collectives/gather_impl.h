@@ -17,4 +17,18 @@ int MPI_Gather_as_Reduce(const void* sendbuf, int sendcount, MPI_Datatype sendty
                          int root, MPI_Comm comm);
 
 
+#if MPI_VERSION >= 4
+int MPI_Gather_as_Allgather_c(const void* sendbuf, MPI_Count sendcount, MPI_Datatype sendtype,
+                              void* recvbuf, MPI_Count recvcount, MPI_Datatype recvtype,
+                              int root, MPI_Comm comm);
+
+int MPI_Gather_as_Gatherv_c(const void* sendbuf, MPI_Count sendcount, MPI_Datatype sendtype,
+                            void* recvbuf, MPI_Count recvcount, MPI_Datatype recvtype,
+                            int root, MPI_Comm comm);
+
+int MPI_Gather_as_Reduce_c(const void* sendbuf, MPI_Count sendcount, MPI_Datatype sendtype,
+                           void* recvbuf, MPI_Count recvcount, MPI_Datatype recvtype,
+                           int root, MPI_Comm comm);
+#endif
+
 #endif /* SRC_COLLECTIVES_GATHER_IMPL_H_ */
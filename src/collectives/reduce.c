@@ -35,12 +35,28 @@
 #include "pgmpi_algid_store.h"
 #include "collective_modules.h"
 #include "util/pgmpi_parse_cli.h"
+#include "util/pgmpi_callsite.h"
+#include "util/pgmpi_skew.h"
+#include "util/pgmpi_nesting.h"
+#include "util/pgmpi_count.h"
 #include "all_guideline_collectives.h"
 
+#ifdef PGMPI_STATIC_TUNING
+#include "pgmpi_static_decisions.h"   /* generated by pgmpi_prf2c */
+#endif
+
 /********************************/
 
 static void parse_arguments(const char *argv);
 static void set_algid(const int algid);
+static void get_buf_req(const int algid, const MPI_Count msg_size, MPI_Datatype datatype, const int comm_size,
+    pgmpi_buf_req_t *req);
+static int call_mockup(const int algid, const void *sendbuf, void *recvbuf, int count, MPI_Datatype datatype,
+    MPI_Op op, int root, MPI_Comm comm);
+#if MPI_VERSION >= 4
+static int call_mockup_c(const int algid, const void *sendbuf, void *recvbuf, MPI_Count count, MPI_Datatype datatype,
+    MPI_Op op, int root, MPI_Comm comm);
+#endif
 
 /********************************/
 
@@ -100,34 +116,43 @@ static void set_algid(const int algid) {
   }
 }
 
-void register_module_reduce(module_t *module) {
-  module->cli_prefix  = "reduce";
-  module->mpiname     = "MPI_Reduce";
-  module->cid         = CID_MPI_REDUCE;
-  module->parse       = &parse_arguments;
-  module->alg_choices = &module_choices;
-  module->set_algid   = &set_algid;
-  module->is_rooted   = 1;
-}
-
-void deregister_module_reduce(module_t *module) {
-}
+/*
+ * buffers the mock-ups take from the buffer manager (see the *_impl.c files)
+ */
+static void get_buf_req(const int algid, const MPI_Count msg_size, MPI_Datatype datatype, const int comm_size,
+    pgmpi_buf_req_t *req) {
+  MPI_Aint lb, extent;
 
+  MPI_Type_get_extent(datatype, &lb, &extent);
+  if( extent <= 0 ) {
+    return;
+  }
 
-int MPI_Reduce(const void* sendbuf, void* recvbuf, int count, MPI_Datatype datatype, MPI_Op op, int root, MPI_Comm comm) {
+  switch (algid) {
+  case REDUCE_AS_ALLREDUCE:
+    req->msg_bytes = msg_size;
+    break;
+  case REDUCE_AS_REDUCESCATTERBLOCK_GATHER:
+    req->msg_bytes = pgmpi_buf_padded_scatter_bytes(msg_size / extent, extent, comm_size);
+    break;
+  case REDUCE_AS_REDUCESCATTER_GATHERV:
+    req->msg_bytes = Reduce_scatter_Gatherv_buf_bytes(msg_size / extent, extent, comm_size);
+    req->int_bytes = 2 * pgmpi_count_array_bytes(msg_size / extent, comm_size);
+    break;
+  case REDUCE_AS_REDUCESCATTER:
+    req->int_bytes = pgmpi_count_array_bytes(msg_size / extent, comm_size);
+    break;
+  default:
+    // no buffers needed
+    break;
+  }
+}
 
+static int call_mockup(const int algid, const void *sendbuf, void *recvbuf, int count, MPI_Datatype datatype,
+    MPI_Op op, int root, MPI_Comm comm) {
   int ret_status = MPI_SUCCESS;
-  int call_default = 0;
-  int size;
-
-  ZF_LOGV("Intercepting MPI_Reduce");
 
-  MPI_Comm_size(comm, &size);
-  if (get_pgmpi_context() == CONTEXT_TUNED) {
-    (void) pgtune_get_algorithm(CID_MPI_REDUCE, pgmpi_convert_type_count_2_bytes(count, datatype), size, &alg_id);
-  }
-
-  switch (alg_id) {
+  switch (algid) {
   case REDUCE_AS_ALLREDUCE:
     ret_status = MPI_Reduce_as_Allreduce(sendbuf, recvbuf, count, datatype, op, root, comm);
     break;
@@ -157,27 +182,175 @@ int MPI_Reduce(const void* sendbuf, void* recvbuf, int count, MPI_Datatype datat
     break;
 #endif
   case REDUCE_DEFAULT:
-    call_default = 1;
+    ret_status = MPI_ERR_OTHER;   // not a mock-up
     break;
   default:   // call the original function
-    ZF_LOGW("cannot find alg id %d, using default", alg_id);
-    call_default = 1;
+    ZF_LOGW("cannot find alg id %d, using default", algid);
+    ret_status = MPI_ERR_OTHER;
   }
 
-  if (ret_status != MPI_SUCCESS) {
-    call_default = 1;
+  return ret_status;
+}
+
+#if MPI_VERSION >= 4
+/*
+ * large-count mock-ups, the algorithms of other libraries only take int counts
+ */
+static int call_mockup_c(const int algid, const void *sendbuf, void *recvbuf, MPI_Count count, MPI_Datatype datatype,
+    MPI_Op op, int root, MPI_Comm comm) {
+  int ret_status = MPI_SUCCESS;
+
+  switch (algid) {
+  case REDUCE_AS_ALLREDUCE:
+    ret_status = MPI_Reduce_as_Allreduce_c(sendbuf, recvbuf, count, datatype, op, root, comm);
+    break;
+  case REDUCE_AS_REDUCESCATTERBLOCK_GATHER:
+    ret_status = MPI_Reduce_as_Reduce_scatter_block_Gather_c(sendbuf, recvbuf, count, datatype, op, root, comm);
+    break;
+  case REDUCE_AS_REDUCESCATTER_GATHERV:
+    ret_status = MPI_Reduce_as_Reduce_scatter_Gatherv_c(sendbuf, recvbuf, count, datatype, op, root, comm);
+    break;
+  case REDUCE_AS_REDUCESCATTER:
+    ret_status = MPI_Reduce_as_Reduce_scatter_c(sendbuf, recvbuf, count, datatype, op, root, comm);
+    break;
+  case REDUCE_DEFAULT:
+    ret_status = MPI_ERR_OTHER;   // not a mock-up
+    break;
+  default:   // call the original function
+    ret_status = MPI_ERR_OTHER;
   }
 
+  return ret_status;
+}
+#endif
+
+void register_module_reduce(module_t *module) {
+  module->cli_prefix  = "reduce";
+  module->mpiname     = "MPI_Reduce";
+  module->cid         = CID_MPI_REDUCE;
+  module->parse       = &parse_arguments;
+  module->alg_choices = &module_choices;
+  module->set_algid   = &set_algid;
+  module->is_rooted   = 1;
+  module->get_buf_req = &get_buf_req;
+}
+
+void deregister_module_reduce(module_t *module) {
+}
+
+
+int MPI_Reduce(const void* sendbuf, void* recvbuf, int count, MPI_Datatype datatype, MPI_Op op, int root, MPI_Comm comm) {
+
+  int call_default = 0;
+  int measure = 0;
+  double t_start = 0;
+
+  ZF_LOGV("Intercepting MPI_Reduce");
+  PGMPI_CALLSITE_ENTER();
+  PGMPI_NESTING_ENTER();
+  PGMPI_SKEW_ENTER(CID_MPI_REDUCE, comm);
+
+#ifdef PGMPI_STATIC_TUNING
+  alg_id = pgmpi_static_select(CID_MPI_REDUCE, pgmpi_convert_type_count_2_bytes(count, datatype), datatype,
+      op, comm);
+#else
+  if( get_pgmpi_context() != CONTEXT_CLI ) {
+    measure = (pgtune_get_algorithm(CID_MPI_REDUCE, pgmpi_convert_type_count_2_bytes(count, datatype), datatype, op,
+        comm, &alg_id) == PGMPI_ALG_MEASURE);
+  }
+#endif
+
+  if( measure ) {
+    t_start = MPI_Wtime();
+  }
+
+  call_default = (call_mockup(alg_id, sendbuf, recvbuf, count, datatype, op, root, comm) != MPI_SUCCESS);
+
   if (call_default == 1) {
     ZF_LOGV("Calling PMPI_Reduce");
     PMPI_Reduce(sendbuf, recvbuf, count, datatype, op, root, comm);
   }
 
+  PGMPI_SKEW_EXIT();
+  // nested collectives of the mock-up may have changed the current call site
+  PGMPI_CALLSITE_ENTER();
+
+  // a fallback ran the default algorithm
+  if( measure ) {
+    pgtune_report_time(CID_MPI_REDUCE, pgmpi_convert_type_count_2_bytes(count, datatype), comm,
+        call_default ? 0 : alg_id, MPI_Wtime() - t_start);
+  }
+
   if (PGMPI_ENABLE_ALGID_STORING) {
     pgmpi_save_algid_for_msg_size(CID_MPI_REDUCE, pgmpi_convert_type_count_2_bytes(count, datatype), alg_id,
         call_default);
   }
 
+  PGMPI_NESTING_EXIT();
   return MPI_SUCCESS;
 }
 
+#if MPI_VERSION >= 4
+/*
+ * large-count binding of MPI-4, counts that do not fit into an int go to the large-count mock-ups
+ */
+int MPI_Reduce_c(const void* sendbuf, void* recvbuf, MPI_Count count, MPI_Datatype datatype, MPI_Op op, int root, MPI_Comm comm) {
+
+  int call_default = 0;
+  int ret_status;
+  int measure = 0;
+  double t_start = 0;
+
+  ZF_LOGV("Intercepting MPI_Reduce_c");
+  PGMPI_CALLSITE_ENTER();
+  PGMPI_NESTING_ENTER();
+  PGMPI_SKEW_ENTER(CID_MPI_REDUCE, comm);
+
+#ifdef PGMPI_STATIC_TUNING
+  alg_id = pgmpi_static_select(CID_MPI_REDUCE, pgmpi_convert_type_count_2_bytes(count, datatype), datatype,
+      op, comm);
+#else
+  if( get_pgmpi_context() != CONTEXT_CLI ) {
+    measure = (pgtune_get_algorithm(CID_MPI_REDUCE, pgmpi_convert_type_count_2_bytes(count, datatype), datatype, op,
+        comm, &alg_id) == PGMPI_ALG_MEASURE);
+  }
+#endif
+
+  if( measure ) {
+    t_start = MPI_Wtime();
+  }
+
+  // use the large-count mock-ups if the int ones cannot take the counts (or the counts derived from them)
+  ret_status = MPI_ERR_COUNT;
+  if( pgmpi_count_fits_int(count) ) {
+    ret_status = call_mockup(alg_id, sendbuf, recvbuf, (int)count, datatype, op, root, comm);
+  }
+  if( ret_status == MPI_ERR_COUNT ) {
+    ret_status = call_mockup_c(alg_id, sendbuf, recvbuf, count, datatype, op, root, comm);
+  }
+  call_default = (ret_status != MPI_SUCCESS);
+
+  if (call_default == 1) {
+    ZF_LOGV("Calling PMPI_Reduce_c");
+    PMPI_Reduce_c(sendbuf, recvbuf, count, datatype, op, root, comm);
+  }
+
+  PGMPI_SKEW_EXIT();
+  // nested collectives of the mock-up may have changed the current call site
+  PGMPI_CALLSITE_ENTER();
+
+  // a fallback ran the default algorithm
+  if( measure ) {
+    pgtune_report_time(CID_MPI_REDUCE, pgmpi_convert_type_count_2_bytes(count, datatype), comm,
+        call_default ? 0 : alg_id, MPI_Wtime() - t_start);
+  }
+
+  if (PGMPI_ENABLE_ALGID_STORING) {
+    pgmpi_save_algid_for_msg_size(CID_MPI_REDUCE, pgmpi_convert_type_count_2_bytes(count, datatype), alg_id,
+        call_default);
+  }
+
+  PGMPI_NESTING_EXIT();
+  return MPI_SUCCESS;
+}
+#endif
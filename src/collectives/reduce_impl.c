@@ -37,6 +37,19 @@
 
 static const int MIN_SCATTER_CHUNK_SIZE = 4; // number of elements
 
+size_t Reduce_scatter_Gatherv_buf_bytes(const MPI_Count count, const MPI_Aint extent, const int size) {
+  MPI_Count nchunks = count / MIN_SCATTER_CHUNK_SIZE;
+  MPI_Count block;
+
+  // block of process 0, the largest one (see MPI_Reduce_as_Reduce_scatter_Gatherv)
+  block = MIN_SCATTER_CHUNK_SIZE * (nchunks / size);
+  if( 0 < nchunks % size ) {
+    block += MIN_SCATTER_CHUNK_SIZE;
+  } else {
+    block += count % MIN_SCATTER_CHUNK_SIZE;
+  }
+  return block * extent;
+}
 
 int MPI_Reduce_as_Allreduce(const void* sendbuf, void* recvbuf, int count, MPI_Datatype datatype, MPI_Op op, int root,
     MPI_Comm comm) {
@@ -102,7 +115,7 @@ int MPI_Reduce_as_Reduce_scatter_block_Gather(const void* sendbuf, void* recvbuf
     n_padding_elems = size - (n % size);
   }
 
-  fake_buf_size1 = (n + n_padding_elems) * type_extent;       // max size for the padded buffer
+  fake_buf_size1 = ((MPI_Aint)n + n_padding_elems) * type_extent;       // max size for the padded buffer
   ZF_LOGV("fake_buf_size1: %zu", fake_buf_size1);
   buf_status = grab_msg_buffer_1(fake_buf_size1, &aux_buf1);
   ZF_LOGV("fake buffer 1 points to %p", aux_buf1);
@@ -262,3 +275,183 @@ int MPI_Reduce_as_Reduce_scatter(const void* sendbuf, void* recvbuf, int count,
   return ret;
 }
 
+
+#if MPI_VERSION >= 4
+/*
+ * large-count mock-ups of MPI-4, used when the count does not fit into an int
+ */
+int MPI_Reduce_as_Allreduce_c(const void* sendbuf, void* recvbuf, MPI_Count count, MPI_Datatype datatype, MPI_Op op,
+    int root, MPI_Comm comm) {
+  int ret = BUF_NO_ERROR;
+  int rank;
+  MPI_Aint type_extent, lb;
+  void *aux_buf1;
+
+  ZF_LOGV("Calling MPI_Reduce_as_Allreduce_c");
+
+  MPI_Comm_rank(comm, &rank);
+  MPI_Type_get_extent(datatype, &lb, &type_extent);
+
+  ret = grab_msg_buffer_1(count * type_extent, &aux_buf1);
+  if (ret != BUF_NO_ERROR) {
+    return MPI_ERR_NO_MEM;
+  }
+
+  // the receive buffer is only allocated on the root
+  PGMPI(MPI_Allreduce_c(sendbuf, (rank == root) ? recvbuf : aux_buf1, count, datatype, op, comm));
+
+  release_msg_buffers();
+  return MPI_SUCCESS;
+}
+
+int MPI_Reduce_as_Reduce_scatter_block_Gather_c(const void* sendbuf, void* recvbuf, MPI_Count count,
+    MPI_Datatype datatype, MPI_Op op, int root, MPI_Comm comm) {
+  MPI_Count n, i;
+  MPI_Count n_padding_elems;
+  MPI_Count scattered_count;
+  int rank, size;
+  MPI_Aint type_extent, lb;
+  size_t fake_buf_size1, fake_buf_size2;
+  void *aux_buf1, *aux_buf2;
+  int buf_status = BUF_NO_ERROR;
+  MPI_Aint padding_offset;
+
+  MPI_Comm_rank(comm, &rank);
+  MPI_Comm_size(comm, &size);
+  MPI_Type_get_extent(datatype, &lb, &type_extent);
+
+  ZF_LOGV("Calling MPI_Reduce_as_Reduce_scatter_block_Gather_c");
+
+  n = count;            // buffer size per process
+  if (n % size == 0) {
+    n_padding_elems = 0;
+  } else {
+    n_padding_elems = size - (n % size);
+  }
+
+  fake_buf_size1 = (n + n_padding_elems) * type_extent;       // max size for the padded buffer
+  buf_status = grab_msg_buffer_1(fake_buf_size1, &aux_buf1);
+  if (buf_status != BUF_NO_ERROR) {
+    return MPI_ERR_NO_MEM;
+  }
+  fake_buf_size2 = fake_buf_size1 / size;       // max size for the scattered buffer per process
+  buf_status = grab_msg_buffer_2(fake_buf_size2, &aux_buf2);
+  if (buf_status != BUF_NO_ERROR) {
+    release_msg_buffers();
+    return MPI_ERR_NO_MEM;
+  }
+
+  scattered_count = fake_buf_size2 / type_extent;
+
+  // padded send buffer, the padding repeats the first element of sendbuf
+  memcpy(aux_buf1, sendbuf, n * type_extent);
+  padding_offset = n * type_extent;
+  for (i=0; i<n_padding_elems; i++) {
+    memcpy((char*)aux_buf1 + padding_offset, sendbuf, type_extent);
+    padding_offset += type_extent;
+  }
+
+  PGMPI(MPI_Reduce_scatter_block_c(aux_buf1, aux_buf2, scattered_count, datatype, op, comm));
+  PGMPI(MPI_Gather_c(aux_buf2, scattered_count, datatype, aux_buf1, scattered_count, datatype, root, comm));
+
+  if (rank == root) {
+    memcpy(recvbuf, aux_buf1, n * type_extent);
+  }
+
+  release_msg_buffers();
+  return MPI_SUCCESS;
+}
+
+int MPI_Reduce_as_Reduce_scatter_Gatherv_c(const void* sendbuf, void* recvbuf, MPI_Count count,
+    MPI_Datatype datatype, MPI_Op op, int root, MPI_Comm comm) {
+  MPI_Count n;
+  MPI_Count nchunks;
+  int i;
+  MPI_Count *recvcounts;
+  MPI_Aint *displs;
+  int rank, size;
+  MPI_Aint type_extent, lb;
+  int *aux_int_buf1, *aux_int_buf2;
+  void *aux_buf1;
+  int buf_status = BUF_NO_ERROR;
+
+  MPI_Comm_rank(comm, &rank);
+  MPI_Comm_size(comm, &size);
+  MPI_Type_get_extent(datatype, &lb, &type_extent);
+
+  ZF_LOGV("Calling MPI_Reduce_as_Reduce_scatter_Gatherv_c");
+
+  // the int buffers hold size counts and size displacements
+  n = count;            // buffer size per process
+  buf_status = grab_int_buffer_1(size * sizeof(MPI_Count), &aux_int_buf1);
+  if (buf_status != BUF_NO_ERROR) {
+    return MPI_ERR_NO_MEM;
+  }
+  buf_status = grab_int_buffer_2(size * sizeof(MPI_Aint), &aux_int_buf2);
+  if (buf_status != BUF_NO_ERROR) {
+    release_int_buffers();
+    return MPI_ERR_NO_MEM;
+  }
+  recvcounts = (MPI_Count*)aux_int_buf1;
+  displs = (MPI_Aint*)aux_int_buf2;
+
+  // same blocks as MPI_Reduce_as_Reduce_scatter_Gatherv
+  nchunks = n / MIN_SCATTER_CHUNK_SIZE;
+  for (i = 0; i < size; i++) {
+    recvcounts[i] = MIN_SCATTER_CHUNK_SIZE * (nchunks/size);
+
+    if (i < nchunks % size) {
+      recvcounts[i] += MIN_SCATTER_CHUNK_SIZE;
+    } else if (i == nchunks % size ) {
+      recvcounts[i] += n % MIN_SCATTER_CHUNK_SIZE;
+    }
+  }
+
+  // the block of process 0 is the largest one, so all processes obtain the same buf_status
+  buf_status = grab_msg_buffer_1(recvcounts[0] * type_extent, &aux_buf1);
+  if (buf_status != BUF_NO_ERROR) {
+    release_int_buffers();
+    return MPI_ERR_NO_MEM;
+  }
+
+  PGMPI(MPI_Reduce_scatter_c(sendbuf, aux_buf1, recvcounts, datatype, op, comm));
+
+  displs[0] = 0;
+  for (i = 1; i < size; i++) {
+    displs[i] = displs[i - 1] + recvcounts[i - 1];
+  }
+
+  PGMPI(MPI_Gatherv_c(aux_buf1, recvcounts[rank], datatype, recvbuf, recvcounts, displs, datatype, root, comm));
+
+  release_msg_buffers();
+  release_int_buffers();
+  return MPI_SUCCESS;
+}
+
+int MPI_Reduce_as_Reduce_scatter_c(const void* sendbuf, void* recvbuf, MPI_Count count, MPI_Datatype datatype,
+                                   MPI_Op op, int root, MPI_Comm comm) {
+  int i, size;
+  int ret;
+  MPI_Count *recvcounts;
+  int *aux_int_buf;
+  int buf_status = BUF_NO_ERROR;
+
+  MPI_Comm_size(comm, &size);
+
+  ZF_LOGV("Calling MPI_Reduce_as_Reduce_scatter_c");
+
+  buf_status = grab_int_buffer_1(size * sizeof(MPI_Count), &aux_int_buf);
+  if (buf_status != BUF_NO_ERROR) {
+    return MPI_ERR_NO_MEM;
+  }
+
+  recvcounts = (MPI_Count*)aux_int_buf;
+  for(i=0; i<size; i++) recvcounts[i] = 0;
+  recvcounts[root] = count;
+
+  ret = PGMPI(MPI_Reduce_scatter_c(sendbuf, recvbuf, recvcounts, datatype, op, comm));
+
+  release_int_buffers();
+  return ret;
+}
+#endif
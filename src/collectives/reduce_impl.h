@@ -15,4 +15,24 @@ int MPI_Reduce_as_Reduce_scatter_Gatherv(const void* sendbuf, void* recvbuf, int
 
 int MPI_Reduce_as_Reduce_scatter(const void* sendbuf, void* recvbuf, int count, MPI_Datatype datatype,
                                  MPI_Op op, int root, MPI_Comm comm);
+
+/*!
+  \return bytes of the message buffer of MPI_Reduce_as_Reduce_scatter_Gatherv
+*/
+size_t Reduce_scatter_Gatherv_buf_bytes(const MPI_Count count, const MPI_Aint extent, const int size);
+
+#if MPI_VERSION >= 4
+int MPI_Reduce_as_Allreduce_c(const void* sendbuf, void* recvbuf, MPI_Count count, MPI_Datatype datatype, MPI_Op op,
+    int root, MPI_Comm comm);
+
+int MPI_Reduce_as_Reduce_scatter_block_Gather_c(const void* sendbuf, void* recvbuf, MPI_Count count,
+    MPI_Datatype datatype, MPI_Op op, int root, MPI_Comm comm);
+
+int MPI_Reduce_as_Reduce_scatter_Gatherv_c(const void* sendbuf, void* recvbuf, MPI_Count count,
+    MPI_Datatype datatype, MPI_Op op, int root, MPI_Comm comm);
+
+int MPI_Reduce_as_Reduce_scatter_c(const void* sendbuf, void* recvbuf, MPI_Count count, MPI_Datatype datatype,
+                                   MPI_Op op, int root, MPI_Comm comm);
+#endif
+
 #endif /* SRC_COLLECTIVES_REDUCE_IMPL_H_ */
@@ -32,6 +32,7 @@
 #include "log/zf_log.h"
 
 #include "bufmanager/pgmpi_buf.h"
+#include "util/pgmpi_count.h"
 #include "reduce_scatter_block_impl.h"
 
 static const int mockup_root_rank = 0;
@@ -54,6 +55,9 @@ int MPI_Reduce_scatter_block_as_Reduce_Scatter(const void* sendbuf, void* recvbu
   ZF_LOGV("Calling MPI_Reduce_scatter_block_as_Reduce_Scatter");
 
   n = recvcount;  // block size scattered per process
+  if (!pgmpi_count_fits_int((MPI_Count)size * n)) {
+    return MPI_ERR_COUNT;
+  }
   count = size * n;
   fake_buf_size = count * type_extent;
 
@@ -134,6 +138,9 @@ int MPI_Reduce_scatter_block_as_Allreduce(const void* sendbuf, void* recvbuf, co
   n = recvcount;  // block size scattered per process
   recvbuf_size = n * type_extent;
 
+  if (!pgmpi_count_fits_int((MPI_Count)size * n)) {
+    return MPI_ERR_COUNT;
+  }
   count = size * n;
   fake_buf_size = count * type_extent;
 
@@ -153,3 +160,89 @@ int MPI_Reduce_scatter_block_as_Allreduce(const void* sendbuf, void* recvbuf, co
   release_msg_buffers();
   return MPI_SUCCESS;
 }
+
+#if MPI_VERSION >= 4
+/*
+ * large-count mock-ups of MPI-4, used when the counts (or the counts derived from
+ * them) do not fit into an int
+ */
+int MPI_Reduce_scatter_block_as_Reduce_Scatter_c(const void* sendbuf, void* recvbuf, const MPI_Count recvcount,
+    MPI_Datatype datatype, MPI_Op op, MPI_Comm comm) {
+  int size;
+  MPI_Aint type_extent, lb;
+  void *aux_buf1;
+  int buf_status = BUF_NO_ERROR;
+
+  MPI_Comm_size(comm, &size);
+  MPI_Type_get_extent(datatype, &lb, &type_extent);
+
+  ZF_LOGV("Calling MPI_Reduce_scatter_block_as_Reduce_Scatter_c");
+
+  buf_status = grab_msg_buffer_1(size * recvcount * type_extent, &aux_buf1);
+  if (buf_status != BUF_NO_ERROR) {
+    return MPI_ERR_NO_MEM;
+  }
+
+  // reduce entire buffer to root, then scatter the block of each process
+  PGMPI(MPI_Reduce_c(sendbuf, aux_buf1, size * recvcount, datatype, op, mockup_root_rank, comm));
+  PGMPI(MPI_Scatter_c(aux_buf1, recvcount, datatype, recvbuf, recvcount, datatype, mockup_root_rank, comm));
+
+  release_msg_buffers();
+  return MPI_SUCCESS;
+}
+
+int MPI_Reduce_scatter_block_as_Reduce_scatter_c(const void* sendbuf, void* recvbuf, const MPI_Count recvcount,
+    MPI_Datatype datatype, MPI_Op op, MPI_Comm comm) {
+  int size, i;
+  int *aux_int_buf;
+  MPI_Count *recvcounts;
+  int buf_status = BUF_NO_ERROR;
+
+  MPI_Comm_size(comm, &size);
+
+  ZF_LOGV("Calling MPI_Reduce_scatter_block_as_Reduce_scatter_c");
+
+  buf_status = grab_int_buffer_1(size * sizeof(MPI_Count), &aux_int_buf);
+  if (buf_status != BUF_NO_ERROR) {
+    return MPI_ERR_NO_MEM;
+  }
+
+  recvcounts = (MPI_Count*)aux_int_buf;
+  for (i = 0; i < size; i++) {
+    recvcounts[i] = recvcount;
+  }
+
+  PGMPI(MPI_Reduce_scatter_c(sendbuf, recvbuf, recvcounts, datatype, op, comm));
+
+  release_int_buffers();
+  return MPI_SUCCESS;
+}
+
+int MPI_Reduce_scatter_block_as_Allreduce_c(const void* sendbuf, void* recvbuf, const MPI_Count recvcount,
+    MPI_Datatype datatype, MPI_Op op, MPI_Comm comm) {
+  int size, rank;
+  MPI_Aint type_extent, lb;
+  size_t recvbuf_size;
+  void *aux_buf1;
+  int buf_status = BUF_NO_ERROR;
+
+  MPI_Comm_rank(comm, &rank);
+  MPI_Comm_size(comm, &size);
+  MPI_Type_get_extent(datatype, &lb, &type_extent);
+
+  ZF_LOGV("Calling MPI_Reduce_scatter_block_as_Allreduce_c");
+
+  recvbuf_size = recvcount * type_extent;
+  buf_status = grab_msg_buffer_1(size * recvbuf_size, &aux_buf1);
+  if (buf_status != BUF_NO_ERROR) {
+    return MPI_ERR_NO_MEM;
+  }
+
+  PGMPI(MPI_Allreduce_c(sendbuf, aux_buf1, size * recvcount, datatype, op, comm));
+
+  memcpy(recvbuf, (char*)(aux_buf1) + rank * recvbuf_size, recvbuf_size);
+
+  release_msg_buffers();
+  return MPI_SUCCESS;
+}
+#endif
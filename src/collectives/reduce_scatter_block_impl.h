@@ -14,4 +14,15 @@ int MPI_Reduce_scatter_block_as_Allreduce(const void* sendbuf, void* recvbuf, co
     MPI_Datatype datatype, MPI_Op op, MPI_Comm comm);
 
 
+#if MPI_VERSION >= 4
+int MPI_Reduce_scatter_block_as_Reduce_Scatter_c(const void* sendbuf, void* recvbuf, const MPI_Count recvcount,
+    MPI_Datatype datatype, MPI_Op op, MPI_Comm comm);
+
+int MPI_Reduce_scatter_block_as_Reduce_scatter_c(const void* sendbuf, void* recvbuf, const MPI_Count recvcount,
+    MPI_Datatype datatype, MPI_Op op, MPI_Comm comm);
+
+int MPI_Reduce_scatter_block_as_Allreduce_c(const void* sendbuf, void* recvbuf, const MPI_Count recvcount,
+    MPI_Datatype datatype, MPI_Op op, MPI_Comm comm);
+#endif
+
 #endif /* SRC_COLLECTIVES_REDUCE_SCATTER_BLOCK_IMPL_H_ */
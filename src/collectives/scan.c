@@ -35,12 +35,26 @@
 #include "pgmpi_algid_store.h"
 #include "collective_modules.h"
 #include "util/pgmpi_parse_cli.h"
+#include "util/pgmpi_callsite.h"
+#include "util/pgmpi_skew.h"
+#include "util/pgmpi_nesting.h"
+#include "util/pgmpi_count.h"
 #include "all_guideline_collectives.h"
 
+#ifdef PGMPI_STATIC_TUNING
+#include "pgmpi_static_decisions.h"   /* generated by pgmpi_prf2c */
+#endif
+
 /********************************/
 
 static void parse_arguments(const char *argv);
 static void set_algid(const int algid);
+static int call_mockup(const int algid, const void *sendbuf, void *recvbuf, int count, MPI_Datatype datatype,
+    MPI_Op op, MPI_Comm comm);
+#if MPI_VERSION >= 4
+static int call_mockup_c(const int algid, const void *sendbuf, void *recvbuf, MPI_Count count, MPI_Datatype datatype,
+    MPI_Op op, MPI_Comm comm);
+#endif
 
 /********************************/
 
@@ -86,6 +100,56 @@ static void set_algid(const int algid) {
   }
 }
 
+static int call_mockup(const int algid, const void *sendbuf, void *recvbuf, int count, MPI_Datatype datatype,
+    MPI_Op op, MPI_Comm comm) {
+  int ret_status = MPI_SUCCESS;
+
+  switch (algid) {
+  case SCAN_AS_EXSCAN_REDUCELOCAL:
+    ret_status = MPI_Scan_as_Exscan_Reduce_local(sendbuf, recvbuf, count, datatype, op, comm);
+    break;
+#ifdef HAVE_LANE_COLL
+  case SCAN_AS_SCAN_HIER:
+    ret_status = Scan_hier(sendbuf, recvbuf, count, datatype, op, comm);
+    break;
+  case SCAN_AS_SCAN_LANE:
+    ret_status = Scan_lane(sendbuf, recvbuf, count, datatype, op, comm);
+    break;
+#endif
+  case SCAN_DEFAULT:
+    ret_status = MPI_ERR_OTHER;   // not a mock-up
+    break;
+  default:   // call the original function
+    ZF_LOGW("cannot find alg id %d, using default", algid);
+    ret_status = MPI_ERR_OTHER;
+  }
+
+  return ret_status;
+}
+
+#if MPI_VERSION >= 4
+/*
+ * large-count mock-ups, the algorithms of other libraries only take int counts
+ */
+static int call_mockup_c(const int algid, const void *sendbuf, void *recvbuf, MPI_Count count, MPI_Datatype datatype,
+    MPI_Op op, MPI_Comm comm) {
+  int ret_status = MPI_SUCCESS;
+
+  switch (algid) {
+  case SCAN_AS_EXSCAN_REDUCELOCAL:
+    ret_status = MPI_Scan_as_Exscan_Reduce_local_c(sendbuf, recvbuf, count, datatype, op, comm);
+    break;
+  case SCAN_DEFAULT:
+    ret_status = MPI_ERR_OTHER;   // not a mock-up
+    break;
+  default:   // call the original function
+    ret_status = MPI_ERR_OTHER;
+  }
+
+  return ret_status;
+}
+#endif
+
 void register_module_scan(module_t *module) {
   module->cli_prefix  = "scan";
   module->mpiname     = "MPI_Scan";
@@ -94,6 +158,7 @@ void register_module_scan(module_t *module) {
   module->alg_choices = &module_choices;
   module->set_algid   = &set_algid;
   module->is_rooted   = 1;
+  module->get_buf_req = NULL;   // the mock-ups need no buffers
 }
 
 void deregister_module_scan(module_t *module) {
@@ -102,52 +167,115 @@ void deregister_module_scan(module_t *module) {
 
 
 int MPI_Scan(const void* sendbuf, void* recvbuf, int count, MPI_Datatype datatype, MPI_Op op, MPI_Comm comm) {
-  int ret_status = MPI_SUCCESS;
   int call_default = 0;
-  int size;
+  int measure = 0;
+  double t_start = 0;
 
   ZF_LOGV("Intercepting MPI_Scan");
+  PGMPI_CALLSITE_ENTER();
+  PGMPI_NESTING_ENTER();
+  PGMPI_SKEW_ENTER(CID_MPI_SCAN, comm);
 
-  MPI_Comm_size(comm, &size);
-
-  if( get_pgmpi_context() == CONTEXT_TUNED ) {
-    (void)pgtune_get_algorithm(CID_MPI_SCAN, pgmpi_convert_type_count_2_bytes(count, datatype), size, &alg_id);
+#ifdef PGMPI_STATIC_TUNING
+  alg_id = pgmpi_static_select(CID_MPI_SCAN, pgmpi_convert_type_count_2_bytes(count, datatype), datatype,
+      op, comm);
+#else
+  if( get_pgmpi_context() != CONTEXT_CLI ) {
+    measure = (pgtune_get_algorithm(CID_MPI_SCAN, pgmpi_convert_type_count_2_bytes(count, datatype), datatype, op,
+        comm, &alg_id) == PGMPI_ALG_MEASURE);
   }
-
-  switch (alg_id) {
-  case SCAN_AS_EXSCAN_REDUCELOCAL:
-    ret_status = MPI_Scan_as_Exscan_Reduce_local(sendbuf, recvbuf, count, datatype, op, comm);
-    break;
-#ifdef HAVE_LANE_COLL
-  case SCAN_AS_SCAN_HIER:
-    ret_status = Scan_hier(sendbuf, recvbuf, count, datatype, op, comm);
-    break;
-  case SCAN_AS_SCAN_LANE:
-    ret_status = Scan_lane(sendbuf, recvbuf, count, datatype, op, comm);
-    break;
 #endif
-  case SCAN_DEFAULT:
-    call_default = 1;
-    break;
-  default:   // call the original function
-    ZF_LOGW("cannot find alg id %d, using default", alg_id);
-    call_default = 1;
-  }
 
-  if (ret_status != MPI_SUCCESS) {
-    call_default = 1;
+  if( measure ) {
+    t_start = MPI_Wtime();
   }
 
+  call_default = (call_mockup(alg_id, sendbuf, recvbuf, count, datatype, op, comm) != MPI_SUCCESS);
+
   if (call_default == 1) {
     ZF_LOGV("Calling PMPI_Scan");
     PMPI_Scan(sendbuf, recvbuf, count, datatype, op, comm);
   }
 
+  PGMPI_SKEW_EXIT();
+  // nested collectives of the mock-up may have changed the current call site
+  PGMPI_CALLSITE_ENTER();
+
+  // a fallback ran the default algorithm
+  if( measure ) {
+    pgtune_report_time(CID_MPI_SCAN, pgmpi_convert_type_count_2_bytes(count, datatype), comm,
+        call_default ? 0 : alg_id, MPI_Wtime() - t_start);
+  }
+
   if (PGMPI_ENABLE_ALGID_STORING) {
     pgmpi_save_algid_for_msg_size(CID_MPI_SCAN, pgmpi_convert_type_count_2_bytes(count, datatype), alg_id,
         call_default);
   }
 
+  PGMPI_NESTING_EXIT();
   return MPI_SUCCESS;
 }
 
+#if MPI_VERSION >= 4
+/*
+ * large-count binding of MPI-4, counts that do not fit into an int go to the large-count mock-ups
+ */
+int MPI_Scan_c(const void* sendbuf, void* recvbuf, MPI_Count count, MPI_Datatype datatype, MPI_Op op, MPI_Comm comm) {
+  int call_default = 0;
+  int ret_status;
+  int measure = 0;
+  double t_start = 0;
+
+  ZF_LOGV("Intercepting MPI_Scan_c");
+  PGMPI_CALLSITE_ENTER();
+  PGMPI_NESTING_ENTER();
+  PGMPI_SKEW_ENTER(CID_MPI_SCAN, comm);
+
+#ifdef PGMPI_STATIC_TUNING
+  alg_id = pgmpi_static_select(CID_MPI_SCAN, pgmpi_convert_type_count_2_bytes(count, datatype), datatype,
+      op, comm);
+#else
+  if( get_pgmpi_context() != CONTEXT_CLI ) {
+    measure = (pgtune_get_algorithm(CID_MPI_SCAN, pgmpi_convert_type_count_2_bytes(count, datatype), datatype, op,
+        comm, &alg_id) == PGMPI_ALG_MEASURE);
+  }
+#endif
+
+  if( measure ) {
+    t_start = MPI_Wtime();
+  }
+
+  // use the large-count mock-ups if the int ones cannot take the counts (or the counts derived from them)
+  ret_status = MPI_ERR_COUNT;
+  if( pgmpi_count_fits_int(count) ) {
+    ret_status = call_mockup(alg_id, sendbuf, recvbuf, (int)count, datatype, op, comm);
+  }
+  if( ret_status == MPI_ERR_COUNT ) {
+    ret_status = call_mockup_c(alg_id, sendbuf, recvbuf, count, datatype, op, comm);
+  }
+  call_default = (ret_status != MPI_SUCCESS);
+
+  if (call_default == 1) {
+    ZF_LOGV("Calling PMPI_Scan_c");
+    PMPI_Scan_c(sendbuf, recvbuf, count, datatype, op, comm);
+  }
+
+  PGMPI_SKEW_EXIT();
+  // nested collectives of the mock-up may have changed the current call site
+  PGMPI_CALLSITE_ENTER();
+
+  // a fallback ran the default algorithm
+  if( measure ) {
+    pgtune_report_time(CID_MPI_SCAN, pgmpi_convert_type_count_2_bytes(count, datatype), comm,
+        call_default ? 0 : alg_id, MPI_Wtime() - t_start);
+  }
+
+  if (PGMPI_ENABLE_ALGID_STORING) {
+    pgmpi_save_algid_for_msg_size(CID_MPI_SCAN, pgmpi_convert_type_count_2_bytes(count, datatype), alg_id,
+        call_default);
+  }
+
+  PGMPI_NESTING_EXIT();
+  return MPI_SUCCESS;
+}
+#endif
@@ -53,3 +53,28 @@ int MPI_Scan_as_Exscan_Reduce_local(const void* sendbuf, void* recvbuf, int coun
   }
   return MPI_SUCCESS;
 }
+
+#if MPI_VERSION >= 4
+/*
+ * large-count mock-up of MPI-4, used when the count does not fit into an int
+ */
+int MPI_Scan_as_Exscan_Reduce_local_c(const void* sendbuf, void* recvbuf, MPI_Count count, MPI_Datatype datatype,
+    MPI_Op op, MPI_Comm comm) {
+  MPI_Aint lb, type_extent;
+  int rank;
+
+  MPI_Comm_rank(comm, &rank);
+  MPI_Type_get_extent(datatype, &lb, &type_extent);
+
+  ZF_LOGV("Calling MPI_Scan_as_Exscan_Reduce_local_c");
+
+  PGMPI(MPI_Exscan_c(sendbuf, recvbuf, count, datatype, op, comm));
+
+  if (rank == 0) {        // recvbuf is not modified by Exscan on process 0
+    memcpy(recvbuf, sendbuf, count * type_extent);
+  } else {
+    PGMPI(MPI_Reduce_local_c(sendbuf, recvbuf, count, datatype, op));
+  }
+  return MPI_SUCCESS;
+}
+#endif
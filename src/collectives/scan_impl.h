@@ -8,4 +8,9 @@ int MPI_Scan_as_Exscan_Reduce_local(const void* sendbuf, void* recvbuf, int coun
     MPI_Comm comm);
 
 
+#if MPI_VERSION >= 4
+int MPI_Scan_as_Exscan_Reduce_local_c(const void* sendbuf, void* recvbuf, MPI_Count count, MPI_Datatype datatype,
+    MPI_Op op, MPI_Comm comm);
+#endif
+
 #endif /* SRC_COLLECTIVES_SCAN_IMPL_H_ */
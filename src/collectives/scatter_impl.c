@@ -32,6 +32,7 @@
 #include "log/zf_log.h"
 
 #include "bufmanager/pgmpi_buf.h"
+#include "util/pgmpi_count.h"
 #include "scatter_impl.h"
 
 
@@ -53,6 +54,9 @@ int MPI_Scatter_as_Bcast(const void* sendbuf, int sendcount, MPI_Datatype sendty
 
   // we need a fake buffer with size * n elements in aux_buf1
   n = sendcount;  // block size scattered per process
+  if (!pgmpi_count_fits_int((MPI_Count)size * n)) {
+    return MPI_ERR_COUNT;
+  }
   count = size * n;
   fake_buf_size = count * type_extent;
 
@@ -72,7 +76,7 @@ int MPI_Scatter_as_Bcast(const void* sendbuf, int sendcount, MPI_Datatype sendty
   PGMPI(MPI_Bcast(bcast_buf, count, sendtype, root, comm));
 
   // copy results to the receive buffer on each process
-  memcpy(recvbuf, (char*)bcast_buf + rank * n * type_extent, n * type_extent);
+  memcpy(recvbuf, (char*)bcast_buf + (MPI_Aint)rank * n * type_extent, n * type_extent);
 
   release_msg_buffers();
   return MPI_SUCCESS;
@@ -95,6 +99,9 @@ int MPI_Scatter_as_Scatterv(const void* sendbuf, int sendcount, MPI_Datatype sen
 
   // we need two fake int buffers with size elements: aux_int_buf1, aux_int_buf2
   n = sendcount;            // buffer size scatters to each process
+  if (!pgmpi_count_fits_int((MPI_Count)size * n)) {   // displacements
+    return MPI_ERR_COUNT;
+  }
 
   fake_int_buf_size = size * sizeof(int);     // same size for both int buffers
   ZF_LOGV("fake_int_buf_size: %zu", fake_int_buf_size);
@@ -121,3 +128,77 @@ int MPI_Scatter_as_Scatterv(const void* sendbuf, int sendcount, MPI_Datatype sen
   release_int_buffers();
   return MPI_SUCCESS;
 }
+
+#if MPI_VERSION >= 4
+/*
+ * large-count mock-ups of MPI-4, used when the counts (or the counts derived from
+ * them) do not fit into an int
+ */
+int MPI_Scatter_as_Bcast_c(const void* sendbuf, MPI_Count sendcount, MPI_Datatype sendtype, void* recvbuf,
+    MPI_Count recvcount, MPI_Datatype recvtype, int root, MPI_Comm comm) {
+  int size, rank;
+  MPI_Aint type_extent, lb;
+  size_t fake_buf_size;
+  void *aux_buf1, *bcast_buf;
+  int buf_status = BUF_NO_ERROR;
+
+  MPI_Comm_rank(comm, &rank);
+  MPI_Comm_size(comm, &size);
+  MPI_Type_get_extent(sendtype, &lb, &type_extent);
+
+  ZF_LOGV("Calling MPI_Scatter_as_Bcast_c");
+
+  fake_buf_size = size * sendcount * type_extent;
+  buf_status = grab_msg_buffer_1(fake_buf_size, &aux_buf1);
+  if (buf_status != BUF_NO_ERROR) {
+    return MPI_ERR_NO_MEM;
+  }
+
+  // sendbuf is only defined at the root
+  bcast_buf = (rank == root) ? (void*)sendbuf : aux_buf1;
+
+  PGMPI(MPI_Bcast_c(bcast_buf, size * sendcount, sendtype, root, comm));
+
+  memcpy(recvbuf, (char*)bcast_buf + rank * sendcount * type_extent, sendcount * type_extent);
+
+  release_msg_buffers();
+  return MPI_SUCCESS;
+}
+
+int MPI_Scatter_as_Scatterv_c(const void* sendbuf, MPI_Count sendcount, MPI_Datatype sendtype, void* recvbuf,
+    MPI_Count recvcount, MPI_Datatype recvtype, int root, MPI_Comm comm) {
+  int i;
+  MPI_Count *sendcounts;
+  MPI_Aint *displs;
+  int size;
+  int *aux_int_buf1, *aux_int_buf2;
+  int buf_status = BUF_NO_ERROR;
+
+  MPI_Comm_size(comm, &size);
+
+  ZF_LOGV("Calling MPI_Scatter_as_Scatterv_c");
+
+  // the int buffers hold size counts and size displacements
+  buf_status = grab_int_buffer_1(size * sizeof(MPI_Count), &aux_int_buf1);
+  if (buf_status != BUF_NO_ERROR) {
+    return MPI_ERR_NO_MEM;
+  }
+  buf_status = grab_int_buffer_2(size * sizeof(MPI_Aint), &aux_int_buf2);
+  if (buf_status != BUF_NO_ERROR) {
+    release_int_buffers();
+    return MPI_ERR_NO_MEM;
+  }
+
+  sendcounts = (MPI_Count*)aux_int_buf1;
+  displs = (MPI_Aint*)aux_int_buf2;
+  for (i = 0; i < size; i++) {
+    sendcounts[i] = sendcount;
+    displs[i] = i * sendcount;
+  }
+
+  PGMPI(MPI_Scatterv_c(sendbuf, sendcounts, displs, sendtype, recvbuf, recvcount, recvtype, root, comm));
+
+  release_int_buffers();
+  return MPI_SUCCESS;
+}
+#endif
@@ -10,4 +10,12 @@ int MPI_Scatter_as_Bcast(const void* sendbuf, int sendcount, MPI_Datatype sendty
 int MPI_Scatter_as_Scatterv(const void* sendbuf, int sendcount, MPI_Datatype sendtype, void* recvbuf, int recvcount,
     MPI_Datatype recvtype, int root, MPI_Comm comm);
 
+#if MPI_VERSION >= 4
+int MPI_Scatter_as_Bcast_c(const void* sendbuf, MPI_Count sendcount, MPI_Datatype sendtype, void* recvbuf,
+    MPI_Count recvcount, MPI_Datatype recvtype, int root, MPI_Comm comm);
+
+int MPI_Scatter_as_Scatterv_c(const void* sendbuf, MPI_Count sendcount, MPI_Datatype sendtype, void* recvbuf,
+    MPI_Count recvcount, MPI_Datatype recvtype, int root, MPI_Comm comm);
+#endif
+
 #endif /* SRC_COLLECTIVES_SCATTER_IMPL_H_ */
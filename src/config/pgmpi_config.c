@@ -36,6 +36,7 @@
 
 #include "pgmpi_config.h"
 #include "util/keyvalue_store.h"
+#include "util/pgmpi_pack.h"
 
 static pgmpi_config_t config;
 
@@ -130,4 +131,25 @@ char *pgmpi_config_get_filename_from_env() {
   return fname;
 }
 
+int pgmpi_config_bcast(const int root, MPI_Comm comm) {
+  int ret = 0;
+  int rank;
+  pgmpi_pack_buf_t buf;
+
+  MPI_Comm_rank(comm, &rank);
 
+  pgmpi_pack_init(&buf);
+  if( rank == root ) {
+    pgmpi_pack_dict(&buf, config.config_dict);
+  }
+
+  if( pgmpi_pack_bcast(&buf, root, comm) != 0 ) {
+    ret = -1;
+  } else if( rank != root ) {
+    ret = pgmpi_unpack_dict(&buf, config.config_dict);
+  }
+
+  pgmpi_pack_free(&buf);
+
+  return ret;
+}
@@ -28,6 +28,7 @@
 #define SRC_CONFIG_PGMPI_CONFIG_H_
 
 #include <stdio.h>
+#include <mpi.h>
 
 #include "util/keyvalue_store.h"
 
@@ -52,4 +53,10 @@ void pgmpi_config_print(FILE *fp);
 
 char *pgmpi_config_get_filename_from_env();
 
+/*!
+  replaces the configuration of all ranks with the one of root
+  \return 0 on success, -1 on error
+*/
+int pgmpi_config_bcast(const int root, MPI_Comm comm);
+
 #endif /* SRC_CONFIG_PGMPI_CONFIG_H_ */
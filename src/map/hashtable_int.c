@@ -31,8 +31,8 @@
 #define ZF_LOG_LEVEL MY_ZF_LOG_LEVEL
 #include "log/zf_log.h"
 
-static entry_t *ht_newpair(int key, int value);
-static int ht_hash(hashtable_t *hashtable, int key);
+static entry_t *ht_newpair(long long key, int value);
+static int ht_hash(hashtable_t *hashtable, long long key);
 
 /* Create a new hashtable. */
 hashtable_t *ht_create(int size) {
@@ -70,19 +70,18 @@ void ht_free(hashtable_t *hashtable) {
 }
 
 
-static int ht_hash(hashtable_t *hashtable, int key) {
-  int x = key;
+static int ht_hash(hashtable_t *hashtable, long long key) {
+  unsigned long long x = (unsigned long long)key;
 
   assert(hashtable->size > 0);
 
-  x = ((x >> 16) ^ x) * 0x45d9f3b;
-  x = ((x >> 16) ^ x) * 0x45d9f3b;
+  x = ((x >> 32) ^ x) * 0x45d9f3bULL;
+  x = ((x >> 16) ^ x) * 0x45d9f3bULL;
   x = (x >> 16) ^ x;
-  x %= hashtable->size;
-  return x;
+  return (int)(x % (unsigned long long)hashtable->size);
 }
 
-static entry_t *ht_newpair(int key, int value) {
+static entry_t *ht_newpair(long long key, int value) {
   entry_t *newpair;
 
   if ((newpair = malloc(sizeof(entry_t))) == NULL) {
@@ -96,7 +95,7 @@ static entry_t *ht_newpair(int key, int value) {
   return newpair;
 }
 
-void ht_set(hashtable_t *hashtable, int key, int value) {
+void ht_set(hashtable_t *hashtable, long long key, int value) {
   int bin = 0;
   entry_t *newpair = NULL;
   entry_t *next    = NULL;
@@ -136,7 +135,7 @@ void ht_set(hashtable_t *hashtable, int key, int value) {
   }
 }
 
-int ht_get(hashtable_t *hashtable, int key, int *value) {
+int ht_get(hashtable_t *hashtable, long long key, int *value) {
   int bin = 0;
   entry_t *pair;
   int ret = -1;
@@ -159,7 +158,7 @@ int ht_get(hashtable_t *hashtable, int key, int *value) {
   return ret;
 }
 
-void ht_get_keys(hashtable_t *hashtable, int **keys, int *nkeys) {
+void ht_get_keys(hashtable_t *hashtable, long long **keys, int *nkeys) {
   int i, key_idx;
 
   *nkeys = 0;
@@ -175,7 +174,7 @@ void ht_get_keys(hashtable_t *hashtable, int **keys, int *nkeys) {
     }
   }
 
-  *keys = (int*)calloc(*nkeys, sizeof(int));
+  *keys = (long long*)calloc(*nkeys, sizeof(long long));
 
   key_idx = 0;
   for(i=0; i<hashtable->size; i++) {
@@ -35,7 +35,7 @@
 //#include <string.h>
 
 struct entry_s {
-  int key;
+  long long key;   /* message sizes may exceed INT_MAX */
   int value;
   struct entry_s *next;
 };
@@ -52,8 +52,8 @@ typedef struct hashtable_s hashtable_t;
 
 hashtable_t *ht_create(int size);
 void ht_free(hashtable_t *hashtable);
-int ht_get(hashtable_t *hashtable, int key, int *value);
-void ht_set(hashtable_t *hashtable, int key, int value);
-void ht_get_keys(hashtable_t *hashtable, int **keys, int *nkeys);
+int ht_get(hashtable_t *hashtable, long long key, int *value);
+void ht_set(hashtable_t *hashtable, long long key, int value);
+void ht_get_keys(hashtable_t *hashtable, long long **keys, int *nkeys);
 
 #endif /* SRC_MAP_HASHTABLE_INT_H_ */
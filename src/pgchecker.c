@@ -0,0 +1,284 @@
+/*  PGMPITuneLib - Library for Autotuning MPI Collectives using Performance Guidelines
+ *  
+ *  Copyright 2017 Sascha Hunold, Alexandra Carpen-Amarie
+ *      Research Group for Parallel Computing
+ *      Faculty of Informatics
+ *      Vienna University of Technology, Austria
+ *  
+ *  <license>
+ *      This library is free software; you can redistribute it
+ *      and/or modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *  
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *  
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free
+ *      Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *      Boston, MA 02110-1301 USA
+ *  </license>
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <mpi.h>
+#include "pgmpi_tune.h"
+#include "bufmanager/pgmpi_buf.h"
+#include "collectives/collective_modules.h"
+#include "util/pgmpi_coll_timing.h"
+#include "util/pgmpi_stats.h"
+
+/*
+ * checks the self-consistent performance guidelines of all collectives and
+ * reports every violation
+ * usage: mpirun -np <p> pgchecker [max msg size] [nrep] [alpha]
+ *
+ * guidelines, for message sizes n = 1, 2, 4, ..., max msg size and process
+ * counts p = 2, 4, 8, ..., np (and np)
+ *  - mock-up:  default(n) <= mock-up(n), for every mock-up of every module
+ *  - monotony: default(n) <= default(2n)
+ *  - split:    default(n) <= 2 default(n/2), i.e., one call is not slower
+ *              than two calls with half of the data
+ *
+ * the tool is linked against pgmpicli and selects the algorithms with set_algid;
+ * the repetitions are synchronized with MPI_Barrier, outliers are removed
+ * with Tukey's fences, and a guideline is violated if the one-sided Wilcoxon
+ * rank-sum test finds the right-hand side faster at level alpha (divided by
+ * the number of mock-ups for the mock-up guidelines)
+ *
+ * a violation is reported with its magnitude, the Hodges-Lehmann estimate of
+ * how much faster the right-hand side is, relative to the median of the
+ * left-hand side, and with its confidence interval (covering 1 - 2 alpha):
+ *   violation;<guideline>;<collective>;<p>;<n>;<right-hand side>;<magnitude>;<ci low>;<ci high>;<p-value>
+ */
+
+#define DEFAULT_MAX_MSG_SIZE  (1 << 16)
+#define DEFAULT_NREP          30
+#define DEFAULT_ALPHA         0.05
+
+enum {
+  GUIDELINE_MOCKUP = 0,
+  GUIDELINE_MONOTONY,
+  GUIDELINE_SPLIT,
+  NB_GUIDELINES
+};
+
+static const char *guideline_names[NB_GUIDELINES] = { "mockup", "monotony", "split" };
+
+/*
+ * run-times of one algorithm for one message size, without outliers
+ */
+typedef struct {
+  int n;
+  double *t;
+} sample_t;
+
+static int measure(module_t *mod, const int alg_id, const int msg_size, const int nrep, void *sbuf, void *rbuf,
+    MPI_Comm comm, sample_t *sample);
+static int check(const int guideline, const module_t *mod, const int nb_procs, const int msg_size,
+    const char *rhs_name, const sample_t *lhs, const sample_t *rhs, const double alpha, const int rank);
+static int check_module(module_t *mod, const int max_msg_size, const int nrep, const double alpha, void *sbuf,
+    void *rbuf, MPI_Comm comm, int *n_checks);
+
+
+/*
+ * \return 0 on success, -1 if the buffers of the algorithm do not fit
+ */
+static int measure(module_t *mod, const int alg_id, const int msg_size, const int nrep, void *sbuf, void *rbuf,
+    MPI_Comm comm, sample_t *sample) {
+  pgmpi_buf_req_t req;
+  int nb_procs;
+
+  PMPI_Comm_size(comm, &nb_procs);
+
+  // a mock-up that does not get its buffers would run the default algorithm
+  req.msg_bytes = 0;
+  req.int_bytes = 0;
+  if( mod->get_buf_req != NULL ) {
+    mod->get_buf_req(alg_id, msg_size, MPI_UNSIGNED_CHAR, nb_procs, &req);
+  }
+  sample->n = 0;
+  sample->t = NULL;
+  if( !pgmpi_buffers_fit(&req) ) {
+    return -1;
+  }
+
+  mod->set_algid(alg_id);
+  // warm-up
+  pgmpi_coll_call(mod->cid, msg_size, sbuf, rbuf, comm);
+  sample->t = (double *)malloc(nrep * sizeof(double));
+  sample->n = pgmpi_coll_time_barrier(mod->cid, msg_size, nrep, sbuf, rbuf, comm, sample->t);
+  sample->n = pgmpi_stats_filter_outliers(sample->t, sample->n, PGMPI_STATS_OUTLIER_IQR_FACTOR);
+  mod->set_algid(0);
+
+  return 0;
+}
+
+/*
+ * lhs <= rhs is expected, the run-times are the same on all processes
+ * \return 1 if the guideline is violated
+ */
+static int check(const int guideline, const module_t *mod, const int nb_procs, const int msg_size,
+    const char *rhs_name, const sample_t *lhs, const sample_t *rhs, const double alpha, const int rank) {
+  double *lhs_t, p, shift, low, high, median;
+  int violated = 0;
+
+  if( lhs->n == 0 || rhs->n == 0 ) {
+    return 0;
+  }
+
+  p = pgmpi_stats_ranksum_less(rhs->t, rhs->n, lhs->t, lhs->n);
+  if( p < alpha ) {
+    lhs_t = (double *)malloc(lhs->n * sizeof(double));
+    memcpy(lhs_t, lhs->t, lhs->n * sizeof(double));
+    median = pgmpi_stats_median(lhs_t, lhs->n);
+    free(lhs_t);
+
+    pgmpi_stats_shift(rhs->t, rhs->n, lhs->t, lhs->n, alpha, &shift, &low, &high);
+    if( rank == 0 && median > 0.0 ) {
+      printf("violation;%s;%s;%d;%d;%s;%.4f;%.4f;%.4f;%.2e\n", guideline_names[guideline], mod->mpiname, nb_procs,
+          msg_size, rhs_name, shift / median, low / median, high / median, p);
+    }
+    violated = 1;
+  }
+  return violated;
+}
+
+/*
+ * \param n_checks incremented by the number of guidelines checked
+ * \return number of violations
+ */
+static int check_module(module_t *mod, const int max_msg_size, const int nrep, const double alpha, void *sbuf,
+    void *rbuf, MPI_Comm comm, int *n_checks) {
+  const int n_mockups = mod->alg_choices->nb_choices - 1;
+  sample_t def, prev, half, mockup;
+  char rhs_name[64];
+  int rank, nb_procs, msg_size, j, r;
+  int n_violations = 0;
+
+  PMPI_Comm_rank(comm, &rank);
+  PMPI_Comm_size(comm, &nb_procs);
+
+  prev.n = 0;
+  prev.t = NULL;
+  for(msg_size=1; msg_size<=max_msg_size && msg_size > 0; msg_size*=2) {
+    measure(mod, 0, msg_size, nrep, sbuf, rbuf, comm, &def);
+
+    for(j=0; j<mod->alg_choices->nb_choices; j++) {
+      const int alg_id = mod->alg_choices->alg[j].algid;
+      if( alg_id == 0 || measure(mod, alg_id, msg_size, nrep, sbuf, rbuf, comm, &mockup) != 0 ) {
+        continue;
+      }
+      n_violations += check(GUIDELINE_MOCKUP, mod, nb_procs, msg_size, mod->alg_choices->alg[j].algname, &def,
+          &mockup, alpha / n_mockups, rank);
+      (*n_checks)++;
+      free(mockup.t);
+    }
+
+    if( msg_size > 1 ) {
+      // default(n/2) <= default(n)
+      snprintf(rhs_name, sizeof(rhs_name), "default(%d)", msg_size);
+      n_violations += check(GUIDELINE_MONOTONY, mod, nb_procs, msg_size / 2, rhs_name, &prev, &def, alpha, rank);
+
+      // default(n) <= 2 default(n/2)
+      half.n = prev.n;
+      half.t = (double *)malloc((prev.n > 0 ? prev.n : 1) * sizeof(double));
+      for(r=0; r<prev.n; r++) {
+        half.t[r] = 2.0 * prev.t[r];
+      }
+      snprintf(rhs_name, sizeof(rhs_name), "2*default(%d)", msg_size / 2);
+      n_violations += check(GUIDELINE_SPLIT, mod, nb_procs, msg_size, rhs_name, &def, &half, alpha, rank);
+      free(half.t);
+      (*n_checks) += 2;
+    }
+
+    free(prev.t);
+    prev = def;
+  }
+  free(prev.t);
+
+  return n_violations;
+}
+
+
+int main(int argc, char *argv[]) {
+  int rank, world_size;
+  int max_msg_size = DEFAULT_MAX_MSG_SIZE;
+  int nrep = DEFAULT_NREP;
+  double alpha = DEFAULT_ALPHA;
+  int p, m, n_checks = 0, n_violations = 0;
+  void *sbuf, *rbuf;
+
+  MPI_Init(&argc, &argv);
+  PMPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  PMPI_Comm_size(MPI_COMM_WORLD, &world_size);
+
+  if( argc > 1 ) {
+    max_msg_size = atoi(argv[1]);
+  }
+  if( argc > 2 ) {
+    nrep = atoi(argv[2]);
+  }
+  if( argc > 3 ) {
+    alpha = atof(argv[3]);
+  }
+  if( max_msg_size < 1 || nrep < 4 || alpha <= 0.0 || alpha >= 0.5 ) {
+    if( rank == 0 ) {
+      fprintf(stderr, "usage: %s [max msg size] [nrep >= 4] [0 < alpha < 0.5]\n", argv[0]);
+    }
+    MPI_Finalize();
+    return 1;
+  }
+
+  // the collectives with one block per process send or receive up to msg_size * p bytes
+  sbuf = calloc((size_t)max_msg_size * world_size, 1);
+  rbuf = calloc((size_t)max_msg_size * world_size, 1);
+
+  if( rank == 0 ) {
+    printf("# pgchecker: %d repetitions, alpha %g\n", nrep, alpha);
+    printf("kind;guideline;collective;nb_procs;msg_size;rhs;magnitude;ci_low;ci_high;p_value\n");
+  }
+
+  for(p=(world_size > 1 ? 2 : 1); ; p*=2) {
+    MPI_Comm comm;
+
+    if( p > world_size ) {
+      if( p / 2 == world_size ) {
+        break;
+      }
+      p = world_size;
+    }
+
+    PMPI_Comm_split(MPI_COMM_WORLD, (rank < p) ? 0 : MPI_UNDEFINED, rank, &comm);
+    if( comm != MPI_COMM_NULL ) {
+      for(m=0; m<pgmpi_modules_get_number(); m++) {
+        n_violations += check_module(pgmpi_modules_get(m), max_msg_size, nrep, alpha, sbuf, rbuf, comm, &n_checks);
+      }
+      PMPI_Comm_free(&comm);
+    }
+    // the processes outside of comm wait for the next process count
+    PMPI_Barrier(MPI_COMM_WORLD);
+
+    if( p == world_size ) {
+      break;
+    }
+  }
+
+  if( rank == 0 ) {
+    printf("# %d of %d guidelines violated\n", n_violations, n_checks);
+  }
+
+  free(sbuf);
+  free(rbuf);
+
+  MPI_Finalize();
+
+  return 0;
+}
@@ -40,7 +40,7 @@ static hashtable_t **maps;
 const int INITIAL_MAP_SIZE = 100;
 
 static int my_rank = -1;
-//static int pgmpi_get_algid_for_msg_size(const pgmpi_collectives_t cid, const int msg_size, int *alg_id);
+//static int pgmpi_get_algid_for_msg_size(const pgmpi_collectives_t cid, const MPI_Count msg_size, int *alg_id);
 
 void pgmpi_init_algid_maps() {
 
@@ -71,7 +71,7 @@ void pgmpi_free_algid_maps() {
   free(maps);
 }
 
-void pgmpi_save_algid_for_msg_size(const pgmpi_collectives_t cid, const int msg_size, const int alg_id,
+void pgmpi_save_algid_for_msg_size(const pgmpi_collectives_t cid, const MPI_Count msg_size, const int alg_id,
     const int called_default) {
 
   int save_alg_id = alg_id;
@@ -100,7 +100,8 @@ void pgmpi_print_algids(FILE *fp) {
 
   for(i=0; i<NUM_COLLECTIVES; i++) {
     if( maps[i] != NULL ) {
-      int *keys, nkeys, j;
+      long long *keys;
+      int nkeys, j;
       module_t *mod;
 
       ht_get_keys(maps[i], &keys, &nkeys);
@@ -115,13 +116,13 @@ void pgmpi_print_algids(FILE *fp) {
         if( found == 1 ) {
           char *algname = pgmpi_modules_get_algname_by_algid(mod->alg_choices, val);
           if( algname != NULL ) {
-            fprintf(fp, "#@pgmpi alg %s %d %s\n", mod->mpiname, keys[j], algname);
+            fprintf(fp, "#@pgmpi alg %s %lld %s\n", mod->mpiname, keys[j], algname);
             free(algname);
           } else {
             ZF_LOGE("unexpected error, algname NULL");
           }
         } else {
-          ZF_LOGW("cannot find value for key %d", keys[j]);
+          ZF_LOGW("cannot find value for key %lld", keys[j]);
         }
       }
       free(keys);
@@ -129,9 +130,9 @@ void pgmpi_print_algids(FILE *fp) {
   }
 }
 
-int pgmpi_convert_type_count_2_bytes(const int count, const MPI_Datatype type) {
-  MPI_Aint lb, extent;
-  MPI_Type_get_extent(type, &lb, &extent);
+MPI_Count pgmpi_convert_type_count_2_bytes(const MPI_Count count, const MPI_Datatype type) {
+  MPI_Count lb, extent;
+  MPI_Type_get_extent_x(type, &lb, &extent);
   return count * extent;
 }
 
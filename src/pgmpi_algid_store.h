@@ -33,11 +33,14 @@ void pgmpi_init_algid_maps();
 
 void pgmpi_free_algid_maps();
 
-void pgmpi_save_algid_for_msg_size(const pgmpi_collectives_t cid, const int msg_size, const int alg_id,
+void pgmpi_save_algid_for_msg_size(const pgmpi_collectives_t cid, const MPI_Count msg_size, const int alg_id,
     const int called_default);
 
 void pgmpi_print_algids(FILE *fp);
 
-int pgmpi_convert_type_count_2_bytes(const int count, const MPI_Datatype type);
+/*!
+  \return size of count elements of type in bytes (count times the extent of type)
+*/
+MPI_Count pgmpi_convert_type_count_2_bytes(const MPI_Count count, const MPI_Datatype type);
 
 #endif /* SRC_PGMPI_ALGID_STORE_H_ */
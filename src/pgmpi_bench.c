@@ -0,0 +1,815 @@
+/*  PGMPITuneLib - Library for Autotuning MPI Collectives using Performance Guidelines
+ *  
+ *  Copyright 2017 Sascha Hunold, Alexandra Carpen-Amarie
+ *      Research Group for Parallel Computing
+ *      Faculty of Informatics
+ *      Vienna University of Technology, Austria
+ *  
+ *  <license>
+ *      This library is free software; you can redistribute it
+ *      and/or modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *  
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *  
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free
+ *      Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *      Boston, MA 02110-1301 USA
+ *  </license>
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <mpi.h>
+#include "pgmpi_tune.h"
+#include "bufmanager/pgmpi_buf.h"
+#include "collectives/collective_modules.h"
+#include "tuning/pgmpi_profile.h"
+#include "tuning/pgmpi_profile_writer.h"
+#include "util/pgmpi_clock.h"
+#include "util/pgmpi_coll_timing.h"
+#include "util/pgmpi_stats.h"
+
+/*
+ * measures the default and every mock-up of every module for message sizes
+ * 1, 2, 4, ..., max msg size and writes
+ *  - one profile per module (<output dir>/bench_<module>_p<p>.prf) that selects
+ *    a mock-up wherever it is significantly faster than the default
+ *  - the run-time of every repetition (<output dir>/bench_p<p>.csv)
+ * usage: mpirun -np <p> pgmpi_bench <output dir> [max msg size] [nrep] [barrier|window] [alpha] [tolerance]
+ *            [--split=<p1>,<p2>,...] [--serialize]
+ *
+ * the tool is linked against pgmpicli and selects the algorithms with set_algid,
+ * so the collectives it calls are the wrappers of the library
+ *
+ * synchronization of the repetitions (as in ReproMPI)
+ *  - barrier: the processes leave an MPI_Barrier before every repetition, the
+ *    run-time of a repetition is the maximum of the local run-times
+ *  - window: the clocks are synchronized with rank 0, every repetition starts
+ *    at the same time on all processes in its own time window; the run-time is
+ *    the time from the start of the window until the last process finished,
+ *    repetitions that some process started late are discarded
+ *
+ * selection
+ *  - the repetitions are split into rounds, every round runs the algorithms in
+ *    a new random order, so that slow phases of the machine hit all of them
+ *  - outliers are removed with Tukey's fences
+ *  - a mock-up violates the guideline of the default if the Wilcoxon rank-sum
+ *    test finds it faster at level alpha (Bonferroni-corrected for the number of
+ *    mock-ups); of these, the one with the largest effect is selected
+ *  - the effect is the Hodges-Lehmann shift relative to the median run-time of
+ *    the default, its confidence interval covers 1 - 2 alpha; both are written
+ *    to the profile (effect=, ci=)
+ *
+ * adaptive search (if a tolerance is given)
+ *  - the message sizes 1, 8, 64, ..., max msg size are measured first, mock-ups
+ *    that are slower than the default at all of them are not measured again
+ *  - intervals between two measured sizes that select different algorithms are
+ *    bisected (at the geometric mean) until the larger size is at most
+ *    (1 + tolerance) times the smaller one
+ *  - a measured size stands for all sizes up to the next measured one
+ *
+ * several process counts (--split)
+ *  - MPI_COMM_WORLD is split into disjoint sub-communicators of the given sizes,
+ *    which are tuned concurrently, each writing its own profiles and run-times
+ *  - the processes are ordered by node; a sub-communicator with at least ppn
+ *    processes starts at a node boundary, a smaller one is placed within a node
+ *  - the sub-communicators that do not fit next to the larger ones run in a
+ *    later batch; --serialize runs every sub-communicator in its own batch, so
+ *    that they do not interfere through shared nodes and links
+ */
+
+#define DEFAULT_MAX_MSG_SIZE  (1 << 20)
+#define DEFAULT_NREP          20
+#define DEFAULT_ALPHA         0.05
+#define COARSE_GRID_FACTOR    8        /* grid of the adaptive search */
+#define MAX_SPLITS            64
+#define NB_ROUNDS             5        /* the repetitions are split into this many rounds */
+#define SHUFFLE_SEED          4711     /* same on all processes, so all run the same order */
+#define WINDOW_NB_ESTIMATES   5        /* barrier-synchronized calls to size the window */
+#define WINDOW_FACTOR         2.0      /* window is this multiple of the estimated run-time */
+#define WINDOW_MIN_S          1.0e-5
+#define WINDOW_START_DELAY_S  1.0e-3   /* time to broadcast the start of the first window */
+
+enum {
+  SYNC_BARRIER = 0,
+  SYNC_WINDOW
+};
+
+static const char *sync_names[] = { "barrier", "window" };
+
+/*
+ * settings and buffers of a run on one communicator
+ */
+typedef struct {
+  MPI_Comm comm;
+  int rank;
+  int nb_procs;
+  int sync;
+  int n_rounds;
+  int nrep_round;      /* repetitions of every algorithm per round */
+  double alpha;
+  unsigned int seed;
+  void *sbuf;
+  void *rbuf;
+  double *times;
+  FILE *csv;           /* rank 0 only */
+} bench_t;
+
+/*
+ * selection for one message size
+ */
+typedef struct {
+  int alg_id;          /* -1 if nothing was measured */
+  double effect;
+  double ci_low;
+  double ci_high;
+} selection_t;
+
+/*
+ * measured message sizes of a module, sorted
+ */
+typedef struct {
+  int n;
+  int capacity;
+  int *msg_size;
+  selection_t *sel;
+} probes_t;
+
+/*
+ * placement of a sub-communicator, ranks are counted in node order
+ */
+typedef struct {
+  int nb_procs;
+  int batch;
+  int first;
+} split_t;
+
+static void shuffle(int *v, const int n, unsigned int *seed);
+static int time_window(const pgmpi_collectives_t cid, const int msg_size, const int nrep, void *sbuf, void *rbuf,
+    MPI_Comm comm, double *times);
+static void select_alg(const module_t *mod, double **samples, const int *n_samples, const double alpha,
+    selection_t *sel, double *median);
+static void measure_size(bench_t *b, module_t *mod, const int msg_size, const int *active, selection_t *sel,
+    double *median);
+static void probes_insert(probes_t *probes, const int idx, const int msg_size, const selection_t *sel);
+static void tune_module(bench_t *b, module_t *mod, const int max_msg_size, const double tolerance, probes_t *probes);
+static int write_profile(const char *path, const module_t *mod, const int nb_procs, const probes_t *probes,
+    const char *header);
+static int run_bench(bench_t *b, const char *path, const int max_msg_size, const double tolerance,
+    const char *header);
+static int get_node_order(int *ppn);
+static int parse_splits(const char *str, split_t *splits);
+static int compare_splits(const void *a, const void *b);
+static int plan_splits(split_t *splits, const int n_splits, const int nb_procs, const int ppn, const int serialize);
+
+
+/*
+ * Fisher-Yates
+ */
+static void shuffle(int *v, const int n, unsigned int *seed) {
+  int i, j, tmp;
+
+  for(i=n-1; i>0; i--) {
+    j = rand_r(seed) % (i + 1);
+    tmp = v[i];
+    v[i] = v[j];
+    v[j] = tmp;
+  }
+}
+
+/*
+ * the clocks must have been synchronized with pgmpi_clock_sync
+ * \param times set to the run-time of every valid repetition (all processes)
+ * \return number of valid repetitions
+ */
+static int time_window(const pgmpi_collectives_t cid, const int msg_size, const int nrep, void *sbuf, void *rbuf,
+    MPI_Comm comm, double *times) {
+  pgmpi_clock_window_t w;
+  double *t_start, *t_end, *t_late, *buf;
+  double estimate[WINDOW_NB_ESTIMATES];
+  double window;
+  int r, n_valid;
+
+  pgmpi_coll_time_barrier(cid, msg_size, WINDOW_NB_ESTIMATES, sbuf, rbuf, comm, estimate);
+  window = WINDOW_FACTOR * pgmpi_stats_median(estimate, WINDOW_NB_ESTIMATES);
+  if( window < WINDOW_MIN_S ) {
+    window = WINDOW_MIN_S;
+  }
+
+  t_start = (double *)malloc(nrep * sizeof(double));
+  t_end = (double *)malloc(nrep * sizeof(double));
+  t_late = (double *)malloc(nrep * sizeof(double));
+  buf = (double *)malloc(nrep * sizeof(double));
+
+  pgmpi_clock_window_init(&w, window, WINDOW_START_DELAY_S, comm);
+  for(r=0; r<nrep; r++) {
+    t_late[r] = pgmpi_clock_window_wait(&w, &t_start[r]);
+    pgmpi_coll_call(cid, msg_size, sbuf, rbuf, comm);
+    t_end[r] = pgmpi_global_time();
+  }
+
+  PMPI_Allreduce(t_end, buf, nrep, MPI_DOUBLE, MPI_MAX, comm);
+  memcpy(t_end, buf, nrep * sizeof(double));
+  PMPI_Allreduce(t_late, buf, nrep, MPI_DOUBLE, MPI_MAX, comm);
+
+  n_valid = 0;
+  for(r=0; r<nrep; r++) {
+    if( buf[r] == 0.0 ) {
+      times[n_valid++] = t_end[r] - t_start[r];
+    }
+  }
+
+  free(t_start);
+  free(t_end);
+  free(t_late);
+  free(buf);
+  return n_valid;
+}
+
+/*
+ * \param samples run-times per algorithm (index in alg_choices), sorted and without outliers afterwards
+ * \param median set to the median run-time per algorithm after removing the outliers, -1 if it was not measured
+ */
+static void select_alg(const module_t *mod, double **samples, const int *n_samples, const double alpha,
+    selection_t *sel, double *median) {
+  const int n_algs = mod->alg_choices->nb_choices;
+  int *n_kept;
+  int j, def = -1, n_tested = 0;
+
+  sel->alg_id = -1;
+  sel->effect = 0.0;
+  sel->ci_low = 0.0;
+  sel->ci_high = 0.0;
+
+  n_kept = (int *)malloc(n_algs * sizeof(int));
+  for(j=0; j<n_algs; j++) {
+    n_kept[j] = pgmpi_stats_filter_outliers(samples[j], n_samples[j], PGMPI_STATS_OUTLIER_IQR_FACTOR);
+    median[j] = (n_kept[j] > 0) ? pgmpi_stats_median(samples[j], n_kept[j]) : -1.0;
+    if( mod->alg_choices->alg[j].algid == 0 ) {
+      def = j;
+    } else if( n_kept[j] > 0 ) {
+      n_tested++;
+    }
+  }
+  if( def < 0 || n_kept[def] == 0 ) {
+    free(n_kept);
+    return;
+  }
+
+  sel->alg_id = 0;
+  for(j=0; j<n_algs && median[def] > 0.0; j++) {
+    double p, shift, low, high;
+
+    if( j == def || n_kept[j] == 0 ) {
+      continue;
+    }
+    // Bonferroni correction for the n_tested comparisons, for the test and the confidence interval
+    p = pgmpi_stats_ranksum_less(samples[j], n_kept[j], samples[def], n_kept[def]);
+    if( p >= alpha / n_tested ) {
+      continue;
+    }
+    pgmpi_stats_shift(samples[j], n_kept[j], samples[def], n_kept[def], alpha / n_tested, &shift, &low, &high);
+    if( sel->alg_id == 0 || shift / median[def] > sel->effect ) {
+      sel->alg_id = mod->alg_choices->alg[j].algid;
+      sel->effect = shift / median[def];
+      sel->ci_low = low / median[def];
+      sel->ci_high = high / median[def];
+    }
+  }
+
+  free(n_kept);
+}
+
+/*
+ * measures the active algorithms (index in alg_choices) in randomized rounds
+ * \param median see select_alg
+ */
+static void measure_size(bench_t *b, module_t *mod, const int msg_size, const int *active, selection_t *sel,
+    double *median) {
+  const int n_algs = mod->alg_choices->nb_choices;
+  double **samples;
+  int *n_samples, *fits, *order;
+  int j, k;
+
+  samples = (double **)malloc(n_algs * sizeof(double *));
+  n_samples = (int *)malloc(n_algs * sizeof(int));
+  fits = (int *)malloc(n_algs * sizeof(int));
+  order = (int *)malloc(n_algs * sizeof(int));
+
+  for(j=0; j<n_algs; j++) {
+    pgmpi_buf_req_t req;
+
+    // a mock-up that does not get its buffers would run the default algorithm
+    req.msg_bytes = 0;
+    req.int_bytes = 0;
+    if( mod->get_buf_req != NULL ) {
+      mod->get_buf_req(mod->alg_choices->alg[j].algid, msg_size, MPI_UNSIGNED_CHAR, b->nb_procs, &req);
+    }
+    fits[j] = pgmpi_buffers_fit(&req);
+    if( !fits[j] && b->rank == 0 ) {
+      printf("skipping %s for %d bytes, buffers do not fit\n", mod->alg_choices->alg[j].algname, msg_size);
+    }
+    samples[j] = (double *)malloc(b->n_rounds * b->nrep_round * sizeof(double));
+    n_samples[j] = 0;
+    order[j] = j;
+  }
+
+  for(k=0; k<b->n_rounds; k++) {
+    shuffle(order, n_algs, &b->seed);
+
+    for(j=0; j<n_algs; j++) {
+      const int a = order[j];
+      int r, n_valid;
+
+      if( !fits[a] || !active[a] ) {
+        continue;
+      }
+      mod->set_algid(mod->alg_choices->alg[a].algid);
+
+      // warm-up
+      pgmpi_coll_call(mod->cid, msg_size, b->sbuf, b->rbuf, b->comm);
+
+      if( b->sync == SYNC_WINDOW ) {
+        n_valid = time_window(mod->cid, msg_size, b->nrep_round, b->sbuf, b->rbuf, b->comm, b->times);
+      } else {
+        n_valid = pgmpi_coll_time_barrier(mod->cid, msg_size, b->nrep_round, b->sbuf, b->rbuf, b->comm, b->times);
+      }
+
+      for(r=0; r<n_valid; r++) {
+        if( b->rank == 0 ) {
+          fprintf(b->csv, "%s;%s;%d;%d;%d;%.9f\n", mod->mpiname, mod->alg_choices->alg[a].algname, b->nb_procs,
+              msg_size, n_samples[a], b->times[r]);
+        }
+        samples[a][n_samples[a]++] = b->times[r];
+      }
+    }
+  }
+  mod->set_algid(0);
+
+  // the run-times are the same on all processes, so is the selection
+  select_alg(mod, samples, n_samples, b->alpha, sel, median);
+  if( sel->alg_id < 0 && b->rank == 0 ) {
+    printf("no valid repetition of the default of %s for %d bytes\n", mod->mpiname, msg_size);
+  }
+
+  for(j=0; j<n_algs; j++) {
+    free(samples[j]);
+  }
+  free(samples);
+  free(n_samples);
+  free(fits);
+  free(order);
+}
+
+static void probes_insert(probes_t *probes, const int idx, const int msg_size, const selection_t *sel) {
+  if( probes->n == probes->capacity ) {
+    probes->capacity = (probes->capacity > 0) ? 2 * probes->capacity : 32;
+    probes->msg_size = (int *)realloc(probes->msg_size, probes->capacity * sizeof(int));
+    probes->sel = (selection_t *)realloc(probes->sel, probes->capacity * sizeof(selection_t));
+  }
+  memmove(&probes->msg_size[idx + 1], &probes->msg_size[idx], (probes->n - idx) * sizeof(int));
+  memmove(&probes->sel[idx + 1], &probes->sel[idx], (probes->n - idx) * sizeof(selection_t));
+  probes->msg_size[idx] = msg_size;
+  probes->sel[idx] = *sel;
+  probes->n++;
+}
+
+/*
+ * \param tolerance 0 to measure all powers of two, otherwise adaptive search
+ * \param probes appended with the measured message sizes
+ */
+static void tune_module(bench_t *b, module_t *mod, const int max_msg_size, const double tolerance, probes_t *probes) {
+  const int n_algs = mod->alg_choices->nb_choices;
+  const int factor = (tolerance > 0.0) ? COARSE_GRID_FACTOR : 2;
+  int *active, *dominated;
+  double *median;
+  selection_t sel;
+  int msg_size, i, j, def = 0;
+
+  active = (int *)malloc(n_algs * sizeof(int));
+  dominated = (int *)malloc(n_algs * sizeof(int));
+  median = (double *)malloc(n_algs * sizeof(double));
+  for(j=0; j<n_algs; j++) {
+    active[j] = 1;
+    dominated[j] = 1;
+    if( mod->alg_choices->alg[j].algid == 0 ) {
+      def = j;
+    }
+  }
+
+  // grid, the largest message size is always measured
+  for(msg_size=1; ; ) {
+    measure_size(b, mod, msg_size, active, &sel, median);
+    probes_insert(probes, probes->n, msg_size, &sel);
+
+    for(j=0; j<n_algs; j++) {
+      if( median[def] < 0.0 || (median[j] >= 0.0 && median[j] < median[def]) ) {
+        dominated[j] = 0;
+      }
+    }
+    if( msg_size == max_msg_size ) {
+      break;
+    }
+    // checked before multiplying, msg_size * factor may not fit into an int
+    msg_size = (msg_size > max_msg_size / factor) ? max_msg_size : msg_size * factor;
+  }
+
+  if( tolerance > 0.0 ) {
+    for(j=0; j<n_algs; j++) {
+      if( j != def && dominated[j] ) {
+        active[j] = 0;
+        if( b->rank == 0 ) {
+          printf("pruning %s, slower than the default for all sizes\n", mod->alg_choices->alg[j].algname);
+        }
+      }
+    }
+
+    // bisect the intervals with a crossover
+    i = 0;
+    while( i < probes->n - 1 ) {
+      const int lo = probes->msg_size[i];
+      const int hi = probes->msg_size[i + 1];
+      int mid = (int)sqrt((double)lo * hi);
+
+      if( mid <= lo ) {
+        mid = lo + 1;
+      }
+      if( probes->sel[i].alg_id == probes->sel[i + 1].alg_id || hi <= lo * (1.0 + tolerance) || mid >= hi ) {
+        i++;
+        continue;
+      }
+      measure_size(b, mod, mid, active, &sel, median);
+      probes_insert(probes, i + 1, mid, &sel);
+    }
+  }
+
+  free(active);
+  free(dominated);
+  free(median);
+}
+
+/*
+ * a measured message size stands for all sizes up to the next measured one
+ */
+static int write_profile(const char *path, const module_t *mod, const int nb_procs, const probes_t *probes,
+    const char *header) {
+  pgmpi_profile_t profile;
+  char *fname;
+  int i, n_ranges = 0;
+  int ret;
+
+  for(i=0; i<probes->n; i++) {
+    if( probes->sel[i].alg_id > 0 ) {
+      n_ranges++;
+    }
+  }
+  if( n_ranges == 0 ) {
+    // the default algorithm was never beaten, nothing to replace
+    return 0;
+  }
+
+  pgmpi_profile_allocate(&profile, mod->mpiname, nb_procs, n_ranges);
+  n_ranges = 0;
+  for(i=0; i<probes->n; i++) {
+    const selection_t *sel = &probes->sel[i];
+    if( sel->alg_id > 0 ) {
+      const MPI_Count start = probes->msg_size[i];
+      const MPI_Count end = (i < probes->n - 1) ? (MPI_Count)probes->msg_size[i + 1] - 1 : start;
+      pgmpi_profile_set_alg_for_range(&profile, n_ranges, start, end,
+          pgmpi_modules_get_algname_by_algid(mod->alg_choices, sel->alg_id));
+      pgmpi_profile_set_effect_for_range(&profile, n_ranges, sel->effect, sel->ci_low, sel->ci_high);
+      n_ranges++;
+    }
+  }
+  // merges adjacent ranges of the same algorithm
+  pgmpi_profile_normalize(&profile);
+
+  fname = (char *)malloc(strlen(path) + strlen(mod->cli_prefix) + 40);
+  sprintf(fname, "%s/bench_%s_p%d.%s", path, mod->cli_prefix, nb_procs, pgmpi_get_profile_file_suffix());
+  ret = pgmpi_profile_write(fname, &profile, header);
+  if( ret == 0 ) {
+    printf("wrote %s\n", fname);
+  } else {
+    fprintf(stderr, "cannot write %s\n", fname);
+  }
+
+  free(fname);
+  pgmpi_profile_free(&profile);
+  return ret;
+}
+
+
+/*
+ * tunes all modules on b->comm, rank 0 of b->comm writes the results
+ * \return 0 on success, 1 on error
+ */
+static int run_bench(bench_t *b, const char *path, const int max_msg_size, const double tolerance,
+    const char *header) {
+  size_t buf_size;
+  char *fname;
+  int m;
+  int ret = 0;
+
+  PMPI_Comm_rank(b->comm, &b->rank);
+  PMPI_Comm_size(b->comm, &b->nb_procs);
+  b->csv = NULL;
+  // the processes of b->comm may come from other sub-communicators of an earlier batch
+  b->seed = SHUFFLE_SEED;
+
+  if( b->rank == 0 ) {
+    fname = (char *)malloc(strlen(path) + 40);
+    sprintf(fname, "%s/bench_p%d.csv", path, b->nb_procs);
+    if( (b->csv = fopen(fname, "w")) == NULL ) {
+      fprintf(stderr, "cannot open %s for writing\n", fname);
+      ret = 1;
+    } else {
+      fprintf(b->csv, "mpiname;algname;nb_procs;msg_size;rep;time\n");
+    }
+    free(fname);
+  }
+  PMPI_Bcast(&ret, 1, MPI_INT, 0, b->comm);
+  if( ret != 0 ) {
+    return ret;
+  }
+
+  // the collectives with one block per process send or receive up to msg_size * p bytes
+  buf_size = (size_t)max_msg_size * b->nb_procs;
+  b->sbuf = calloc(buf_size, 1);
+  b->rbuf = calloc(buf_size, 1);
+  b->times = (double *)malloc(b->nrep_round * sizeof(double));
+
+  for(m=0; m<pgmpi_modules_get_number(); m++) {
+    module_t *mod = pgmpi_modules_get(m);
+    probes_t probes = { 0, 0, NULL, NULL };
+
+    // re-synchronize for every module, as the clocks drift
+    if( b->sync == SYNC_WINDOW && pgmpi_clock_sync(b->comm) != 0 ) {
+      if( b->rank == 0 ) {
+        fprintf(stderr, "cannot synchronize clocks\n");
+      }
+      ret = 1;
+      break;
+    }
+
+    tune_module(b, mod, max_msg_size, tolerance, &probes);
+    if( b->rank == 0 ) {
+      printf("measured %d message sizes of %s on %d processes\n", probes.n, mod->mpiname, b->nb_procs);
+      if( write_profile(path, mod, b->nb_procs, &probes, header) != 0 ) {
+        ret = 1;
+      }
+    }
+
+    free(probes.msg_size);
+    free(probes.sel);
+  }
+
+  if( b->rank == 0 ) {
+    fclose(b->csv);
+  }
+
+  free(b->times);
+  free(b->sbuf);
+  free(b->rbuf);
+  return ret;
+}
+
+/*
+ * \param ppn set to the number of processes per node, 1 if the nodes host different numbers
+ * \return position of the calling process if the processes are ordered by node
+ */
+static int get_node_order(int *ppn) {
+  MPI_Comm node_comm, leader_comm;
+  int local_rank, leader_rank, node_size, min_size, node_first = 0;
+
+  PMPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, 0, MPI_INFO_NULL, &node_comm);
+  PMPI_Comm_rank(node_comm, &local_rank);
+  PMPI_Comm_size(node_comm, &node_size);
+
+  // the first process of every node counts the processes on the nodes before
+  PMPI_Comm_split(MPI_COMM_WORLD, (local_rank == 0) ? 0 : MPI_UNDEFINED, 0, &leader_comm);
+  if( leader_comm != MPI_COMM_NULL ) {
+    PMPI_Comm_rank(leader_comm, &leader_rank);
+    PMPI_Exscan(&node_size, &node_first, 1, MPI_INT, MPI_SUM, leader_comm);
+    if( leader_rank == 0 ) {
+      // the result of MPI_Exscan is undefined on the first process
+      node_first = 0;
+    }
+    PMPI_Comm_free(&leader_comm);
+  }
+  PMPI_Bcast(&node_first, 1, MPI_INT, 0, node_comm);
+
+  PMPI_Allreduce(&node_size, &min_size, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+  PMPI_Allreduce(&node_size, ppn, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+  if( min_size != *ppn ) {
+    *ppn = 1;
+  }
+
+  PMPI_Comm_free(&node_comm);
+  return node_first + local_rank;
+}
+
+/*
+ * \param str comma separated process counts
+ * \return number of sub-communicators, -1 on error
+ */
+static int parse_splits(const char *str, split_t *splits) {
+  const char *c = str;
+  char *end;
+  int i, n = 0;
+
+  while( *c != '\0' ) {
+    long v = strtol(c, &end, 10);
+    if( end == c || v < 1 || n == MAX_SPLITS || (*end != ',' && *end != '\0') ) {
+      return -1;
+    }
+    for(i=0; i<n; i++) {
+      if( splits[i].nb_procs == v ) {
+        // both would write the same files
+        return -1;
+      }
+    }
+    splits[n].nb_procs = (int)v;
+    splits[n].batch = -1;
+    splits[n].first = 0;
+    n++;
+    c = (*end == ',') ? end + 1 : end;
+  }
+  return n;
+}
+
+static int compare_splits(const void *a, const void *b) {
+  return ((const split_t *)b)->nb_procs - ((const split_t *)a)->nb_procs;
+}
+
+/*
+ * first fit decreasing of the sub-communicators into batches of nb_procs processes
+ * \return number of batches, -1 if a sub-communicator is larger than nb_procs
+ */
+static int plan_splits(split_t *splits, const int n_splits, const int nb_procs, const int ppn, const int serialize) {
+  int used[MAX_SPLITS];
+  int i, k, n_batches = 0;
+
+  qsort(splits, n_splits, sizeof(split_t), &compare_splits);
+  for(i=0; i<n_splits; i++) {
+    const int p = splits[i].nb_procs;
+
+    if( p > nb_procs ) {
+      return -1;
+    }
+    for(k=0; k<=n_batches; k++) {
+      int first;
+
+      if( k == n_batches ) {
+        used[n_batches++] = 0;
+      }
+      first = used[k];
+      if( first % ppn != 0 && (p >= ppn || first % ppn + p > ppn) ) {
+        // starts at the next node
+        first += ppn - first % ppn;
+      }
+      if( first + p <= nb_procs && (!serialize || used[k] == 0) ) {
+        splits[i].batch = k;
+        splits[i].first = first;
+        used[k] = first + p;
+        break;
+      }
+    }
+  }
+  return n_batches;
+}
+
+
+int main(int argc, char *argv[]) {
+  bench_t b;
+  const char *arg[7];
+  split_t splits[MAX_SPLITS];
+  int max_msg_size = DEFAULT_MAX_MSG_SIZE;
+  int nrep = DEFAULT_NREP;
+  double tolerance = 0.0;
+  int n_args = 0, n_splits = 0, n_batches = 1, serialize = 0;
+  int rank, nb_procs, i, k, n;
+  char header[160];
+  int ret = 0;
+
+  MPI_Init(&argc, &argv);
+  PMPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  PMPI_Comm_size(MPI_COMM_WORLD, &nb_procs);
+
+  b.sync = SYNC_BARRIER;
+  b.alpha = DEFAULT_ALPHA;
+
+  for(i=1; i<argc; i++) {
+    if( strncmp(argv[i], "--split=", 8) == 0 ) {
+      n_splits = parse_splits(argv[i] + 8, splits);
+    } else if( strcmp(argv[i], "--serialize") == 0 ) {
+      serialize = 1;
+    } else if( n_args < 7 ) {
+      arg[n_args++] = argv[i];
+    } else {
+      n_args = 0;
+      break;
+    }
+  }
+
+  if( n_args < 1 ) {
+    if( rank == 0 ) {
+      fprintf(stderr, "usage: %s <output dir> [max msg size] [nrep] [barrier|window] [alpha] [tolerance] "
+          "[--split=<p1>,<p2>,...] [--serialize]\n", argv[0]);
+    }
+    MPI_Finalize();
+    return 1;
+  }
+  if( n_args > 1 ) {
+    max_msg_size = atoi(arg[1]);
+  }
+  if( n_args > 2 ) {
+    nrep = atoi(arg[2]);
+  }
+  if( n_args > 3 ) {
+    if( strcmp(arg[3], sync_names[SYNC_WINDOW]) == 0 ) {
+      b.sync = SYNC_WINDOW;
+    } else if( strcmp(arg[3], sync_names[SYNC_BARRIER]) != 0 ) {
+      b.sync = -1;
+    }
+  }
+  if( n_args > 4 ) {
+    b.alpha = atof(arg[4]);
+  }
+  if( n_args > 5 ) {
+    tolerance = atof(arg[5]);
+  }
+  if( max_msg_size < 1 || nrep < 1 || b.sync < 0 || b.alpha <= 0.0 || b.alpha >= 0.5 || tolerance < 0.0 ||
+      n_splits < 0 ) {
+    if( rank == 0 ) {
+      fprintf(stderr, "invalid max msg size %d, nrep %d, synchronization, alpha %g, tolerance %g or split\n",
+          max_msg_size, nrep, b.alpha, tolerance);
+    }
+    MPI_Finalize();
+    return 1;
+  }
+
+  b.n_rounds = (nrep < NB_ROUNDS) ? nrep : NB_ROUNDS;
+  b.nrep_round = (nrep + b.n_rounds - 1) / b.n_rounds;
+
+  n = snprintf(header, sizeof(header), "measured by pgmpi_bench, %d repetitions in %d rounds, %s synchronization, "
+      "alpha %g", b.n_rounds * b.nrep_round, b.n_rounds, sync_names[b.sync], b.alpha);
+  if( tolerance > 0.0 && n < (int)sizeof(header) ) {
+    snprintf(header + n, sizeof(header) - n, ", adaptive search with tolerance %g", tolerance);
+  }
+
+  if( n_splits == 0 ) {
+    b.comm = MPI_COMM_WORLD;
+    ret = run_bench(&b, arg[0], max_msg_size, tolerance, header);
+  } else {
+    int ppn;
+    const int pos = get_node_order(&ppn);
+
+    n_batches = plan_splits(splits, n_splits, nb_procs, ppn, serialize);
+    if( n_batches < 0 ) {
+      if( rank == 0 ) {
+        fprintf(stderr, "a sub-communicator is larger than %d processes\n", nb_procs);
+      }
+      MPI_Finalize();
+      return 1;
+    }
+    if( rank == 0 ) {
+      for(i=0; i<n_splits; i++) {
+        printf("sub-communicator of %d processes: batch %d, processes %d to %d in node order (ppn %d)\n",
+            splits[i].nb_procs, splits[i].batch, splits[i].first, splits[i].first + splits[i].nb_procs - 1, ppn);
+      }
+    }
+
+    for(k=0; k<n_batches; k++) {
+      int color = MPI_UNDEFINED;
+
+      for(i=0; i<n_splits; i++) {
+        if( splits[i].batch == k && pos >= splits[i].first && pos < splits[i].first + splits[i].nb_procs ) {
+          color = i;
+        }
+      }
+      PMPI_Comm_split(MPI_COMM_WORLD, color, pos, &b.comm);
+      if( b.comm != MPI_COMM_NULL ) {
+        ret |= run_bench(&b, arg[0], max_msg_size, tolerance, header);
+        PMPI_Comm_free(&b.comm);
+      }
+      // the next batch starts after all sub-communicators of this one finished
+      PMPI_Barrier(MPI_COMM_WORLD);
+    }
+  }
+
+  PMPI_Allreduce(MPI_IN_PLACE, &ret, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+
+  MPI_Finalize();
+
+  return ret;
+}
@@ -0,0 +1,354 @@
+/*  PGMPITuneLib - Library for Autotuning MPI Collectives using Performance Guidelines
+ *  
+ *  Copyright 2017 Sascha Hunold, Alexandra Carpen-Amarie
+ *      Research Group for Parallel Computing
+ *      Faculty of Informatics
+ *      Vienna University of Technology, Austria
+ *  
+ *  <license>
+ *      This library is free software; you can redistribute it
+ *      and/or modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *  
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *  
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free
+ *      Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *      Boston, MA 02110-1301 USA
+ *  </license>
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <mpi.h>
+#include "pgmpi_tune.h"
+#include "tuning/pgmpi_cost_model.h"
+
+/*
+ * fits the parameters of the cost model on the target machine and measures
+ * the base collectives used by the mock-ups for the number of processes of the job
+ * usage: mpirun -np <p> pgmpi_calibrate <model file> [max msg size] [nrep]
+ *
+ * all measurements use the PMPI interface, so the tool is not affected by the
+ * tuning library it is linked against
+ */
+
+#define DEFAULT_MAX_MSG_SIZE  (1 << 20)
+#define DEFAULT_NREP          20
+#define LOCAL_OPS_PER_REP     10
+
+static int compare_doubles(const void *a, const void *b);
+static double median(double *v, const int n);
+static void fit_linear(const int n, const double *x, const double *y, double *offset, double *slope);
+static double time_primitive(const int prim, const int msg_size, const int nrep, void *sbuf, void *rbuf,
+    int *counts, int *displs, MPI_Comm comm);
+static double time_local(const int prim, const int msg_size, const int nrep, void *sbuf, void *rbuf);
+static double time_pingpong(const int msg_size, const int nrep, void *sbuf, void *rbuf);
+
+
+static int compare_doubles(const void *a, const void *b) {
+  const double d1 = *(const double *)a;
+  const double d2 = *(const double *)b;
+  return (d1 > d2) - (d1 < d2);
+}
+
+static double median(double *v, const int n) {
+  qsort(v, n, sizeof(double), &compare_doubles);
+  return (n % 2 == 1) ? v[n / 2] : (v[n / 2 - 1] + v[n / 2]) / 2.0;
+}
+
+/*
+ * least squares fit of y = offset + slope * x
+ */
+static void fit_linear(const int n, const double *x, const double *y, double *offset, double *slope) {
+  double sx = 0, sy = 0, sxx = 0, sxy = 0;
+  double d;
+  int i;
+
+  for(i=0; i<n; i++) {
+    sx += x[i];
+    sy += y[i];
+    sxx += x[i] * x[i];
+    sxy += x[i] * y[i];
+  }
+  d = n * sxx - sx * sx;
+  if( n < 2 || d == 0.0 ) {
+    *slope = 0.0;
+    *offset = (n > 0) ? sy / n : 0.0;
+    return;
+  }
+  *slope = (n * sxy - sx * sy) / d;
+  *offset = (sy - *slope * sx) / n;
+  if( *slope < 0.0 ) {
+    *slope = 0.0;
+  }
+  if( *offset < 0.0 ) {
+    *offset = 0.0;
+  }
+}
+
+/*
+ * message sizes are bytes of MPI_UNSIGNED_CHAR, following the convention of the wrappers
+ * \return median local run-time
+ */
+static double time_primitive(const int prim, const int msg_size, const int nrep, void *sbuf, void *rbuf,
+    int *counts, int *displs, MPI_Comm comm) {
+  double *t;
+  double tmed;
+  int i, r, nb_procs;
+
+  PMPI_Comm_size(comm, &nb_procs);
+  for(i=0; i<nb_procs; i++) {
+    counts[i] = msg_size;
+    displs[i] = i * msg_size;
+  }
+
+  t = (double *)malloc(nrep * sizeof(double));
+  for(r=0; r<nrep; r++) {
+    PMPI_Barrier(comm);
+    t[r] = PMPI_Wtime();
+    switch( prim ) {
+    case PGMPI_PRIM_ALLGATHER:
+      PMPI_Allgather(sbuf, msg_size, MPI_UNSIGNED_CHAR, rbuf, msg_size, MPI_UNSIGNED_CHAR, comm);
+      break;
+    case PGMPI_PRIM_ALLGATHERV:
+      PMPI_Allgatherv(sbuf, msg_size, MPI_UNSIGNED_CHAR, rbuf, counts, displs, MPI_UNSIGNED_CHAR, comm);
+      break;
+    case PGMPI_PRIM_ALLREDUCE:
+      PMPI_Allreduce(sbuf, rbuf, msg_size, MPI_UNSIGNED_CHAR, MPI_SUM, comm);
+      break;
+    case PGMPI_PRIM_ALLTOALL:
+      PMPI_Alltoall(sbuf, msg_size, MPI_UNSIGNED_CHAR, rbuf, msg_size, MPI_UNSIGNED_CHAR, comm);
+      break;
+    case PGMPI_PRIM_ALLTOALLV:
+      PMPI_Alltoallv(sbuf, counts, displs, MPI_UNSIGNED_CHAR, rbuf, counts, displs, MPI_UNSIGNED_CHAR, comm);
+      break;
+    case PGMPI_PRIM_BCAST:
+      PMPI_Bcast(rbuf, msg_size, MPI_UNSIGNED_CHAR, 0, comm);
+      break;
+    case PGMPI_PRIM_EXSCAN:
+      PMPI_Exscan(sbuf, rbuf, msg_size, MPI_UNSIGNED_CHAR, MPI_SUM, comm);
+      break;
+    case PGMPI_PRIM_GATHER:
+      PMPI_Gather(sbuf, msg_size, MPI_UNSIGNED_CHAR, rbuf, msg_size, MPI_UNSIGNED_CHAR, 0, comm);
+      break;
+    case PGMPI_PRIM_GATHERV:
+      PMPI_Gatherv(sbuf, msg_size, MPI_UNSIGNED_CHAR, rbuf, counts, displs, MPI_UNSIGNED_CHAR, 0, comm);
+      break;
+    case PGMPI_PRIM_REDUCE:
+      PMPI_Reduce(sbuf, rbuf, msg_size, MPI_UNSIGNED_CHAR, MPI_SUM, 0, comm);
+      break;
+    case PGMPI_PRIM_REDUCE_SCATTER:
+      PMPI_Reduce_scatter(sbuf, rbuf, counts, MPI_UNSIGNED_CHAR, MPI_SUM, comm);
+      break;
+    case PGMPI_PRIM_REDUCE_SCATTER_BLOCK:
+      PMPI_Reduce_scatter_block(sbuf, rbuf, msg_size, MPI_UNSIGNED_CHAR, MPI_SUM, comm);
+      break;
+    case PGMPI_PRIM_SCAN:
+      PMPI_Scan(sbuf, rbuf, msg_size, MPI_UNSIGNED_CHAR, MPI_SUM, comm);
+      break;
+    case PGMPI_PRIM_SCATTER:
+      PMPI_Scatter(sbuf, msg_size, MPI_UNSIGNED_CHAR, rbuf, msg_size, MPI_UNSIGNED_CHAR, 0, comm);
+      break;
+    case PGMPI_PRIM_SCATTERV:
+      PMPI_Scatterv(sbuf, counts, displs, MPI_UNSIGNED_CHAR, rbuf, msg_size, MPI_UNSIGNED_CHAR, 0, comm);
+      break;
+    default:
+      break;
+    }
+    t[r] = PMPI_Wtime() - t[r];
+  }
+
+  tmed = median(t, nrep);
+  free(t);
+  return tmed;
+}
+
+/*
+ * \return median run-time of a memcpy or MPI_Reduce_local of msg_size bytes
+ */
+static double time_local(const int prim, const int msg_size, const int nrep, void *sbuf, void *rbuf) {
+  double *t;
+  double tmed;
+  int r, k;
+
+  t = (double *)malloc(nrep * sizeof(double));
+  for(r=0; r<nrep; r++) {
+    t[r] = PMPI_Wtime();
+    for(k=0; k<LOCAL_OPS_PER_REP; k++) {
+      if( prim == PGMPI_PRIM_COPY ) {
+        memcpy(rbuf, sbuf, msg_size);
+      } else {
+        PMPI_Reduce_local(sbuf, rbuf, msg_size, MPI_UNSIGNED_CHAR, MPI_SUM);
+      }
+    }
+    t[r] = (PMPI_Wtime() - t[r]) / LOCAL_OPS_PER_REP;
+  }
+
+  tmed = median(t, nrep);
+  free(t);
+  return tmed;
+}
+
+/*
+ * \return median one-way time between rank 0 and rank 1, only valid on rank 0
+ */
+static double time_pingpong(const int msg_size, const int nrep, void *sbuf, void *rbuf) {
+  double *t;
+  double tmed = 0;
+  int r, rank;
+
+  PMPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  t = (double *)malloc(nrep * sizeof(double));
+  for(r=0; r<nrep; r++) {
+    if( rank == 0 ) {
+      t[r] = PMPI_Wtime();
+      PMPI_Send(sbuf, msg_size, MPI_UNSIGNED_CHAR, 1, 0, MPI_COMM_WORLD);
+      PMPI_Recv(rbuf, msg_size, MPI_UNSIGNED_CHAR, 1, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+      t[r] = (PMPI_Wtime() - t[r]) / 2.0;
+    } else if( rank == 1 ) {
+      PMPI_Recv(rbuf, msg_size, MPI_UNSIGNED_CHAR, 0, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+      PMPI_Send(sbuf, msg_size, MPI_UNSIGNED_CHAR, 0, 0, MPI_COMM_WORLD);
+    }
+  }
+
+  if( rank == 0 ) {
+    tmed = median(t, nrep);
+  }
+  free(t);
+  return tmed;
+}
+
+
+int main(int argc, char *argv[]) {
+  int rank, nb_procs;
+  int max_msg_size = DEFAULT_MAX_MSG_SIZE;
+  int nrep = DEFAULT_NREP;
+  int msg_size, n_sizes, prim, i;
+  double *x, *y;
+  double offset, slope;
+  void *sbuf, *rbuf;
+  int *counts, *displs;
+  size_t buf_size;
+  pgmpi_cost_model_t model;
+  int ret = 0;
+
+  MPI_Init(&argc, &argv);
+  PMPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  PMPI_Comm_size(MPI_COMM_WORLD, &nb_procs);
+
+  if( argc < 2 ) {
+    if( rank == 0 ) {
+      fprintf(stderr, "usage: %s <model file> [max msg size] [nrep]\n", argv[0]);
+    }
+    MPI_Finalize();
+    return 1;
+  }
+  if( argc > 2 ) {
+    max_msg_size = atoi(argv[2]);
+  }
+  if( argc > 3 ) {
+    nrep = atoi(argv[3]);
+  }
+  if( max_msg_size < 1 || nrep < 1 ) {
+    if( rank == 0 ) {
+      fprintf(stderr, "invalid max msg size %d or nrep %d\n", max_msg_size, nrep);
+    }
+    MPI_Finalize();
+    return 1;
+  }
+
+  // the mock-ups run base collectives with up to msg_size * p bytes per process
+  buf_size = (size_t)max_msg_size * nb_procs;
+  sbuf = calloc(buf_size, 1);
+  rbuf = calloc(buf_size, 1);
+  counts = (int *)malloc(nb_procs * sizeof(int));
+  displs = (int *)malloc(nb_procs * sizeof(int));
+
+  n_sizes = 0;
+  for(msg_size=1; msg_size<=max_msg_size && msg_size > 0; msg_size*=4) {
+    n_sizes++;
+  }
+  x = (double *)malloc(n_sizes * sizeof(double));
+  y = (double *)malloc(n_sizes * sizeof(double));
+
+  pgmpi_cost_model_init(&model);
+
+  // alpha and beta
+  if( nb_procs > 1 ) {
+    for(i=0, msg_size=1; i<n_sizes; i++, msg_size*=4) {
+      x[i] = msg_size;
+      y[i] = time_pingpong(msg_size, nrep, sbuf, rbuf);
+    }
+    if( rank == 0 ) {
+      fit_linear(n_sizes, x, y, &offset, &slope);
+      model.alpha = offset;
+      model.beta = slope;
+    }
+  }
+
+  // gamma and delta, the local operations are part of the model as well
+  for(prim=PGMPI_PRIM_COPY; prim<=PGMPI_PRIM_REDUCE_LOCAL; prim++) {
+    for(i=0, msg_size=1; i<n_sizes; i++, msg_size*=4) {
+      double tlocal = time_local(prim, msg_size, nrep, sbuf, rbuf);
+      double tmax;
+      PMPI_Reduce(&tlocal, &tmax, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+      x[i] = msg_size;
+      y[i] = tmax;
+      if( rank == 0 ) {
+        pgmpi_cost_model_add_sample(&model, prim, nb_procs, msg_size, tmax);
+      }
+    }
+    if( rank == 0 ) {
+      fit_linear(n_sizes, x, y, &offset, &slope);
+      if( prim == PGMPI_PRIM_COPY ) {
+        model.delta = slope;
+      } else {
+        model.gamma = slope;
+      }
+    }
+  }
+
+  // base collectives for the number of processes of the job
+  for(prim=0; prim<PGMPI_PRIM_COPY; prim++) {
+    for(i=0, msg_size=1; i<n_sizes; i++, msg_size*=4) {
+      double tlocal = time_primitive(prim, msg_size, nrep, sbuf, rbuf, counts, displs, MPI_COMM_WORLD);
+      double tmax;
+      PMPI_Reduce(&tlocal, &tmax, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+      if( rank == 0 ) {
+        pgmpi_cost_model_add_sample(&model, prim, nb_procs, msg_size, tmax);
+      }
+    }
+  }
+
+  if( rank == 0 ) {
+    pgmpi_cost_model_sort(&model);
+    if( pgmpi_cost_model_write(argv[1], &model) == 0 ) {
+      printf("alpha=%.3e beta=%.3e gamma=%.3e delta=%.3e, wrote %d measurements to %s\n",
+          model.alpha, model.beta, model.gamma, model.delta, model.n_samples, argv[1]);
+    } else {
+      fprintf(stderr, "cannot write %s\n", argv[1]);
+      ret = 1;
+    }
+  }
+
+  pgmpi_cost_model_free(&model);
+  free(x);
+  free(y);
+  free(counts);
+  free(displs);
+  free(sbuf);
+  free(rbuf);
+
+  MPI_Finalize();
+
+  return ret;
+}
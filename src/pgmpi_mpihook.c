@@ -29,6 +29,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <assert.h>
+#include <signal.h>
 
 #include <mpi.h>
 #include "pgmpi_tune.h"
@@ -38,16 +39,27 @@
 #include "config/pgmpi_config_reader.h"
 #include "util/pgmpi_parse_cli.h"
 #include "util/keyvalue_store.h"
+#include "util/pgmpi_callsite.h"
+#include "util/pgmpi_skew.h"
+#include "util/pgmpi_nesting.h"
 #include "pgmpi_algid_store.h"
 
 #define ZF_LOG_LEVEL MY_ZF_LOG_LEVEL
 #include "log/zf_log.h"
 
 static pgmpi_dictionary_t hashmap;
+static volatile sig_atomic_t reload_requested = 0;
+static char *callsite_table_fname = NULL;
+static char *skew_stats_fname = NULL;
 
 extern pgmpi_context_hook_t context;
 
+int pgmpi_nesting_depth = 0;
+
 int check_and_override_lib_env_params(int *argc, char ***argv);
+static void init_callsites();
+static void init_skew();
+static void init_buffers();
 
 int MPI_Init(int *argc, char ***argv) {
   int ret;
@@ -71,9 +83,19 @@ int MPI_Finalize( void ) {
 
 void fill_and_read_pgmpi_config() {
   char *conf_fname = NULL;
+  int rank;
 
   pgmpi_config_init();
 
+  // only rank 0 touches the file system, the others receive the configuration
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  if( rank != 0 ) {
+    if( pgmpi_config_bcast(0, MPI_COMM_WORLD) != 0 ) {
+      ZF_LOGE("cannot receive configuration, using the default config");
+    }
+    return;
+  }
+
   conf_fname = pgmpitune_get_value_from_dict(&hashmap, "config_file");
 
   if( conf_fname == NULL ) {
@@ -89,6 +111,7 @@ void fill_and_read_pgmpi_config() {
     free(conf_fname);
   }
 
+  pgmpi_config_bcast(0, MPI_COMM_WORLD);
 }
 
 void free_pgmpi_config() {
@@ -168,6 +191,73 @@ int check_and_override_lib_env_params(int *argc, char ***argv) {
 
 
 
+/*
+ * --callsites=on keys decisions on call sites, any other value except "off"
+ * also names the file that rank 0 writes the call sites to at the end
+ */
+static void init_callsites() {
+  char *mode;
+
+  free(callsite_table_fname);
+  callsite_table_fname = NULL;
+
+  mode = pgmpitune_get_value_from_dict(&hashmap, "callsite_mode");
+  if( mode == NULL || strcmp(mode, "off") == 0 ) {
+    pgmpi_callsite_init(0);
+  } else {
+    if( strcmp(mode, "on") != 0 ) {
+      callsite_table_fname = strdup(mode);
+    }
+    pgmpi_callsite_init(1);
+  }
+  free(mode);
+}
+
+/*
+ * --skew_interval=N samples the arrival skew of every N-th call,
+ * rank 0 writes its statistics to --skew_out at the end
+ */
+static void init_skew() {
+  char *val;
+  int interval = 0;
+
+  free(skew_stats_fname);
+  skew_stats_fname = pgmpitune_get_value_from_dict(&hashmap, "skew_output_file");
+
+  val = pgmpitune_get_value_from_dict(&hashmap, "skew_interval");
+  if( val != NULL ) {
+    interval = atoi(val);
+    if( interval < 0 ) {
+      ZF_LOGW("invalid skew interval %s, skew estimation disabled", val);
+      interval = 0;
+    }
+    free(val);
+  }
+  pgmpi_skew_init(interval);
+}
+
+/*
+ * the mock-ups are selected by the smallest buffers of all processes,
+ * so that all processes select the same one
+ */
+static void init_buffers() {
+  size_t size_msg_buffer = 0, size_int_buffer = 0;
+
+  if( pgmpi_config_get_long_value("size_msg_buffer_bytes", &size_msg_buffer) == -1 ) {
+    ZF_LOGE("cannot find size_msg_buffer_bytes in config, setting to 0");
+    size_msg_buffer = 0;
+  }
+  if( pgmpi_config_get_long_value("size_int_buffer_bytes", &size_int_buffer) == -1 ) {
+    ZF_LOGE("cannot find size_int_buffer_bytes in config, setting to 0");
+    size_int_buffer = 0;
+  }
+
+  if( pgmpi_allocate_buffers(size_msg_buffer, size_int_buffer) != BUF_NO_ERROR ) {
+    ZF_LOGE("cannot allocate buffers of %zu / %zu bytes", size_msg_buffer, size_int_buffer);
+  }
+  pgmpi_buffers_agree(MPI_COMM_WORLD);
+}
+
 void init_pgtune_lib(int *argc, char ***argv) {
 
   pgmpitune_init_dictionary(&hashmap);
@@ -176,25 +266,17 @@ void init_pgtune_lib(int *argc, char ***argv) {
 
   parse_cli_arguments(&hashmap, argc, argv);
 
+  init_callsites();
+
   if( PGMPI_ENABLE_ALGID_STORING ) {
     pgmpi_init_algid_maps();
   }
 
   fill_and_read_pgmpi_config();
 
-  {
-    size_t size_msg_buffer = 0, size_int_buffer = 0;
-    if( pgmpi_config_get_long_value("size_msg_buffer_bytes", &size_msg_buffer) == -1 ) {
-      ZF_LOGE("cannot find size_msg_buffer_bytes in config, setting to 0");
-      size_msg_buffer = 0;
-    }
-    if( pgmpi_config_get_long_value("size_int_buffer_bytes", &size_int_buffer) == -1 ) {
-      ZF_LOGE("cannot find size_int_buffer_bytes in config, setting to 0");
-      size_int_buffer = 0;
-    }
+  init_buffers();
 
-    pgmpi_allocate_buffers(size_msg_buffer, size_int_buffer);
-  }
+  init_skew();
 
   context.context_init();
 }
@@ -213,11 +295,34 @@ void finalize_pgtune_lib() {
 
   free_pgmpi_config();
 
+  // the context may still need the modules, e.g., to write learned profiles
+  context.context_free();
+
+  if( callsite_table_fname != NULL ) {
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    if( rank == 0 ) {
+      pgmpi_callsite_write(callsite_table_fname);
+    }
+    free(callsite_table_fname);
+    callsite_table_fname = NULL;
+  }
+  pgmpi_callsite_free();
+
+  if( skew_stats_fname != NULL ) {
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    if( rank == 0 ) {
+      pgmpi_skew_write(skew_stats_fname);
+    }
+    free(skew_stats_fname);
+    skew_stats_fname = NULL;
+  }
+  pgmpi_skew_free();
+
   pgmpi_modules_free();
 
   pgmpitune_cleanup_dictionary(&hashmap);
-
-  context.context_free();
 }
 
 
@@ -230,15 +335,62 @@ int get_pgmpi_context() {
 }
 
 
-int pgtune_get_algorithm(pgmpi_collectives_t cid, int msg_size, int comm_size,
+int pgtune_get_algorithm(pgmpi_collectives_t cid, MPI_Count msg_size, MPI_Datatype datatype, MPI_Op op, MPI_Comm comm,
     int *alg_id) {
-  return context.context_get_algorithm(cid, msg_size, comm_size, alg_id);
+  return context.context_get_algorithm(cid, msg_size, datatype, op, comm, alg_id);
+}
+
+int pgtune_get_skew_stats(pgmpi_collectives_t cid, MPI_Comm comm, pgmpi_skew_stats_t *stats) {
+  return pgmpi_skew_get_stats(cid, comm, stats);
+}
+
+void pgtune_report_time(pgmpi_collectives_t cid, MPI_Count msg_size, MPI_Comm comm, int alg_id, double time) {
+  if( context.context_report_time != NULL ) {
+    context.context_report_time(cid, msg_size, comm, alg_id, time);
+  }
+}
+
+static void reload_signal_handler(int signum) {
+  reload_requested = 1;
+}
+
+void pgtune_request_reload(void) {
+  reload_requested = 1;
+}
+
+int pgmpi_context_take_reload_request() {
+  int ret = reload_requested;
+  reload_requested = 0;
+  return ret;
+}
+
+int pgmpi_context_install_reload_signal(int signum) {
+  struct sigaction sa;
+
+  memset(&sa, 0, sizeof(sa));
+  sa.sa_handler = &reload_signal_handler;
+  sigemptyset(&sa.sa_mask);
+  sa.sa_flags = SA_RESTART;
+  if( sigaction(signum, &sa, NULL) != 0 ) {
+    ZF_LOGE("cannot install handler for signal %d", signum);
+    return -1;
+  }
+  return 0;
 }
 
 void pgtune_override_argv_parameter(int argc, char **argv) {
   pgmpitune_cleanup_dictionary(&hashmap);
   pgmpitune_init_dictionary(&hashmap);
   parse_cli_arguments(&hashmap, &argc, &argv);
+  init_callsites();
+  if( pgmpitune_dict_has_key(&hashmap, "config_file") ) {
+    // a new configuration may change the buffer sizes
+    free_pgmpi_config();
+    fill_and_read_pgmpi_config();
+    pgmpi_free_buffers();
+    init_buffers();
+  }
+  init_skew();
   // need to reinit context to pass args to modules
   context.context_init();
 }
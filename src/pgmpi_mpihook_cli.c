@@ -46,13 +46,15 @@
 
 static void context_init();
 static void context_free();
-static int context_get_algorithm(pgmpi_collectives_t cid, int msg_size, int comm_size, int *alg_id);
+static int context_get_algorithm(pgmpi_collectives_t cid, MPI_Count msg_size, MPI_Datatype datatype, MPI_Op op,
+    MPI_Comm comm, int *alg_id);
 
 pgmpi_context_hook_t context = {
      CONTEXT_CLI,
      &context_init,
      &context_free,
-     &context_get_algorithm
+     &context_get_algorithm,
+     NULL
  };
 
 static void pass_cli_arguments_to_modules();
@@ -93,8 +95,8 @@ static void context_free() {
 }
 
 
-static int context_get_algorithm(pgmpi_collectives_t cid, int msg_size, int comm_size,
-    int *alg_id) {
+static int context_get_algorithm(pgmpi_collectives_t cid, MPI_Count msg_size, MPI_Datatype datatype, MPI_Op op,
+    MPI_Comm comm, int *alg_id) {
   assert(1==1);
   return -1;
 }
@@ -0,0 +1,272 @@
+/*  PGMPITuneLib - Library for Autotuning MPI Collectives using Performance Guidelines
+ *  
+ *  Copyright 2017 Sascha Hunold, Alexandra Carpen-Amarie
+ *      Research Group for Parallel Computing
+ *      Faculty of Informatics
+ *      Vienna University of Technology, Austria
+ *  
+ *  <license>
+ *      This library is free software; you can redistribute it
+ *      and/or modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *  
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *  
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free
+ *      Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *      Boston, MA 02110-1301 USA
+ *  </license>
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <mpi.h>
+#include "pgmpi_tune.h"
+#include "tuning/pgmpi_dtree.h"
+#include "tuning/pgmpi_comm_topology.h"
+#include "util/pgmpi_pack.h"
+#include "pgmpi_mpihook_private.h"
+
+#define ZF_LOG_LEVEL MY_ZF_LOG_LEVEL
+#include "log/zf_log.h"
+
+/*
+ * context of pgmpidtree, the algorithms are selected by a learned model
+ * (decision tree or tree ensemble) instead of profiles
+ */
+
+/*
+ * decision for one interval between two bytes thresholds of a forest
+ * the datatype size and operation class of the last evaluation are kept as tag
+ */
+typedef struct {
+  int valid;
+  int dtype_size;
+  int op_class;
+  int alg_id;
+} memo_entry_t;
+
+/*
+ * per-communicator state, attached to the communicator as an MPI attribute
+ */
+typedef struct {
+  unsigned int generation;
+  double features[PGMPI_DTREE_NB_FEATURES];       /* p, nodes and ppn are fixed per communicator */
+  memo_entry_t *memo[CID_MARKER_END_DO_NOT_USE_OR_CHANGE];  /* n_bytes_thresholds+1 entries per forest */
+} dtree_comm_state_t;
+
+static pgmpi_dtree_model_t model;
+static unsigned int generation = 0;
+static int dtree_keyval = MPI_KEYVAL_INVALID;
+
+static void context_init();
+static void context_free();
+static int context_get_algorithm(pgmpi_collectives_t cid, MPI_Count msg_size, MPI_Datatype datatype, MPI_Op op,
+    MPI_Comm comm, int *alg_id);
+static void read_and_bcast_model(const char *fname);
+static int dtree_delete_fn(MPI_Comm comm, int keyval, void *attribute_val, void *extra_state);
+static void state_clear(dtree_comm_state_t *state);
+static dtree_comm_state_t *get_state(MPI_Comm comm);
+
+pgmpi_context_hook_t context = {
+     CONTEXT_DTREE,
+     &context_init,
+     &context_free,
+     &context_get_algorithm,
+     NULL
+ };
+
+
+/*
+ * rank 0 reads the model and broadcasts it
+ */
+static void read_and_bcast_model(const char *fname) {
+  int rank;
+  pgmpi_pack_buf_t buf;
+
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+  pgmpi_pack_init(&buf);
+  if( rank == 0 ) {
+    if( fname != NULL ) {
+      ZF_LOGV("reading model from %s", fname);
+      if( pgmpi_dtree_model_read(fname, &model) != 0 ) {
+        ZF_LOGE("cannot read model from %s, using default algorithms", fname);
+      }
+    } else {
+      ZF_LOGW("no model given (--dtree), using default algorithms");
+    }
+    pgmpi_dtree_model_pack(&buf, &model);
+  }
+
+  if( pgmpi_pack_bcast(&buf, 0, MPI_COMM_WORLD) != 0 ) {
+    ZF_LOGE("cannot broadcast model");
+  } else if( rank != 0 && pgmpi_dtree_model_unpack(&buf, &model) != 0 ) {
+    ZF_LOGE("cannot unpack model");
+  }
+
+  pgmpi_pack_free(&buf);
+}
+
+static void state_clear(dtree_comm_state_t *state) {
+  int i;
+
+  for(i=0; i<NUM_COLLECTIVES; i++) {
+    free(state->memo[i]);
+    state->memo[i] = NULL;
+  }
+}
+
+static int dtree_delete_fn(MPI_Comm comm, int keyval, void *attribute_val, void *extra_state) {
+  dtree_comm_state_t *state = (dtree_comm_state_t *)attribute_val;
+
+  if( state != NULL ) {
+    state_clear(state);
+    free(state);
+  }
+  return MPI_SUCCESS;
+}
+
+/*
+ * the layout is only detected if the model splits on it, as the detection is
+ * collective over comm (like the first collective call itself)
+ */
+static dtree_comm_state_t *get_state(MPI_Comm comm) {
+  dtree_comm_state_t *state = NULL;
+  pgmpi_comm_shape_t shape;
+  int flag = 0;
+  int i, nb_procs;
+
+  if( dtree_keyval == MPI_KEYVAL_INVALID ) {
+    return NULL;
+  }
+
+  MPI_Comm_get_attr(comm, dtree_keyval, &state, &flag);
+  if( flag && state->generation == generation ) {
+    return state;
+  }
+
+  if( !flag ) {
+    ZF_LOGV("first use of communicator, creating model state");
+    state = (dtree_comm_state_t *)calloc(1, sizeof(dtree_comm_state_t));
+    if( MPI_Comm_set_attr(comm, dtree_keyval, state) != MPI_SUCCESS ) {
+      ZF_LOGE("cannot attach model state to communicator");
+      free(state);
+      return NULL;
+    }
+  } else {
+    state_clear(state);
+  }
+  state->generation = generation;
+
+  MPI_Comm_size(comm, &nb_procs);
+  if( model.uses_layout ) {
+    pgmpi_comm_topology_detect(comm, &shape);
+  } else {
+    pgmpi_comm_topology_unknown(nb_procs, &shape);
+  }
+  state->features[PGMPI_DTREE_FEATURE_P] = nb_procs;
+  state->features[PGMPI_DTREE_FEATURE_NODES] = (shape.nb_nodes > 0) ? shape.nb_nodes : -1;
+  state->features[PGMPI_DTREE_FEATURE_PPN] = (shape.nb_nodes > 0) ? shape.ppn : -1;
+
+  for(i=0; i<NUM_COLLECTIVES; i++) {
+    if( model.forest[i] != NULL ) {
+      state->memo[i] = (memo_entry_t *)calloc(model.forest[i]->n_bytes_thresholds + 1, sizeof(memo_entry_t));
+    }
+  }
+
+  return state;
+}
+
+
+static void context_init() {
+  pgmpi_dictionary_t *hashmap;
+  char *fname;
+  int ret;
+
+  hashmap = pgmpi_context_get_cli_dict();
+  fname = pgmpitune_get_value_from_dict(hashmap, "dtree_file");
+
+  // context may be re-initialized by pgtune_override_argv_parameter
+  pgmpi_dtree_model_free(&model);
+  generation++;
+
+  read_and_bcast_model(fname);
+  free(fname);
+
+  if( dtree_keyval == MPI_KEYVAL_INVALID ) {
+    ret = MPI_Comm_create_keyval(MPI_COMM_NULL_COPY_FN, &dtree_delete_fn, &dtree_keyval, NULL);
+    if( ret != MPI_SUCCESS ) {
+      ZF_LOGE("cannot create keyval for model state");
+      dtree_keyval = MPI_KEYVAL_INVALID;
+    }
+  }
+}
+
+
+static void context_free() {
+  void *val;
+  int flag;
+
+  if( dtree_keyval != MPI_KEYVAL_INVALID ) {
+    // attributes of MPI_COMM_WORLD and MPI_COMM_SELF are not necessarily deleted by MPI_Finalize
+    MPI_Comm_get_attr(MPI_COMM_WORLD, dtree_keyval, &val, &flag);
+    if( flag ) {
+      MPI_Comm_delete_attr(MPI_COMM_WORLD, dtree_keyval);
+    }
+    MPI_Comm_get_attr(MPI_COMM_SELF, dtree_keyval, &val, &flag);
+    if( flag ) {
+      MPI_Comm_delete_attr(MPI_COMM_SELF, dtree_keyval);
+    }
+    MPI_Comm_free_keyval(&dtree_keyval);
+    dtree_keyval = MPI_KEYVAL_INVALID;
+  }
+
+  pgmpi_dtree_model_free(&model);
+}
+
+
+static int context_get_algorithm(pgmpi_collectives_t cid, MPI_Count msg_size, MPI_Datatype datatype, MPI_Op op,
+    MPI_Comm comm, int *alg_id) {
+  const pgmpi_dtree_forest_t *forest;
+  dtree_comm_state_t *state;
+  memo_entry_t *e;
+  int dtype_size, op_class;
+
+  *alg_id = 0;
+  forest = model.forest[cid];
+  if( forest == NULL ) {
+    return 0;
+  }
+
+  state = get_state(comm);
+  if( state == NULL ) {
+    return 0;
+  }
+
+  MPI_Type_size(datatype, &dtype_size);
+  op_class = pgmpi_dtree_op_class(op);
+
+  e = &state->memo[cid][pgmpi_dtree_forest_bytes_interval(forest, msg_size)];
+  if( !e->valid || e->dtype_size != dtype_size || e->op_class != op_class ) {
+    state->features[PGMPI_DTREE_FEATURE_BYTES] = msg_size;
+    state->features[PGMPI_DTREE_FEATURE_DTYPE_SIZE] = dtype_size;
+    state->features[PGMPI_DTREE_FEATURE_OP] = op_class;
+    e->alg_id = pgmpi_dtree_forest_eval(forest, state->features);
+    e->dtype_size = dtype_size;
+    e->op_class = op_class;
+    e->valid = 1;
+    ZF_LOGV("model selects alg %d for cid %d, msg_size=%lld", e->alg_id, cid, (long long)msg_size);
+  }
+
+  *alg_id = e->alg_id;
+  return 0;
+}
@@ -0,0 +1,157 @@
+/*  PGMPITuneLib - Library for Autotuning MPI Collectives using Performance Guidelines
+ *  
+ *  Copyright 2017 Sascha Hunold, Alexandra Carpen-Amarie
+ *      Research Group for Parallel Computing
+ *      Faculty of Informatics
+ *      Vienna University of Technology, Austria
+ *  
+ *  <license>
+ *      This library is free software; you can redistribute it
+ *      and/or modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *  
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *  
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free
+ *      Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *      Boston, MA 02110-1301 USA
+ *  </license>
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <mpi.h>
+#include "pgmpi_tune.h"
+#include "tuning/pgmpi_cost_model.h"
+#include "util/pgmpi_pack.h"
+#include "pgmpi_mpihook_private.h"
+
+#define ZF_LOG_LEVEL MY_ZF_LOG_LEVEL
+#include "log/zf_log.h"
+
+/*
+ * context of pgmpimodel, the algorithms are selected by the predictions of a
+ * calibrated cost model (see pgmpi_calibrate) instead of measured profiles
+ */
+
+#define MEMO_SIZE 1024   /* must be a power of two */
+
+typedef struct {
+  int valid;
+  int cid;
+  int nb_procs;
+  MPI_Count msg_size;
+  int alg_id;
+} memo_entry_t;
+
+static pgmpi_cost_model_t model;
+static memo_entry_t memo[MEMO_SIZE];
+
+static void context_init();
+static void context_free();
+static int context_get_algorithm(pgmpi_collectives_t cid, MPI_Count msg_size, MPI_Datatype datatype, MPI_Op op,
+    MPI_Comm comm, int *alg_id);
+static void read_and_bcast_model(const char *fname);
+
+pgmpi_context_hook_t context = {
+     CONTEXT_MODEL,
+     &context_init,
+     &context_free,
+     &context_get_algorithm,
+     NULL
+ };
+
+
+/*
+ * rank 0 reads the calibration file and broadcasts the model
+ */
+static void read_and_bcast_model(const char *fname) {
+  int rank;
+  pgmpi_pack_buf_t buf;
+
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+  pgmpi_pack_init(&buf);
+  if( rank == 0 ) {
+    if( fname != NULL ) {
+      if( pgmpi_cost_model_read(fname, &model) != 0 ) {
+        ZF_LOGE("cannot read cost model from %s, using default parameters", fname);
+        pgmpi_cost_model_free(&model);
+        pgmpi_cost_model_init(&model);
+      }
+    } else {
+      ZF_LOGI("no cost model given (--cost_model), using default parameters");
+    }
+    pgmpi_cost_model_pack(&buf, &model);
+  }
+
+  if( pgmpi_pack_bcast(&buf, 0, MPI_COMM_WORLD) != 0 ) {
+    ZF_LOGE("cannot broadcast cost model");
+  } else if( rank != 0 && pgmpi_cost_model_unpack(&buf, &model) != 0 ) {
+    ZF_LOGE("cannot unpack cost model");
+    pgmpi_cost_model_init(&model);
+  }
+
+  pgmpi_pack_free(&buf);
+}
+
+
+static void context_init() {
+  pgmpi_dictionary_t *hashmap;
+  char *fname;
+
+  hashmap = pgmpi_context_get_cli_dict();
+  fname = pgmpitune_get_value_from_dict(hashmap, "cost_model_file");
+
+  // context may be re-initialized by pgtune_override_argv_parameter
+  pgmpi_cost_model_free(&model);
+  pgmpi_cost_model_init(&model);
+  memset(memo, 0, sizeof(memo));
+
+  read_and_bcast_model(fname);
+  free(fname);
+}
+
+
+static void context_free() {
+  pgmpi_cost_model_free(&model);
+}
+
+
+static int context_get_algorithm(pgmpi_collectives_t cid, MPI_Count msg_size, MPI_Datatype datatype, MPI_Op op,
+    MPI_Comm comm, int *alg_id) {
+  int nb_procs;
+  unsigned int h;
+  memo_entry_t *e;
+
+  PMPI_Comm_size(comm, &nb_procs);
+
+  h = ((unsigned int)cid * 2654435761u) ^ ((unsigned int)nb_procs * 40503u) ^ (unsigned int)msg_size ^
+      (unsigned int)((unsigned long long)msg_size >> 32);
+  h ^= h >> 15;
+  e = &memo[h & (MEMO_SIZE - 1)];
+
+  if( !e->valid || e->cid != cid || e->nb_procs != nb_procs || e->msg_size != msg_size ) {
+    int selected = 0;
+    if( pgmpi_cost_model_select(&model, cid, nb_procs, msg_size, &selected) != 0 ) {
+      selected = 0;
+    }
+    e->valid = 1;
+    e->cid = cid;
+    e->nb_procs = nb_procs;
+    e->msg_size = msg_size;
+    e->alg_id = selected;
+    ZF_LOGV("model selects alg %d for cid %d, p=%d, msg_size=%lld", selected, cid, nb_procs, (long long)msg_size);
+  }
+
+  *alg_id = e->alg_id;
+  return 0;
+}
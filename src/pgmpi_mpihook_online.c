@@ -0,0 +1,148 @@
+/*  PGMPITuneLib - Library for Autotuning MPI Collectives using Performance Guidelines
+ *  
+ *  Copyright 2017 Sascha Hunold, Alexandra Carpen-Amarie
+ *      Research Group for Parallel Computing
+ *      Faculty of Informatics
+ *      Vienna University of Technology, Austria
+ *  
+ *  <license>
+ *      This library is free software; you can redistribute it
+ *      and/or modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *  
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *  
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free
+ *      Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *      Boston, MA 02110-1301 USA
+ *  </license>
+ */
+
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <mpi.h>
+#include "pgmpi_tune.h"
+#include "tuning/pgmpi_online_tuner.h"
+#include "util/pgmpi_nesting.h"
+#include "pgmpi_mpihook_private.h"
+
+#define ZF_LOG_LEVEL MY_ZF_LOG_LEVEL
+#include "log/zf_log.h"
+
+/*
+ * context of pgmpionline, the algorithms are learned while the application runs
+ * instead of being read from profiles
+ */
+
+static char *output_path = NULL;   /* directory for the learned profiles, if given */
+
+static void context_init();
+static void context_free();
+static int context_get_algorithm(pgmpi_collectives_t cid, MPI_Count msg_size, MPI_Datatype datatype, MPI_Op op,
+    MPI_Comm comm, int *alg_id);
+static void context_report_time(pgmpi_collectives_t cid, MPI_Count msg_size, MPI_Comm comm, int alg_id, double time);
+
+pgmpi_context_hook_t context = {
+     CONTEXT_ONLINE,
+     &context_init,
+     &context_free,
+     &context_get_algorithm,
+     &context_report_time
+ };
+
+
+static void context_init() {
+  pgmpi_dictionary_t *hashmap;
+  pgmpi_online_params_t params;
+  char *val;
+
+  hashmap = pgmpi_context_get_cli_dict();
+  pgmpi_online_params_default(&params);
+
+  val = pgmpitune_get_value_from_dict(hashmap, "online_trials");
+  if( val != NULL ) {
+    params.nb_trials = atoi(val);
+    free(val);
+  }
+
+  val = pgmpitune_get_value_from_dict(hashmap, "online_mode");
+  if( val != NULL ) {
+    if( strcmp(val, "bandit") == 0 ) {
+      params.bandit = 1;
+    } else if( strcmp(val, "once") != 0 ) {
+      ZF_LOGE("unknown online mode \"%s\", using once", val);
+    }
+    free(val);
+  }
+
+  val = pgmpitune_get_value_from_dict(hashmap, "online_epsilon");
+  if( val != NULL ) {
+    params.epsilon = atof(val);
+    free(val);
+  }
+
+  val = pgmpitune_get_value_from_dict(hashmap, "online_switch_t");
+  if( val != NULL ) {
+    params.switch_t = atof(val);
+    free(val);
+  }
+
+  val = pgmpitune_get_value_from_dict(hashmap, "online_seed");
+  if( val != NULL ) {
+    params.seed = (unsigned int)strtoul(val, NULL, 10);
+    free(val);
+  }
+
+  // context may be re-initialized by pgtune_override_argv_parameter
+  free(output_path);
+  output_path = pgmpitune_get_value_from_dict(hashmap, "online_output_path");
+
+  pgmpi_online_tuner_init(&params);
+}
+
+
+static void context_free() {
+  int rank;
+
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  // communicators that do not contain rank 0 learn decisions as well
+  if( output_path != NULL && pgmpi_online_tuner_gather_decisions(MPI_COMM_WORLD, 0) != 0 ) {
+    ZF_LOGE("learned profiles may miss the decisions of other ranks");
+  }
+  if( rank == 0 && output_path != NULL ) {
+    if( pgmpi_online_tuner_write_profiles(output_path) != 0 ) {
+      ZF_LOGE("cannot write learned profiles to %s", output_path);
+    }
+  }
+  free(output_path);
+  output_path = NULL;
+
+  pgmpi_online_tuner_free();
+}
+
+
+static int context_get_algorithm(pgmpi_collectives_t cid, MPI_Count msg_size, MPI_Datatype datatype, MPI_Op op,
+    MPI_Comm comm, int *alg_id) {
+  // the time of a nested call is part of the time of the mock-up that called it
+  if( pgmpi_nesting_is_nested() ) {
+    return pgmpi_online_tuner_get_committed(cid, msg_size, comm, alg_id);
+  }
+  return pgmpi_online_tuner_get_algorithm(cid, msg_size, comm, alg_id);
+}
+
+
+static void context_report_time(pgmpi_collectives_t cid, MPI_Count msg_size, MPI_Comm comm, int alg_id, double time) {
+  if( pgmpi_nesting_is_nested() ) {
+    return;
+  }
+  pgmpi_online_tuner_report_time(cid, msg_size, comm, alg_id, time);
+}
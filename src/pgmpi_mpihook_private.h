@@ -9,4 +9,16 @@
 
 pgmpi_dictionary_t *pgmpi_context_get_cli_dict();
 
+/*!
+  reload requests come from pgtune_request_reload or a signal
+  \return 1 if a reload was requested since the last call, 0 otherwise
+*/
+int pgmpi_context_take_reload_request();
+
+/*!
+  installs a handler that requests a reload when signum is received
+  \return 0 on success, -1 on error
+*/
+int pgmpi_context_install_reload_signal(int signum);
+
 #endif //PGMPITUNELIB_SRC_PGMPI_MPIHOOK_PRIVATE_H
@@ -0,0 +1,76 @@
+/*  PGMPITuneLib - Library for Autotuning MPI Collectives using Performance Guidelines
+ *  
+ *  Copyright 2017 Sascha Hunold, Alexandra Carpen-Amarie
+ *      Research Group for Parallel Computing
+ *      Faculty of Informatics
+ *      Vienna University of Technology, Austria
+ *  
+ *  <license>
+ *      This library is free software; you can redistribute it
+ *      and/or modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *  
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *  
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free
+ *      Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *      Boston, MA 02110-1301 USA
+ *  </license>
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <mpi.h>
+#include "pgmpi_tune.h"
+#include "pgmpi_mpihook_private.h"
+
+#define ZF_LOG_LEVEL MY_ZF_LOG_LEVEL
+#include "log/zf_log.h"
+
+#include "pgmpi_static_decisions.h"   /* generated by pgmpi_prf2c */
+
+/*
+ * context of pgmpituned_static, the decisions are compiled into the library,
+ * so there is nothing to read at startup and the wrappers do not go
+ * through this hook (see PGMPI_STATIC_TUNING)
+ */
+
+static void context_init();
+static void context_free();
+static int context_get_algorithm(pgmpi_collectives_t cid, MPI_Count msg_size, MPI_Datatype datatype, MPI_Op op,
+    MPI_Comm comm, int *alg_id);
+
+pgmpi_context_hook_t context = {
+     CONTEXT_STATIC,
+     &context_init,
+     &context_free,
+     &context_get_algorithm,
+     NULL
+ };
+
+
+static void context_init() {
+  pgmpi_dictionary_t *hashmap;
+
+  hashmap = pgmpi_context_get_cli_dict();
+  if( pgmpitune_dict_has_key(hashmap, "profile_path") || pgmpitune_dict_has_key(hashmap, "profile_db") ) {
+    ZF_LOGW("profiles are compiled into this library, ignoring --ppath and --pdb");
+  }
+}
+
+
+static void context_free() {
+}
+
+
+static int context_get_algorithm(pgmpi_collectives_t cid, MPI_Count msg_size, MPI_Datatype datatype, MPI_Op op,
+    MPI_Comm comm, int *alg_id) {
+  *alg_id = pgmpi_static_select(cid, msg_size, datatype, op, comm);
+  return 0;
+}
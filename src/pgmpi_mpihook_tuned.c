@@ -29,13 +29,19 @@
 #include <stdlib.h>
 #include <string.h>
 #include <assert.h>
+#include <signal.h>
+#include <sys/stat.h>
 
 #include <mpi.h>
 #include "pgmpi_tune.h"
 #include "bufmanager/pgmpi_buf.h"
 #include "config/pgmpi_config.h"
 #include "tuning/pgmpi_function_replacer.h"
+#include "tuning/pgmpi_comm_cache.h"
 #include "tuning/pgmpi_profile_reader.h"
+#include "tuning/pgmpi_profile_db.h"
+#include "util/pgmpi_callsite.h"
+#include "util/pgmpi_skew.h"
 #include "pgmpi_algid_store.h"
 #include "pgmpi_mpihook_private.h"
 
@@ -46,35 +52,150 @@
 
 /****************************************/
 
-static alg_lookup_table_t lookup;
+/*
+ * everything a lookup table refers to, so that it can be released as a whole
+ */
+typedef struct {
+  alg_lookup_table_t lookup;
+  int allocated;
+  pgmpi_profile_db_t profile_db;   /* mapped binary profiles, if given */
+  pgmpi_profile_t *profiles;       /* profiles read from the profile path */
+  double mtime;                    /* newest modification time of the sources (rank 0 only) */
+} lookup_slot_t;
+
+/*
+ * double buffering: a reload builds the table in the inactive slot and then
+ * publishes it, the previous table stays valid until the next reload
+ */
+static lookup_slot_t slots[2];
+static lookup_slot_t *active = &slots[0];
+
+static int reload_interval = 0;         /* world collectives between reload checks, 0: no reloading */
+static unsigned long world_calls = 0;
 
 /****************************************/
 
 static void context_init();
 static void context_free();
-static int context_get_algorithm(pgmpi_collectives_t cid, int msg_size, int comm_size, int *alg_id);
+static int context_get_algorithm(pgmpi_collectives_t cid, MPI_Count msg_size, MPI_Datatype datatype, MPI_Op op,
+    MPI_Comm comm, int *alg_id);
 
-static void fill_lookup_table();
-static void free_lookup_table();
+static void fill_lookup_table(lookup_slot_t *slot);
+static void free_lookup_table(lookup_slot_t *slot);
+static void read_and_bcast_profiles(const char *prof_path, pgmpi_profile_t **profiles, int *n_profiles);
+static double get_sources_mtime();
+static void check_reload();
+static void init_reloading();
 
 
 pgmpi_context_hook_t context = {
      CONTEXT_TUNED,
      &context_init,
      &context_free,
-     &context_get_algorithm
+     &context_get_algorithm,
+     NULL
  };
 
 
 /****************************************/
 
-static void fill_lookup_table() {
+/*
+ * rank 0 reads all profiles and broadcasts them, so that the other ranks
+ * do not access the file system
+ */
+static void read_and_bcast_profiles(const char *prof_path, pgmpi_profile_t **profiles, int *n_profiles) {
+  int rank;
+  int i, n;
+  pgmpi_pack_buf_t buf;
+
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+  *profiles = NULL;
+  *n_profiles = 0;
+
+  pgmpi_pack_init(&buf);
+  if( rank == 0 ) {
+    if( prof_path != NULL ) {
+      ZF_LOGV("reading profiles from %s", prof_path);
+      pgmpi_profile_read_many(prof_path, profiles, n_profiles);
+    }
+    pgmpi_pack_int(&buf, *n_profiles);
+    for(i=0; i<*n_profiles; i++) {
+      pgmpi_profile_pack(&buf, &(*profiles)[i]);
+    }
+  }
+
+  if( pgmpi_pack_bcast(&buf, 0, MPI_COMM_WORLD) != 0 ) {
+    ZF_LOGE("cannot broadcast profiles");
+    pgmpi_pack_free(&buf);
+    return;
+  }
+
+  if( rank != 0 && pgmpi_unpack_int(&buf, &n) == 0 && n > 0 ) {
+    *profiles = (pgmpi_profile_t *)calloc(n, sizeof(pgmpi_profile_t));
+    for(i=0; i<n; i++) {
+      if( pgmpi_profile_unpack(&buf, &(*profiles)[*n_profiles]) != 0 ) {
+        break;
+      }
+      (*n_profiles)++;
+    }
+  }
+
+  pgmpi_pack_free(&buf);
+}
+
+static void fill_lookup_table(lookup_slot_t *slot) {
   char *prof_path;
+  char *db_name;
+  char *policy_name;
+  char *min_confidence;
+  char *min_effect;
   pgmpi_dictionary_t *hashmap;
 
   hashmap = pgmpi_context_get_cli_dict();
 
-  pgmpi_allocate_replacement_table(&lookup);
+  pgmpi_allocate_replacement_table(&slot->lookup);
+  slot->allocated = 1;
+
+  policy_name = pgmpitune_get_value_from_dict(hashmap, "profile_policy");
+  if( policy_name != NULL ) {
+    pgmpi_profile_match_policy_t policy;
+    if( pgmpi_profile_match_policy_from_string(policy_name, &policy) == 0 ) {
+      ZF_LOGV("using profile match policy %s", policy_name);
+      pgmpi_set_profile_match_policy(&slot->lookup, policy);
+    } else {
+      ZF_LOGE("unknown profile match policy \"%s\", using exact", policy_name);
+    }
+    free(policy_name);
+  }
+
+  min_confidence = pgmpitune_get_value_from_dict(hashmap, "profile_min_confidence");
+  if( min_confidence != NULL ) {
+    pgmpi_set_profile_min_confidence(&slot->lookup, atof(min_confidence));
+    free(min_confidence);
+  }
+
+  min_effect = pgmpitune_get_value_from_dict(hashmap, "profile_min_effect");
+  if( min_effect != NULL ) {
+    pgmpi_set_profile_min_effect(&slot->lookup, atof(min_effect));
+    free(min_effect);
+  }
+
+  slot->mtime = get_sources_mtime();
+
+  // every rank maps the database itself, node-local ranks share the pages
+  db_name = pgmpitune_get_value_from_dict(hashmap, "profile_db");
+  if( db_name != NULL ) {
+    int i;
+    if( pgmpi_profile_db_open(db_name, &slot->profile_db) == 0 ) {
+      for(i=0; i<slot->profile_db.n_profiles; i++) {
+        pgmpi_add_profile_to_table(&slot->lookup, &slot->profile_db.profiles[i]);
+      }
+    } else {
+      ZF_LOGE("cannot use profile database %s", db_name);
+    }
+    free(db_name);
+  }
 
   prof_path = pgmpitune_get_value_from_dict(hashmap, "profile_path");
 
@@ -86,18 +207,15 @@ static void fill_lookup_table() {
     }
   }
 
-  if( prof_path != NULL ) {
-    pgmpi_profile_t *profiles;
+  {
     int n_profiles = 0;
     int i;
 
-    ZF_LOGV("reading profiles from %s", prof_path);
-
-    pgmpi_profile_read_many(prof_path, &profiles, &n_profiles);
+    read_and_bcast_profiles(prof_path, &slot->profiles, &n_profiles);
 
     for(i=0; i<n_profiles; i++) {
-      ZF_LOGV("adding profile for cid %u", profiles[i].cid);
-      pgmpi_add_profile_to_table(&lookup, &profiles[i]);
+      ZF_LOGV("adding profile for cid %u", slot->profiles[i].cid);
+      pgmpi_add_profile_to_table(&slot->lookup, &slot->profiles[i]);
     }
 
     free(prof_path);
@@ -105,38 +223,188 @@ static void fill_lookup_table() {
 
 }
 
-static void free_lookup_table() {
-  pgmpi_free_replacement_table(&lookup);
+static void free_lookup_table(lookup_slot_t *slot) {
+  if( slot->allocated ) {
+    pgmpi_free_replacement_table(&slot->lookup);
+    slot->allocated = 0;
+  }
+  free(slot->profiles);
+  slot->profiles = NULL;
+  pgmpi_profile_db_close(&slot->profile_db);
+}
+
+/*
+ * modification time of the profile directory and the profile database,
+ * profiles should be replaced atomically (write to a temporary file and rename)
+ */
+static double get_sources_mtime() {
+  pgmpi_dictionary_t *hashmap;
+  const char *keys[] = { "profile_path", "profile_db" };
+  double mtime = 0;
+  int rank;
+  int i;
+
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  if( rank != 0 || reload_interval <= 0 ) {
+    return 0;
+  }
+
+  hashmap = pgmpi_context_get_cli_dict();
+  for(i=0; i<2; i++) {
+    char *fname = pgmpitune_get_value_from_dict(hashmap, keys[i]);
+    struct stat st;
+    if( fname == NULL && i == 0 ) {
+      fname = pgmpi_get_profile_path();
+    }
+    if( fname != NULL ) {
+      if( stat(fname, &st) == 0 && st.st_mtim.tv_sec + 1e-9 * st.st_mtim.tv_nsec > mtime ) {
+        mtime = st.st_mtim.tv_sec + 1e-9 * st.st_mtim.tv_nsec;
+      }
+      free(fname);
+    }
+  }
+
+  return mtime;
+}
+
+/*
+ * safe point, called by all ranks at the same collective call on MPI_COMM_WORLD
+ * the ranks agree on the reload, build the new table and switch to it together
+ */
+static void check_reload() {
+  int local, global;
+  lookup_slot_t *next;
+
+  local = pgmpi_context_take_reload_request();
+  if( get_sources_mtime() > active->mtime ) {
+    ZF_LOGV("profiles have changed");
+    local = 1;
+  }
+
+  PMPI_Allreduce(&local, &global, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+  if( global == 0 ) {
+    return;
+  }
+
+  ZF_LOGV("reloading profiles after %lu collectives on MPI_COMM_WORLD", world_calls);
+  next = (active == &slots[0]) ? &slots[1] : &slots[0];
+  free_lookup_table(next);    // retired at the previous reload, no longer referenced
+  fill_lookup_table(next);
+  active = next;
+  pgmpi_comm_cache_invalidate();
+}
+
+static void init_reloading() {
+  pgmpi_dictionary_t *hashmap;
+  char *val;
+
+  hashmap = pgmpi_context_get_cli_dict();
+
+  reload_interval = 0;
+  val = pgmpitune_get_value_from_dict(hashmap, "reload_interval");
+  if( val != NULL ) {
+    reload_interval = atoi(val);
+    free(val);
+  }
+
+  val = pgmpitune_get_value_from_dict(hashmap, "reload_signal");
+  if( val != NULL ) {
+    int signum = -1;
+    if( strcmp(val, "USR1") == 0 ) {
+      signum = SIGUSR1;
+    } else if( strcmp(val, "USR2") == 0 ) {
+      signum = SIGUSR2;
+    } else if( strcmp(val, "HUP") == 0 ) {
+      signum = SIGHUP;
+    } else {
+      ZF_LOGE("unsupported reload signal \"%s\" (use USR1, USR2 or HUP)", val);
+    }
+    if( signum > 0 ) {
+      pgmpi_context_install_reload_signal(signum);
+    }
+    free(val);
+  }
+
+  if( reload_interval <= 0 && pgmpitune_dict_has_key(hashmap, "reload_signal") ) {
+    ZF_LOGW("--reload_signal has no effect without --reload_interval");
+  }
 }
 
 
 static void context_init() {
-  fill_lookup_table();
+  // context may be re-initialized by pgtune_override_argv_parameter
+  free_lookup_table(&slots[0]);
+  free_lookup_table(&slots[1]);
+  active = &slots[0];
+  world_calls = 0;
+  init_reloading();
+  fill_lookup_table(active);
+  pgmpi_comm_cache_init();
+  pgmpi_comm_cache_invalidate();
 }
 
 
 static void context_free() {
-  free_lookup_table();
+  pgmpi_comm_cache_free();
+  free_lookup_table(&slots[0]);
+  free_lookup_table(&slots[1]);
 }
 
 
-static int context_get_algorithm(pgmpi_collectives_t cid, int msg_size, int comm_size,
-    int *alg_id) {
+static int context_get_algorithm(pgmpi_collectives_t cid, MPI_Count msg_size, MPI_Datatype datatype, MPI_Op op,
+    MPI_Comm comm, int *alg_id) {
   int res;
+  pgmpi_call_qualifiers_t call;
+  pgmpi_comm_cache_t *cache;
 
   *alg_id = 0;
+  call.dtype_id = pgmpi_qualifier_dtype_id(datatype);
+  call.op_id = pgmpi_qualifier_op_id(op);
+  call.site_id = pgmpi_callsite_agreed_id(comm);
+  call.skew_us = pgmpi_skew_current_us();
+
+  // all ranks take part in every collective on MPI_COMM_WORLD, so they reach the same checks
+  if( reload_interval > 0 && comm == MPI_COMM_WORLD ) {
+    world_calls++;
+    if( world_calls % reload_interval == 0 ) {
+      check_reload();
+    }
+  }
 
-  res = pgmpi_find_replacement_algorithm(&lookup, cid, msg_size, comm_size, alg_id);
+  cache = pgmpi_comm_cache_get(comm, &active->lookup);
+  if( cache == NULL ) {
+    int comm_size;
+    MPI_Comm_size(comm, &comm_size);
+    res = pgmpi_find_replacement_algorithm(&active->lookup, cid, msg_size, datatype, &call, comm_size, alg_id);
+    if (res != 0) {
+      *alg_id = 0;
+    }
+    return 0;
+  }
+
+  if( pgmpi_comm_cache_lookup(cache, cid, msg_size, &call, alg_id) == 0 ) {
+    return 0;
+  }
+
+  res = -1;
+  if( cache->profile[cid] != NULL ) {
+    const pgmpi_range_t *range;
+    range = pgmpi_profile_find_range_for_call(cache->profile[cid], msg_size, &call);
+    if( range != NULL && pgmpi_range_is_effective(&active->lookup, range) ) {
+      *alg_id = pgmpi_select_from_range(range, cid, msg_size, datatype, cache->comm_size);
+      res = 0;
+    }
+  }
 
   if (res != 0) {
-    ZF_LOGV("Cannot set algorithm for collective %u (%d, %d), reset alg to 0", cid, msg_size, comm_size);
+    ZF_LOGV("Cannot set algorithm for collective %u (%lld, %d), reset alg to 0", cid, (long long)msg_size,
+        cache->comm_size);
     *alg_id = 0;
   }
 
   ZF_LOGV("found alg id %d", *alg_id);
+  pgmpi_comm_cache_store(cache, cid, msg_size, &call, *alg_id);
 
   return 0;
 }
 
-
-
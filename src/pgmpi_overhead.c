@@ -0,0 +1,428 @@
+/*  PGMPITuneLib - Library for Autotuning MPI Collectives using Performance Guidelines
+ *  
+ *  Copyright 2017 Sascha Hunold, Alexandra Carpen-Amarie
+ *      Research Group for Parallel Computing
+ *      Faculty of Informatics
+ *      Vienna University of Technology, Austria
+ *  
+ *  <license>
+ *      This library is free software; you can redistribute it
+ *      and/or modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *  
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *  
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free
+ *      Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *      Boston, MA 02110-1301 USA
+ *  </license>
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+
+#include <mpi.h>
+#include "pgmpi_tune.h"
+#include "pgmpi_algid_store.h"
+#include "collectives/collective_modules.h"
+#include "tuning/pgmpi_comm_cache.h"
+#include "tuning/pgmpi_profile.h"
+#include "util/pgmpi_callsite.h"
+#include "util/pgmpi_skew.h"
+
+/*
+ * measures what the wrappers add to a call of PMPI_<collective> for small
+ * messages (8 to 64 bytes of MPI_UNSIGNED_CHAR)
+ * usage: mpirun -np <p> pgmpi_overhead_{cli,tuned} [nranges] [ncalls]
+ *
+ * every call is timed on its own (in cycles with rdtsc, where available);
+ * the wrapper and PMPI are called alternately, and the overhead is the
+ * difference of the percentiles of both
+ *
+ * variants
+ *  - pgmpi_overhead_cli (linked with pgmpicli): the default path of the CLI context
+ *  - pgmpi_overhead_tuned (linked with pgmpituned): an empty profile directory,
+ *    then profiles with nranges ranges per collective; the ranges select a
+ *    mock-up for the odd message sizes 1, 3, ..., so the measured (even) sizes
+ *    are looked up among them and call the default; last, the same profiles
+ *    with call sites and arrival skew sampling (every SKEW_INTERVAL-th call) enabled
+ *
+ * the parts of the dispatch are timed separately: the check of the context,
+ * the call-site hook (entered twice, as in the wrappers), the skew hook (entry
+ * and exit), MPI_Comm_size, the extent of the datatype (count to bytes), the
+ * lookup (pgtune_get_algorithm) and the algid store; the hooks only check a
+ * flag unless they are enabled; the lookup cycles through NB_LOOKUP_SIZES even sizes from the
+ * measured one on, more than the memo of the communicator cache holds, so
+ * every lookup searches the ranges; "timer" is the cost of timing an empty region, which is
+ * included in every part
+ */
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_RDTSC
+#define TICKS() ((double)__rdtsc())
+#define TICK_UNIT "cycles"
+#else
+#define TICKS() ticks_ns()
+#define TICK_UNIT "ns"
+#endif
+
+#define DEFAULT_NRANGES   64
+#define DEFAULT_NCALLS    10000
+#define MIN_MSG_SIZE      8
+#define MAX_MSG_SIZE      64
+#define NB_PERCENTILES    3
+#define NB_LOOKUP_SIZES   (2 * PGMPI_COMM_CACHE_MEMO_SIZE)
+#define SKEW_INTERVAL     16
+
+static const double percentiles[NB_PERCENTILES] = { 0.5, 0.9, 0.99 };
+
+enum {
+  PART_TIMER = 0,      /* nothing, the cost of taking the time */
+  PART_CONTEXT,
+  PART_CALLSITE,
+  PART_SKEW,
+  PART_COMM_SIZE,
+  PART_EXTENT,
+  PART_LOOKUP,
+  PART_ALGID_STORE,
+  NB_PARTS
+};
+
+static const char *part_names[NB_PARTS] = { "timer", "context", "callsite", "skew", "comm_size", "extent", "lookup", "algid_store" };
+
+#ifndef HAVE_RDTSC
+static double ticks_ns(void);
+#endif
+static int compare_doubles(const void *a, const void *b);
+static void get_percentiles(double *v, const int n, double *pct);
+static int call_collective(const pgmpi_collectives_t cid, const int use_pmpi, const int msg_size, void *sbuf,
+    void *rbuf);
+static double time_part(const int part, const pgmpi_collectives_t cid, const int msg_size, const int call);
+static void measure_variant(const char *variant, const int ncalls, void *sbuf, void *rbuf);
+static int write_profiles(const char *dir, const int nb_procs, const int nranges);
+static void remove_profiles(const char *dir);
+
+
+#ifndef HAVE_RDTSC
+static double ticks_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+#endif
+
+static int compare_doubles(const void *a, const void *b) {
+  const double d1 = *(const double *)a;
+  const double d2 = *(const double *)b;
+  return (d1 > d2) - (d1 < d2);
+}
+
+/*
+ * sorts v
+ */
+static void get_percentiles(double *v, const int n, double *pct) {
+  int i;
+
+  qsort(v, n, sizeof(double), &compare_doubles);
+  for(i=0; i<NB_PERCENTILES; i++) {
+    pct[i] = v[(int)(percentiles[i] * (n - 1))];
+  }
+}
+
+static int call_collective(const pgmpi_collectives_t cid, const int use_pmpi, const int msg_size, void *sbuf,
+    void *rbuf) {
+  const MPI_Comm comm = MPI_COMM_WORLD;
+  const MPI_Datatype t = MPI_UNSIGNED_CHAR;
+
+  switch( cid ) {
+  case CID_MPI_ALLGATHER:
+    return use_pmpi ? PMPI_Allgather(sbuf, msg_size, t, rbuf, msg_size, t, comm) :
+        MPI_Allgather(sbuf, msg_size, t, rbuf, msg_size, t, comm);
+  case CID_MPI_ALLREDUCE:
+    return use_pmpi ? PMPI_Allreduce(sbuf, rbuf, msg_size, t, MPI_SUM, comm) :
+        MPI_Allreduce(sbuf, rbuf, msg_size, t, MPI_SUM, comm);
+  case CID_MPI_ALLTOALL:
+    return use_pmpi ? PMPI_Alltoall(sbuf, msg_size, t, rbuf, msg_size, t, comm) :
+        MPI_Alltoall(sbuf, msg_size, t, rbuf, msg_size, t, comm);
+  case CID_MPI_BCAST:
+    return use_pmpi ? PMPI_Bcast(rbuf, msg_size, t, 0, comm) : MPI_Bcast(rbuf, msg_size, t, 0, comm);
+  case CID_MPI_GATHER:
+    return use_pmpi ? PMPI_Gather(sbuf, msg_size, t, rbuf, msg_size, t, 0, comm) :
+        MPI_Gather(sbuf, msg_size, t, rbuf, msg_size, t, 0, comm);
+  case CID_MPI_REDUCE:
+    return use_pmpi ? PMPI_Reduce(sbuf, rbuf, msg_size, t, MPI_SUM, 0, comm) :
+        MPI_Reduce(sbuf, rbuf, msg_size, t, MPI_SUM, 0, comm);
+  case CID_MPI_REDUCESCATTERBLOCK:
+    return use_pmpi ? PMPI_Reduce_scatter_block(sbuf, rbuf, msg_size, t, MPI_SUM, comm) :
+        MPI_Reduce_scatter_block(sbuf, rbuf, msg_size, t, MPI_SUM, comm);
+  case CID_MPI_SCAN:
+    return use_pmpi ? PMPI_Scan(sbuf, rbuf, msg_size, t, MPI_SUM, comm) :
+        MPI_Scan(sbuf, rbuf, msg_size, t, MPI_SUM, comm);
+  case CID_MPI_SCATTER:
+    return use_pmpi ? PMPI_Scatter(sbuf, msg_size, t, rbuf, msg_size, t, 0, comm) :
+        MPI_Scatter(sbuf, msg_size, t, rbuf, msg_size, t, 0, comm);
+  default:
+    return MPI_ERR_OTHER;
+  }
+}
+
+/*
+ * \return ticks of one call of the part, as done by the wrappers
+ * call selects the message size of the lookup
+ */
+static double time_part(const int part, const pgmpi_collectives_t cid, const int msg_size, const int call) {
+  const int lookup_size = msg_size + 2 * (call % NB_LOOKUP_SIZES);
+  double t;
+  int size, alg_id;
+  MPI_Count bytes;
+  volatile int is_cli;
+
+  t = TICKS();
+  switch( part ) {
+  case PART_TIMER:
+    break;
+  case PART_CONTEXT:
+    is_cli = (get_pgmpi_context() == CONTEXT_CLI);
+    (void)is_cli;
+    break;
+  case PART_CALLSITE:
+    PGMPI_CALLSITE_ENTER();
+    PGMPI_CALLSITE_ENTER();
+    break;
+  case PART_SKEW:
+    PGMPI_SKEW_ENTER(cid, MPI_COMM_WORLD);
+    PGMPI_SKEW_EXIT();
+    break;
+  case PART_COMM_SIZE:
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+    break;
+  case PART_EXTENT:
+    bytes = pgmpi_convert_type_count_2_bytes(msg_size, MPI_UNSIGNED_CHAR);
+    (void)bytes;
+    break;
+  case PART_LOOKUP:
+    pgtune_get_algorithm(cid, lookup_size, MPI_UNSIGNED_CHAR, MPI_SUM, MPI_COMM_WORLD, &alg_id);
+    break;
+  case PART_ALGID_STORE:
+    pgmpi_save_algid_for_msg_size(cid, msg_size, 0, 1);
+    break;
+  }
+  return TICKS() - t;
+}
+
+/*
+ * rank 0 prints one line per collective, message size and kind of measurement
+ */
+static void measure_variant(const char *variant, const int ncalls, void *sbuf, void *rbuf) {
+  double *t_wrapper, *t_pmpi, *t_part;
+  double pct_wrapper[NB_PERCENTILES], pct_pmpi[NB_PERCENTILES], pct[NB_PERCENTILES];
+  int rank, cid, msg_size, i, k, part;
+
+  PMPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+  t_wrapper = (double *)malloc(ncalls * sizeof(double));
+  t_pmpi = (double *)malloc(ncalls * sizeof(double));
+  t_part = (double *)malloc(ncalls * sizeof(double));
+
+  for(cid=0; cid<NUM_COLLECTIVES; cid++) {
+    const char *mpiname = pgmpi_modules_get(cid)->mpiname;
+
+    for(msg_size=MIN_MSG_SIZE; msg_size<=MAX_MSG_SIZE; msg_size*=2) {
+      // warm-up
+      call_collective(cid, 0, msg_size, sbuf, rbuf);
+      call_collective(cid, 1, msg_size, sbuf, rbuf);
+
+      for(i=0; i<ncalls; i++) {
+        double t;
+
+        PMPI_Barrier(MPI_COMM_WORLD);
+        t = TICKS();
+        call_collective(cid, 0, msg_size, sbuf, rbuf);
+        t_wrapper[i] = TICKS() - t;
+
+        PMPI_Barrier(MPI_COMM_WORLD);
+        t = TICKS();
+        call_collective(cid, 1, msg_size, sbuf, rbuf);
+        t_pmpi[i] = TICKS() - t;
+      }
+      get_percentiles(t_wrapper, ncalls, pct_wrapper);
+      get_percentiles(t_pmpi, ncalls, pct_pmpi);
+
+      if( rank == 0 ) {
+        printf("%s;%s;%d;wrapper", variant, mpiname, msg_size);
+        for(k=0; k<NB_PERCENTILES; k++) {
+          printf(";%.0f", pct_wrapper[k]);
+        }
+        printf("\n%s;%s;%d;pmpi", variant, mpiname, msg_size);
+        for(k=0; k<NB_PERCENTILES; k++) {
+          printf(";%.0f", pct_pmpi[k]);
+        }
+        printf("\n%s;%s;%d;overhead", variant, mpiname, msg_size);
+        for(k=0; k<NB_PERCENTILES; k++) {
+          printf(";%.0f", pct_wrapper[k] - pct_pmpi[k]);
+        }
+        printf("\n");
+      }
+
+      for(part=0; part<NB_PARTS; part++) {
+        for(i=0; i<ncalls; i++) {
+          t_part[i] = time_part(part, cid, msg_size, i);
+        }
+        get_percentiles(t_part, ncalls, pct);
+        if( rank == 0 ) {
+          printf("%s;%s;%d;%s", variant, mpiname, msg_size, part_names[part]);
+          for(k=0; k<NB_PERCENTILES; k++) {
+            printf(";%.0f", pct[k]);
+          }
+          printf("\n");
+        }
+      }
+    }
+  }
+
+  free(t_wrapper);
+  free(t_pmpi);
+  free(t_part);
+}
+
+/*
+ * one profile per collective, the ranges select the first mock-up for the odd message sizes
+ */
+static int write_profiles(const char *dir, const int nb_procs, const int nranges) {
+  char fname[256];
+  FILE *fp;
+  int cid, i;
+
+  for(cid=0; cid<NUM_COLLECTIVES; cid++) {
+    const module_t *mod = pgmpi_modules_get(cid);
+
+    snprintf(fname, sizeof(fname), "%s/overhead_%s.%s", dir, mod->cli_prefix, pgmpi_get_profile_file_suffix());
+    if( (fp = fopen(fname, "w")) == NULL ) {
+      fprintf(stderr, "cannot open %s for writing\n", fname);
+      return -1;
+    }
+    fprintf(fp, "%s\n%d\n1\n%d %s\n%d\n", mod->mpiname, nb_procs, mod->alg_choices->alg[1].algid,
+        mod->alg_choices->alg[1].algname, nranges);
+    for(i=0; i<nranges; i++) {
+      fprintf(fp, "%d %d %d\n", 2 * i + 1, 2 * i + 1, mod->alg_choices->alg[1].algid);
+    }
+    fclose(fp);
+  }
+  return 0;
+}
+
+static void remove_profiles(const char *dir) {
+  char fname[256];
+  int cid;
+
+  for(cid=0; cid<NUM_COLLECTIVES; cid++) {
+    snprintf(fname, sizeof(fname), "%s/overhead_%s.%s", dir, pgmpi_modules_get(cid)->cli_prefix,
+        pgmpi_get_profile_file_suffix());
+    unlink(fname);
+  }
+  rmdir(dir);
+}
+
+
+int main(int argc, char *argv[]) {
+  int rank, nb_procs;
+  int nranges = DEFAULT_NRANGES;
+  int ncalls = DEFAULT_NCALLS;
+  void *sbuf, *rbuf;
+  char variant[64];
+  int ret = 0;
+
+  MPI_Init(&argc, &argv);
+  PMPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  PMPI_Comm_size(MPI_COMM_WORLD, &nb_procs);
+
+  if( argc > 1 ) {
+    nranges = atoi(argv[1]);
+  }
+  if( argc > 2 ) {
+    ncalls = atoi(argv[2]);
+  }
+  if( nranges < 1 || ncalls < 1 ) {
+    if( rank == 0 ) {
+      fprintf(stderr, "usage: %s [nranges] [ncalls]\n", argv[0]);
+    }
+    MPI_Finalize();
+    return 1;
+  }
+
+  // one block per process
+  sbuf = calloc((size_t)MAX_MSG_SIZE * nb_procs, 1);
+  rbuf = calloc((size_t)MAX_MSG_SIZE * nb_procs, 1);
+
+  if( rank == 0 ) {
+    printf("# %d calls per measurement, %d processes, times in %s\n", ncalls, nb_procs, TICK_UNIT);
+    printf("variant;collective;msg_size;measurement;p50;p90;p99\n");
+  }
+
+  if( get_pgmpi_context() != CONTEXT_TUNED ) {
+    measure_variant((get_pgmpi_context() == CONTEXT_CLI) ? "cli" : "configured", ncalls, sbuf, rbuf);
+  } else {
+    char dir[64];
+    char ppath[96];
+    char skew[32];
+    char callsites[] = "--callsites=on";
+    char *args[4];
+
+    if( rank == 0 ) {
+      strcpy(dir, "/tmp/pgmpi_overhead_XXXXXX");
+      if( mkdtemp(dir) == NULL ) {
+        fprintf(stderr, "cannot create profile directory\n");
+        ret = 1;
+      }
+    }
+    PMPI_Bcast(&ret, 1, MPI_INT, 0, MPI_COMM_WORLD);
+    if( ret == 0 ) {
+      PMPI_Bcast(dir, sizeof(dir), MPI_CHAR, 0, MPI_COMM_WORLD);
+      snprintf(ppath, sizeof(ppath), "--ppath=%s", dir);
+      args[0] = argv[0];
+      args[1] = ppath;
+
+      pgtune_override_argv_parameter(2, args);
+      measure_variant("tuned_empty", ncalls, sbuf, rbuf);
+
+      if( rank == 0 ) {
+        ret = (write_profiles(dir, nb_procs, nranges) != 0);
+      }
+      PMPI_Bcast(&ret, 1, MPI_INT, 0, MPI_COMM_WORLD);
+      if( ret == 0 ) {
+        pgtune_override_argv_parameter(2, args);
+        snprintf(variant, sizeof(variant), "tuned_%d_ranges", nranges);
+        measure_variant(variant, ncalls, sbuf, rbuf);
+
+        snprintf(skew, sizeof(skew), "--skew_interval=%d", SKEW_INTERVAL);
+        args[2] = callsites;
+        args[3] = skew;
+        pgtune_override_argv_parameter(4, args);
+        snprintf(variant, sizeof(variant), "tuned_%d_ranges_hooks", nranges);
+        measure_variant(variant, ncalls, sbuf, rbuf);
+      }
+
+      PMPI_Barrier(MPI_COMM_WORLD);
+      if( rank == 0 ) {
+        remove_profiles(dir);
+      }
+    }
+  }
+
+  free(sbuf);
+  free(rbuf);
+
+  MPI_Finalize();
+
+  return ret;
+}
@@ -0,0 +1,338 @@
+/*  PGMPITuneLib - Library for Autotuning MPI Collectives using Performance Guidelines
+ *  
+ *  Copyright 2017 Sascha Hunold, Alexandra Carpen-Amarie
+ *      Research Group for Parallel Computing
+ *      Faculty of Informatics
+ *      Vienna University of Technology, Austria
+ *  
+ *  <license>
+ *      This library is free software; you can redistribute it
+ *      and/or modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *  
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *  
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free
+ *      Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *      Boston, MA 02110-1301 USA
+ *  </license>
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pgmpi_tune.h"
+#include "collectives/collective_modules.h"
+#include "tuning/pgmpi_profile_reader.h"
+#include "tuning/pgmpi_function_replacer.h"
+#include "tuning/pgmpi_range_qualifier.h"
+
+/*
+ * compiles a directory of .prf profiles into a C header with one inlined
+ * decision function per collective (see PGMPI_STATIC_TUNING)
+ * usage: pgmpi_prf2c <profile directory> <header file> [exact|nearest|floor] [--peffect=<min effect>]
+ * ranges whose effect may be below the minimum effect select the default algorithm, as in PGMPITuneD
+ */
+
+static void emit_range_tree(FILE *fp, const alg_lookup_table_t *tab, const pgmpi_profile_t *prof, const int lo,
+    const int hi, const int indent);
+static void emit_group_condition(FILE *fp, const pgmpi_range_group_t *group);
+static void emit_profile_function(FILE *fp, const alg_lookup_table_t *tab, const module_t *mod,
+    const pgmpi_profile_t *prof);
+static void emit_collective_function(FILE *fp, const alg_lookup_table_t *tab, const module_t *mod,
+    pgmpi_profile_t **profiles, const int n_profiles, const pgmpi_profile_match_policy_t policy);
+static void emit_range_return(FILE *fp, const alg_lookup_table_t *tab, const pgmpi_profile_t *prof,
+    const pgmpi_range_t *r, const int indent);
+
+
+/*
+ * ranges with fallbacks select the first algorithm that gets its buffers at run-time
+ */
+static void emit_range_return(FILE *fp, const alg_lookup_table_t *tab, const pgmpi_profile_t *prof,
+    const pgmpi_range_t *r, const int indent) {
+  int j;
+
+  if( !pgmpi_range_is_effective(tab, r) ) {
+    fprintf(fp, "%*sreturn 0;   /* effect %.3f may be below %.3f */\n", indent, "", r->effect_ci_low, tab->min_effect);
+    return;
+  }
+  if( r->n_fallbacks == 0 ) {
+    fprintf(fp, "%*sreturn %d;\n", indent, "", r->alg_id);
+    return;
+  }
+  fprintf(fp, "%*sreturn pgmpi_modules_select_fitting_alg(%d, (const int[]){ %d", indent, "", prof->cid, r->alg_id);
+  for(j=0; j<r->n_fallbacks; j++) {
+    fprintf(fp, ", %d", r->fallback[j]);
+  }
+  fprintf(fp, " }, %d,\n%*s    msg_size, datatype, pgmpi_static_comm_size(comm));\n", r->n_fallbacks + 1, indent, "");
+}
+
+/*
+ * balanced comparison tree over the sorted, disjoint ranges lo..hi
+ */
+static void emit_range_tree(FILE *fp, const alg_lookup_table_t *tab, const pgmpi_profile_t *prof, const int lo,
+    const int hi, const int indent) {
+  int mid;
+  const pgmpi_range_t *r;
+
+  if( lo > hi ) {
+    return;
+  }
+  mid = lo + (hi - lo) / 2;
+  r = &prof->range[mid];
+
+  if( lo < mid ) {
+    fprintf(fp, "%*sif( msg_size < %lldLL ) {\n", indent, "", (long long)r->msg_size_start);
+    emit_range_tree(fp, tab, prof, lo, mid-1, indent+2);
+    fprintf(fp, "%*s} else ", indent, "");
+  } else {
+    fprintf(fp, "%*s", indent, "");
+  }
+  if( mid < hi ) {
+    fprintf(fp, "if( msg_size > %lldLL ) {\n", (long long)r->msg_size_end);
+    emit_range_tree(fp, tab, prof, mid+1, hi, indent+2);
+    fprintf(fp, "%*s} else ", indent, "");
+  }
+  if( lo < mid && mid < hi ) {
+    fprintf(fp, "{\n");
+  } else if( lo < mid ) {
+    fprintf(fp, "if( msg_size <= %lldLL ) {\n", (long long)r->msg_size_end);
+  } else if( mid < hi ) {
+    fprintf(fp, "if( msg_size >= %lldLL ) {\n", (long long)r->msg_size_start);
+  } else {
+    fprintf(fp, "if( msg_size >= %lldLL && msg_size <= %lldLL ) {\n", (long long)r->msg_size_start,
+        (long long)r->msg_size_end);
+  }
+  emit_range_return(fp, tab, prof, r, indent+2);
+  fprintf(fp, "%*s}\n", indent, "");
+}
+
+static void emit_group_condition(FILE *fp, const pgmpi_range_group_t *group) {
+  const char *op_name;
+  const char *sep = "";
+
+  if( group->site_id != PGMPI_QUALIFIER_ANY ) {
+    fprintf(fp, "pgmpi_callsite_agreed_id(comm) == 0x%08x", group->site_id);
+    sep = " && ";
+  }
+  if( group->skew_us != PGMPI_QUALIFIER_ANY ) {
+    fprintf(fp, "%spgmpi_skew_current_us() >= %d", sep, group->skew_us);
+    sep = " && ";
+  }
+  if( group->dtype_id != PGMPI_QUALIFIER_ANY ) {
+    fprintf(fp, "%sdatatype == %s", sep, pgmpi_qualifier_dtype_name(group->dtype_id));
+    sep = " && ";
+  }
+  if( group->op_id != PGMPI_QUALIFIER_ANY ) {
+    op_name = pgmpi_qualifier_op_name(group->op_id);
+    if( strncmp(op_name, "MPI_", 4) == 0 ) {
+      fprintf(fp, "%sop == %s", sep, op_name);
+    } else {
+      // user-defined operations are classified at runtime
+      fprintf(fp, "%spgmpi_qualifier_op_matches(%d, pgmpi_qualifier_op_id(op))", sep, group->op_id);
+    }
+  }
+}
+
+static void emit_group_comment(FILE *fp, const pgmpi_range_group_t *group) {
+  fprintf(fp, "  /* dtype=%s op=%s", pgmpi_qualifier_dtype_name(group->dtype_id), pgmpi_qualifier_op_name(group->op_id));
+  if( group->site_id != PGMPI_QUALIFIER_ANY ) {
+    fprintf(fp, " site=0x%08x", group->site_id);
+  }
+  if( group->skew_us != PGMPI_QUALIFIER_ANY ) {
+    fprintf(fp, " skew=%d", group->skew_us);
+  }
+  fprintf(fp, " */\n");
+}
+
+static int is_unqualified(const pgmpi_range_group_t *group) {
+  return (group->dtype_id == PGMPI_QUALIFIER_ANY && group->op_id == PGMPI_QUALIFIER_ANY &&
+      group->site_id == PGMPI_QUALIFIER_ANY && group->skew_us == PGMPI_QUALIFIER_ANY);
+}
+
+/*
+ * groups are tried from the most to the least specific one, as in pgmpi_profile_find_alg
+ */
+static void emit_profile_function(FILE *fp, const alg_lookup_table_t *tab, const module_t *mod,
+    const pgmpi_profile_t *prof) {
+  const pgmpi_range_group_t **order;
+  int i, j;
+
+  // stable insertion sort, groups that are equally specific keep their order
+  order = (const pgmpi_range_group_t **)malloc(prof->n_groups * sizeof(pgmpi_range_group_t *));
+  for(i=0; i<prof->n_groups; i++) {
+    const pgmpi_range_group_t *g = &prof->group[i];
+    for(j=i; j>0 && pgmpi_profile_group_is_more_specific(g, order[j-1]); j--) {
+      order[j] = order[j-1];
+    }
+    order[j] = g;
+  }
+
+  fprintf(fp, "static inline int pgmpi_static_select_%s_p%d(const MPI_Count msg_size, MPI_Datatype datatype, MPI_Op op,\n"
+      "    MPI_Comm comm) {\n",
+      mod->cli_prefix, prof->nb_procs);
+  for(i=0; i<prof->n_groups; i++) {
+    const pgmpi_range_group_t *g = order[i];
+    emit_group_comment(fp, g);
+    if( is_unqualified(g) ) {
+      emit_range_tree(fp, tab, prof, g->first, g->first + g->n - 1, 2);
+      continue;
+    }
+    fprintf(fp, "  if( ");
+    emit_group_condition(fp, g);
+    fprintf(fp, " ) {\n");
+    emit_range_tree(fp, tab, prof, g->first, g->first + g->n - 1, 4);
+    fprintf(fp, "  }\n");
+  }
+  fprintf(fp, "  return 0;\n}\n\n");
+
+  free(order);
+}
+
+static void emit_collective_function(FILE *fp, const alg_lookup_table_t *tab, const module_t *mod,
+    pgmpi_profile_t **profiles, const int n_profiles, const pgmpi_profile_match_policy_t policy) {
+  int i;
+
+  for(i=0; i<n_profiles; i++) {
+    emit_profile_function(fp, tab, mod, profiles[i]);
+  }
+
+  fprintf(fp, "static inline int pgmpi_static_select_%s(const MPI_Count msg_size, MPI_Datatype datatype, MPI_Op op,\n"
+      "    MPI_Comm comm) {\n", mod->cli_prefix);
+  if( n_profiles == 0 ) {
+    fprintf(fp, "  return 0;\n}\n\n");
+    return;
+  }
+  if( policy == PROFILE_MATCH_NEAREST && n_profiles == 1 ) {
+    fprintf(fp, "  return pgmpi_static_select_%s_p%d(msg_size, datatype, op, comm);\n}\n\n", mod->cli_prefix,
+        profiles[0]->nb_procs);
+    return;
+  }
+
+  fprintf(fp, "  int comm_size;\n  PMPI_Comm_size(comm, &comm_size);\n");
+  for(i=0; i<n_profiles; i++) {
+    int p = profiles[i]->nb_procs;
+    switch( policy ) {
+    case PROFILE_MATCH_EXACT:
+    case PROFILE_MATCH_EXTRAPOLATE:
+      fprintf(fp, "  if( comm_size == %d ) {\n", p);
+      break;
+    case PROFILE_MATCH_FLOOR:
+      // largest process count first
+      p = profiles[n_profiles-1-i]->nb_procs;
+      fprintf(fp, "  if( comm_size >= %d ) {\n", p);
+      break;
+    case PROFILE_MATCH_NEAREST:
+      // on a tie, the smaller process count wins
+      if( i == n_profiles-1 ) {
+        fprintf(fp, "  return pgmpi_static_select_%s_p%d(msg_size, datatype, op, comm);\n}\n\n", mod->cli_prefix, p);
+        return;
+      }
+      fprintf(fp, "  if( 2 * comm_size <= %d ) {\n", p + profiles[i+1]->nb_procs);
+      break;
+    }
+    fprintf(fp, "    return pgmpi_static_select_%s_p%d(msg_size, datatype, op, comm);\n  }\n", mod->cli_prefix, p);
+  }
+  fprintf(fp, "  return 0;\n}\n\n");
+}
+
+int main(int argc, char *argv[]) {
+  pgmpi_profile_t *profiles = NULL;
+  int n_profiles = 0;
+  alg_lookup_table_t tab;
+  pgmpi_profile_match_policy_t policy = PROFILE_MATCH_EXACT;
+  double min_effect = PGMPI_DEFAULT_MIN_EFFECT;
+  FILE *fp;
+  int i, j;
+
+  if( argc < 3 || argc > 5 ) {
+    fprintf(stderr, "usage: %s <profile directory> <header file> [exact|nearest|floor] [--peffect=<min effect>]\n",
+        argv[0]);
+    return 1;
+  }
+  for(i=3; i<argc; i++) {
+    if( strncmp(argv[i], "--peffect=", 10) == 0 ) {
+      min_effect = atof(argv[i] + 10);
+    } else if( pgmpi_profile_match_policy_from_string(argv[i], &policy) != 0 ) {
+      fprintf(stderr, "unknown profile match policy %s\n", argv[i]);
+      return 1;
+    }
+  }
+  if( policy == PROFILE_MATCH_EXTRAPOLATE ) {
+    // process counts are only known at run-time
+    fprintf(stderr, "warning: policy extrapolate is not supported for compiled profiles, using exact\n");
+    policy = PROFILE_MATCH_EXACT;
+  }
+
+  pgmpi_modules_init();
+
+  if( pgmpi_profile_read_many(argv[1], &profiles, &n_profiles) != 0 ) {
+    fprintf(stderr, "cannot read profiles from %s\n", argv[1]);
+    pgmpi_modules_free();
+    return 1;
+  }
+
+  // the table sorts the profiles of each collective by process count
+  pgmpi_allocate_replacement_table(&tab);
+  pgmpi_set_profile_min_effect(&tab, min_effect);
+  for(i=0; i<n_profiles; i++) {
+    if( profiles[i].nb_nodes > 0 ) {
+      fprintf(stderr, "warning: ignoring node layout of profile for %s with p=%d\n",
+          pgmpi_modules_get(profiles[i].cid)->mpiname, profiles[i].nb_procs);
+      profiles[i].nb_nodes = 0;
+      profiles[i].ppn = 0;
+    }
+    pgmpi_add_profile_to_table(&tab, &profiles[i]);
+  }
+
+  if( (fp = fopen(argv[2], "w")) == NULL ) {
+    fprintf(stderr, "cannot open %s\n", argv[2]);
+    pgmpi_free_replacement_table(&tab);
+    free(profiles);
+    pgmpi_modules_free();
+    return 1;
+  }
+
+  fprintf(fp, "/* generated by pgmpi_prf2c from %s, do not edit */\n\n", argv[1]);
+  fprintf(fp, "#ifndef PGMPI_STATIC_DECISIONS_H_\n#define PGMPI_STATIC_DECISIONS_H_\n\n");
+  fprintf(fp, "#include <mpi.h>\n#include \"pgmpi_tune.h\"\n#include \"tuning/pgmpi_range_qualifier.h\"\n"
+      "#include \"collectives/collective_modules.h\"\n#include \"util/pgmpi_callsite.h\"\n"
+      "#include \"util/pgmpi_skew.h\"\n\n");
+  fprintf(fp, "static inline int pgmpi_static_comm_size(MPI_Comm comm) {\n"
+      "  int comm_size;\n  PMPI_Comm_size(comm, &comm_size);\n  return comm_size;\n}\n\n");
+
+  for(i=0; i<tab.num_collectives; i++) {
+    pgmpi_profile_t **cprofiles;
+    int n;
+    pgmpi_get_profiles(&tab, i, &cprofiles, &n);
+    emit_collective_function(fp, &tab, pgmpi_modules_get(i), cprofiles, n, policy);
+  }
+
+  fprintf(fp, "static inline int pgmpi_static_select(const pgmpi_collectives_t cid, const MPI_Count msg_size,\n"
+      "    MPI_Datatype datatype, MPI_Op op, MPI_Comm comm) {\n  switch( cid ) {\n");
+  for(i=0; i<tab.num_collectives; i++) {
+    module_t *mod = pgmpi_modules_get(i);
+    fprintf(fp, "  case %d: /* %s */\n", i, mod->mpiname);
+    fprintf(fp, "    return pgmpi_static_select_%s(msg_size, datatype, op, comm);\n", mod->cli_prefix);
+  }
+  fprintf(fp, "  default:\n    return 0;\n  }\n}\n\n#endif\n");
+  fclose(fp);
+
+  for(j=0, i=0; i<tab.num_collectives; i++) {
+    j += tab.n_profiles[i];
+  }
+  printf("compiled %d profiles into %s\n", j, argv[2]);
+
+  pgmpi_free_replacement_table(&tab);
+  free(profiles);
+  pgmpi_modules_free();
+
+  return 0;
+}
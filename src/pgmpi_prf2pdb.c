@@ -0,0 +1,73 @@
+/*  PGMPITuneLib - Library for Autotuning MPI Collectives using Performance Guidelines
+ *  
+ *  Copyright 2017 Sascha Hunold, Alexandra Carpen-Amarie
+ *      Research Group for Parallel Computing
+ *      Faculty of Informatics
+ *      Vienna University of Technology, Austria
+ *  
+ *  <license>
+ *      This library is free software; you can redistribute it
+ *      and/or modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *  
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *  
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free
+ *      Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *      Boston, MA 02110-1301 USA
+ *  </license>
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "pgmpi_tune.h"
+#include "collectives/collective_modules.h"
+#include "tuning/pgmpi_profile_reader.h"
+#include "tuning/pgmpi_profile_db.h"
+
+/*
+ * converts a directory of .prf profiles into a binary profile database
+ * usage: pgmpi_prf2pdb <profile directory> <database file>
+ */
+
+int main(int argc, char *argv[]) {
+  pgmpi_profile_t *profiles = NULL;
+  int n_profiles = 0;
+  int i, ret;
+
+  if( argc != 3 ) {
+    fprintf(stderr, "usage: %s <profile directory> <database file>\n", argv[0]);
+    return 1;
+  }
+
+  pgmpi_modules_init();
+
+  if( pgmpi_profile_read_many(argv[1], &profiles, &n_profiles) != 0 ) {
+    fprintf(stderr, "cannot read profiles from %s\n", argv[1]);
+    pgmpi_modules_free();
+    return 1;
+  }
+
+  ret = pgmpi_profile_db_write(argv[2], profiles, n_profiles);
+  if( ret == 0 ) {
+    printf("wrote %d profiles to %s\n", n_profiles, argv[2]);
+  } else {
+    fprintf(stderr, "cannot write %s\n", argv[2]);
+  }
+
+  for(i=0; i<n_profiles; i++) {
+    pgmpi_profile_free(&profiles[i]);
+  }
+  free(profiles);
+
+  pgmpi_modules_free();
+
+  return (ret == 0) ? 0 : 1;
+}
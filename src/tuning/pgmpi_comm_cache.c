@@ -0,0 +1,191 @@
+/*  PGMPITuneLib - Library for Autotuning MPI Collectives using Performance Guidelines
+ *  
+ *  Copyright 2017 Sascha Hunold, Alexandra Carpen-Amarie
+ *      Research Group for Parallel Computing
+ *      Faculty of Informatics
+ *      Vienna University of Technology, Austria
+ *  
+ *  <license>
+ *      This library is free software; you can redistribute it
+ *      and/or modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *  
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *  
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free
+ *      Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *      Boston, MA 02110-1301 USA
+ *  </license>
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+
+#include <mpi.h>
+#include "pgmpi_tune.h"
+
+#define ZF_LOG_LEVEL MY_ZF_LOG_LEVEL
+#include "log/zf_log.h"
+
+#include "pgmpi_comm_cache.h"
+
+static int comm_cache_keyval = MPI_KEYVAL_INVALID;
+static unsigned int cache_generation = 0;
+
+static int comm_cache_delete_fn(MPI_Comm comm, int keyval, void *attribute_val, void *extra_state);
+static void build_comm_cache(pgmpi_comm_cache_t *cache, MPI_Comm comm, alg_lookup_table_t *tab);
+
+
+static int comm_cache_delete_fn(MPI_Comm comm, int keyval, void *attribute_val, void *extra_state) {
+  pgmpi_comm_cache_t *cache = (pgmpi_comm_cache_t *)attribute_val;
+
+  if( cache != NULL ) {
+    free(cache->profile);
+    free(cache);
+  }
+  return MPI_SUCCESS;
+}
+
+static void build_comm_cache(pgmpi_comm_cache_t *cache, MPI_Comm comm, alg_lookup_table_t *tab) {
+  int i;
+
+  MPI_Comm_size(comm, &cache->comm_size);
+  pgmpi_comm_topology_unknown(cache->comm_size, &cache->shape);
+  if( tab != NULL && tab->has_shapes ) {
+    pgmpi_comm_topology_detect(comm, &cache->shape);
+  }
+
+  if( cache->profile == NULL ) {
+    cache->profile = (pgmpi_profile_t **)calloc(NUM_COLLECTIVES, sizeof(pgmpi_profile_t *));
+  }
+  for(i=0; i<NUM_COLLECTIVES; i++) {
+    cache->profile[i] = NULL;
+    if( tab != NULL && i < tab->num_collectives ) {
+      pgmpi_get_profile_for_comm_shape(tab, i, &cache->shape, &cache->profile[i]);
+    }
+  }
+
+  cache->memo_n = 0;
+  cache->memo_next = 0;
+  cache->generation = cache_generation;
+}
+
+int pgmpi_comm_cache_init(void) {
+  int ret;
+
+  if( comm_cache_keyval != MPI_KEYVAL_INVALID ) {
+    return 0;
+  }
+
+  ret = MPI_Comm_create_keyval(MPI_COMM_NULL_COPY_FN, &comm_cache_delete_fn, &comm_cache_keyval, NULL);
+  if( ret != MPI_SUCCESS ) {
+    ZF_LOGE("cannot create keyval for communicator cache");
+    comm_cache_keyval = MPI_KEYVAL_INVALID;
+    return -1;
+  }
+
+  return 0;
+}
+
+void pgmpi_comm_cache_free(void) {
+  void *val;
+  int flag;
+
+  if( comm_cache_keyval == MPI_KEYVAL_INVALID ) {
+    return;
+  }
+
+  // attributes of MPI_COMM_WORLD and MPI_COMM_SELF are not necessarily deleted by MPI_Finalize
+  MPI_Comm_get_attr(MPI_COMM_WORLD, comm_cache_keyval, &val, &flag);
+  if( flag ) {
+    MPI_Comm_delete_attr(MPI_COMM_WORLD, comm_cache_keyval);
+  }
+  MPI_Comm_get_attr(MPI_COMM_SELF, comm_cache_keyval, &val, &flag);
+  if( flag ) {
+    MPI_Comm_delete_attr(MPI_COMM_SELF, comm_cache_keyval);
+  }
+
+  MPI_Comm_free_keyval(&comm_cache_keyval);
+  comm_cache_keyval = MPI_KEYVAL_INVALID;
+}
+
+void pgmpi_comm_cache_invalidate(void) {
+  cache_generation++;
+}
+
+pgmpi_comm_cache_t *pgmpi_comm_cache_get(MPI_Comm comm, alg_lookup_table_t *tab) {
+  pgmpi_comm_cache_t *cache = NULL;
+  int flag = 0;
+
+  if( comm_cache_keyval == MPI_KEYVAL_INVALID ) {
+    return NULL;
+  }
+
+  MPI_Comm_get_attr(comm, comm_cache_keyval, &cache, &flag);
+  if( flag && cache->generation == cache_generation ) {
+    return cache;
+  }
+
+  if( !flag ) {
+    ZF_LOGV("first use of communicator, building cache");
+    cache = (pgmpi_comm_cache_t *)calloc(1, sizeof(pgmpi_comm_cache_t));
+    build_comm_cache(cache, comm, tab);
+    if( MPI_Comm_set_attr(comm, comm_cache_keyval, cache) != MPI_SUCCESS ) {
+      ZF_LOGE("cannot attach cache to communicator");
+      comm_cache_delete_fn(comm, comm_cache_keyval, cache, NULL);
+      return NULL;
+    }
+  } else {
+    ZF_LOGV("communicator cache is stale, rebuilding");
+    build_comm_cache(cache, comm, tab);
+  }
+
+  return cache;
+}
+
+int pgmpi_comm_cache_lookup(pgmpi_comm_cache_t *cache, const pgmpi_collectives_t cid, const MPI_Count msg_size,
+    const pgmpi_call_qualifiers_t *call, int *alg_id) {
+  int i;
+
+  for(i=0; i<cache->memo_n; i++) {
+    if( cache->memo[i].msg_size == msg_size && cache->memo[i].cid == cid &&
+        cache->memo[i].dtype_id == call->dtype_id && cache->memo[i].op_id == call->op_id &&
+        cache->memo[i].site_id == call->site_id &&
+        cache->memo[i].skew_lo <= call->skew_us && call->skew_us < cache->memo[i].skew_hi ) {
+      *alg_id = cache->memo[i].alg_id;
+      return 0;
+    }
+  }
+  return -1;
+}
+
+void pgmpi_comm_cache_store(pgmpi_comm_cache_t *cache, const pgmpi_collectives_t cid, const MPI_Count msg_size,
+    const pgmpi_call_qualifiers_t *call, const int alg_id) {
+  pgmpi_comm_memo_entry_t *entry;
+
+  if( call->dtype_id == PGMPI_QUALIFIER_NONE ) {
+    // derived datatype, see pgmpi_comm_cache_lookup
+    return;
+  }
+
+  entry = &cache->memo[cache->memo_next];
+  entry->cid = cid;
+  entry->msg_size = msg_size;
+  entry->dtype_id = call->dtype_id;
+  entry->op_id = call->op_id;
+  entry->site_id = call->site_id;
+  pgmpi_profile_skew_interval(cache->profile[cid], call->skew_us, &entry->skew_lo, &entry->skew_hi);
+  entry->alg_id = alg_id;
+
+  cache->memo_next = (cache->memo_next + 1) % PGMPI_COMM_CACHE_MEMO_SIZE;
+  if( cache->memo_n < PGMPI_COMM_CACHE_MEMO_SIZE ) {
+    cache->memo_n++;
+  }
+}
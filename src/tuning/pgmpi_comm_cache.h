@@ -0,0 +1,93 @@
+/*  PGMPITuneLib - Library for Autotuning MPI Collectives using Performance Guidelines
+ *  
+ *  Copyright 2017 Sascha Hunold, Alexandra Carpen-Amarie
+ *      Research Group for Parallel Computing
+ *      Faculty of Informatics
+ *      Vienna University of Technology, Austria
+ *  
+ *  <license>
+ *      This library is free software; you can redistribute it
+ *      and/or modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *  
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *  
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free
+ *      Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *      Boston, MA 02110-1301 USA
+ *  </license>
+ */
+
+
+#ifndef SRC_TUNING_PGMPI_COMM_CACHE_H_
+#define SRC_TUNING_PGMPI_COMM_CACHE_H_
+
+#include <mpi.h>
+
+#include "pgmpi_tune.h"
+#include "pgmpi_function_replacer.h"
+
+#define PGMPI_COMM_CACHE_MEMO_SIZE 8
+
+typedef struct {
+  pgmpi_collectives_t cid;
+  MPI_Count msg_size;
+  int dtype_id;
+  int op_id;
+  int site_id;
+  int skew_lo;    /* skews in [skew_lo, skew_hi) select the same ranges */
+  int skew_hi;
+  int alg_id;
+} pgmpi_comm_memo_entry_t;
+
+/*
+ * per-communicator state, attached to the communicator as an MPI attribute
+ * the cache is rebuilt whenever the lookup table changes (generation)
+ */
+typedef struct {
+  unsigned int generation;
+  int comm_size;
+  pgmpi_comm_shape_t shape;    /* node layout, only detected if a profile declares one */
+  pgmpi_profile_t **profile;   /* one entry per collective, profile matching comm_size or NULL */
+  int memo_n;                  /* number of valid memo entries */
+  int memo_next;               /* next entry to overwrite */
+  pgmpi_comm_memo_entry_t memo[PGMPI_COMM_CACHE_MEMO_SIZE];
+} pgmpi_comm_cache_t;
+
+int pgmpi_comm_cache_init(void);
+
+void pgmpi_comm_cache_free(void);
+
+/*!
+  marks all existing caches as stale, e.g., after the lookup table has been rebuilt
+*/
+void pgmpi_comm_cache_invalidate(void);
+
+/*!
+  \return cache attached to comm, built from tab if the communicator is seen for
+          the first time or the cache is stale; NULL on error
+*/
+pgmpi_comm_cache_t *pgmpi_comm_cache_get(MPI_Comm comm, alg_lookup_table_t *tab);
+
+/*!
+  entries are keyed by the qualifier ids of the call rather than by the
+  datatype and op handles, which MPI may reuse once they are freed; calls with
+  derived datatypes are not memoized, as the buffers of the mock-ups depend on
+  their extent; an entry covers the skews between the skew qualifiers of the
+  profile next to the skew it was stored with, so that the changing skew
+  estimate does not miss
+  \param call qualifiers of the call, site_id and skew_us may be PGMPI_QUALIFIER_NONE if unknown
+  \return 0 if a decision for (cid, msg_size, call) is memoized and written to alg_id, -1 otherwise
+*/
+int pgmpi_comm_cache_lookup(pgmpi_comm_cache_t *cache, const pgmpi_collectives_t cid, const MPI_Count msg_size,
+    const pgmpi_call_qualifiers_t *call, int *alg_id);
+
+void pgmpi_comm_cache_store(pgmpi_comm_cache_t *cache, const pgmpi_collectives_t cid, const MPI_Count msg_size,
+    const pgmpi_call_qualifiers_t *call, const int alg_id);
+
+#endif /* SRC_TUNING_PGMPI_COMM_CACHE_H_ */
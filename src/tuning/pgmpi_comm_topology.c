@@ -0,0 +1,79 @@
+/*  PGMPITuneLib - Library for Autotuning MPI Collectives using Performance Guidelines
+ *  
+ *  Copyright 2017 Sascha Hunold, Alexandra Carpen-Amarie
+ *      Research Group for Parallel Computing
+ *      Faculty of Informatics
+ *      Vienna University of Technology, Austria
+ *  
+ *  <license>
+ *      This library is free software; you can redistribute it
+ *      and/or modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *  
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *  
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free
+ *      Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *      Boston, MA 02110-1301 USA
+ *  </license>
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <mpi.h>
+#include "pgmpi_tune.h"
+
+#define ZF_LOG_LEVEL MY_ZF_LOG_LEVEL
+#include "log/zf_log.h"
+
+#include "pgmpi_comm_topology.h"
+
+
+void pgmpi_comm_topology_unknown(const int nb_procs, pgmpi_comm_shape_t *shape) {
+  shape->nb_procs = nb_procs;
+  shape->nb_nodes = 0;
+  shape->ppn = 0;
+}
+
+int pgmpi_comm_topology_detect(MPI_Comm comm, pgmpi_comm_shape_t *shape) {
+  MPI_Comm node_comm;
+  int comm_size, node_size;
+  int local[2], global[2];
+
+  MPI_Comm_size(comm, &comm_size);
+  pgmpi_comm_topology_unknown(comm_size, shape);
+
+  if( MPI_Comm_split_type(comm, MPI_COMM_TYPE_SHARED, 0, MPI_INFO_NULL, &node_comm) != MPI_SUCCESS ) {
+    ZF_LOGE("cannot split communicator by shared memory domain");
+    return -1;
+  }
+  MPI_Comm_size(node_comm, &node_size);
+  MPI_Comm_free(&node_comm);
+
+  // max and min number of processes per node in one reduction
+  // PMPI, as MPI_Allreduce is intercepted and would ask for this communicator's cache again
+  local[0] = node_size;
+  local[1] = -node_size;
+  if( PMPI_Allreduce(local, global, 2, MPI_INT, MPI_MAX, comm) != MPI_SUCCESS ) {
+    ZF_LOGE("cannot reduce node sizes");
+    return -1;
+  }
+
+  if( global[0] == -global[1] ) {
+    shape->ppn = global[0];
+    shape->nb_nodes = comm_size / global[0];
+  } else {
+    shape->ppn = -1;
+    shape->nb_nodes = -1;
+  }
+  ZF_LOGV("communicator layout: p=%d nodes=%d ppn=%d", shape->nb_procs, shape->nb_nodes, shape->ppn);
+
+  return 0;
+}
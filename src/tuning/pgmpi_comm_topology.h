@@ -0,0 +1,55 @@
+/*  PGMPITuneLib - Library for Autotuning MPI Collectives using Performance Guidelines
+ *  
+ *  Copyright 2017 Sascha Hunold, Alexandra Carpen-Amarie
+ *      Research Group for Parallel Computing
+ *      Faculty of Informatics
+ *      Vienna University of Technology, Austria
+ *  
+ *  <license>
+ *      This library is free software; you can redistribute it
+ *      and/or modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *  
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *  
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free
+ *      Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *      Boston, MA 02110-1301 USA
+ *  </license>
+ */
+
+
+#ifndef SRC_TUNING_PGMPI_COMM_TOPOLOGY_H_
+#define SRC_TUNING_PGMPI_COMM_TOPOLOGY_H_
+
+#include <mpi.h>
+
+/*
+ * node layout of a communicator
+ * nb_nodes == 0: layout unknown (not detected)
+ * nb_nodes == -1: irregular layout (nodes host different numbers of processes)
+ */
+typedef struct {
+  int nb_procs;
+  int nb_nodes;
+  int ppn;        /* processes per node */
+} pgmpi_comm_shape_t;
+
+/*!
+  detects the node layout of comm, collective over comm
+  nodes are identified with MPI_Comm_split_type(MPI_COMM_TYPE_SHARED)
+  \return 0 on success, -1 on error (shape is then set to unknown)
+*/
+int pgmpi_comm_topology_detect(MPI_Comm comm, pgmpi_comm_shape_t *shape);
+
+/*!
+  sets shape to p processes with an unknown layout
+*/
+void pgmpi_comm_topology_unknown(const int nb_procs, pgmpi_comm_shape_t *shape);
+
+#endif /* SRC_TUNING_PGMPI_COMM_TOPOLOGY_H_ */
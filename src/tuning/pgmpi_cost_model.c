@@ -0,0 +1,527 @@
+/*  PGMPITuneLib - Library for Autotuning MPI Collectives using Performance Guidelines
+ *  
+ *  Copyright 2017 Sascha Hunold, Alexandra Carpen-Amarie
+ *      Research Group for Parallel Computing
+ *      Faculty of Informatics
+ *      Vienna University of Technology, Austria
+ *  
+ *  <license>
+ *      This library is free software; you can redistribute it
+ *      and/or modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *  
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *  
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free
+ *      Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *      Boston, MA 02110-1301 USA
+ *  </license>
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "pgmpi_tune.h"
+
+#define ZF_LOG_LEVEL MY_ZF_LOG_LEVEL
+#include "log/zf_log.h"
+
+#include "pgmpi_cost_model.h"
+#include "collectives/collective_modules.h"
+
+/*
+ * message size of a step relative to the message size m of the mock-up
+ */
+typedef enum {
+  STEP_SIZE_M = 0,
+  STEP_SIZE_M_TIMES_P,
+  STEP_SIZE_M_DIV_P     /* rounded up, as the mock-ups pad the buffers */
+} step_size_t;
+
+#define MAX_MOCKUP_STEPS 4
+
+typedef struct {
+  int prim;
+  step_size_t size;
+} mockup_step_t;
+
+typedef struct {
+  const char *algname;
+  int n_steps;
+  mockup_step_t step[MAX_MOCKUP_STEPS];
+} mockup_cost_t;
+
+static const char *prim_names[PGMPI_PRIM_NB] = {
+    "MPI_Allgather",
+    "MPI_Allgatherv",
+    "MPI_Allreduce",
+    "MPI_Alltoall",
+    "MPI_Alltoallv",
+    "MPI_Bcast",
+    "MPI_Exscan",
+    "MPI_Gather",
+    "MPI_Gatherv",
+    "MPI_Reduce",
+    "MPI_Reduce_scatter",
+    "MPI_Reduce_scatter_block",
+    "MPI_Scan",
+    "MPI_Scatter",
+    "MPI_Scatterv",
+    "memcpy",
+    "MPI_Reduce_local"
+};
+
+/* primitive of the default algorithm, indexed by pgmpi_collectives_t */
+static const int default_prim[] = {
+    PGMPI_PRIM_ALLGATHER,
+    PGMPI_PRIM_ALLREDUCE,
+    PGMPI_PRIM_ALLTOALL,
+    PGMPI_PRIM_BCAST,
+    PGMPI_PRIM_GATHER,
+    PGMPI_PRIM_REDUCE,
+    PGMPI_PRIM_REDUCE_SCATTER_BLOCK,
+    PGMPI_PRIM_SCAN,
+    PGMPI_PRIM_SCATTER
+};
+
+/*
+ * compositions of the mock-ups in src/collectives/ *_impl.c
+ * mock-ups of the optional extensions (lane, hier, circulant) are not described
+ * and therefore never selected by the model
+ */
+static const mockup_cost_t mockup_costs[] = {
+    { "allgather_as_allgatherv", 1, { { PGMPI_PRIM_ALLGATHERV, STEP_SIZE_M } } },
+    { "allgather_as_allreduce", 2, { { PGMPI_PRIM_COPY, STEP_SIZE_M },
+                                     { PGMPI_PRIM_ALLREDUCE, STEP_SIZE_M_TIMES_P } } },
+    { "allgather_as_alltoall", 2, { { PGMPI_PRIM_COPY, STEP_SIZE_M_TIMES_P },
+                                    { PGMPI_PRIM_ALLTOALL, STEP_SIZE_M } } },
+    { "allgather_as_gather_bcast", 2, { { PGMPI_PRIM_GATHER, STEP_SIZE_M },
+                                        { PGMPI_PRIM_BCAST, STEP_SIZE_M_TIMES_P } } },
+    { "allreduce_as_reduce_bcast", 2, { { PGMPI_PRIM_REDUCE, STEP_SIZE_M },
+                                        { PGMPI_PRIM_BCAST, STEP_SIZE_M } } },
+    { "allreduce_as_reducescatterblock_allgather", 4, { { PGMPI_PRIM_COPY, STEP_SIZE_M },
+                                                        { PGMPI_PRIM_REDUCE_SCATTER_BLOCK, STEP_SIZE_M_DIV_P },
+                                                        { PGMPI_PRIM_ALLGATHER, STEP_SIZE_M_DIV_P },
+                                                        { PGMPI_PRIM_COPY, STEP_SIZE_M } } },
+    { "allreduce_as_reducescatter_allgatherv", 2, { { PGMPI_PRIM_REDUCE_SCATTER, STEP_SIZE_M_DIV_P },
+                                                    { PGMPI_PRIM_ALLGATHERV, STEP_SIZE_M_DIV_P } } },
+    { "alltoall_as_alltoallv", 1, { { PGMPI_PRIM_ALLTOALLV, STEP_SIZE_M } } },
+    { "bcast_as_allgatherv", 1, { { PGMPI_PRIM_ALLGATHERV, STEP_SIZE_M_DIV_P } } },
+    { "bcast_as_scatter_allgather", 4, { { PGMPI_PRIM_COPY, STEP_SIZE_M },
+                                         { PGMPI_PRIM_SCATTER, STEP_SIZE_M_DIV_P },
+                                         { PGMPI_PRIM_ALLGATHER, STEP_SIZE_M_DIV_P },
+                                         { PGMPI_PRIM_COPY, STEP_SIZE_M } } },
+    { "gather_as_allgather", 1, { { PGMPI_PRIM_ALLGATHER, STEP_SIZE_M } } },
+    { "gather_as_gatherv", 1, { { PGMPI_PRIM_GATHERV, STEP_SIZE_M } } },
+    { "gather_as_reduce", 2, { { PGMPI_PRIM_COPY, STEP_SIZE_M },
+                               { PGMPI_PRIM_REDUCE, STEP_SIZE_M_TIMES_P } } },
+    { "reduce_as_allreduce", 1, { { PGMPI_PRIM_ALLREDUCE, STEP_SIZE_M } } },
+    { "reduce_as_reducescatterblock_gather", 4, { { PGMPI_PRIM_COPY, STEP_SIZE_M },
+                                                  { PGMPI_PRIM_REDUCE_SCATTER_BLOCK, STEP_SIZE_M_DIV_P },
+                                                  { PGMPI_PRIM_GATHER, STEP_SIZE_M_DIV_P },
+                                                  { PGMPI_PRIM_COPY, STEP_SIZE_M } } },
+    { "reduce_as_reducescatter_gatherv", 2, { { PGMPI_PRIM_REDUCE_SCATTER, STEP_SIZE_M_DIV_P },
+                                              { PGMPI_PRIM_GATHERV, STEP_SIZE_M_DIV_P } } },
+    // the root receives the whole vector, which moves as much data as a reduce
+    { "reduce_as_reducescatter", 1, { { PGMPI_PRIM_REDUCE, STEP_SIZE_M } } },
+    { "reducescatterblock_as_reduce_scatter", 2, { { PGMPI_PRIM_REDUCE, STEP_SIZE_M_TIMES_P },
+                                                   { PGMPI_PRIM_SCATTER, STEP_SIZE_M } } },
+    { "reducescatterblock_as_reducescatter", 1, { { PGMPI_PRIM_REDUCE_SCATTER, STEP_SIZE_M } } },
+    { "reducescatterblock_as_allreduce", 2, { { PGMPI_PRIM_ALLREDUCE, STEP_SIZE_M_TIMES_P },
+                                              { PGMPI_PRIM_COPY, STEP_SIZE_M } } },
+    { "scan_as_exscan_reducelocal", 2, { { PGMPI_PRIM_EXSCAN, STEP_SIZE_M },
+                                         { PGMPI_PRIM_REDUCE_LOCAL, STEP_SIZE_M } } },
+    { "scatter_as_bcast", 2, { { PGMPI_PRIM_BCAST, STEP_SIZE_M_TIMES_P },
+                               { PGMPI_PRIM_COPY, STEP_SIZE_M } } },
+    { "scatter_as_scatterv", 1, { { PGMPI_PRIM_SCATTERV, STEP_SIZE_M } } }
+};
+
+static int compare_samples(const void *a, const void *b);
+static int ceil_log2(const int p);
+static double predict_hockney(const pgmpi_cost_model_t *model, const int prim, const int nb_procs,
+    const MPI_Count msg_size);
+static const mockup_cost_t *find_mockup_cost(const char *algname);
+
+
+static int compare_samples(const void *a, const void *b) {
+  const pgmpi_cost_sample_t *s1 = (const pgmpi_cost_sample_t *)a;
+  const pgmpi_cost_sample_t *s2 = (const pgmpi_cost_sample_t *)b;
+
+  if( s1->prim != s2->prim ) {
+    return (s1->prim < s2->prim) ? -1 : 1;
+  }
+  if( s1->nb_procs != s2->nb_procs ) {
+    return (s1->nb_procs < s2->nb_procs) ? -1 : 1;
+  }
+  if( s1->msg_size != s2->msg_size ) {
+    return (s1->msg_size < s2->msg_size) ? -1 : 1;
+  }
+  return 0;
+}
+
+static int ceil_log2(const int p) {
+  int l = 0;
+  while( (1 << l) < p ) {
+    l++;
+  }
+  return l;
+}
+
+/*
+ * textbook estimates: binomial trees for bcast, reduce, gather, scatter and scan,
+ * Rabenseifner's algorithm for allreduce, recursive doubling for allgather and
+ * reduce_scatter, and pairwise exchange for alltoall
+ */
+static double predict_hockney(const pgmpi_cost_model_t *model, const int prim, const int nb_procs,
+    const MPI_Count msg_size) {
+  const double m = msg_size;
+  const double p = nb_procs;
+  const double l = ceil_log2(nb_procs);
+
+  switch( prim ) {
+  case PGMPI_PRIM_BCAST:
+    return l * (model->alpha + model->beta * m);
+  case PGMPI_PRIM_REDUCE:
+  case PGMPI_PRIM_SCAN:
+  case PGMPI_PRIM_EXSCAN:
+    return l * (model->alpha + (model->beta + model->gamma) * m);
+  case PGMPI_PRIM_ALLREDUCE:
+    return 2.0 * l * model->alpha + (p - 1.0) / p * m * (2.0 * model->beta + model->gamma);
+  case PGMPI_PRIM_ALLGATHER:
+  case PGMPI_PRIM_ALLGATHERV:
+  case PGMPI_PRIM_GATHER:
+  case PGMPI_PRIM_GATHERV:
+  case PGMPI_PRIM_SCATTER:
+  case PGMPI_PRIM_SCATTERV:
+    return l * model->alpha + (p - 1.0) * m * model->beta;
+  case PGMPI_PRIM_REDUCE_SCATTER:
+  case PGMPI_PRIM_REDUCE_SCATTER_BLOCK:
+    return l * model->alpha + (p - 1.0) * m * (model->beta + model->gamma);
+  case PGMPI_PRIM_ALLTOALL:
+  case PGMPI_PRIM_ALLTOALLV:
+    return (p - 1.0) * (model->alpha + model->beta * m);
+  case PGMPI_PRIM_COPY:
+    return model->delta * m;
+  case PGMPI_PRIM_REDUCE_LOCAL:
+    return model->gamma * m;
+  default:
+    ZF_LOGE("unknown primitive %d", prim);
+  }
+  return 0.0;
+}
+
+static const mockup_cost_t *find_mockup_cost(const char *algname) {
+  size_t i;
+
+  for(i=0; i<sizeof(mockup_costs)/sizeof(mockup_cost_t); i++) {
+    if( strcmp(mockup_costs[i].algname, algname) == 0 ) {
+      return &mockup_costs[i];
+    }
+  }
+  return NULL;
+}
+
+void pgmpi_cost_model_init(pgmpi_cost_model_t *model) {
+  // a 1 us / 1 GB/s network, only used until the model is calibrated
+  model->alpha = 1e-6;
+  model->beta  = 1e-9;
+  model->gamma = 5e-10;
+  model->delta = 1e-10;
+  model->n_samples = 0;
+  model->capacity = 0;
+  model->sample = NULL;
+}
+
+void pgmpi_cost_model_free(pgmpi_cost_model_t *model) {
+  free(model->sample);
+  model->sample = NULL;
+  model->n_samples = 0;
+  model->capacity = 0;
+}
+
+int pgmpi_cost_primitive_by_name(const char *name) {
+  int i;
+
+  for(i=0; i<PGMPI_PRIM_NB; i++) {
+    if( strcmp(prim_names[i], name) == 0 ) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+const char *pgmpi_cost_primitive_name(const int prim) {
+  if( prim < 0 || prim >= PGMPI_PRIM_NB ) {
+    return NULL;
+  }
+  return prim_names[prim];
+}
+
+void pgmpi_cost_model_add_sample(pgmpi_cost_model_t *model, const int prim, const int nb_procs,
+    const MPI_Count msg_size, const double time) {
+  pgmpi_cost_sample_t *s;
+
+  if( model->n_samples == model->capacity ) {
+    model->capacity = (model->capacity == 0) ? 64 : 2 * model->capacity;
+    model->sample = (pgmpi_cost_sample_t *)realloc(model->sample, model->capacity * sizeof(pgmpi_cost_sample_t));
+  }
+  s = &model->sample[model->n_samples++];
+  s->prim = prim;
+  s->nb_procs = nb_procs;
+  s->msg_size = msg_size;
+  s->time = time;
+}
+
+void pgmpi_cost_model_sort(pgmpi_cost_model_t *model) {
+  if( model->n_samples > 1 ) {
+    qsort(model->sample, model->n_samples, sizeof(pgmpi_cost_sample_t), &compare_samples);
+  }
+}
+
+int pgmpi_cost_model_read(const char *fname, pgmpi_cost_model_t *model) {
+  FILE *fp;
+  char *line = NULL;
+  size_t len = 0;
+  int lineno = 0;
+  int ret = 0;
+
+  if( fname == NULL ) {
+    ZF_LOGE("file name is NULL");
+    return -1;
+  }
+  if ((fp = fopen(fname, "r")) == NULL) {
+    ZF_LOGE("Can't open %s", fname);
+    return -1;
+  }
+
+  while( getline(&line, &len, fp) != -1 ) {
+    char name[64];
+    int nb_procs, prim;
+    long long msg_size;
+    double value;
+
+    lineno++;
+    if( line[0] == '#' || sscanf(line, "%63s", name) != 1 ) {
+      continue;
+    }
+
+    if( strcmp(name, "alpha") == 0 || strcmp(name, "beta") == 0 || strcmp(name, "gamma") == 0 ||
+        strcmp(name, "delta") == 0 ) {
+      if( sscanf(line, "%*s %lf", &value) != 1 ) {
+        ZF_LOGE("%s:%d: missing value for %s", fname, lineno, name);
+        ret = -1;
+        break;
+      }
+      if( name[0] == 'a' ) {
+        model->alpha = value;
+      } else if( name[0] == 'b' ) {
+        model->beta = value;
+      } else if( name[0] == 'g' ) {
+        model->gamma = value;
+      } else {
+        model->delta = value;
+      }
+      continue;
+    }
+
+    prim = pgmpi_cost_primitive_by_name(name);
+    if( prim < 0 ) {
+      ZF_LOGW("%s:%d: ignoring unknown primitive %s", fname, lineno, name);
+      continue;
+    }
+    if( sscanf(line, "%*s %d %lld %lf", &nb_procs, &msg_size, &value) != 3 || nb_procs <= 0 || msg_size < 0 ) {
+      ZF_LOGE("%s:%d: invalid measurement", fname, lineno);
+      ret = -1;
+      break;
+    }
+    pgmpi_cost_model_add_sample(model, prim, nb_procs, (MPI_Count)msg_size, value);
+  }
+
+  free(line);
+  fclose(fp);
+
+  pgmpi_cost_model_sort(model);
+  return ret;
+}
+
+int pgmpi_cost_model_write(const char *fname, const pgmpi_cost_model_t *model) {
+  FILE *fp;
+  int i;
+
+  if ((fp = fopen(fname, "w")) == NULL) {
+    ZF_LOGE("Can't open %s for writing", fname);
+    return -1;
+  }
+
+  fprintf(fp, "# Hockney parameters [s], [s/byte]\n");
+  fprintf(fp, "alpha %.6e\n", model->alpha);
+  fprintf(fp, "beta %.6e\n", model->beta);
+  fprintf(fp, "# local reduction and memcpy [s/byte]\n");
+  fprintf(fp, "gamma %.6e\n", model->gamma);
+  fprintf(fp, "delta %.6e\n", model->delta);
+  fprintf(fp, "# primitive nb_procs msg_size time[s]\n");
+  for(i=0; i<model->n_samples; i++) {
+    fprintf(fp, "%s %d %lld %.6e\n", prim_names[model->sample[i].prim], model->sample[i].nb_procs,
+        (long long)model->sample[i].msg_size, model->sample[i].time);
+  }
+
+  if( fclose(fp) != 0 ) {
+    ZF_LOGE("cannot write %s", fname);
+    return -1;
+  }
+  return 0;
+}
+
+void pgmpi_cost_model_pack(pgmpi_pack_buf_t *buf, const pgmpi_cost_model_t *model) {
+  pgmpi_pack_bytes(buf, &model->alpha, sizeof(double));
+  pgmpi_pack_bytes(buf, &model->beta, sizeof(double));
+  pgmpi_pack_bytes(buf, &model->gamma, sizeof(double));
+  pgmpi_pack_bytes(buf, &model->delta, sizeof(double));
+  pgmpi_pack_int(buf, model->n_samples);
+  if( model->n_samples > 0 ) {
+    pgmpi_pack_bytes(buf, model->sample, model->n_samples * sizeof(pgmpi_cost_sample_t));
+  }
+}
+
+int pgmpi_cost_model_unpack(pgmpi_pack_buf_t *buf, pgmpi_cost_model_t *model) {
+  int n;
+
+  pgmpi_cost_model_free(model);
+  if( pgmpi_unpack_bytes(buf, &model->alpha, sizeof(double)) != 0 ||
+      pgmpi_unpack_bytes(buf, &model->beta, sizeof(double)) != 0 ||
+      pgmpi_unpack_bytes(buf, &model->gamma, sizeof(double)) != 0 ||
+      pgmpi_unpack_bytes(buf, &model->delta, sizeof(double)) != 0 ||
+      pgmpi_unpack_int(buf, &n) != 0 || n < 0 ) {
+    return -1;
+  }
+
+  if( n > 0 ) {
+    model->sample = (pgmpi_cost_sample_t *)malloc(n * sizeof(pgmpi_cost_sample_t));
+    model->capacity = n;
+    if( pgmpi_unpack_bytes(buf, model->sample, n * sizeof(pgmpi_cost_sample_t)) != 0 ) {
+      pgmpi_cost_model_free(model);
+      return -1;
+    }
+    model->n_samples = n;
+  }
+  return 0;
+}
+
+double pgmpi_cost_model_predict_primitive(const pgmpi_cost_model_t *model, const int prim, const int nb_procs,
+    const MPI_Count msg_size) {
+  int lo, hi, mid;
+  int first, last;
+  const pgmpi_cost_sample_t *s;
+
+  // first sample of (prim, nb_procs)
+  lo = 0;
+  hi = model->n_samples;
+  while( lo < hi ) {
+    mid = (lo + hi) / 2;
+    s = &model->sample[mid];
+    if( s->prim < prim || (s->prim == prim && s->nb_procs < nb_procs) ) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  first = lo;
+  last = first;
+  while( last < model->n_samples && model->sample[last].prim == prim && model->sample[last].nb_procs == nb_procs ) {
+    last++;
+  }
+
+  if( first == last ) {
+    return predict_hockney(model, prim, nb_procs, msg_size);
+  }
+
+  s = model->sample;
+  if( last - first == 1 || msg_size <= s[first].msg_size ) {
+    return s[first].time;
+  }
+
+  // piecewise linear, the last segment is extended for larger messages
+  for(mid=first+1; mid<last-1; mid++) {
+    if( msg_size <= s[mid].msg_size ) {
+      break;
+    }
+  }
+  {
+    double slope = (s[mid].time - s[mid-1].time) / (double)(s[mid].msg_size - s[mid-1].msg_size);
+    double t = s[mid-1].time + slope * (msg_size - s[mid-1].msg_size);
+    return (t > 0.0) ? t : 0.0;
+  }
+}
+
+int pgmpi_cost_model_predict_alg(const pgmpi_cost_model_t *model, const pgmpi_collectives_t cid,
+    const char *algname, const int nb_procs, const MPI_Count msg_size, double *time) {
+  const mockup_cost_t *desc;
+  int i;
+
+  if( cid < 0 || cid >= NUM_COLLECTIVES ) {
+    return -1;
+  }
+
+  if( strcmp(algname, "default") == 0 ) {
+    *time = pgmpi_cost_model_predict_primitive(model, default_prim[cid], nb_procs, msg_size);
+    return 0;
+  }
+
+  desc = find_mockup_cost(algname);
+  if( desc == NULL ) {
+    return -1;
+  }
+
+  *time = 0.0;
+  for(i=0; i<desc->n_steps; i++) {
+    MPI_Count size;
+    switch( desc->step[i].size ) {
+    case STEP_SIZE_M_TIMES_P:
+      size = msg_size * nb_procs;
+      break;
+    case STEP_SIZE_M_DIV_P:
+      size = (msg_size + nb_procs - 1) / nb_procs;
+      break;
+    default:
+      size = msg_size;
+    }
+    *time += pgmpi_cost_model_predict_primitive(model, desc->step[i].prim, nb_procs, size);
+  }
+
+  return 0;
+}
+
+int pgmpi_cost_model_select(const pgmpi_cost_model_t *model, const pgmpi_collectives_t cid, const int nb_procs,
+    const MPI_Count msg_size, int *alg_id) {
+  module_t *mod;
+  double best = -1.0;
+  int i;
+
+  mod = pgmpi_modules_get(cid);
+  if( mod == NULL ) {
+    return -1;
+  }
+
+  *alg_id = 0;
+  for(i=0; i<mod->alg_choices->nb_choices; i++) {
+    double t;
+    if( pgmpi_cost_model_predict_alg(model, cid, mod->alg_choices->alg[i].algname, nb_procs, msg_size, &t) != 0 ) {
+      continue;
+    }
+    // ties go to the first choice, i.e., to the default algorithm
+    if( best < 0 || t < best ) {
+      best = t;
+      *alg_id = mod->alg_choices->alg[i].algid;
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,141 @@
+/*  PGMPITuneLib - Library for Autotuning MPI Collectives using Performance Guidelines
+ *  
+ *  Copyright 2017 Sascha Hunold, Alexandra Carpen-Amarie
+ *      Research Group for Parallel Computing
+ *      Faculty of Informatics
+ *      Vienna University of Technology, Austria
+ *  
+ *  <license>
+ *      This library is free software; you can redistribute it
+ *      and/or modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *  
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *  
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free
+ *      Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *      Boston, MA 02110-1301 USA
+ *  </license>
+ */
+
+
+#ifndef SRC_TUNING_PGMPI_COST_MODEL_H_
+#define SRC_TUNING_PGMPI_COST_MODEL_H_
+
+#include "pgmpi_tune.h"
+#include "util/pgmpi_pack.h"
+
+/*
+ * the cost model predicts the run-time of a mock-up from its composition,
+ * e.g., allreduce_as_reducescatterblock_allgather is
+ *   memcpy(m) + MPI_Reduce_scatter_block(m/p) + MPI_Allgather(m/p) + memcpy(m)
+ *
+ * the cost of a base collective is interpolated from calibrated measurements
+ * (pgmpi_calibrate) for the same number of processes, otherwise it is estimated
+ * from the Hockney parameters alpha (latency) and beta (time per byte), with gamma
+ * as time per byte of a local reduction and delta as time per byte of a memcpy
+ *
+ * message sizes follow the convention of the wrappers: the block per process for
+ * allgather(v), alltoall(v), gather(v), scatter(v) and reduce_scatter(_block),
+ * the whole buffer for the other collectives
+ */
+
+typedef enum {
+  PGMPI_PRIM_ALLGATHER = 0,
+  PGMPI_PRIM_ALLGATHERV,
+  PGMPI_PRIM_ALLREDUCE,
+  PGMPI_PRIM_ALLTOALL,
+  PGMPI_PRIM_ALLTOALLV,
+  PGMPI_PRIM_BCAST,
+  PGMPI_PRIM_EXSCAN,
+  PGMPI_PRIM_GATHER,
+  PGMPI_PRIM_GATHERV,
+  PGMPI_PRIM_REDUCE,
+  PGMPI_PRIM_REDUCE_SCATTER,
+  PGMPI_PRIM_REDUCE_SCATTER_BLOCK,
+  PGMPI_PRIM_SCAN,
+  PGMPI_PRIM_SCATTER,
+  PGMPI_PRIM_SCATTERV,
+  PGMPI_PRIM_COPY,          /* local memcpy */
+  PGMPI_PRIM_REDUCE_LOCAL,  /* local reduction */
+  PGMPI_PRIM_NB
+} pgmpi_cost_primitive_t;
+
+typedef struct {
+  int prim;
+  int nb_procs;
+  MPI_Count msg_size;
+  double time;    /* seconds, maximum over all processes */
+} pgmpi_cost_sample_t;
+
+typedef struct {
+  double alpha;
+  double beta;
+  double gamma;
+  double delta;
+  int n_samples;
+  int capacity;
+  pgmpi_cost_sample_t *sample;  /* sorted by (prim, nb_procs, msg_size) once the model is complete */
+} pgmpi_cost_model_t;
+
+/*!
+  initializes an empty model with default parameters
+*/
+void pgmpi_cost_model_init(pgmpi_cost_model_t *model);
+
+void pgmpi_cost_model_free(pgmpi_cost_model_t *model);
+
+/*!
+  \return primitive with the given name (e.g., "MPI_Allgatherv", "memcpy"), -1 if unknown
+*/
+int pgmpi_cost_primitive_by_name(const char *name);
+
+const char *pgmpi_cost_primitive_name(const int prim);
+
+/*!
+  adds a measurement, call pgmpi_cost_model_sort afterwards
+*/
+void pgmpi_cost_model_add_sample(pgmpi_cost_model_t *model, const int prim, const int nb_procs,
+    const MPI_Count msg_size, const double time);
+
+void pgmpi_cost_model_sort(pgmpi_cost_model_t *model);
+
+/*!
+  reads a calibration file written by pgmpi_cost_model_write
+  \return 0 on success, -1 on error
+*/
+int pgmpi_cost_model_read(const char *fname, pgmpi_cost_model_t *model);
+
+int pgmpi_cost_model_write(const char *fname, const pgmpi_cost_model_t *model);
+
+void pgmpi_cost_model_pack(pgmpi_pack_buf_t *buf, const pgmpi_cost_model_t *model);
+
+int pgmpi_cost_model_unpack(pgmpi_pack_buf_t *buf, pgmpi_cost_model_t *model);
+
+/*!
+  \return predicted run-time of a base collective or local operation
+*/
+double pgmpi_cost_model_predict_primitive(const pgmpi_cost_model_t *model, const int prim, const int nb_procs,
+    const MPI_Count msg_size);
+
+/*!
+  \param time set to the predicted run-time of the algorithm
+  \return 0 on success, -1 if there is no description of the algorithm
+*/
+int pgmpi_cost_model_predict_alg(const pgmpi_cost_model_t *model, const pgmpi_collectives_t cid,
+    const char *algname, const int nb_procs, const MPI_Count msg_size, double *time);
+
+/*!
+  selects the algorithm with the lowest predicted run-time among the described
+  alg choices of the module
+  \return 0 on success, -1 if cid is invalid
+*/
+int pgmpi_cost_model_select(const pgmpi_cost_model_t *model, const pgmpi_collectives_t cid, const int nb_procs,
+    const MPI_Count msg_size, int *alg_id);
+
+#endif /* SRC_TUNING_PGMPI_COST_MODEL_H_ */
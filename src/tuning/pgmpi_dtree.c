@@ -0,0 +1,475 @@
+/*  PGMPITuneLib - Library for Autotuning MPI Collectives using Performance Guidelines
+ *  
+ *  Copyright 2017 Sascha Hunold, Alexandra Carpen-Amarie
+ *      Research Group for Parallel Computing
+ *      Faculty of Informatics
+ *      Vienna University of Technology, Austria
+ *  
+ *  <license>
+ *      This library is free software; you can redistribute it
+ *      and/or modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *  
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *  
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free
+ *      Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *      Boston, MA 02110-1301 USA
+ *  </license>
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <math.h>
+
+#include "pgmpi_tune.h"
+
+#define ZF_LOG_LEVEL MY_ZF_LOG_LEVEL
+#include "log/zf_log.h"
+
+#include "pgmpi_dtree.h"
+#include "pgmpi_range_qualifier.h"
+#include "collectives/collective_modules.h"
+
+#define PGMPI_DTREE_MAX_CHOICES 32
+
+static const char *feature_names[PGMPI_DTREE_NB_FEATURES] = {
+    "p",
+    "nodes",
+    "ppn",
+    "bytes",
+    "dtype_size",
+    "op"
+};
+
+static char *next_data_line(FILE *fp, char **line, size_t *len, int *lineno);
+static int read_forest(FILE *fp, char **line, size_t *len, int *lineno, const pgmpi_collectives_t cid,
+    pgmpi_dtree_forest_t *forest);
+static void forest_free(pgmpi_dtree_forest_t *forest);
+static int forest_finalize(pgmpi_dtree_forest_t *forest);
+static int compare_counts(const void *a, const void *b);
+
+
+static int compare_counts(const void *a, const void *b) {
+  const MPI_Count i1 = *(const MPI_Count *)a;
+  const MPI_Count i2 = *(const MPI_Count *)b;
+  return (i1 > i2) - (i1 < i2);
+}
+
+/*
+ * \return next line that is neither empty nor a comment, with trailing comments removed, NULL at the end of the file
+ */
+static char *next_data_line(FILE *fp, char **line, size_t *len, int *lineno) {
+  char *c;
+
+  while( getline(line, len, fp) != -1 ) {
+    (*lineno)++;
+    c = strchr(*line, '#');
+    if( c != NULL ) {
+      *c = '\0';
+    }
+    for(c=*line; *c == ' ' || *c == '\t' || *c == '\r' || *c == '\n'; c++);
+    if( *c != '\0' ) {
+      return c;
+    }
+  }
+  return NULL;
+}
+
+static void forest_free(pgmpi_dtree_forest_t *forest) {
+  free(forest->root);
+  free(forest->node);
+  free(forest->bytes_thresholds);
+  free(forest);
+}
+
+/*
+ * checks the node array and collects the thresholds of splits on bytes
+ */
+static int forest_finalize(pgmpi_dtree_forest_t *forest) {
+  module_t *mod;
+  int i, n;
+
+  mod = pgmpi_modules_get(forest->cid);
+  if( mod == NULL || mod->alg_choices->nb_choices > PGMPI_DTREE_MAX_CHOICES ) {
+    ZF_LOGE("cannot model collective %d", forest->cid);
+    return -1;
+  }
+
+  for(i=0; i<forest->n_trees; i++) {
+    if( forest->root[i] < 0 || forest->root[i] >= forest->n_nodes ) {
+      ZF_LOGE("invalid root %d", forest->root[i]);
+      return -1;
+    }
+  }
+
+  n = 0;
+  for(i=0; i<forest->n_nodes; i++) {
+    pgmpi_dtree_node_t *node = &forest->node[i];
+    if( node->feature == PGMPI_DTREE_LEAF ) {
+      if( node->child[0] < 0 || node->child[0] >= mod->alg_choices->nb_choices ) {
+        ZF_LOGE("invalid alg choice %d in node %d", node->child[0], i);
+        return -1;
+      }
+    } else {
+      // children after their parent, so every path ends in a leaf
+      if( node->feature < 0 || node->feature >= PGMPI_DTREE_NB_FEATURES ||
+          node->child[0] <= i || node->child[0] >= forest->n_nodes ||
+          node->child[1] <= i || node->child[1] >= forest->n_nodes ) {
+        ZF_LOGE("invalid split in node %d", i);
+        return -1;
+      }
+      if( node->feature == PGMPI_DTREE_FEATURE_BYTES ) {
+        n++;
+      }
+    }
+  }
+
+  free(forest->bytes_thresholds);
+  forest->bytes_thresholds = NULL;
+  forest->n_bytes_thresholds = 0;
+  if( n > 0 ) {
+    forest->bytes_thresholds = (MPI_Count *)malloc(n * sizeof(MPI_Count));
+    for(i=0; i<forest->n_nodes; i++) {
+      if( forest->node[i].feature == PGMPI_DTREE_FEATURE_BYTES ) {
+        // msg_size <= t holds for the same sizes as msg_size <= floor(t)
+        double t = floor(forest->node[i].value);
+        if( t < -1.0 ) {
+          t = -1.0;
+        } else if( t > PGMPI_DTREE_MAX_BYTES ) {
+          t = PGMPI_DTREE_MAX_BYTES;
+        }
+        forest->bytes_thresholds[forest->n_bytes_thresholds++] = (MPI_Count)t;
+      }
+    }
+    qsort(forest->bytes_thresholds, n, sizeof(MPI_Count), &compare_counts);
+    // remove duplicates
+    n = 1;
+    for(i=1; i<forest->n_bytes_thresholds; i++) {
+      if( forest->bytes_thresholds[i] != forest->bytes_thresholds[n-1] ) {
+        forest->bytes_thresholds[n++] = forest->bytes_thresholds[i];
+      }
+    }
+    forest->n_bytes_thresholds = n;
+  }
+
+  return 0;
+}
+
+/*
+ * reads the trees of one collective, node indices in the file are relative to their tree
+ */
+static int read_forest(FILE *fp, char **line, size_t *len, int *lineno, const pgmpi_collectives_t cid,
+    pgmpi_dtree_forest_t *forest) {
+  module_t *mod;
+  char *data;
+  int t, i, n_nodes;
+
+  mod = pgmpi_modules_get(cid);
+  forest->cid = cid;
+
+  data = next_data_line(fp, line, len, lineno);
+  if( data == NULL || sscanf(data, "%d", &forest->n_trees) != 1 || forest->n_trees < 1 ) {
+    ZF_LOGE("line %d: number of trees expected", *lineno);
+    return -1;
+  }
+  forest->root = (int *)calloc(forest->n_trees, sizeof(int));
+
+  for(t=0; t<forest->n_trees; t++) {
+    int offset = forest->n_nodes;
+
+    data = next_data_line(fp, line, len, lineno);
+    if( data == NULL || sscanf(data, "%d", &n_nodes) != 1 || n_nodes < 1 ) {
+      ZF_LOGE("line %d: number of nodes expected", *lineno);
+      return -1;
+    }
+    forest->root[t] = offset;
+    forest->n_nodes += n_nodes;
+    forest->node = (pgmpi_dtree_node_t *)realloc(forest->node, forest->n_nodes * sizeof(pgmpi_dtree_node_t));
+
+    for(i=offset; i<forest->n_nodes; i++) {
+      pgmpi_dtree_node_t *node = &forest->node[i];
+      char kind[16], name[128];
+
+      data = next_data_line(fp, line, len, lineno);
+      if( data == NULL || sscanf(data, "%15s %127s", kind, name) != 2 ) {
+        ZF_LOGE("line %d: node expected", *lineno);
+        return -1;
+      }
+
+      if( strcmp(kind, "leaf") == 0 ) {
+        int algid = pgmpi_modules_get_algid_by_algname(mod->alg_choices, name);
+        int k;
+
+        node->feature = PGMPI_DTREE_LEAF;
+        node->child[0] = -1;
+        node->child[1] = -1;
+        for(k=0; k<mod->alg_choices->nb_choices; k++) {
+          if( mod->alg_choices->alg[k].algid == algid ) {
+            node->child[0] = k;
+          }
+        }
+        if( node->child[0] < 0 ) {
+          ZF_LOGE("line %d: unknown algorithm %s for %s", *lineno, name, mod->mpiname);
+          return -1;
+        }
+        node->value = 1.0;
+        sscanf(data, "%*s %*s %lf", &node->value);
+      } else if( strcmp(kind, "split") == 0 ) {
+        node->feature = pgmpi_dtree_feature_by_name(name);
+        if( node->feature < 0 ) {
+          ZF_LOGE("line %d: unknown feature %s", *lineno, name);
+          return -1;
+        }
+        if( sscanf(data, "%*s %*s %lf %d %d", &node->value, &node->child[0], &node->child[1]) != 3 ) {
+          ZF_LOGE("line %d: split <feature> <threshold> <left> <right> expected", *lineno);
+          return -1;
+        }
+        node->child[0] += offset;
+        node->child[1] += offset;
+      } else {
+        ZF_LOGE("line %d: leaf or split expected", *lineno);
+        return -1;
+      }
+    }
+
+    // children must stay within their tree
+    for(i=offset; i<forest->n_nodes; i++) {
+      if( forest->node[i].feature != PGMPI_DTREE_LEAF &&
+          (forest->node[i].child[0] >= forest->n_nodes || forest->node[i].child[1] >= forest->n_nodes) ) {
+        ZF_LOGE("tree %d of %s: child of node %d outside of the tree", t, mod->mpiname, i - offset);
+        return -1;
+      }
+    }
+  }
+
+  return forest_finalize(forest);
+}
+
+
+void pgmpi_dtree_model_init(pgmpi_dtree_model_t *model) {
+  memset(model, 0, sizeof(pgmpi_dtree_model_t));
+}
+
+void pgmpi_dtree_model_free(pgmpi_dtree_model_t *model) {
+  int i;
+
+  for(i=0; i<NUM_COLLECTIVES; i++) {
+    if( model->forest[i] != NULL ) {
+      forest_free(model->forest[i]);
+    }
+  }
+  pgmpi_dtree_model_init(model);
+}
+
+int pgmpi_dtree_feature_by_name(const char *name) {
+  int i;
+
+  for(i=0; i<PGMPI_DTREE_NB_FEATURES; i++) {
+    if( strcmp(feature_names[i], name) == 0 ) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+const char *pgmpi_dtree_feature_name(const int feature) {
+  if( feature < 0 || feature >= PGMPI_DTREE_NB_FEATURES ) {
+    return NULL;
+  }
+  return feature_names[feature];
+}
+
+int pgmpi_dtree_op_class(MPI_Op op) {
+  int op_id;
+
+  if( op == MPI_OP_NULL ) {
+    return PGMPI_DTREE_OP_NONE;
+  }
+  op_id = pgmpi_qualifier_op_id(op);
+  if( op_id == pgmpi_qualifier_op_id_by_name("user_commutative") ) {
+    return PGMPI_DTREE_OP_USER_COMMUTATIVE;
+  }
+  if( op_id == pgmpi_qualifier_op_id_by_name("user_noncommutative") ) {
+    return PGMPI_DTREE_OP_USER_NONCOMMUTATIVE;
+  }
+  return PGMPI_DTREE_OP_PREDEFINED;
+}
+
+int pgmpi_dtree_model_read(const char *fname, pgmpi_dtree_model_t *model) {
+  FILE *fp;
+  char *line = NULL;
+  size_t len = 0;
+  int lineno = 0;
+  int i, ret = 0;
+  char *data;
+
+  if( fname == NULL ) {
+    ZF_LOGE("file name is NULL");
+    return -1;
+  }
+  if ((fp = fopen(fname, "r")) == NULL) {
+    ZF_LOGE("Can't open %s", fname);
+    return -1;
+  }
+
+  while( (data = next_data_line(fp, &line, &len, &lineno)) != NULL ) {
+    char mpiname[64];
+    pgmpi_collectives_t cid;
+
+    if( sscanf(data, "%63s", mpiname) != 1 || pgmpi_modules_get_id_by_mpiname(mpiname, &cid) != 0 ) {
+      ZF_LOGE("%s:%d: collective name expected", fname, lineno);
+      ret = -1;
+      break;
+    }
+    if( model->forest[cid] != NULL ) {
+      ZF_LOGE("%s:%d: second model for %s", fname, lineno, mpiname);
+      ret = -1;
+      break;
+    }
+
+    model->forest[cid] = (pgmpi_dtree_forest_t *)calloc(1, sizeof(pgmpi_dtree_forest_t));
+    if( read_forest(fp, &line, &len, &lineno, cid, model->forest[cid]) != 0 ) {
+      ZF_LOGE("invalid model for %s in %s", mpiname, fname);
+      ret = -1;
+      break;
+    }
+  }
+
+  free(line);
+  fclose(fp);
+
+  if( ret != 0 ) {
+    pgmpi_dtree_model_free(model);
+    return ret;
+  }
+
+  for(i=0; i<NUM_COLLECTIVES; i++) {
+    pgmpi_dtree_forest_t *forest = model->forest[i];
+    int n;
+    if( forest == NULL ) {
+      continue;
+    }
+    for(n=0; n<forest->n_nodes; n++) {
+      if( forest->node[n].feature == PGMPI_DTREE_FEATURE_NODES || forest->node[n].feature == PGMPI_DTREE_FEATURE_PPN ) {
+        model->uses_layout = 1;
+      }
+    }
+  }
+
+  return 0;
+}
+
+void pgmpi_dtree_model_pack(pgmpi_pack_buf_t *buf, const pgmpi_dtree_model_t *model) {
+  int i, n = 0;
+
+  for(i=0; i<NUM_COLLECTIVES; i++) {
+    if( model->forest[i] != NULL ) {
+      n++;
+    }
+  }
+
+  pgmpi_pack_int(buf, model->uses_layout);
+  pgmpi_pack_int(buf, n);
+  for(i=0; i<NUM_COLLECTIVES; i++) {
+    const pgmpi_dtree_forest_t *forest = model->forest[i];
+    if( forest == NULL ) {
+      continue;
+    }
+    pgmpi_pack_int(buf, forest->cid);
+    pgmpi_pack_int(buf, forest->n_trees);
+    pgmpi_pack_bytes(buf, forest->root, forest->n_trees * sizeof(int));
+    pgmpi_pack_int(buf, forest->n_nodes);
+    pgmpi_pack_bytes(buf, forest->node, forest->n_nodes * sizeof(pgmpi_dtree_node_t));
+  }
+}
+
+int pgmpi_dtree_model_unpack(pgmpi_pack_buf_t *buf, pgmpi_dtree_model_t *model) {
+  int i, n, cid;
+
+  pgmpi_dtree_model_free(model);
+  if( pgmpi_unpack_int(buf, &model->uses_layout) != 0 || pgmpi_unpack_int(buf, &n) != 0 ) {
+    return -1;
+  }
+
+  for(i=0; i<n; i++) {
+    pgmpi_dtree_forest_t *forest;
+
+    if( pgmpi_unpack_int(buf, &cid) != 0 || cid < 0 || cid >= NUM_COLLECTIVES || model->forest[cid] != NULL ) {
+      pgmpi_dtree_model_free(model);
+      return -1;
+    }
+    forest = (pgmpi_dtree_forest_t *)calloc(1, sizeof(pgmpi_dtree_forest_t));
+    model->forest[cid] = forest;
+    forest->cid = cid;
+    if( pgmpi_unpack_int(buf, &forest->n_trees) != 0 || forest->n_trees < 1 ) {
+      pgmpi_dtree_model_free(model);
+      return -1;
+    }
+    forest->root = (int *)malloc(forest->n_trees * sizeof(int));
+    if( pgmpi_unpack_bytes(buf, forest->root, forest->n_trees * sizeof(int)) != 0 ||
+        pgmpi_unpack_int(buf, &forest->n_nodes) != 0 || forest->n_nodes < 1 ) {
+      pgmpi_dtree_model_free(model);
+      return -1;
+    }
+    forest->node = (pgmpi_dtree_node_t *)malloc(forest->n_nodes * sizeof(pgmpi_dtree_node_t));
+    if( pgmpi_unpack_bytes(buf, forest->node, forest->n_nodes * sizeof(pgmpi_dtree_node_t)) != 0 ||
+        forest_finalize(forest) != 0 ) {
+      pgmpi_dtree_model_free(model);
+      return -1;
+    }
+  }
+
+  return 0;
+}
+
+int pgmpi_dtree_forest_eval(const pgmpi_dtree_forest_t *forest, const double *features) {
+  double score[PGMPI_DTREE_MAX_CHOICES];
+  module_t *mod;
+  int i, t, best;
+
+  mod = pgmpi_modules_get(forest->cid);
+  for(i=0; i<mod->alg_choices->nb_choices; i++) {
+    score[i] = 0.0;
+  }
+
+  for(t=0; t<forest->n_trees; t++) {
+    const pgmpi_dtree_node_t *node = &forest->node[forest->root[t]];
+    while( node->feature != PGMPI_DTREE_LEAF ) {
+      node = &forest->node[node->child[features[node->feature] <= node->value ? 0 : 1]];
+    }
+    score[node->child[0]] += node->value;
+  }
+
+  best = 0;
+  for(i=1; i<mod->alg_choices->nb_choices; i++) {
+    if( score[i] > score[best] ) {
+      best = i;
+    }
+  }
+
+  return mod->alg_choices->alg[best].algid;
+}
+
+int pgmpi_dtree_forest_bytes_interval(const pgmpi_dtree_forest_t *forest, const MPI_Count msg_size) {
+  int lo = 0, hi = forest->n_bytes_thresholds;
+
+  // number of thresholds below msg_size
+  while( lo < hi ) {
+    int mid = (lo + hi) / 2;
+    if( forest->bytes_thresholds[mid] < msg_size ) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
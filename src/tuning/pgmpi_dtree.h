@@ -0,0 +1,127 @@
+/*  PGMPITuneLib - Library for Autotuning MPI Collectives using Performance Guidelines
+ *  
+ *  Copyright 2017 Sascha Hunold, Alexandra Carpen-Amarie
+ *      Research Group for Parallel Computing
+ *      Faculty of Informatics
+ *      Vienna University of Technology, Austria
+ *  
+ *  <license>
+ *      This library is free software; you can redistribute it
+ *      and/or modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *  
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *  
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free
+ *      Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *      Boston, MA 02110-1301 USA
+ *  </license>
+ */
+
+
+#ifndef SRC_TUNING_PGMPI_DTREE_H_
+#define SRC_TUNING_PGMPI_DTREE_H_
+
+#include "pgmpi_tune.h"
+#include "util/pgmpi_pack.h"
+
+/*
+ * a learned selection model per collective: a decision tree or an ensemble of
+ * trees (e.g., gradient-boosted trees with one tree per class and round)
+ *
+ * every leaf adds its score to one alg choice, the choice with the highest sum
+ * over all trees is selected (ties go to the first choice)
+ * an inner node sends a call to the left child if feature <= threshold
+ */
+
+typedef enum {
+  PGMPI_DTREE_FEATURE_P = 0,       /* number of processes */
+  PGMPI_DTREE_FEATURE_NODES,       /* number of nodes, -1 for irregular layouts */
+  PGMPI_DTREE_FEATURE_PPN,         /* processes per node, -1 for irregular layouts */
+  PGMPI_DTREE_FEATURE_BYTES,       /* message size, same convention as the profiles */
+  PGMPI_DTREE_FEATURE_DTYPE_SIZE,  /* size of the datatype in bytes */
+  PGMPI_DTREE_FEATURE_OP,          /* operation class, see pgmpi_dtree_op_class_t */
+  PGMPI_DTREE_NB_FEATURES
+} pgmpi_dtree_feature_t;
+
+typedef enum {
+  PGMPI_DTREE_OP_NONE = 0,         /* non-reducing collective */
+  PGMPI_DTREE_OP_PREDEFINED,
+  PGMPI_DTREE_OP_USER_COMMUTATIVE,
+  PGMPI_DTREE_OP_USER_NONCOMMUTATIVE
+} pgmpi_dtree_op_class_t;
+
+#define PGMPI_DTREE_LEAF -1
+
+#define PGMPI_DTREE_MAX_BYTES 4.0e18   /* larger bytes thresholds are clamped */
+
+/*
+ * node of the flat node array, children are absolute indices into the array
+ * leaves keep the index of the alg choice in child[0]
+ */
+typedef struct {
+  int feature;      /* PGMPI_DTREE_LEAF for leaves */
+  int child[2];
+  double value;     /* threshold of inner nodes, score of leaves */
+} pgmpi_dtree_node_t;
+
+typedef struct {
+  pgmpi_collectives_t cid;
+  int n_trees;
+  int *root;                  /* index of the root of each tree */
+  int n_nodes;
+  pgmpi_dtree_node_t *node;   /* nodes of all trees, in file order */
+  int n_bytes_thresholds;
+  MPI_Count *bytes_thresholds;  /* sorted thresholds of all splits on bytes */
+} pgmpi_dtree_forest_t;
+
+typedef struct {
+  pgmpi_dtree_forest_t *forest[CID_MARKER_END_DO_NOT_USE_OR_CHANGE];  /* NULL if a collective is not modeled */
+  int uses_layout;            /* some split uses nodes or ppn */
+} pgmpi_dtree_model_t;
+
+void pgmpi_dtree_model_init(pgmpi_dtree_model_t *model);
+
+void pgmpi_dtree_model_free(pgmpi_dtree_model_t *model);
+
+/*!
+  \return feature with the given name (p, nodes, ppn, bytes, dtype_size, op), -1 if unknown
+*/
+int pgmpi_dtree_feature_by_name(const char *name);
+
+const char *pgmpi_dtree_feature_name(const int feature);
+
+/*!
+  \return class of op as used by PGMPI_DTREE_FEATURE_OP
+*/
+int pgmpi_dtree_op_class(MPI_Op op);
+
+/*!
+  reads a model file with the forests of one or more collectives
+  \return 0 on success, -1 on error
+*/
+int pgmpi_dtree_model_read(const char *fname, pgmpi_dtree_model_t *model);
+
+void pgmpi_dtree_model_pack(pgmpi_pack_buf_t *buf, const pgmpi_dtree_model_t *model);
+
+int pgmpi_dtree_model_unpack(pgmpi_pack_buf_t *buf, pgmpi_dtree_model_t *model);
+
+/*!
+  \param features PGMPI_DTREE_NB_FEATURES values describing the call
+  \return selected alg id
+*/
+int pgmpi_dtree_forest_eval(const pgmpi_dtree_forest_t *forest, const double *features);
+
+/*!
+  calls whose message sizes fall into the same interval between two bytes
+  thresholds take the same path through all trees
+  \return interval of msg_size, between 0 and n_bytes_thresholds
+*/
+int pgmpi_dtree_forest_bytes_interval(const pgmpi_dtree_forest_t *forest, const MPI_Count msg_size);
+
+#endif /* SRC_TUNING_PGMPI_DTREE_H_ */
@@ -29,17 +29,27 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <assert.h>
 
 #define ZF_LOG_LEVEL MY_ZF_LOG_LEVEL
 #include "log/zf_log.h"
 
 #include "pgmpi_function_replacer.h"
+#include "pgmpi_profile_extrapolate.h"
+#include "collectives/collective_modules.h"
 
-int pgmpi_find_replacement_algorithm(const alg_lookup_table_t *tab, const pgmpi_collectives_t cid, const int msg_size,
-    const int comm_size, int *alg_id) {
+static int shape_matches(const pgmpi_profile_t *profile, const pgmpi_comm_shape_t *shape);
+static int is_candidate(const pgmpi_profile_t *profile, const pgmpi_comm_shape_t *shape,
+    const pgmpi_profile_match_policy_t policy);
+static pgmpi_profile_t *get_derived_profile(alg_lookup_table_t *tab, const pgmpi_collectives_t cid,
+    const pgmpi_comm_shape_t *shape);
+
+int pgmpi_find_replacement_algorithm(alg_lookup_table_t *tab, const pgmpi_collectives_t cid, const MPI_Count msg_size,
+    MPI_Datatype datatype, const pgmpi_call_qualifiers_t *call, const int comm_size, int *alg_id) {
 
   pgmpi_profile_t *profile = NULL;
+  const pgmpi_range_t *range;
 
   if (tab == NULL) {
     ZF_LOGE("tab is NULL");
@@ -56,29 +66,178 @@ int pgmpi_find_replacement_algorithm(const alg_lookup_table_t *tab, const pgmpi_
     return -1;
   }
 
-  if( pgmpi_get_profile(tab, cid, &profile) != 0 ) {
+  if( pgmpi_get_profile_for_comm_size(tab, cid, comm_size, &profile) != 0 ) {
     ZF_LOGE("cannot find correct profile for cid=%d", cid);
     return -1;
   }
   if( profile == NULL ) {
-    // there is no profile for that collective
-    ZF_LOGV("no profile for collective with id %u", cid);
     return -1;
   }
 
-  if( profile->nb_procs != comm_size ) {
-    ZF_LOGW("profile does not match number of processes");
+  range = pgmpi_profile_find_range_for_call(profile, msg_size, call);
+  if( range == NULL || !pgmpi_range_is_effective(tab, range) ) {
+    return -1;
+  }
+  *alg_id = pgmpi_select_from_range(range, cid, msg_size, datatype, comm_size);
+  return 0;
+
+}
+
+int pgmpi_range_is_effective(const alg_lookup_table_t *tab, const pgmpi_range_t *range) {
+  if( range->has_effect && range->effect_ci_low <= tab->min_effect ) {
+    ZF_LOGV("effect of alg %d may be below %.3f (ci [%.3f,%.3f]), using default", range->alg_id, tab->min_effect,
+        range->effect_ci_low, range->effect_ci_high);
+    return 0;
+  }
+  return 1;
+}
+
+int pgmpi_select_from_range(const pgmpi_range_t *range, const pgmpi_collectives_t cid, const MPI_Count msg_size,
+    MPI_Datatype datatype, const int comm_size) {
+  int candidates[PGMPI_PROFILE_MAX_FALLBACKS+1];
+  int n;
+
+  n = pgmpi_profile_get_candidates(range, candidates);
+  return pgmpi_modules_select_fitting_alg(cid, candidates, n, msg_size, datatype, comm_size);
+}
+
+int pgmpi_get_profile_for_comm_size(alg_lookup_table_t *tab, const pgmpi_collectives_t cid, const int comm_size,
+    pgmpi_profile_t **prof) {
+  pgmpi_comm_shape_t shape;
+
+  pgmpi_comm_topology_unknown(comm_size, &shape);
+  return pgmpi_get_profile_for_comm_shape(tab, cid, &shape, prof);
+}
+
+static int shape_matches(const pgmpi_profile_t *profile, const pgmpi_comm_shape_t *shape) {
+  return (profile->ppn > 0 && profile->ppn == shape->ppn);
+}
+
+static int is_candidate(const pgmpi_profile_t *profile, const pgmpi_comm_shape_t *shape,
+    const pgmpi_profile_match_policy_t policy) {
+
+  if( profile->nb_nodes > 0 && !shape_matches(profile, shape) ) {
+    return 0;
+  }
+  switch( policy ) {
+  case PROFILE_MATCH_EXACT:
+  case PROFILE_MATCH_EXTRAPOLATE:
+    return (profile->nb_procs == shape->nb_procs);
+  case PROFILE_MATCH_FLOOR:
+    return (profile->nb_procs <= shape->nb_procs);
+  case PROFILE_MATCH_NEAREST:
+    return 1;
+  }
+  return 0;
+}
+
+int pgmpi_get_profile_for_comm_shape(alg_lookup_table_t *tab, const pgmpi_collectives_t cid,
+    const pgmpi_comm_shape_t *shape, pgmpi_profile_t **prof) {
+  pgmpi_profile_t **profiles;
+  int n_profiles;
+  int i;
+  int best_dist = -1;
+
+  *prof = NULL;
+
+  if( pgmpi_get_profiles(tab, cid, &profiles, &n_profiles) != 0 ) {
     return -1;
   }
+  if( n_profiles == 0 ) {
+    // there is no profile for that collective
+    ZF_LOGV("no profile for collective with id %u", cid);
+    return 0;
+  }
+
+  // profiles are sorted by nb_procs, so on a tie in distance the smaller process count is kept
+  // unless the later profile matches the layout and the current one does not
+  for(i=0; i<n_profiles; i++) {
+    int dist;
+
+    if( !is_candidate(profiles[i], shape, tab->policy) ) {
+      continue;
+    }
+    dist = abs(profiles[i]->nb_procs - shape->nb_procs);
+    if( *prof == NULL || dist < best_dist ||
+        (dist == best_dist && shape_matches(profiles[i], shape) && !shape_matches(*prof, shape)) ) {
+      *prof = profiles[i];
+      best_dist = dist;
+    }
+  }
+
+  if( *prof == NULL && tab->policy == PROFILE_MATCH_EXTRAPOLATE ) {
+    *prof = get_derived_profile(tab, cid, shape);
+  }
+
+  if( *prof == NULL ) {
+    ZF_LOGV("no profile for collective %u matches %d processes (%d x %d)", cid, shape->nb_procs,
+        shape->nb_nodes, shape->ppn);
+  }
+
+  return 0;
+}
+
+/*
+ * derived profiles are kept in the table, so a profile is only derived once per
+ * process count and layout; a derived profile without ranges records that the
+ * confidence was too low
+ */
+static pgmpi_profile_t *get_derived_profile(alg_lookup_table_t *tab, const pgmpi_collectives_t cid,
+    const pgmpi_comm_shape_t *shape) {
+  pgmpi_profile_t **candidates;
+  pgmpi_profile_t *derived = NULL;
+  double confidence;
+  int i, n;
+
+  for(i=0; i<tab->n_derived[cid]; i++) {
+    if( tab->derived[cid][i]->nb_procs == shape->nb_procs && tab->derived[cid][i]->ppn == shape->ppn ) {
+      derived = tab->derived[cid][i];
+      break;
+    }
+  }
+
+  if( derived == NULL ) {
+    // profiles measured on another number of processes per node are not comparable
+    candidates = (pgmpi_profile_t **)malloc(tab->n_profiles[cid] * sizeof(pgmpi_profile_t *));
+    n = 0;
+    for(i=0; i<tab->n_profiles[cid]; i++) {
+      if( is_candidate(tab->profile[cid][i], shape, PROFILE_MATCH_NEAREST) ) {
+        candidates[n++] = tab->profile[cid][i];
+      }
+    }
 
-  return pgmpi_profile_find_alg(profile, msg_size, alg_id);
+    derived = (pgmpi_profile_t *)calloc(1, sizeof(pgmpi_profile_t));
+    if( pgmpi_profile_extrapolate(candidates, n, shape->nb_procs, derived, &confidence) != 0 ) {
+      pgmpi_profile_allocate(derived, pgmpi_modules_get(cid)->mpiname, shape->nb_procs, 1);
+      derived->n_ranges = 0;
+      confidence = 0.0;
+    }
+    if( confidence < tab->min_confidence ) {
+      ZF_LOGV("confidence %.2f of derived profile for cid %u and p=%d too low, using default", confidence, cid,
+          shape->nb_procs);
+      derived->n_ranges = 0;
+      derived->n_groups = 0;
+    }
+    derived->nb_nodes = shape->nb_nodes;
+    derived->ppn = shape->ppn;
+    free(candidates);
 
+    tab->derived[cid] = (pgmpi_profile_t **)realloc(tab->derived[cid],
+        (tab->n_derived[cid] + 1) * sizeof(pgmpi_profile_t *));
+    tab->derived[cid][tab->n_derived[cid]++] = derived;
+  }
+
+  return (derived->n_ranges > 0) ? derived : NULL;
 }
 
-int pgmpi_get_profile(const alg_lookup_table_t *tab, const pgmpi_collectives_t cid, pgmpi_profile_t **prof) {
-  assert(cid >= 0 || cid >= tab->num_collectives );
-  //ZF_LOGV("tab profile at %u is %p", cid, tab->profile[cid]);
-  *prof = tab->profile[cid];
+int pgmpi_get_profiles(const alg_lookup_table_t *tab, const pgmpi_collectives_t cid, pgmpi_profile_t ***profiles,
+    int *n_profiles) {
+  if( cid < 0 || cid >= tab->num_collectives ) {
+    ZF_LOGE("cid invalid");
+    return -1;
+  }
+  *profiles = tab->profile[cid];
+  *n_profiles = tab->n_profiles[cid];
   return 0;
 }
 
@@ -89,11 +248,21 @@ int pgmpi_allocate_replacement_table(alg_lookup_table_t *tab) {
     return -1;
   }
   tab->num_collectives = NUM_COLLECTIVES;
-  tab->profile = (pgmpi_profile_t **) calloc(NUM_COLLECTIVES, sizeof(pgmpi_profile_t*));
+  tab->n_profiles = (int *) calloc(NUM_COLLECTIVES, sizeof(int));
+  tab->profile = (pgmpi_profile_t ***) calloc(NUM_COLLECTIVES, sizeof(pgmpi_profile_t**));
+  tab->policy = PROFILE_MATCH_EXACT;
+  tab->has_shapes = 0;
+  tab->min_confidence = PGMPI_EXTRAPOLATE_DEFAULT_MIN_CONFIDENCE;
+  tab->min_effect = PGMPI_DEFAULT_MIN_EFFECT;
+  tab->n_derived = (int *) calloc(NUM_COLLECTIVES, sizeof(int));
+  tab->derived = (pgmpi_profile_t ***) calloc(NUM_COLLECTIVES, sizeof(pgmpi_profile_t**));
   return 0;
 }
 
 int pgmpi_add_profile_to_table(alg_lookup_table_t *tab, pgmpi_profile_t *profile) {
+  pgmpi_profile_t **profiles;
+  int n, i;
+
   if (tab == NULL) {
     ZF_LOGE("tab is NULL");
     return -1;
@@ -107,14 +276,40 @@ int pgmpi_add_profile_to_table(alg_lookup_table_t *tab, pgmpi_profile_t *profile
     return -1;
   }
 
-  ZF_LOGV("add profile at %u (address %p)", profile->cid, profile);
-  tab->profile[profile->cid] = profile;
+  ZF_LOGV("add profile at %u for p=%d (address %p)", profile->cid, profile->nb_procs, profile);
+
+  profiles = tab->profile[profile->cid];
+  n = tab->n_profiles[profile->cid];
+
+  if( profile->nb_nodes > 0 ) {
+    tab->has_shapes = 1;
+  }
+
+  for(i=0; i<n; i++) {
+    if( profiles[i]->nb_procs == profile->nb_procs && profiles[i]->nb_nodes == profile->nb_nodes &&
+        profiles[i]->ppn == profile->ppn ) {
+      ZF_LOGW("replacing profile for cid %u and p=%d", profile->cid, profile->nb_procs);
+      pgmpi_profile_free(profiles[i]);
+      profiles[i] = profile;
+      return 0;
+    }
+  }
+
+  // insert sorted by nb_procs
+  profiles = (pgmpi_profile_t **) realloc(profiles, (n+1) * sizeof(pgmpi_profile_t*));
+  for(i=n; i>0 && profiles[i-1]->nb_procs > profile->nb_procs; i--) {
+    profiles[i] = profiles[i-1];
+  }
+  profiles[i] = profile;
+
+  tab->profile[profile->cid] = profiles;
+  tab->n_profiles[profile->cid] = n+1;
 
   return 0;
 }
 
 int pgmpi_free_replacement_table(alg_lookup_table_t *tab) {
-  int i;
+  int i, j;
 
   if (tab == NULL) {
     ZF_LOGE("tab is NULL");
@@ -122,16 +317,58 @@ int pgmpi_free_replacement_table(alg_lookup_table_t *tab) {
   }
 
   for(i=0; i<tab->num_collectives; i++) {
-    if( tab->profile[i] != NULL ) {
-      //ZF_LOGV("free profile at %i (%p)", i, tab->profile[i]);
-      pgmpi_profile_free(tab->profile[i]);
+    for(j=0; j<tab->n_profiles[i]; j++) {
+      pgmpi_profile_free(tab->profile[i][j]);
     }
+    free(tab->profile[i]);
+    for(j=0; j<tab->n_derived[i]; j++) {
+      pgmpi_profile_free(tab->derived[i][j]);
+      free(tab->derived[i][j]);
+    }
+    free(tab->derived[i]);
   }
 
   free(tab->profile);
+  free(tab->n_profiles);
+  free(tab->derived);
+  free(tab->n_derived);
 
   return 0;
 }
 
+void pgmpi_set_profile_match_policy(alg_lookup_table_t *tab, const pgmpi_profile_match_policy_t policy) {
+  tab->policy = policy;
+}
+
+void pgmpi_set_profile_min_confidence(alg_lookup_table_t *tab, const double min_confidence) {
+  tab->min_confidence = min_confidence;
+}
+
+void pgmpi_set_profile_min_effect(alg_lookup_table_t *tab, const double min_effect) {
+  tab->min_effect = min_effect;
+}
+
+int pgmpi_profile_match_policy_from_string(const char *name, pgmpi_profile_match_policy_t *policy) {
+  int ret = 0;
+
+  if( name == NULL ) {
+    return -1;
+  }
+
+  if( strcmp(name, "exact") == 0 ) {
+    *policy = PROFILE_MATCH_EXACT;
+  } else if( strcmp(name, "nearest") == 0 ) {
+    *policy = PROFILE_MATCH_NEAREST;
+  } else if( strcmp(name, "floor") == 0 ) {
+    *policy = PROFILE_MATCH_FLOOR;
+  } else if( strcmp(name, "extrapolate") == 0 ) {
+    *policy = PROFILE_MATCH_EXTRAPOLATE;
+  } else {
+    ret = -1;
+  }
+
+  return ret;
+}
+
 #endif /* SRC_TUNING_PGMPI_FUNCTION_REPLACER_C_ */
 
@@ -29,21 +29,103 @@
 
 #include "pgmpi_tune.h"
 #include "pgmpi_profile.h"
+#include "pgmpi_comm_topology.h"
+
+#define PGMPI_DEFAULT_MIN_EFFECT 0.0
+
+typedef enum {
+  PROFILE_MATCH_EXACT = 0,   /* only use a profile with nb_procs == comm size */
+  PROFILE_MATCH_NEAREST,     /* use the profile with the closest nb_procs */
+  PROFILE_MATCH_FLOOR,       /* use the profile with the largest nb_procs <= comm size */
+  PROFILE_MATCH_EXTRAPOLATE  /* use the exact profile, otherwise derive one from the other process counts */
+} pgmpi_profile_match_policy_t;
 
 typedef struct {
   int num_collectives;
-  pgmpi_profile_t **profile;
+  int *n_profiles;             /* number of profiles per collective */
+  pgmpi_profile_t ***profile;  /* per collective, profiles sorted by nb_procs */
+  pgmpi_profile_match_policy_t policy;
+  int has_shapes;              /* 1 if a profile declares a node layout */
+  double min_confidence;       /* derived profiles with a lower confidence are not used */
+  double min_effect;           /* ranges whose effect may be lower are not used (if they have one) */
+  int *n_derived;              /* number of derived profiles per collective */
+  pgmpi_profile_t ***derived;  /* per collective, profiles derived for unseen process counts (extrapolate policy) */
 } alg_lookup_table_t;
 
-int pgmpi_find_replacement_algorithm(const alg_lookup_table_t *tab, const pgmpi_collectives_t cid, const int msg_size,
-    const int comm_size, int *alg_id);
+/*!
+  \param call qualifier ids of the call (datatype, op, call site, skew)
+  \param alg_id set to the first algorithm of the matching range that gets its buffers
+*/
+int pgmpi_find_replacement_algorithm(alg_lookup_table_t *tab, const pgmpi_collectives_t cid, const MPI_Count msg_size,
+    MPI_Datatype datatype, const pgmpi_call_qualifiers_t *call, const int comm_size, int *alg_id);
+
+/*!
+  \return 1 if the range should be used, i.e., it has no measured effect or the
+          lower bound of the confidence interval of its effect exceeds the minimum effect
+*/
+int pgmpi_range_is_effective(const alg_lookup_table_t *tab, const pgmpi_range_t *range);
+
+/*!
+  \return the algorithm of range or, if its buffers do not fit, the first of its
+          fallbacks that fits; the default algorithm (0) if none fits
+*/
+int pgmpi_select_from_range(const pgmpi_range_t *range, const pgmpi_collectives_t cid, const MPI_Count msg_size,
+    MPI_Datatype datatype, const int comm_size);
+
+/*!
+  \param profiles set to the profiles of collective cid (sorted by nb_procs)
+  \param n_profiles set to the number of profiles
+  \return 0 on success, <>0 if cid is invalid
+*/
+int pgmpi_get_profiles(const alg_lookup_table_t *tab, const pgmpi_collectives_t cid, pgmpi_profile_t ***profiles,
+    int *n_profiles);
 
-int pgmpi_get_profile(const alg_lookup_table_t *tab, const pgmpi_collectives_t cid, pgmpi_profile_t **prof);
+/*!
+  selects a profile of collective cid for a communicator with comm_size processes
+  according to the match policy of the table
+  \param prof set to the selected profile, NULL if there is none
+  \return 0 on success, <>0 if cid is invalid
+*/
+int pgmpi_get_profile_for_comm_size(alg_lookup_table_t *tab, const pgmpi_collectives_t cid, const int comm_size,
+    pgmpi_profile_t **prof);
+
+/*!
+  same as pgmpi_get_profile_for_comm_size, but takes the node layout into account:
+  profiles declaring a layout with a different number of processes per node
+  are skipped, and a profile with a matching layout is preferred over one
+  without a layout at the same distance in process count
+*/
+int pgmpi_get_profile_for_comm_shape(alg_lookup_table_t *tab, const pgmpi_collectives_t cid,
+    const pgmpi_comm_shape_t *shape, pgmpi_profile_t **prof);
 
 int pgmpi_allocate_replacement_table(alg_lookup_table_t *tab);
 
 int pgmpi_free_replacement_table(alg_lookup_table_t *tab);
 
+/*!
+  adds a profile to the table, a profile for the same collective,
+  number of processes and node layout replaces the existing one
+*/
 int pgmpi_add_profile_to_table(alg_lookup_table_t *tab, pgmpi_profile_t *profile);
 
+void pgmpi_set_profile_match_policy(alg_lookup_table_t *tab, const pgmpi_profile_match_policy_t policy);
+
+/*!
+  \param min_confidence derived profiles (extrapolate policy) with a lower confidence are
+         not used, i.e., the default algorithms are used instead
+*/
+void pgmpi_set_profile_min_confidence(alg_lookup_table_t *tab, const double min_confidence);
+
+/*!
+  \param min_effect ranges whose measured effect (relative reduction of the run-time)
+         is not larger than min_effect with confidence use the default algorithm
+*/
+void pgmpi_set_profile_min_effect(alg_lookup_table_t *tab, const double min_effect);
+
+/*!
+  \param name one of "exact", "nearest", "floor", "extrapolate"
+  \return 0 if name is a valid policy, -1 otherwise
+*/
+int pgmpi_profile_match_policy_from_string(const char *name, pgmpi_profile_match_policy_t *policy);
+
 #endif /* SRC_TUNING_PGMPI_FUNCTION_REPLACER_H_ */
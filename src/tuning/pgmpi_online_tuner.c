@@ -0,0 +1,635 @@
+/*  PGMPITuneLib - Library for Autotuning MPI Collectives using Performance Guidelines
+ *  
+ *  Copyright 2017 Sascha Hunold, Alexandra Carpen-Amarie
+ *      Research Group for Parallel Computing
+ *      Faculty of Informatics
+ *      Vienna University of Technology, Austria
+ *  
+ *  <license>
+ *      This library is free software; you can redistribute it
+ *      and/or modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *  
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *  
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free
+ *      Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *      Boston, MA 02110-1301 USA
+ *  </license>
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <stdint.h>
+#include <math.h>
+#include <assert.h>
+
+#include <mpi.h>
+#include "pgmpi_tune.h"
+
+#define ZF_LOG_LEVEL MY_ZF_LOG_LEVEL
+#include "log/zf_log.h"
+
+#include "pgmpi_online_tuner.h"
+#include "pgmpi_profile.h"
+#include "pgmpi_profile_writer.h"
+#include "collectives/collective_modules.h"
+#include "util/pgmpi_callsite.h"
+
+#define DECISION_INTS 5   /* a decision sent as ints: cid, comm_size, bucket, site_id, alg_id */
+
+typedef struct {
+  pgmpi_collectives_t cid;
+  int comm_size;
+  int bucket;
+  int site_id;    /* PGMPI_QUALIFIER_ANY without call sites */
+  int alg_id;
+} online_decision_t;
+
+static int online_keyval = MPI_KEYVAL_INVALID;
+static pgmpi_online_params_t online_params = {
+    .nb_trials = PGMPI_ONLINE_DEFAULT_TRIALS,
+    .bandit = 0,
+    .epsilon = PGMPI_ONLINE_DEFAULT_EPSILON,
+    .switch_t = PGMPI_ONLINE_DEFAULT_SWITCH_T,
+    .seed = PGMPI_ONLINE_DEFAULT_SEED };
+
+// keys of the communicators of this rank are increasing
+static unsigned int next_state_key = 0;
+
+// decisions committed on this rank, written as profiles at the end
+static online_decision_t *decisions = NULL;
+static int n_decisions = 0;
+static int capacity_decisions = 0;
+
+static int online_delete_fn(MPI_Comm comm, int keyval, void *attribute_val, void *extra_state);
+static pgmpi_online_state_t *get_state(MPI_Comm comm);
+static pgmpi_online_entry_t *new_entries(void);
+static void free_entries(pgmpi_online_entry_t *entry);
+static pgmpi_online_entry_t *get_site_entries(pgmpi_online_state_t *state, MPI_Comm comm, int *site_id);
+static void record_decision(const pgmpi_collectives_t cid, const int comm_size, const int bucket,
+    const int site_id, const int alg_id);
+static int find_decision(const pgmpi_collectives_t cid, const int comm_size, const int bucket, const int site_id);
+static void commit_entry(pgmpi_online_entry_t *entry, const module_alg_choices_t *choices,
+    const pgmpi_collectives_t cid, const int comm_size, const int bucket, const int site_id);
+static uint64_t schedule_draw(const pgmpi_online_state_t *state, const int site_id, const pgmpi_collectives_t cid,
+    const int bucket, const unsigned int n, const int stream);
+static void update_stat(pgmpi_online_stat_t *stat, const double time);
+static int is_significantly_faster(const pgmpi_online_stat_t *challenger, const pgmpi_online_stat_t *incumbent);
+
+
+static pgmpi_online_entry_t *new_entries(void) {
+  pgmpi_online_entry_t *entry;
+  int i;
+
+  entry = (pgmpi_online_entry_t *)calloc(NUM_COLLECTIVES * PGMPI_ONLINE_NB_BUCKETS, sizeof(pgmpi_online_entry_t));
+  for(i=0; i<NUM_COLLECTIVES * PGMPI_ONLINE_NB_BUCKETS; i++) {
+    entry[i].alg_id = -1;
+  }
+  return entry;
+}
+
+static void free_entries(pgmpi_online_entry_t *entry) {
+  int i;
+
+  if( entry == NULL ) {
+    return;
+  }
+  for(i=0; i<NUM_COLLECTIVES * PGMPI_ONLINE_NB_BUCKETS; i++) {
+    free(entry[i].stat);
+  }
+  free(entry);
+}
+
+static int online_delete_fn(MPI_Comm comm, int keyval, void *attribute_val, void *extra_state) {
+  pgmpi_online_state_t *state = (pgmpi_online_state_t *)attribute_val;
+  int i;
+
+  if( state != NULL ) {
+    free_entries(state->entry);
+    for(i=0; i<state->n_sites; i++) {
+      free_entries(state->site_entry[i]);
+    }
+    free(state->site_entry);
+    free(state);
+  }
+  return MPI_SUCCESS;
+}
+
+/*
+ * ranks that call from different sites learn in the entries without site
+ * \param site_id set to the id of the current call site, PGMPI_QUALIFIER_ANY without call sites
+ * \return entries of the current call site
+ */
+static pgmpi_online_entry_t *get_site_entries(pgmpi_online_state_t *state, MPI_Comm comm, int *site_id) {
+  int site = pgmpi_callsite_current();
+
+  if( site < 0 || (*site_id = pgmpi_callsite_agreed_id(comm)) == PGMPI_QUALIFIER_NONE ) {
+    *site_id = PGMPI_QUALIFIER_ANY;
+    return state->entry;
+  }
+
+  if( site >= state->n_sites ) {
+    int n = (site < 2 * state->n_sites) ? 2 * state->n_sites : site + 1;
+    state->site_entry = (pgmpi_online_entry_t **)realloc(state->site_entry, n * sizeof(pgmpi_online_entry_t *));
+    memset(state->site_entry + state->n_sites, 0, (n - state->n_sites) * sizeof(pgmpi_online_entry_t *));
+    state->n_sites = n;
+  }
+  if( state->site_entry[site] == NULL ) {
+    ZF_LOGV("first use of call site 0x%08x on communicator", *site_id);
+    state->site_entry[site] = new_entries();
+  }
+  return state->site_entry[site];
+}
+
+static pgmpi_online_state_t *get_state(MPI_Comm comm) {
+  pgmpi_online_state_t *state = NULL;
+  int flag = 0;
+  int inter = 0;
+
+  if( online_keyval == MPI_KEYVAL_INVALID ) {
+    return NULL;
+  }
+
+  MPI_Comm_get_attr(comm, online_keyval, &state, &flag);
+  if( flag ) {
+    return state;
+  }
+
+  ZF_LOGV("first use of communicator, creating online state");
+  state = (pgmpi_online_state_t *)calloc(1, sizeof(pgmpi_online_state_t));
+  MPI_Comm_size(comm, &state->comm_size);
+
+  // the first call on a communicator is collective, the ranks agree on a key that none of them used yet
+  MPI_Comm_test_inter(comm, &inter);
+  if( !inter ) {
+    PMPI_Allreduce(&next_state_key, &state->key, 1, MPI_UNSIGNED, MPI_MAX, comm);
+    next_state_key = state->key + 1;
+  }
+  state->entry = new_entries();
+
+  if( MPI_Comm_set_attr(comm, online_keyval, state) != MPI_SUCCESS ) {
+    ZF_LOGE("cannot attach online state to communicator");
+    online_delete_fn(comm, online_keyval, state, NULL);
+    return NULL;
+  }
+
+  return state;
+}
+
+/*
+ * \return index of the decision, -1 if there is none
+ */
+static int find_decision(const pgmpi_collectives_t cid, const int comm_size, const int bucket, const int site_id) {
+  int i;
+
+  for(i=0; i<n_decisions; i++) {
+    if( decisions[i].cid == cid && decisions[i].comm_size == comm_size && decisions[i].bucket == bucket &&
+        decisions[i].site_id == site_id ) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+static void record_decision(const pgmpi_collectives_t cid, const int comm_size, const int bucket,
+    const int site_id, const int alg_id) {
+  int i;
+
+  // communicators of the same size learn independently, the latest decision is kept
+  if( (i = find_decision(cid, comm_size, bucket, site_id)) >= 0 ) {
+    decisions[i].alg_id = alg_id;
+    return;
+  }
+
+  if( n_decisions == capacity_decisions ) {
+    capacity_decisions = (capacity_decisions == 0) ? 16 : 2 * capacity_decisions;
+    decisions = (online_decision_t *)realloc(decisions, capacity_decisions * sizeof(online_decision_t));
+  }
+  decisions[n_decisions].cid = cid;
+  decisions[n_decisions].comm_size = comm_size;
+  decisions[n_decisions].bucket = bucket;
+  decisions[n_decisions].site_id = site_id;
+  decisions[n_decisions].alg_id = alg_id;
+  n_decisions++;
+}
+
+static void commit_entry(pgmpi_online_entry_t *entry, const module_alg_choices_t *choices,
+    const pgmpi_collectives_t cid, const int comm_size, const int bucket, const int site_id) {
+  int i;
+  int best = 0;
+
+  // ties go to the lower index, i.e., to the default algorithm; choices that
+  // always fell back to the default have no times
+  for(i=1; i<choices->nb_choices; i++) {
+    if( entry->stat[i].n > 0 && entry->stat[i].best < entry->stat[best].best ) {
+      best = i;
+    }
+  }
+
+  entry->alg_id = choices->alg[best].algid;
+  entry->n_seen = 0;
+  if( !online_params.bandit ) {
+    // statistics are only needed to re-tune later
+    free(entry->stat);
+    entry->stat = NULL;
+  }
+
+  ZF_LOGV("committed alg %d for cid %d, bucket %d, p=%d", entry->alg_id, cid, bucket, comm_size);
+  record_decision(cid, comm_size, bucket, site_id, entry->alg_id);
+}
+
+/*
+ * splitmix64 of (seed, communicator key, call site, cid, bucket, n), identical on all ranks
+ */
+static uint64_t schedule_draw(const pgmpi_online_state_t *state, const int site_id, const pgmpi_collectives_t cid,
+    const int bucket, const unsigned int n, const int stream) {
+  uint64_t z;
+
+  z = ((uint64_t)online_params.seed << 32) ^ ((uint64_t)cid << 16) ^ ((uint64_t)bucket << 8) ^ (uint64_t)stream;
+  z ^= (((uint64_t)state->key << 32) | (uint32_t)site_id) * 0xD6E8FEB86659FD93ULL;
+  z += 0x9E3779B97F4A7C15ULL * ((uint64_t)n + 1);
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  return z ^ (z >> 31);
+}
+
+static void update_stat(pgmpi_online_stat_t *stat, const double time) {
+  double diff, incr;
+
+  if( stat->n == 0 ) {
+    stat->best = time;
+    stat->mean = time;
+    stat->var  = 0.0;
+  } else {
+    if( time < stat->best ) {
+      stat->best = time;
+    }
+    diff = time - stat->mean;
+    incr = PGMPI_ONLINE_EWMA_WEIGHT * diff;
+    stat->mean += incr;
+    stat->var = (1.0 - PGMPI_ONLINE_EWMA_WEIGHT) * (stat->var + diff * incr);
+  }
+  stat->n++;
+}
+
+/*
+ * Welch's t-test on the weighted statistics, the number of samples is capped
+ * by the effective window of the exponential weights
+ */
+static int is_significantly_faster(const pgmpi_online_stat_t *challenger, const pgmpi_online_stat_t *incumbent) {
+  const double max_samples = 2.0 / PGMPI_ONLINE_EWMA_WEIGHT - 1.0;
+  double n_c, n_i;
+  double se;
+
+  if( challenger->n < online_params.nb_trials || incumbent->n < online_params.nb_trials ||
+      challenger->mean >= incumbent->mean ) {
+    return 0;
+  }
+
+  n_c = (challenger->n < max_samples) ? challenger->n : max_samples;
+  n_i = (incumbent->n < max_samples) ? incumbent->n : max_samples;
+  se = sqrt(challenger->var / n_c + incumbent->var / n_i);
+
+  return (incumbent->mean - challenger->mean) > online_params.switch_t * se;
+}
+
+void pgmpi_online_params_default(pgmpi_online_params_t *params) {
+  params->nb_trials = PGMPI_ONLINE_DEFAULT_TRIALS;
+  params->bandit = 0;
+  params->epsilon = PGMPI_ONLINE_DEFAULT_EPSILON;
+  params->switch_t = PGMPI_ONLINE_DEFAULT_SWITCH_T;
+  params->seed = PGMPI_ONLINE_DEFAULT_SEED;
+}
+
+int pgmpi_online_tuner_init(const pgmpi_online_params_t *params) {
+  int ret;
+
+  online_params = *params;
+  if( online_params.nb_trials <= 0 ) {
+    ZF_LOGW("invalid number of trials %d, using %d", online_params.nb_trials, PGMPI_ONLINE_DEFAULT_TRIALS);
+    online_params.nb_trials = PGMPI_ONLINE_DEFAULT_TRIALS;
+  }
+  if( online_params.epsilon < 0.0 || online_params.epsilon > 1.0 ) {
+    ZF_LOGW("invalid exploration rate %g, using %g", online_params.epsilon, PGMPI_ONLINE_DEFAULT_EPSILON);
+    online_params.epsilon = PGMPI_ONLINE_DEFAULT_EPSILON;
+  }
+  if( online_params.switch_t <= 0.0 ) {
+    ZF_LOGW("invalid switch threshold %g, using %g", online_params.switch_t, PGMPI_ONLINE_DEFAULT_SWITCH_T);
+    online_params.switch_t = PGMPI_ONLINE_DEFAULT_SWITCH_T;
+  }
+
+  if( online_keyval != MPI_KEYVAL_INVALID ) {
+    return 0;
+  }
+
+  ret = MPI_Comm_create_keyval(MPI_COMM_NULL_COPY_FN, &online_delete_fn, &online_keyval, NULL);
+  if( ret != MPI_SUCCESS ) {
+    ZF_LOGE("cannot create keyval for online tuning");
+    online_keyval = MPI_KEYVAL_INVALID;
+    return -1;
+  }
+
+  return 0;
+}
+
+void pgmpi_online_tuner_free(void) {
+  void *val;
+  int flag;
+
+  free(decisions);
+  decisions = NULL;
+  n_decisions = 0;
+  capacity_decisions = 0;
+
+  if( online_keyval == MPI_KEYVAL_INVALID ) {
+    return;
+  }
+
+  // attributes of MPI_COMM_WORLD and MPI_COMM_SELF are not necessarily deleted by MPI_Finalize
+  MPI_Comm_get_attr(MPI_COMM_WORLD, online_keyval, &val, &flag);
+  if( flag ) {
+    MPI_Comm_delete_attr(MPI_COMM_WORLD, online_keyval);
+  }
+  MPI_Comm_get_attr(MPI_COMM_SELF, online_keyval, &val, &flag);
+  if( flag ) {
+    MPI_Comm_delete_attr(MPI_COMM_SELF, online_keyval);
+  }
+
+  MPI_Comm_free_keyval(&online_keyval);
+  online_keyval = MPI_KEYVAL_INVALID;
+}
+
+int pgmpi_online_bucket(const MPI_Count msg_size) {
+  int bucket = 0;
+  MPI_Count m = msg_size;
+
+  while( m > 1 ) {
+    m >>= 1;
+    bucket++;
+  }
+  return bucket;
+}
+
+void pgmpi_online_bucket_range(const int bucket, MPI_Count *msize_start, MPI_Count *msize_end) {
+  assert(bucket >= 0 && bucket < PGMPI_ONLINE_NB_BUCKETS);
+
+  *msize_start = (bucket == 0) ? 0 : ((MPI_Count)1 << bucket);
+  *msize_end = (bucket == PGMPI_ONLINE_NB_BUCKETS - 1) ? LLONG_MAX : ((MPI_Count)1 << (bucket + 1)) - 1;
+}
+
+int pgmpi_online_tuner_get_algorithm(const pgmpi_collectives_t cid, const MPI_Count msg_size, MPI_Comm comm,
+    int *alg_id) {
+  pgmpi_online_state_t *state;
+  pgmpi_online_entry_t *entry;
+  module_t *mod;
+  int bucket, site_id;
+
+  *alg_id = 0;
+
+  state = get_state(comm);
+  if( state == NULL ) {
+    return 0;
+  }
+
+  bucket = pgmpi_online_bucket(msg_size);
+  entry = &get_site_entries(state, comm, &site_id)[cid * PGMPI_ONLINE_NB_BUCKETS + bucket];
+  if( entry->alg_id >= 0 ) {
+    *alg_id = entry->alg_id;
+    if( entry->stat != NULL && online_params.epsilon > 0.0 ) {
+      // 53 random bits give a uniform double in [0,1)
+      double u = (double)(schedule_draw(state, site_id, cid, bucket, entry->n_seen, 0) >> 11) / 9007199254740992.0;
+      if( u < online_params.epsilon ) {
+        mod = pgmpi_modules_get(cid);
+        *alg_id = mod->alg_choices->alg[schedule_draw(state, site_id, cid, bucket, entry->n_seen, 1) %
+                                        mod->alg_choices->nb_choices].algid;
+        entry->n_seen++;
+        return PGMPI_ALG_MEASURE;
+      }
+      entry->n_seen++;
+    }
+    return 0;
+  }
+
+  mod = pgmpi_modules_get(cid);
+  if( mod == NULL || mod->alg_choices->nb_choices < 2 ) {
+    // nothing to choose from
+    entry->alg_id = 0;
+    return 0;
+  }
+
+  if( entry->stat == NULL ) {
+    entry->stat = (pgmpi_online_stat_t *)calloc(mod->alg_choices->nb_choices, sizeof(pgmpi_online_stat_t));
+  }
+
+  *alg_id = mod->alg_choices->alg[entry->n_calls % mod->alg_choices->nb_choices].algid;
+  return PGMPI_ALG_MEASURE;
+}
+
+int pgmpi_online_tuner_get_committed(const pgmpi_collectives_t cid, const MPI_Count msg_size, MPI_Comm comm,
+    int *alg_id) {
+  pgmpi_online_state_t *state;
+  pgmpi_online_entry_t *entry;
+  int site_id;
+
+  *alg_id = 0;
+
+  state = get_state(comm);
+  if( state == NULL ) {
+    return 0;
+  }
+
+  entry = &get_site_entries(state, comm, &site_id)[cid * PGMPI_ONLINE_NB_BUCKETS + pgmpi_online_bucket(msg_size)];
+  if( entry->alg_id >= 0 ) {
+    *alg_id = entry->alg_id;
+  }
+  return 0;
+}
+
+void pgmpi_online_tuner_report_time(const pgmpi_collectives_t cid, const MPI_Count msg_size, MPI_Comm comm,
+    const int alg_id, const double time) {
+  pgmpi_online_state_t *state;
+  pgmpi_online_entry_t *entry;
+  module_t *mod;
+  double max_time;
+  int bucket, site_id;
+  int idx;
+
+  // the slowest rank determines the run-time of a collective
+  PMPI_Allreduce(&time, &max_time, 1, MPI_DOUBLE, MPI_MAX, comm);
+
+  state = get_state(comm);
+  if( state == NULL ) {
+    return;
+  }
+
+  bucket = pgmpi_online_bucket(msg_size);
+  entry = &get_site_entries(state, comm, &site_id)[cid * PGMPI_ONLINE_NB_BUCKETS + bucket];
+  mod = pgmpi_modules_get(cid);
+  if( entry->stat == NULL || mod == NULL ) {
+    return;
+  }
+
+  for(idx=0; idx<mod->alg_choices->nb_choices; idx++) {
+    if( mod->alg_choices->alg[idx].algid == alg_id ) {
+      break;
+    }
+  }
+  if( idx == mod->alg_choices->nb_choices ) {
+    ZF_LOGW("reported time for unknown alg id %d", alg_id);
+    return;
+  }
+
+  update_stat(&entry->stat[idx], max_time);
+  entry->n_calls++;
+
+  if( entry->alg_id < 0 ) {
+    if( entry->n_calls >= online_params.nb_trials * mod->alg_choices->nb_choices ) {
+      commit_entry(entry, mod->alg_choices, cid, state->comm_size, bucket, site_id);
+    }
+  } else if( mod->alg_choices->alg[idx].algid != entry->alg_id ) {
+    int inc;
+    for(inc=0; inc<mod->alg_choices->nb_choices; inc++) {
+      if( mod->alg_choices->alg[inc].algid == entry->alg_id ) {
+        break;
+      }
+    }
+    if( inc < mod->alg_choices->nb_choices && is_significantly_faster(&entry->stat[idx], &entry->stat[inc]) ) {
+      ZF_LOGV("switching cid %d, bucket %d, p=%d from alg %d to %d", cid, bucket, state->comm_size,
+          entry->alg_id, mod->alg_choices->alg[idx].algid);
+      entry->alg_id = mod->alg_choices->alg[idx].algid;
+      record_decision(cid, state->comm_size, bucket, site_id, entry->alg_id);
+    }
+  }
+}
+
+int pgmpi_online_tuner_gather_decisions(MPI_Comm comm, const int root) {
+  int rank, size, i;
+  int n_total = 0;
+  int *sendbuf, *recvbuf = NULL;
+  int *counts = NULL, *displs = NULL;
+  int n_send = n_decisions * DECISION_INTS;
+  int ret = 0;
+
+  PMPI_Comm_rank(comm, &rank);
+  PMPI_Comm_size(comm, &size);
+
+  sendbuf = (int *)malloc((n_decisions + 1) * DECISION_INTS * sizeof(int));
+  for(i=0; i<n_decisions; i++) {
+    sendbuf[i * DECISION_INTS + 0] = decisions[i].cid;
+    sendbuf[i * DECISION_INTS + 1] = decisions[i].comm_size;
+    sendbuf[i * DECISION_INTS + 2] = decisions[i].bucket;
+    sendbuf[i * DECISION_INTS + 3] = decisions[i].site_id;
+    sendbuf[i * DECISION_INTS + 4] = decisions[i].alg_id;
+  }
+
+  if( rank == root ) {
+    counts = (int *)malloc(size * sizeof(int));
+    displs = (int *)malloc(size * sizeof(int));
+  }
+  PMPI_Gather(&n_send, 1, MPI_INT, counts, 1, MPI_INT, root, comm);
+  if( rank == root ) {
+    for(i=0; i<size; i++) {
+      displs[i] = n_total;
+      n_total += counts[i];
+    }
+    recvbuf = (int *)malloc((n_total + 1) * sizeof(int));
+  }
+  if( PMPI_Gatherv(sendbuf, n_send, MPI_INT, recvbuf, counts, displs, MPI_INT, root, comm) != MPI_SUCCESS ) {
+    ZF_LOGE("cannot gather the learned decisions");
+    ret = -1;
+  } else if( rank == root ) {
+    // the decisions of root come first, then those of the lower ranks
+    for(i=0; i<n_total; i+=DECISION_INTS) {
+      int *d = &recvbuf[i];
+      if( find_decision(d[0], d[1], d[2], d[3]) < 0 ) {
+        record_decision(d[0], d[1], d[2], d[3], d[4]);
+      }
+    }
+  }
+
+  free(sendbuf);
+  free(recvbuf);
+  free(counts);
+  free(displs);
+  return ret;
+}
+
+int pgmpi_online_tuner_write_profiles(const char *path) {
+  int ret = 0;
+  int i, j;
+  char header[80];
+
+  snprintf(header, sizeof(header), "learned online, %d trials per algorithm%s", online_params.nb_trials,
+      online_params.bandit ? ", re-tuned" : "");
+
+  for(i=0; i<n_decisions; i++) {
+    pgmpi_profile_t profile;
+    module_t *mod;
+    char *fname;
+    int n_ranges = 0;
+    int written = 0;
+
+    // one profile per (cid, comm_size), written when its first decision is seen
+    for(j=0; j<i; j++) {
+      if( decisions[j].cid == decisions[i].cid && decisions[j].comm_size == decisions[i].comm_size ) {
+        written = 1;
+        break;
+      }
+    }
+    if( written ) {
+      continue;
+    }
+
+    for(j=i; j<n_decisions; j++) {
+      if( decisions[j].cid == decisions[i].cid && decisions[j].comm_size == decisions[i].comm_size &&
+          decisions[j].alg_id != 0 ) {
+        n_ranges++;
+      }
+    }
+    if( n_ranges == 0 ) {
+      // the default algorithm won everywhere, nothing to replace
+      continue;
+    }
+
+    mod = pgmpi_modules_get(decisions[i].cid);
+    pgmpi_profile_allocate(&profile, mod->mpiname, decisions[i].comm_size, n_ranges);
+    n_ranges = 0;
+    for(j=i; j<n_decisions; j++) {
+      if( decisions[j].cid == decisions[i].cid && decisions[j].comm_size == decisions[i].comm_size &&
+          decisions[j].alg_id != 0 ) {
+        pgmpi_range_t *r = &profile.range[n_ranges++];
+        pgmpi_online_bucket_range(decisions[j].bucket, &r->msg_size_start, &r->msg_size_end);
+        r->alg_id = decisions[j].alg_id;
+        r->dtype_id = PGMPI_QUALIFIER_ANY;
+        r->op_id = PGMPI_QUALIFIER_ANY;
+        r->site_id = decisions[j].site_id;
+        r->skew_us = PGMPI_QUALIFIER_ANY;
+        r->n_fallbacks = 0;
+        r->has_effect = 0;
+      }
+    }
+    pgmpi_profile_normalize(&profile);
+
+    fname = (char *)malloc(strlen(path) + strlen(mod->cli_prefix) + 40);
+    sprintf(fname, "%s/online_%s_p%d.%s", path, mod->cli_prefix, decisions[i].comm_size,
+        pgmpi_get_profile_file_suffix());
+    if( pgmpi_profile_write(fname, &profile, header) != 0 ) {
+      ret = -1;
+    } else {
+      ZF_LOGV("wrote learned profile %s", fname);
+    }
+    free(fname);
+    pgmpi_profile_free(&profile);
+  }
+
+  return ret;
+}
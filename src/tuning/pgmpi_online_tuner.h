@@ -0,0 +1,148 @@
+/*  PGMPITuneLib - Library for Autotuning MPI Collectives using Performance Guidelines
+ *  
+ *  Copyright 2017 Sascha Hunold, Alexandra Carpen-Amarie
+ *      Research Group for Parallel Computing
+ *      Faculty of Informatics
+ *      Vienna University of Technology, Austria
+ *  
+ *  <license>
+ *      This library is free software; you can redistribute it
+ *      and/or modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *  
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *  
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free
+ *      Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *      Boston, MA 02110-1301 USA
+ *  </license>
+ */
+
+
+#ifndef SRC_TUNING_PGMPI_ONLINE_TUNER_H_
+#define SRC_TUNING_PGMPI_ONLINE_TUNER_H_
+
+#include <mpi.h>
+
+#include "pgmpi_tune.h"
+
+/*
+ * the online tuner learns the algorithm per (communicator, collective, size bucket)
+ * a bucket holds all message sizes with the same power of two, [2^b, 2^(b+1)-1]
+ * (bucket 0 also holds size 0)
+ * if call sites are enabled (see util/pgmpi_callsite.h), every call site learns
+ * on its own
+ */
+
+#define PGMPI_ONLINE_NB_BUCKETS     63
+#define PGMPI_ONLINE_DEFAULT_TRIALS 5
+#define PGMPI_ONLINE_DEFAULT_EPSILON 0.05
+#define PGMPI_ONLINE_DEFAULT_SEED   4711
+#define PGMPI_ONLINE_DEFAULT_SWITCH_T 3.0
+#define PGMPI_ONLINE_EWMA_WEIGHT    0.1   /* weight of a new measurement in the running statistics */
+
+typedef struct {
+  int nb_trials;      /* calls per alg choice before the fastest one is committed */
+  int bandit;         /* keep exploring after the commit and switch if another choice becomes faster */
+  double epsilon;     /* fraction of calls that explore in bandit mode */
+  double switch_t;    /* t-value a challenger needs to replace the committed algorithm */
+  unsigned int seed;  /* seed of the exploration schedule, must be the same on all ranks */
+} pgmpi_online_params_t;
+
+/*
+ * run-time statistics of one alg choice, times are maxima over all ranks
+ * mean and var are exponentially weighted, so old measurements fade out
+ */
+typedef struct {
+  int n;
+  double best;
+  double mean;
+  double var;
+} pgmpi_online_stat_t;
+
+typedef struct {
+  int n_calls;               /* calls measured so far */
+  unsigned int n_seen;       /* calls since the commit, position in the exploration schedule */
+  int alg_id;                /* committed algorithm, -1 while exploring */
+  pgmpi_online_stat_t *stat; /* per alg choice, NULL before the first measurement */
+} pgmpi_online_entry_t;
+
+/*
+ * per-communicator state, attached to the communicator as an MPI attribute
+ */
+typedef struct {
+  int comm_size;
+  unsigned int key;              /* same on all ranks, gives the communicator its own exploration schedule */
+  pgmpi_online_entry_t *entry;   /* NUM_COLLECTIVES x PGMPI_ONLINE_NB_BUCKETS */
+  int n_sites;
+  pgmpi_online_entry_t **site_entry;  /* per call site index, same layout as entry, NULL until used */
+} pgmpi_online_state_t;
+
+void pgmpi_online_params_default(pgmpi_online_params_t *params);
+
+/*!
+  may be called again to change the parameters, learned decisions are kept
+  \return 0 on success, -1 on error
+*/
+int pgmpi_online_tuner_init(const pgmpi_online_params_t *params);
+
+void pgmpi_online_tuner_free(void);
+
+int pgmpi_online_bucket(const MPI_Count msg_size);
+
+/*!
+  \param msize_start first message size of the bucket
+  \param msize_end last message size of the bucket (inclusive)
+*/
+void pgmpi_online_bucket_range(const int bucket, MPI_Count *msize_start, MPI_Count *msize_end);
+
+/*!
+  while a bucket is explored, the alg choices of the module are returned in turn
+  in bandit mode, a seeded schedule picks the calls (a fraction epsilon) that try a
+  random alg choice after the commit; all ranks follow the same schedule, which
+  differs between communicators and call sites
+  \return PGMPI_ALG_MEASURE if the call has to be timed, 0 otherwise
+*/
+int pgmpi_online_tuner_get_algorithm(const pgmpi_collectives_t cid, const MPI_Count msg_size, MPI_Comm comm,
+    int *alg_id);
+
+/*!
+  for collectives called by mock-ups, which must neither explore nor be timed
+  \return 0, alg_id is set to the committed algorithm, or to the default one while exploring
+*/
+int pgmpi_online_tuner_get_committed(const pgmpi_collectives_t cid, const MPI_Count msg_size, MPI_Comm comm,
+    int *alg_id);
+
+/*!
+  collective over comm, reduces the run-times to their maximum over all ranks
+  after nb_trials calls per alg choice, the fastest choice is committed; as all ranks
+  see the same times, they all commit the same algorithm
+  in bandit mode, a choice replaces the committed algorithm once its mean run-time
+  is lower with a t-value of at least switch_t
+*/
+void pgmpi_online_tuner_report_time(const pgmpi_collectives_t cid, const MPI_Count msg_size, MPI_Comm comm,
+    const int alg_id, const double time);
+
+/*!
+  collective over comm, root adds the decisions of the other ranks that it
+  does not know, so that decisions learned on communicators without root are
+  written as well; for the same collective, communicator size, bucket and
+  call site, the decision of root or else of the lowest rank is kept
+  \return 0 on success, -1 on error
+*/
+int pgmpi_online_tuner_gather_decisions(MPI_Comm comm, const int root);
+
+/*!
+  writes one profile per collective and communicator size with the committed
+  decisions that differ from the default algorithm, decisions of call sites are
+  restricted to their site (site qualifier)
+  \return 0 on success, -1 if a profile cannot be written
+*/
+int pgmpi_online_tuner_write_profiles(const char *path);
+
+#endif /* SRC_TUNING_PGMPI_ONLINE_TUNER_H_ */
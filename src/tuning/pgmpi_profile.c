@@ -29,6 +29,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <assert.h>
+#include <limits.h>
 
 #define ZF_LOG_LEVEL MY_ZF_LOG_LEVEL
 #include "log/zf_log.h"
@@ -49,7 +50,12 @@ int pgmpi_profile_allocate(pgmpi_profile_t *profile, const char *mpiname, const
   profile->cid = cid;
   profile->n_ranges = n_ranges;
   profile->nb_procs = nb_procs;
+  profile->nb_nodes = 0;
+  profile->ppn = 0;
   profile->range = (pgmpi_range_t *)malloc(n_ranges * sizeof(pgmpi_range_t));
+  profile->n_groups = 0;
+  profile->group = NULL;
+  profile->is_mapped = 0;
   return 0;
 }
 
@@ -60,6 +66,14 @@ int pgmpi_profile_free(pgmpi_profile_t *profile) {
     return 1;
   }
 
+  if( profile->is_mapped ) {
+    return 0;
+  }
+
+  free(profile->group);
+  profile->group = NULL;
+  profile->n_groups = 0;
+
   if( profile->range == NULL) {
     return 0;
   }
@@ -70,8 +84,8 @@ int pgmpi_profile_free(pgmpi_profile_t *profile) {
   return 0;
 }
 
-int pgmpi_profile_set_alg_for_range(pgmpi_profile_t *profile, const int range_idx, const int msize_begin,
-    const int msize_end, const char *algname) {
+int pgmpi_profile_set_alg_for_range(pgmpi_profile_t *profile, const int range_idx, const MPI_Count msize_begin,
+    const MPI_Count msize_end, const char *algname) {
   int algid;
   module_t *mod;
 
@@ -94,25 +108,435 @@ int pgmpi_profile_set_alg_for_range(pgmpi_profile_t *profile, const int range_id
   profile->range[range_idx].msg_size_start = msize_begin;
   profile->range[range_idx].msg_size_end   = msize_end;
   profile->range[range_idx].alg_id = algid;
+  profile->range[range_idx].dtype_id = PGMPI_QUALIFIER_ANY;
+  profile->range[range_idx].op_id    = PGMPI_QUALIFIER_ANY;
+  profile->range[range_idx].site_id  = PGMPI_QUALIFIER_ANY;
+  profile->range[range_idx].skew_us  = PGMPI_QUALIFIER_ANY;
+  profile->range[range_idx].n_fallbacks = 0;
+  profile->range[range_idx].has_effect = 0;
+  profile->range[range_idx].effect = 0.0;
+  profile->range[range_idx].effect_ci_low = 0.0;
+  profile->range[range_idx].effect_ci_high = 0.0;
+
+  return 0;
+}
+
+int pgmpi_profile_add_fallback_for_range(pgmpi_profile_t *profile, const int range_idx, const char *algname) {
+  pgmpi_range_t *r;
+  int algid;
+
+  assert(profile != NULL);
+  assert(range_idx >= 0 && range_idx < profile->n_ranges);
+
+  r = &profile->range[range_idx];
+  if( r->n_fallbacks == PGMPI_PROFILE_MAX_FALLBACKS ) {
+    ZF_LOGE("more than %d fallbacks for a range", PGMPI_PROFILE_MAX_FALLBACKS);
+    return -1;
+  }
+  algid = pgmpi_modules_get_algid_by_algname(pgmpi_modules_get(profile->cid)->alg_choices, algname);
+  if( algid < 0 ) {
+    ZF_LOGE("cannot find alg id for algname: %s", algname);
+    return -1;
+  }
+  r->fallback[r->n_fallbacks++] = algid;
+
+  return 0;
+}
+
+int pgmpi_profile_get_candidates(const pgmpi_range_t *range, int *candidates) {
+  int i;
+
+  candidates[0] = range->alg_id;
+  for(i=0; i<range->n_fallbacks; i++) {
+    candidates[i+1] = range->fallback[i];
+  }
+  return range->n_fallbacks + 1;
+}
+
+int pgmpi_profile_set_shape(pgmpi_profile_t *profile, const int nb_nodes, const int ppn) {
+
+  assert(profile != NULL);
+
+  if( nb_nodes <= 0 || ppn <= 0 || nb_nodes * ppn != profile->nb_procs ) {
+    ZF_LOGE("invalid layout %d x %d for profile with %d processes", nb_nodes, ppn, profile->nb_procs);
+    return -1;
+  }
+  profile->nb_nodes = nb_nodes;
+  profile->ppn = ppn;
+
+  return 0;
+}
+
+int pgmpi_profile_set_qualifiers_for_range(pgmpi_profile_t *profile, const int range_idx, const int dtype_id,
+    const int op_id) {
+
+  assert(profile != NULL);
+  assert(range_idx >= 0 && range_idx < profile->n_ranges);
+
+  profile->range[range_idx].dtype_id = dtype_id;
+  profile->range[range_idx].op_id    = op_id;
+
+  return 0;
+}
+
+int pgmpi_profile_set_site_for_range(pgmpi_profile_t *profile, const int range_idx, const int site_id) {
+
+  assert(profile != NULL);
+  assert(range_idx >= 0 && range_idx < profile->n_ranges);
+
+  profile->range[range_idx].site_id = site_id;
 
   return 0;
 }
 
-int pgmpi_profile_find_alg(pgmpi_profile_t *profile, const int msize, int *algid) {
+int pgmpi_profile_set_skew_for_range(pgmpi_profile_t *profile, const int range_idx, const int skew_us) {
+
+  assert(profile != NULL);
+  assert(range_idx >= 0 && range_idx < profile->n_ranges);
+
+  profile->range[range_idx].skew_us = skew_us;
+
+  return 0;
+}
+
+int pgmpi_profile_set_effect_for_range(pgmpi_profile_t *profile, const int range_idx, const double effect,
+    const double ci_low, const double ci_high) {
+
+  assert(profile != NULL);
+  assert(range_idx >= 0 && range_idx < profile->n_ranges);
+
+  if( ci_low > effect || ci_high < effect ) {
+    ZF_LOGE("effect %g is not in its confidence interval [%g,%g]", effect, ci_low, ci_high);
+    return -1;
+  }
+  profile->range[range_idx].has_effect = 1;
+  profile->range[range_idx].effect = effect;
+  profile->range[range_idx].effect_ci_low = ci_low;
+  profile->range[range_idx].effect_ci_high = ci_high;
+
+  return 0;
+}
+
+/*
+ * the merged range claims no more than its weakest part,
+ * it has no effect if one of the ranges has none
+ */
+static void merge_effects(pgmpi_range_t *r, const pgmpi_range_t *other) {
+  if( !r->has_effect || !other->has_effect ) {
+    r->has_effect = 0;
+    return;
+  }
+  if( other->effect < r->effect ) {
+    r->effect = other->effect;
+  }
+  if( other->effect_ci_low < r->effect_ci_low ) {
+    r->effect_ci_low = other->effect_ci_low;
+  }
+  if( other->effect_ci_high > r->effect_ci_high ) {
+    r->effect_ci_high = other->effect_ci_high;
+  }
+}
+
+static int same_algs(const pgmpi_range_t *r1, const pgmpi_range_t *r2) {
   int i;
-  int ret = -1;
 
-  // TODO: to bisection!
+  if( r1->alg_id != r2->alg_id || r1->n_fallbacks != r2->n_fallbacks ) {
+    return 0;
+  }
+  for(i=0; i<r1->n_fallbacks; i++) {
+    if( r1->fallback[i] != r2->fallback[i] ) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+static int same_qualifiers(const pgmpi_range_t *r1, const pgmpi_range_t *r2) {
+  return (r1->dtype_id == r2->dtype_id && r1->op_id == r2->op_id && r1->site_id == r2->site_id &&
+      r1->skew_us == r2->skew_us);
+}
+
+static int compare_ranges(const void *a, const void *b) {
+  const pgmpi_range_t *r1 = (const pgmpi_range_t *)a;
+  const pgmpi_range_t *r2 = (const pgmpi_range_t *)b;
+
+  if( r1->dtype_id != r2->dtype_id ) {
+    return (r1->dtype_id < r2->dtype_id) ? -1 : 1;
+  }
+  if( r1->op_id != r2->op_id ) {
+    return (r1->op_id < r2->op_id) ? -1 : 1;
+  }
+  if( r1->site_id != r2->site_id ) {
+    return (r1->site_id < r2->site_id) ? -1 : 1;
+  }
+  if( r1->skew_us != r2->skew_us ) {
+    return (r1->skew_us < r2->skew_us) ? -1 : 1;
+  }
+  if( r1->msg_size_start < r2->msg_size_start ) {
+    return -1;
+  } else if( r1->msg_size_start > r2->msg_size_start ) {
+    return 1;
+  }
+  return 0;
+}
+
+int pgmpi_profile_normalize(pgmpi_profile_t *profile) {
+  int i, j;
+
+  assert(profile != NULL);
+
+  if( profile->n_ranges <= 0 ) {
+    return 0;
+  }
+
+  qsort(profile->range, profile->n_ranges, sizeof(pgmpi_range_t), &compare_ranges);
+
+  // ranges are inclusive on both ends, so [16,32] and [32,64] overlap
+  for(i=1; i<profile->n_ranges; i++) {
+    if( same_qualifiers(&profile->range[i], &profile->range[i-1]) &&
+        profile->range[i].msg_size_start <= profile->range[i-1].msg_size_end ) {
+      ZF_LOGE("overlapping message size ranges [%lld,%lld] and [%lld,%lld] in profile for cid %d",
+          (long long)profile->range[i-1].msg_size_start, (long long)profile->range[i-1].msg_size_end,
+          (long long)profile->range[i].msg_size_start, (long long)profile->range[i].msg_size_end, profile->cid);
+      return -1;
+    }
+  }
+
+  // merge adjacent ranges that select the same algorithms
+  j = 0;
+  for(i=1; i<profile->n_ranges; i++) {
+    if( same_qualifiers(&profile->range[i], &profile->range[j]) && same_algs(&profile->range[i], &profile->range[j]) &&
+        profile->range[i].msg_size_start == profile->range[j].msg_size_end + 1 ) {
+      profile->range[j].msg_size_end = profile->range[i].msg_size_end;
+      merge_effects(&profile->range[j], &profile->range[i]);
+    } else {
+      j++;
+      profile->range[j] = profile->range[i];
+    }
+  }
+  if( j+1 < profile->n_ranges ) {
+    ZF_LOGV("merged %d adjacent ranges in profile for cid %d", profile->n_ranges - (j+1), profile->cid);
+  }
+  profile->n_ranges = j+1;
+
+  // index the runs of ranges with the same qualifiers
+  free(profile->group);
+  profile->n_groups = 0;
+  profile->group = (pgmpi_range_group_t *)malloc(profile->n_ranges * sizeof(pgmpi_range_group_t));
   for(i=0; i<profile->n_ranges; i++) {
-    if( profile->range[i].msg_size_start <= msize &&
-        profile->range[i].msg_size_end   >= msize) {
-      *algid = profile->range[i].alg_id;
-      ret = 0;
+    if( i == 0 || !same_qualifiers(&profile->range[i], &profile->range[i-1]) ) {
+      pgmpi_range_group_t *g = &profile->group[profile->n_groups++];
+      g->dtype_id = profile->range[i].dtype_id;
+      g->op_id    = profile->range[i].op_id;
+      g->site_id  = profile->range[i].site_id;
+      g->skew_us  = profile->range[i].skew_us;
+      g->first    = i;
+      g->n        = 0;
+    }
+    profile->group[profile->n_groups-1].n++;
+  }
+
+  return 0;
+}
+
+static int find_range_in_group(const pgmpi_profile_t *profile, const pgmpi_range_group_t *group,
+    const MPI_Count msize) {
+  int lo, hi;
+
+  // ranges within a group are sorted and disjoint (see pgmpi_profile_normalize)
+  lo = group->first;
+  hi = group->first + group->n - 1;
+  while( lo <= hi ) {
+    int mid = lo + (hi - lo) / 2;
+    if( profile->range[mid].msg_size_end < msize ) {
+      lo = mid + 1;
+    } else if( profile->range[mid].msg_size_start > msize ) {
+      hi = mid - 1;
+    } else {
+      return mid;
+    }
+  }
+
+  return -1;
+}
+
+static int group_weight(const pgmpi_range_group_t *g) {
+  return (g->site_id != PGMPI_QUALIFIER_ANY ? 8 : 0) + (g->skew_us != PGMPI_QUALIFIER_ANY ? 4 : 0) +
+      (g->op_id != PGMPI_QUALIFIER_ANY ? 2 : 0) + (g->dtype_id != PGMPI_QUALIFIER_ANY ? 1 : 0);
+}
+
+void pgmpi_profile_skew_interval(const pgmpi_profile_t *profile, const int skew_us, int *skew_lo, int *skew_hi) {
+  int i;
+
+  // an unknown skew only matches groups without skew qualifier
+  if( skew_us < 0 ) {
+    *skew_lo = skew_us;
+    *skew_hi = skew_us + 1;
+    return;
+  }
+
+  *skew_lo = 0;
+  *skew_hi = INT_MAX;
+  if( profile == NULL ) {
+    return;
+  }
+  for(i=0; i<profile->n_groups; i++) {
+    const int q = profile->group[i].skew_us;
+    if( q == PGMPI_QUALIFIER_ANY ) {
+      continue;
+    }
+    if( q <= skew_us && q > *skew_lo ) {
+      *skew_lo = q;
+    } else if( q > skew_us && q < *skew_hi ) {
+      *skew_hi = q;
+    }
+  }
+}
+
+int pgmpi_profile_group_is_more_specific(const pgmpi_range_group_t *g1, const pgmpi_range_group_t *g2) {
+  int w1 = group_weight(g1);
+  int w2 = group_weight(g2);
+
+  if( w1 != w2 ) {
+    return (w1 > w2);
+  }
+  return (g1->skew_us > g2->skew_us);
+}
+
+int pgmpi_profile_find_alg(const pgmpi_profile_t *profile, const MPI_Count msize, const int dtype_id,
+    const int op_id, int *algid) {
+  pgmpi_call_qualifiers_t call;
+
+  call.dtype_id = dtype_id;
+  call.op_id = op_id;
+  call.site_id = PGMPI_QUALIFIER_NONE;
+  call.skew_us = PGMPI_QUALIFIER_NONE;
+  return pgmpi_profile_find_alg_for_call(profile, msize, &call, algid);
+}
+
+int pgmpi_profile_find_alg_for_call(const pgmpi_profile_t *profile, const MPI_Count msize,
+    const pgmpi_call_qualifiers_t *call, int *algid) {
+  const pgmpi_range_t *range;
+
+  range = pgmpi_profile_find_range_for_call(profile, msize, call);
+  if( range == NULL ) {
+    return -1;
+  }
+  *algid = range->alg_id;
+  return 0;
+}
+
+const pgmpi_range_t *pgmpi_profile_find_range_for_call(const pgmpi_profile_t *profile, const MPI_Count msize,
+    const pgmpi_call_qualifiers_t *call) {
+  int i;
+  int best_idx = -1;
+  const pgmpi_range_group_t *best = NULL;
+
+  for(i=0; i<profile->n_groups; i++) {
+    const pgmpi_range_group_t *g = &profile->group[i];
+    int idx;
+
+    if( !pgmpi_qualifier_dtype_matches(g->dtype_id, call->dtype_id) ||
+        !pgmpi_qualifier_op_matches(g->op_id, call->op_id) ||
+        !pgmpi_qualifier_site_matches(g->site_id, call->site_id) ||
+        !pgmpi_qualifier_skew_matches(g->skew_us, call->skew_us) ) {
+      continue;
+    }
+    if( best != NULL && !pgmpi_profile_group_is_more_specific(g, best) ) {
+      continue;
+    }
+    idx = find_range_in_group(profile, g, msize);
+    if( idx >= 0 ) {
+      best_idx = idx;
+      best = g;
+    }
+  }
+
+  if( best_idx < 0 ) {
+    return NULL;
+  }
+  return &profile->range[best_idx];
+}
+
+void pgmpi_profile_pack(pgmpi_pack_buf_t *buf, const pgmpi_profile_t *profile) {
+  int i, j;
+
+  pgmpi_pack_int(buf, profile->cid);
+  pgmpi_pack_int(buf, profile->nb_procs);
+  pgmpi_pack_int(buf, profile->nb_nodes);
+  pgmpi_pack_int(buf, profile->ppn);
+  pgmpi_pack_int(buf, profile->n_ranges);
+  for(i=0; i<profile->n_ranges; i++) {
+    pgmpi_pack_count(buf, profile->range[i].msg_size_start);
+    pgmpi_pack_count(buf, profile->range[i].msg_size_end);
+    pgmpi_pack_int(buf, profile->range[i].alg_id);
+    pgmpi_pack_int(buf, profile->range[i].dtype_id);
+    pgmpi_pack_int(buf, profile->range[i].op_id);
+    pgmpi_pack_int(buf, profile->range[i].site_id);
+    pgmpi_pack_int(buf, profile->range[i].skew_us);
+    pgmpi_pack_int(buf, profile->range[i].n_fallbacks);
+    for(j=0; j<profile->range[i].n_fallbacks; j++) {
+      pgmpi_pack_int(buf, profile->range[i].fallback[j]);
+    }
+    pgmpi_pack_int(buf, profile->range[i].has_effect);
+    pgmpi_pack_double(buf, profile->range[i].effect);
+    pgmpi_pack_double(buf, profile->range[i].effect_ci_low);
+    pgmpi_pack_double(buf, profile->range[i].effect_ci_high);
+  }
+}
+
+int pgmpi_profile_unpack(pgmpi_pack_buf_t *buf, pgmpi_profile_t *profile) {
+  int i, j;
+  int cid;
+  int err = 0;
+
+  err |= pgmpi_unpack_int(buf, &cid);
+  err |= pgmpi_unpack_int(buf, &profile->nb_procs);
+  err |= pgmpi_unpack_int(buf, &profile->nb_nodes);
+  err |= pgmpi_unpack_int(buf, &profile->ppn);
+  err |= pgmpi_unpack_int(buf, &profile->n_ranges);
+  if( err != 0 || cid < 0 || cid >= NUM_COLLECTIVES || profile->n_ranges < 0 ) {
+    ZF_LOGE("invalid packed profile");
+    return -1;
+  }
+  profile->cid = (pgmpi_collectives_t)cid;
+  profile->n_groups = 0;
+  profile->group = NULL;
+  profile->is_mapped = 0;
+  profile->range = (pgmpi_range_t *)malloc(profile->n_ranges * sizeof(pgmpi_range_t));
+  for(i=0; i<profile->n_ranges; i++) {
+    err |= pgmpi_unpack_count(buf, &profile->range[i].msg_size_start);
+    err |= pgmpi_unpack_count(buf, &profile->range[i].msg_size_end);
+    err |= pgmpi_unpack_int(buf, &profile->range[i].alg_id);
+    err |= pgmpi_unpack_int(buf, &profile->range[i].dtype_id);
+    err |= pgmpi_unpack_int(buf, &profile->range[i].op_id);
+    err |= pgmpi_unpack_int(buf, &profile->range[i].site_id);
+    err |= pgmpi_unpack_int(buf, &profile->range[i].skew_us);
+    err |= pgmpi_unpack_int(buf, &profile->range[i].n_fallbacks);
+    if( err != 0 || profile->range[i].n_fallbacks < 0 || profile->range[i].n_fallbacks > PGMPI_PROFILE_MAX_FALLBACKS ) {
+      err = 1;
+      profile->n_ranges = i;
       break;
     }
+    for(j=0; j<profile->range[i].n_fallbacks; j++) {
+      err |= pgmpi_unpack_int(buf, &profile->range[i].fallback[j]);
+    }
+    err |= pgmpi_unpack_int(buf, &profile->range[i].has_effect);
+    err |= pgmpi_unpack_double(buf, &profile->range[i].effect);
+    err |= pgmpi_unpack_double(buf, &profile->range[i].effect_ci_low);
+    err |= pgmpi_unpack_double(buf, &profile->range[i].effect_ci_high);
   }
 
-  return ret;
+  // ranges were normalized by the sender, this only rebuilds the groups
+  if( err != 0 || pgmpi_profile_normalize(profile) != 0 ) {
+    ZF_LOGE("invalid packed profile");
+    pgmpi_profile_free(profile);
+    profile->range = NULL;
+    profile->n_ranges = 0;
+    return -1;
+  }
+
+  return 0;
 }
 
 char *pgmpi_get_profile_path() {
@@ -29,18 +29,49 @@
 
 
 #include "pgmpi_tune.h"
+#include "pgmpi_range_qualifier.h"
+#include "util/pgmpi_pack.h"
+
+#define PGMPI_PROFILE_MAX_FALLBACKS 3
 
 typedef struct {
-  int msg_size_start;
-  int msg_size_end; /* communication amount in bytes */
+  MPI_Count msg_size_start;
+  MPI_Count msg_size_end; /* communication amount in bytes */
   int alg_id;       /* selected alg (should be != 0) */
+  int dtype_id;     /* datatype qualifier, PGMPI_QUALIFIER_ANY if not restricted */
+  int op_id;        /* reduction op qualifier, PGMPI_QUALIFIER_ANY if not restricted */
+  int site_id;      /* call site qualifier, PGMPI_QUALIFIER_ANY if not restricted */
+  int skew_us;      /* minimum arrival skew qualifier in microseconds, PGMPI_QUALIFIER_ANY if not restricted */
+  int n_fallbacks;  /* algorithms tried in this order if alg_id does not get its buffers */
+  int fallback[PGMPI_PROFILE_MAX_FALLBACKS];
+  int has_effect;   /* 1 if the benefit of alg_id over the default was measured */
+  double effect;    /* relative reduction of the run-time, e.g., 0.2 if alg_id is 20% faster */
+  double effect_ci_low;   /* confidence interval of effect */
+  double effect_ci_high;
 } pgmpi_range_t;
 
+/*
+ * consecutive ranges (after normalization) that share the same qualifiers
+ */
+typedef struct {
+  int dtype_id;
+  int op_id;
+  int site_id;
+  int skew_us;
+  int first;      /* index of first range */
+  int n;          /* number of ranges */
+} pgmpi_range_group_t;
+
 typedef struct {
   pgmpi_collectives_t cid;
   int nb_procs;
+  int nb_nodes;   /* node layout the profile was measured on, 0 if not declared */
+  int ppn;
   int n_ranges;   /* number of ranges of message sizes in selection */
   pgmpi_range_t *range;
+  int n_groups;
+  pgmpi_range_group_t *group;
+  int is_mapped;  /* range and group point into a mapped profile database and must not be freed */
 } pgmpi_profile_t;
 
 int pgmpi_profile_allocate(pgmpi_profile_t *profile, const char *mpiname, const int nb_procs,
@@ -48,10 +79,114 @@ int pgmpi_profile_allocate(pgmpi_profile_t *profile, const char *mpiname, const
 
 int pgmpi_profile_free(pgmpi_profile_t *profile);
 
-int pgmpi_profile_set_alg_for_range(pgmpi_profile_t *profile, const int range_idx, const int msize_begin,
-    const int msize_end, const char *algname);
+int pgmpi_profile_set_alg_for_range(pgmpi_profile_t *profile, const int range_idx, const MPI_Count msize_begin,
+    const MPI_Count msize_end, const char *algname);
+
+/*!
+  declares the node layout (nb_nodes x ppn) the profile was measured on
+  \return 0 on success, -1 if the layout does not match nb_procs
+*/
+int pgmpi_profile_set_shape(pgmpi_profile_t *profile, const int nb_nodes, const int ppn);
+
+/*!
+  restricts a range to a datatype and/or reduction operation
+  \param dtype_id id from pgmpi_qualifier_dtype_id_by_name or PGMPI_QUALIFIER_ANY
+  \param op_id id from pgmpi_qualifier_op_id_by_name or PGMPI_QUALIFIER_ANY
+*/
+int pgmpi_profile_set_qualifiers_for_range(pgmpi_profile_t *profile, const int range_idx, const int dtype_id,
+    const int op_id);
+
+/*!
+  restricts a range to a call site
+  \param site_id id from pgmpi_qualifier_site_id_by_name or PGMPI_QUALIFIER_ANY
+*/
+int pgmpi_profile_set_site_for_range(pgmpi_profile_t *profile, const int range_idx, const int site_id);
+
+/*!
+  restricts a range to calls with an estimated arrival skew of at least skew_us
+  \param skew_us value from pgmpi_qualifier_skew_by_name or PGMPI_QUALIFIER_ANY
+*/
+int pgmpi_profile_set_skew_for_range(pgmpi_profile_t *profile, const int range_idx, const int skew_us);
+
+/*!
+  appends a fallback algorithm to a range
+  \return 0 on success, -1 if the algorithm is unknown or the range has
+          PGMPI_PROFILE_MAX_FALLBACKS fallbacks already
+*/
+int pgmpi_profile_add_fallback_for_range(pgmpi_profile_t *profile, const int range_idx, const char *algname);
+
+/*!
+  records the measured benefit of the algorithm of a range over the default
+  \param effect relative reduction of the run-time
+  \param ci_low, ci_high confidence interval of effect
+*/
+int pgmpi_profile_set_effect_for_range(pgmpi_profile_t *profile, const int range_idx, const double effect,
+    const double ci_low, const double ci_high);
+
+/*!
+  \param candidates set to the algorithm of the range followed by its fallbacks,
+         must have room for PGMPI_PROFILE_MAX_FALLBACKS+1 entries
+  \return number of candidates
+*/
+int pgmpi_profile_get_candidates(const pgmpi_range_t *range, int *candidates);
+
+/*!
+  sorts the ranges of a profile by qualifiers and message size and merges adjacent ranges
+  that select the same algorithms, a merged range keeps the smallest effect and lower bound
+  \return 0 on success, -1 if two ranges with the same qualifiers overlap
+*/
+int pgmpi_profile_normalize(pgmpi_profile_t *profile);
+
+/*!
+  binary search on the ranges, requires a normalized profile
+  if several groups of ranges match the call, the most specific one wins
+  (see pgmpi_profile_group_is_more_specific)
+  \param dtype_id id of the datatype of the call (see pgmpi_qualifier_dtype_id)
+  \param op_id id of the operation of the call (see pgmpi_qualifier_op_id)
+  \return 0 if a range contains msize, -1 otherwise
+*/
+int pgmpi_profile_find_alg(const pgmpi_profile_t *profile, const MPI_Count msize, const int dtype_id,
+    const int op_id, int *algid);
+
+/*!
+  same as pgmpi_profile_find_alg, for a call with known call site and/or skew
+*/
+int pgmpi_profile_find_alg_for_call(const pgmpi_profile_t *profile, const MPI_Count msize,
+    const pgmpi_call_qualifiers_t *call, int *algid);
+
+/*!
+  same as pgmpi_profile_find_alg_for_call, but returns the range with its fallbacks
+  \return matching range, NULL if no range contains msize
+*/
+const pgmpi_range_t *pgmpi_profile_find_range_for_call(const pgmpi_profile_t *profile, const MPI_Count msize,
+    const pgmpi_call_qualifiers_t *call);
+
+/*!
+  skews in [*skew_lo, *skew_hi) match the same groups of ranges as skew_us, so
+  decisions can be reused for them although the skew estimate changes
+  \param profile may be NULL
+  \param skew_us skew of a call, PGMPI_QUALIFIER_NONE if unknown
+*/
+void pgmpi_profile_skew_interval(const pgmpi_profile_t *profile, const int skew_us, int *skew_lo, int *skew_hi);
+
+/*!
+  a site qualifier counts more than a skew qualifier, which counts more than an
+  op qualifier, which counts more than a datatype qualifier; of two skew
+  qualifiers, the higher skew is more specific
+  \return 1 if g1 takes precedence over g2 when both cover a call, 0 otherwise
+*/
+int pgmpi_profile_group_is_more_specific(const pgmpi_range_group_t *g1, const pgmpi_range_group_t *g2);
+
+/*!
+  serializes a normalized profile, e.g., to broadcast it
+*/
+void pgmpi_profile_pack(pgmpi_pack_buf_t *buf, const pgmpi_profile_t *profile);
 
-int pgmpi_profile_find_alg(pgmpi_profile_t *profile, const int msize, int *algid);
+/*!
+  allocates profile from packed data
+  \return 0 on success, -1 if the data is invalid
+*/
+int pgmpi_profile_unpack(pgmpi_pack_buf_t *buf, pgmpi_profile_t *profile);
 
 char *pgmpi_get_profile_path();
 char *pgmpi_get_profile_file_suffix();
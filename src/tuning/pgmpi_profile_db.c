@@ -0,0 +1,259 @@
+/*  PGMPITuneLib - Library for Autotuning MPI Collectives using Performance Guidelines
+ *  
+ *  Copyright 2017 Sascha Hunold, Alexandra Carpen-Amarie
+ *      Research Group for Parallel Computing
+ *      Faculty of Informatics
+ *      Vienna University of Technology, Austria
+ *  
+ *  <license>
+ *      This library is free software; you can redistribute it
+ *      and/or modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *  
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *  
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free
+ *      Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *      Boston, MA 02110-1301 USA
+ *  </license>
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "pgmpi_tune.h"
+
+#define ZF_LOG_LEVEL MY_ZF_LOG_LEVEL
+#include "log/zf_log.h"
+
+#include "pgmpi_profile_db.h"
+#include "collectives/collective_modules.h"
+
+static int check_header(const pgmpi_profile_db_header_t *hdr, const size_t file_size);
+static int check_profile(const pgmpi_profile_t *p);
+
+
+static int check_header(const pgmpi_profile_db_header_t *hdr, const size_t file_size) {
+  size_t expected;
+
+  if( memcmp(hdr->magic, PGMPI_PROFILE_DB_MAGIC, sizeof(hdr->magic)) != 0 ) {
+    ZF_LOGE("not a profile database");
+    return -1;
+  }
+  if( hdr->version != PGMPI_PROFILE_DB_VERSION ) {
+    ZF_LOGE("profile database has version %d, expected %d", hdr->version, PGMPI_PROFILE_DB_VERSION);
+    return -1;
+  }
+  if( hdr->sizeof_range != sizeof(pgmpi_range_t) || hdr->sizeof_group != sizeof(pgmpi_range_group_t) ) {
+    ZF_LOGE("record layout of profile database does not match this build");
+    return -1;
+  }
+  if( hdr->n_profiles < 0 || hdr->n_groups < 0 || hdr->n_ranges < 0 ) {
+    ZF_LOGE("invalid record counts in profile database");
+    return -1;
+  }
+
+  expected = sizeof(pgmpi_profile_db_header_t)
+      + hdr->n_profiles * sizeof(pgmpi_profile_db_record_t)
+      + hdr->n_groups * sizeof(pgmpi_range_group_t)
+      + hdr->n_ranges * sizeof(pgmpi_range_t);
+  if( expected != file_size ) {
+    ZF_LOGE("profile database is truncated (%zu bytes, expected %zu)", file_size, expected);
+    return -1;
+  }
+
+  return 0;
+}
+
+/*
+ * the groups must lie within the ranges of the profile, and the algorithms
+ * must exist in the module of the collective
+ */
+static int check_profile(const pgmpi_profile_t *p) {
+  const module_t *mod = pgmpi_modules_get(p->cid);
+  int i, j;
+
+  if( mod == NULL ) {
+    return -1;
+  }
+  for(i=0; i<p->n_groups; i++) {
+    if( p->group[i].first < 0 || p->group[i].n < 0 || p->group[i].first + p->group[i].n > p->n_ranges ) {
+      ZF_LOGE("group %d (first %d, n %d) exceeds the %d ranges", i, p->group[i].first, p->group[i].n, p->n_ranges);
+      return -1;
+    }
+  }
+  for(i=0; i<p->n_ranges; i++) {
+    const pgmpi_range_t *r = &p->range[i];
+    if( r->alg_id < 0 || r->alg_id >= mod->alg_choices->nb_choices ||
+        r->n_fallbacks < 0 || r->n_fallbacks > PGMPI_PROFILE_MAX_FALLBACKS ) {
+      ZF_LOGE("range %d has invalid algorithm %d or %d fallbacks", i, r->alg_id, r->n_fallbacks);
+      return -1;
+    }
+    for(j=0; j<r->n_fallbacks; j++) {
+      if( r->fallback[j] < 0 || r->fallback[j] >= mod->alg_choices->nb_choices ) {
+        ZF_LOGE("range %d has invalid fallback algorithm %d", i, r->fallback[j]);
+        return -1;
+      }
+    }
+  }
+  return 0;
+}
+
+int pgmpi_profile_db_write(const char *fname, const pgmpi_profile_t *profiles, const int n_profiles) {
+  FILE *fp;
+  pgmpi_profile_db_header_t hdr;
+  int i;
+  int first_group, first_range;
+
+  memset(&hdr, 0, sizeof(hdr));
+  memcpy(hdr.magic, PGMPI_PROFILE_DB_MAGIC, sizeof(hdr.magic));
+  hdr.version = PGMPI_PROFILE_DB_VERSION;
+  hdr.n_profiles = n_profiles;
+  hdr.sizeof_range = sizeof(pgmpi_range_t);
+  hdr.sizeof_group = sizeof(pgmpi_range_group_t);
+  for(i=0; i<n_profiles; i++) {
+    hdr.n_groups += profiles[i].n_groups;
+    hdr.n_ranges += profiles[i].n_ranges;
+  }
+
+  if( (fp = fopen(fname, "wb")) == NULL ) {
+    ZF_LOGE("cannot open %s for writing", fname);
+    return -1;
+  }
+
+  fwrite(&hdr, sizeof(hdr), 1, fp);
+
+  first_group = 0;
+  first_range = 0;
+  for(i=0; i<n_profiles; i++) {
+    pgmpi_profile_db_record_t rec;
+    rec.cid = profiles[i].cid;
+    rec.nb_procs = profiles[i].nb_procs;
+    rec.nb_nodes = profiles[i].nb_nodes;
+    rec.ppn = profiles[i].ppn;
+    rec.first_group = first_group;
+    rec.n_groups = profiles[i].n_groups;
+    rec.first_range = first_range;
+    rec.n_ranges = profiles[i].n_ranges;
+    fwrite(&rec, sizeof(rec), 1, fp);
+    first_group += profiles[i].n_groups;
+    first_range += profiles[i].n_ranges;
+  }
+
+  for(i=0; i<n_profiles; i++) {
+    fwrite(profiles[i].group, sizeof(pgmpi_range_group_t), profiles[i].n_groups, fp);
+  }
+  for(i=0; i<n_profiles; i++) {
+    fwrite(profiles[i].range, sizeof(pgmpi_range_t), profiles[i].n_ranges, fp);
+  }
+
+  if( ferror(fp) ) {
+    ZF_LOGE("error writing %s", fname);
+    fclose(fp);
+    return -1;
+  }
+  fclose(fp);
+
+  return 0;
+}
+
+int pgmpi_profile_db_open(const char *fname, pgmpi_profile_db_t *db) {
+  int fd;
+  struct stat st;
+  const pgmpi_profile_db_header_t *hdr;
+  const pgmpi_profile_db_record_t *rec;
+  pgmpi_range_group_t *groups;
+  pgmpi_range_t *ranges;
+  int i;
+
+  db->map = NULL;
+  db->map_size = 0;
+  db->n_profiles = 0;
+  db->profiles = NULL;
+
+  if( (fd = open(fname, O_RDONLY)) < 0 ) {
+    ZF_LOGE("cannot open profile database %s", fname);
+    return -1;
+  }
+  if( fstat(fd, &st) != 0 || st.st_size < sizeof(pgmpi_profile_db_header_t) ) {
+    ZF_LOGE("invalid profile database %s", fname);
+    close(fd);
+    return -1;
+  }
+
+  // read-only shared mapping, ranks on the same node share the pages
+  db->map_size = st.st_size;
+  db->map = mmap(NULL, db->map_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if( db->map == MAP_FAILED ) {
+    ZF_LOGE("cannot map profile database %s", fname);
+    db->map = NULL;
+    return -1;
+  }
+
+  hdr = (const pgmpi_profile_db_header_t *)db->map;
+  if( check_header(hdr, db->map_size) != 0 ) {
+    pgmpi_profile_db_close(db);
+    return -1;
+  }
+
+  rec    = (const pgmpi_profile_db_record_t *)(hdr + 1);
+  groups = (pgmpi_range_group_t *)(rec + hdr->n_profiles);
+  ranges = (pgmpi_range_t *)(groups + hdr->n_groups);
+
+  db->profiles = (pgmpi_profile_t *)calloc(hdr->n_profiles, sizeof(pgmpi_profile_t));
+  for(i=0; i<hdr->n_profiles; i++) {
+    pgmpi_profile_t *p = &db->profiles[i];
+
+    if( rec[i].cid < 0 || rec[i].cid >= NUM_COLLECTIVES ||
+        rec[i].first_group < 0 || rec[i].n_groups < 0 || rec[i].first_group + rec[i].n_groups > hdr->n_groups ||
+        rec[i].first_range < 0 || rec[i].n_ranges < 0 || rec[i].first_range + rec[i].n_ranges > hdr->n_ranges ) {
+      ZF_LOGE("invalid profile record %d in %s", i, fname);
+      pgmpi_profile_db_close(db);
+      return -1;
+    }
+
+    p->cid = (pgmpi_collectives_t)rec[i].cid;
+    p->nb_procs = rec[i].nb_procs;
+    p->nb_nodes = rec[i].nb_nodes;
+    p->ppn = rec[i].ppn;
+    p->n_ranges = rec[i].n_ranges;
+    p->range = ranges + rec[i].first_range;
+    p->n_groups = rec[i].n_groups;
+    p->group = groups + rec[i].first_group;
+    p->is_mapped = 1;
+
+    if( check_profile(p) != 0 ) {
+      ZF_LOGE("invalid profile %d in %s", i, fname);
+      pgmpi_profile_db_close(db);
+      return -1;
+    }
+  }
+  db->n_profiles = hdr->n_profiles;
+
+  ZF_LOGV("mapped %d profiles from %s", db->n_profiles, fname);
+
+  return 0;
+}
+
+void pgmpi_profile_db_close(pgmpi_profile_db_t *db) {
+  free(db->profiles);
+  db->profiles = NULL;
+  db->n_profiles = 0;
+  if( db->map != NULL ) {
+    munmap(db->map, db->map_size);
+    db->map = NULL;
+  }
+  db->map_size = 0;
+}
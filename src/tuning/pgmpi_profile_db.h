@@ -0,0 +1,100 @@
+/*  PGMPITuneLib - Library for Autotuning MPI Collectives using Performance Guidelines
+ *  
+ *  Copyright 2017 Sascha Hunold, Alexandra Carpen-Amarie
+ *      Research Group for Parallel Computing
+ *      Faculty of Informatics
+ *      Vienna University of Technology, Austria
+ *  
+ *  <license>
+ *      This library is free software; you can redistribute it
+ *      and/or modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *  
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *  
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free
+ *      Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *      Boston, MA 02110-1301 USA
+ *  </license>
+ */
+
+
+#ifndef SRC_TUNING_PGMPI_PROFILE_DB_H_
+#define SRC_TUNING_PGMPI_PROFILE_DB_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "pgmpi_profile.h"
+
+/*
+ * binary profile database, one file holding the profiles of all collectives
+ *
+ * layout (native byte order and struct layout of the build):
+ *   header            (int32 fields)
+ *   profile records   [n_profiles] (int32 fields)
+ *   group records     [n_groups]   (pgmpi_range_group_t, int fields)
+ *   range records     [n_ranges]   (pgmpi_range_t, MPI_Count message sizes,
+ *                                   int ids and qualifiers, double effects)
+ *
+ * groups and ranges are stored exactly as in a normalized pgmpi_profile_t,
+ * so the mapped file is used in place without parsing
+ * algorithm ids, datatype and op ids are stored as numbers, so a database
+ * must be created by pgmpi_prf2pdb of the same build
+ */
+
+#define PGMPI_PROFILE_DB_MAGIC   "PGMPIPDB"
+#define PGMPI_PROFILE_DB_VERSION 6
+
+typedef struct {
+  char magic[8];
+  int32_t version;
+  int32_t n_profiles;
+  int32_t n_groups;
+  int32_t n_ranges;
+  int32_t sizeof_range;   /* sanity checks for the record layout */
+  int32_t sizeof_group;
+} pgmpi_profile_db_header_t;
+
+typedef struct {
+  int32_t cid;
+  int32_t nb_procs;
+  int32_t nb_nodes;
+  int32_t ppn;
+  int32_t first_group;
+  int32_t n_groups;
+  int32_t first_range;
+  int32_t n_ranges;
+} pgmpi_profile_db_record_t;
+
+typedef struct {
+  void *map;
+  size_t map_size;
+  int n_profiles;
+  pgmpi_profile_t *profiles;   /* ranges and groups point into map */
+} pgmpi_profile_db_t;
+
+/*!
+  writes normalized profiles to a database file
+  \return 0 on success, -1 on error
+*/
+int pgmpi_profile_db_write(const char *fname, const pgmpi_profile_t *profiles, const int n_profiles);
+
+/*!
+  maps a database file and sets up db->profiles to use it in place
+  the groups and algorithm ids are checked, so a corrupt file is rejected
+  \return 0 on success, -1 if the file cannot be mapped or is invalid
+*/
+int pgmpi_profile_db_open(const char *fname, pgmpi_profile_db_t *db);
+
+/*!
+  unmaps the database, profiles of db must not be used afterwards
+*/
+void pgmpi_profile_db_close(pgmpi_profile_db_t *db);
+
+#endif /* SRC_TUNING_PGMPI_PROFILE_DB_H_ */
@@ -0,0 +1,257 @@
+/*  PGMPITuneLib - Library for Autotuning MPI Collectives using Performance Guidelines
+ *  
+ *  Copyright 2017 Sascha Hunold, Alexandra Carpen-Amarie
+ *      Research Group for Parallel Computing
+ *      Faculty of Informatics
+ *      Vienna University of Technology, Austria
+ *  
+ *  <license>
+ *      This library is free software; you can redistribute it
+ *      and/or modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *  
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *  
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free
+ *      Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *      Boston, MA 02110-1301 USA
+ *  </license>
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <math.h>
+
+#include "pgmpi_tune.h"
+
+#define ZF_LOG_LEVEL MY_ZF_LOG_LEVEL
+#include "log/zf_log.h"
+
+#include "pgmpi_profile_extrapolate.h"
+#include "collectives/collective_modules.h"
+
+static const pgmpi_range_group_t *find_group(const pgmpi_profile_t *profile, const pgmpi_range_group_t *key);
+static int count_group_keys(pgmpi_profile_t **used, const int n_used);
+static int groups_match(pgmpi_profile_t **used, const pgmpi_range_group_t **g, const int n_used);
+static MPI_Count fit_boundary(const double *x, const double *y, const int n, const double x_target, double *ss);
+
+
+/*
+ * \return group of profile with the same qualifiers as key, NULL if there is none
+ */
+static const pgmpi_range_group_t *find_group(const pgmpi_profile_t *profile, const pgmpi_range_group_t *key) {
+  int i;
+
+  for(i=0; i<profile->n_groups; i++) {
+    if( profile->group[i].dtype_id == key->dtype_id && profile->group[i].op_id == key->op_id &&
+        profile->group[i].site_id == key->site_id && profile->group[i].skew_us == key->skew_us ) {
+      return &profile->group[i];
+    }
+  }
+  return NULL;
+}
+
+/*
+ * \return number of distinct qualifier combinations over all profiles
+ */
+static int count_group_keys(pgmpi_profile_t **used, const int n_used) {
+  int i, j, k, n = 0;
+
+  for(i=0; i<n_used; i++) {
+    for(j=0; j<used[i]->n_groups; j++) {
+      const pgmpi_range_group_t *g = &used[i]->group[j];
+      int seen = 0;
+      for(k=0; k<i && !seen; k++) {
+        seen = (find_group(used[k], g) != NULL);
+      }
+      if( !seen ) {
+        n++;
+      }
+    }
+  }
+  return n;
+}
+
+/*
+ * \return 1 if all groups select the same sequence of algorithms
+ */
+static int groups_match(pgmpi_profile_t **used, const pgmpi_range_group_t **g, const int n_used) {
+  int k, r;
+
+  for(k=1; k<n_used; k++) {
+    if( g[k] == NULL || g[k]->n != g[0]->n ) {
+      return 0;
+    }
+    for(r=0; r<g[0]->n; r++) {
+      if( used[k]->range[g[k]->first + r].alg_id != used[0]->range[g[0]->first + r].alg_id ) {
+        return 0;
+      }
+    }
+  }
+  return 1;
+}
+
+/*
+ * least squares fit of y = a + b * x, evaluated at x_target
+ * y is log(msg_size + 1), so that a boundary at 0 stays at 0
+ * \param ss incremented by the sum of squared residuals
+ * \return fitted value as message size
+ */
+static MPI_Count fit_boundary(const double *x, const double *y, const int n, const double x_target, double *ss) {
+  double sx = 0, sy = 0, sxx = 0, sxy = 0;
+  double a, b, d, v;
+  int i;
+
+  for(i=0; i<n; i++) {
+    sx += x[i];
+    sy += y[i];
+    sxx += x[i] * x[i];
+    sxy += x[i] * y[i];
+  }
+  d = n * sxx - sx * sx;
+  b = (d != 0.0) ? (n * sxy - sx * sy) / d : 0.0;
+  a = (sy - b * sx) / n;
+
+  for(i=0; i<n; i++) {
+    double r = y[i] - (a + b * x[i]);
+    *ss += r * r;
+  }
+
+  v = expm1(a + b * x_target);
+  if( v >= (double)LLONG_MAX ) {
+    return LLONG_MAX;
+  }
+  if( v < 0.0 ) {
+    return 0;
+  }
+  return (MPI_Count)(v + 0.5);
+}
+
+int pgmpi_profile_extrapolate(pgmpi_profile_t **profiles, const int n_profiles, const int nb_procs,
+    pgmpi_profile_t *result, double *confidence) {
+  pgmpi_profile_t **used;
+  const pgmpi_range_group_t **g;
+  double *x, *y;
+  double x_target, ss = 0.0;
+  double structure, fit, distance;
+  int n_used = 0, n_boundaries = 0;
+  int n_keys, n_matched = 0, n_dropped = 0;
+  int i, k, r, n;
+
+  *confidence = 0.0;
+
+  used = (pgmpi_profile_t **)malloc(n_profiles * sizeof(pgmpi_profile_t *));
+  for(i=0; i<n_profiles; i++) {
+    if( n_used == 0 || profiles[i]->nb_procs != used[n_used-1]->nb_procs ) {
+      used[n_used++] = profiles[i];
+    }
+  }
+  if( n_used < 2 ) {
+    free(used);
+    return -1;
+  }
+
+  pgmpi_profile_allocate(result, pgmpi_modules_get(used[0]->cid)->mpiname, nb_procs,
+      (used[0]->n_ranges > 0) ? used[0]->n_ranges : 1);
+  n = 0;
+
+  g = (const pgmpi_range_group_t **)malloc(n_used * sizeof(pgmpi_range_group_t *));
+  x = (double *)malloc(n_used * sizeof(double));
+  y = (double *)malloc(n_used * sizeof(double));
+  for(k=0; k<n_used; k++) {
+    x[k] = log((double)used[k]->nb_procs);
+  }
+  x_target = log((double)nb_procs);
+
+  for(i=0; i<used[0]->n_groups; i++) {
+    MPI_Count prev_end = -1;
+
+    g[0] = &used[0]->group[i];
+    for(k=1; k<n_used; k++) {
+      g[k] = find_group(used[k], g[0]);
+    }
+    if( !groups_match(used, g, n_used) ) {
+      ZF_LOGV("cannot extrapolate ranges with qualifiers %d/%d/%d/%d", g[0]->dtype_id, g[0]->op_id, g[0]->site_id,
+          g[0]->skew_us);
+      continue;
+    }
+    n_matched++;
+
+    for(r=0; r<g[0]->n; r++) {
+      pgmpi_range_t *range = &result->range[n];
+      int adjacent = 1;
+
+      *range = used[0]->range[g[0]->first + r];
+      // effects were measured for other process counts
+      range->has_effect = 0;
+
+      for(k=0; k<n_used; k++) {
+        const pgmpi_range_t *rk = &used[k]->range[g[k]->first + r];
+        y[k] = log1p((double)rk->msg_size_start);
+        if( r == 0 || used[k]->range[g[k]->first + r - 1].msg_size_end + 1 != rk->msg_size_start ) {
+          adjacent = 0;
+        }
+      }
+      range->msg_size_start = fit_boundary(x, y, n_used, x_target, &ss);
+      // ranges that touch in all profiles still touch
+      if( adjacent ) {
+        range->msg_size_start = prev_end + 1;
+      }
+
+      for(k=0; k<n_used; k++) {
+        const pgmpi_range_t *rk = &used[k]->range[g[k]->first + r];
+        y[k] = log1p((double)rk->msg_size_end);
+      }
+      range->msg_size_end = fit_boundary(x, y, n_used, x_target, &ss);
+      n_boundaries += 2 * n_used;
+
+      if( range->msg_size_start <= prev_end ) {
+        range->msg_size_start = prev_end + 1;
+      }
+      if( range->msg_size_start > range->msg_size_end ) {
+        // the fitted boundaries cross, the range vanishes
+        n_dropped++;
+        continue;
+      }
+      prev_end = range->msg_size_end;
+      n++;
+    }
+  }
+
+  result->n_ranges = n;
+  if( pgmpi_profile_normalize(result) != 0 ) {
+    // ranges of different groups cannot overlap, so this should not happen
+    result->n_ranges = 0;
+    n_matched = 0;
+  }
+
+  n_keys = count_group_keys(used, n_used);
+  structure = (n_keys > 0) ? (double)n_matched / n_keys : 1.0;
+  fit = (n_used > 2 && n_boundaries > 0) ? exp(-sqrt(ss / n_boundaries)) : 0.9;
+  if( nb_procs < used[0]->nb_procs || nb_procs > used[n_used-1]->nb_procs ) {
+    double span = log((double)used[n_used-1]->nb_procs / used[0]->nb_procs);
+    double d = (nb_procs < used[0]->nb_procs) ? log((double)used[0]->nb_procs / nb_procs) :
+        log((double)nb_procs / used[n_used-1]->nb_procs);
+    distance = 1.0 / (1.0 + d / (span > log(2.0) ? span : log(2.0)));
+  } else {
+    distance = 1.0;
+  }
+  *confidence = structure * fit * distance * (n_dropped > 0 ? 0.5 : 1.0);
+
+  ZF_LOGV("extrapolated profile of cid %d for p=%d from %d process counts: %d ranges, confidence %.2f",
+      result->cid, nb_procs, n_used, result->n_ranges, *confidence);
+
+  free(g);
+  free(x);
+  free(y);
+  free(used);
+  return 0;
+}
@@ -0,0 +1,56 @@
+/*  PGMPITuneLib - Library for Autotuning MPI Collectives using Performance Guidelines
+ *  
+ *  Copyright 2017 Sascha Hunold, Alexandra Carpen-Amarie
+ *      Research Group for Parallel Computing
+ *      Faculty of Informatics
+ *      Vienna University of Technology, Austria
+ *  
+ *  <license>
+ *      This library is free software; you can redistribute it
+ *      and/or modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *  
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *  
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free
+ *      Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *      Boston, MA 02110-1301 USA
+ *  </license>
+ */
+
+
+#ifndef SRC_TUNING_PGMPI_PROFILE_EXTRAPOLATE_H_
+#define SRC_TUNING_PGMPI_PROFILE_EXTRAPOLATE_H_
+
+#include "pgmpi_profile.h"
+
+#define PGMPI_EXTRAPOLATE_DEFAULT_MIN_CONFIDENCE 0.5
+
+/*!
+  derives a profile for nb_procs processes from normalized profiles of the same
+  collective measured for other process counts
+
+  every boundary of a message size range is fitted as a power law of the number
+  of processes (least squares in log-log space), so crossovers move with p; this
+  requires that all profiles select the same sequence of algorithms in a group
+  of ranges (same qualifiers), other groups are dropped
+
+  the confidence (0..1) is the product of the fraction of groups that could be
+  fitted, the quality of the fit (1 for exact fits; 0.9 if only two process counts
+  were measured and the fit cannot be checked), and a penalty for extrapolating
+  beyond the measured process counts
+
+  \param profiles profiles sorted by nb_procs, only the first profile of each process count is used
+  \param result set to the derived profile (normalized), must be freed with pgmpi_profile_free
+  \param confidence set to the confidence of the derived profile
+  \return 0 on success, -1 if there are fewer than two process counts
+*/
+int pgmpi_profile_extrapolate(pgmpi_profile_t **profiles, const int n_profiles, const int nb_procs,
+    pgmpi_profile_t *result, double *confidence);
+
+#endif /* SRC_TUNING_PGMPI_PROFILE_EXTRAPOLATE_H_ */
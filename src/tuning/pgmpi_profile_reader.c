@@ -37,6 +37,12 @@
 #include "pgmpi_profile_reader.h"
 
 
+static int next_key_value(char *str, char **saveptr, char **key, char **value);
+static int parse_range_qualifiers(char *str, int *dtype_id, int *op_id, int *site_id, int *skew_us,
+    int *fallback_refs, int *n_fallbacks, int *has_effect, double *effect);
+static int parse_ref_list(const char *str, int *refs, int *n_refs);
+static int parse_profile_shape(char *str, int *nb_nodes, int *ppn);
+
 static int can_ignore(char *line) {
   int ret = 0;
 
@@ -57,7 +63,7 @@ static int can_ignore(char *line) {
 
 
 static ssize_t get_next_line(FILE *fp, char **line) {
-  size_t len;
+  size_t len = 0;   // getline reallocates line as needed
   ssize_t read;
 
   do {
@@ -80,6 +86,166 @@ static ssize_t get_next_line(FILE *fp, char **line) {
   return read;
 }
 
+/*
+ * tokenizes "key=value" pairs, pass str on the first call and NULL afterwards
+ * stops at the end of the line or at a comment
+ * \return 1 if a pair was found, 0 otherwise
+ */
+static int next_key_value(char *str, char **saveptr, char **key, char **value) {
+  char *tok;
+
+  while( (tok = strtok_r(str, " \t\r\n", saveptr)) != NULL ) {
+    str = NULL;
+    if( tok[0] == '#' ) {
+      break;
+    }
+    *value = strchr(tok, '=');
+    if( *value == NULL ) {
+      ZF_LOGW("ignoring token \"%s\"", tok);
+      continue;
+    }
+    **value = '\0';
+    (*value)++;
+    *key = tok;
+    return 1;
+  }
+
+  return 0;
+}
+
+/*
+ * comma-separated list of ref ids, e.g. "3,1"
+ * \return 0 on success, -1 if the list is invalid or too long
+ */
+static int parse_ref_list(const char *str, int *refs, int *n_refs) {
+  const char *p = str;
+  char *end;
+
+  *n_refs = 0;
+  while( 1 ) {
+    if( *n_refs == PGMPI_PROFILE_MAX_FALLBACKS ) {
+      return -1;
+    }
+    refs[(*n_refs)++] = (int)strtol(p, &end, 10);
+    if( end == p ) {
+      return -1;
+    }
+    if( *end == '\0' ) {
+      return 0;
+    }
+    if( *end != ',' ) {
+      return -1;
+    }
+    p = end + 1;
+  }
+}
+
+/*
+ * optional qualifiers after the range, e.g. "dtype=MPI_DOUBLE op=MPI_SUM site=0x1a2b3c4d skew=50"
+ * missing keys and "*" mean any datatype/operation/call site/skew
+ * "fallback=3,1" lists the ref ids of algorithms to use if the selected one does not get its buffers
+ * "effect=0.21 ci=0.18,0.24" is the measured benefit over the default and its confidence interval
+ * \param effect set to effect, lower and upper bound if has_effect is set
+ */
+static int parse_range_qualifiers(char *str, int *dtype_id, int *op_id, int *site_id, int *skew_us,
+    int *fallback_refs, int *n_fallbacks, int *has_effect, double *effect) {
+  char *tok, *value;
+  char *saveptr;
+  int has_ci = 0;
+
+  *dtype_id = PGMPI_QUALIFIER_ANY;
+  *op_id    = PGMPI_QUALIFIER_ANY;
+  *site_id  = PGMPI_QUALIFIER_ANY;
+  *skew_us  = PGMPI_QUALIFIER_ANY;
+  *n_fallbacks = 0;
+  *has_effect = 0;
+
+  while( next_key_value(str, &saveptr, &tok, &value) ) {
+    str = NULL;
+    if( strcmp(tok, "dtype") == 0 ) {
+      *dtype_id = pgmpi_qualifier_dtype_id_by_name(value);
+      if( *dtype_id == PGMPI_QUALIFIER_NONE ) {
+        ZF_LOGE("unknown datatype \"%s\"", value);
+        return -1;
+      }
+    } else if( strcmp(tok, "op") == 0 ) {
+      *op_id = pgmpi_qualifier_op_id_by_name(value);
+      if( *op_id == PGMPI_QUALIFIER_NONE ) {
+        ZF_LOGE("unknown operation \"%s\"", value);
+        return -1;
+      }
+    } else if( strcmp(tok, "site") == 0 ) {
+      *site_id = pgmpi_qualifier_site_id_by_name(value);
+      if( *site_id == PGMPI_QUALIFIER_NONE ) {
+        ZF_LOGE("invalid call site \"%s\"", value);
+        return -1;
+      }
+    } else if( strcmp(tok, "skew") == 0 ) {
+      *skew_us = pgmpi_qualifier_skew_by_name(value);
+      if( *skew_us == PGMPI_QUALIFIER_NONE ) {
+        ZF_LOGE("invalid skew \"%s\"", value);
+        return -1;
+      }
+    } else if( strcmp(tok, "fallback") == 0 ) {
+      if( parse_ref_list(value, fallback_refs, n_fallbacks) != 0 ) {
+        ZF_LOGE("invalid fallbacks \"%s\" (at most %d)", value, PGMPI_PROFILE_MAX_FALLBACKS);
+        return -1;
+      }
+    } else if( strcmp(tok, "effect") == 0 ) {
+      if( sscanf(value, "%lf", &effect[0]) != 1 ) {
+        ZF_LOGE("invalid effect \"%s\"", value);
+        return -1;
+      }
+      *has_effect = 1;
+    } else if( strcmp(tok, "ci") == 0 ) {
+      if( sscanf(value, "%lf,%lf", &effect[1], &effect[2]) != 2 ) {
+        ZF_LOGE("invalid confidence interval \"%s\"", value);
+        return -1;
+      }
+      has_ci = 1;
+    } else {
+      ZF_LOGW("ignoring unknown key \"%s\" in range", tok);
+    }
+  }
+
+  if( *has_effect != has_ci ) {
+    ZF_LOGE("effect and ci must be given together");
+    return -1;
+  }
+
+  return 0;
+}
+
+/*
+ * optional node layout after the number of processes, e.g. "nodes=8 ppn=32"
+ * nb_nodes and ppn are 0 if the layout is not declared
+ */
+static int parse_profile_shape(char *str, int *nb_nodes, int *ppn) {
+  char *tok, *value;
+  char *saveptr;
+
+  *nb_nodes = 0;
+  *ppn = 0;
+
+  while( next_key_value(str, &saveptr, &tok, &value) ) {
+    str = NULL;
+    if( strcmp(tok, "nodes") == 0 ) {
+      *nb_nodes = atoi(value);
+    } else if( strcmp(tok, "ppn") == 0 ) {
+      *ppn = atoi(value);
+    } else {
+      ZF_LOGW("ignoring unknown key \"%s\" for number of processes", tok);
+    }
+  }
+
+  if( (*nb_nodes == 0) != (*ppn == 0) ) {
+    ZF_LOGE("nodes and ppn must be given together");
+    return -1;
+  }
+
+  return 0;
+}
+
 /*
  * we use getline, manpage says "standardized in POSIX.1-2008"
  */
@@ -89,7 +255,10 @@ int pgmpi_profile_read(const char *fname, pgmpi_profile_t *profile) {
   FILE *fp;
   int i;
   int nb_procs, n_ranges;
+  int nb_nodes, ppn;
+  int nchars;
   int alg_nb;
+  int range_idx;
 
   //char *line = NULL;
   int linelength = 100;
@@ -118,11 +287,21 @@ int pgmpi_profile_read(const char *fname, pgmpi_profile_t *profile) {
   ZF_LOGV("mpiname=%s", buf);
 
   get_next_line(fp, &line);
-  sscanf(line, "%d", &nb_procs);
+  nchars = 0;
+  sscanf(line, "%d%n", &nb_procs, &nchars);
   ZF_LOGV("nb_procs=%d", nb_procs);
 
   if( nb_procs <= 0) {
     ZF_LOGE("number of procs must be > 0");
+    free(line);
+    fclose(fp);
+    return -1;
+  }
+
+  if( parse_profile_shape(line + nchars, &nb_nodes, &ppn) != 0 ) {
+    ZF_LOGE("invalid node layout in %s", fname);
+    free(line);
+    fclose(fp);
     return -1;
   }
 
@@ -145,19 +324,46 @@ int pgmpi_profile_read(const char *fname, pgmpi_profile_t *profile) {
 
   if( n_ranges <= 0) {
     ZF_LOGE("number of ranges must be > 0");
-    return -1;
+    ret = -1;
+    goto cleanup;
   }
 
   pgmpi_profile_allocate(profile, buf, nb_procs, n_ranges);
 
+  if( nb_nodes > 0 && pgmpi_profile_set_shape(profile, nb_nodes, ppn) != 0 ) {
+    pgmpi_profile_free(profile);
+    profile->range = NULL;
+    profile->n_ranges = 0;
+    ret = -1;
+    goto cleanup;
+  }
+
+  range_idx = 0;
   for(i=0; i<n_ranges; i++) {
-    int ref_id, msg_size_begin, msg_size_end;
+    long long msg_size_begin, msg_size_end;
+    int ref_id;
+    int dtype_id, op_id, site_id, skew_us;
+    int fallback_refs[PGMPI_PROFILE_MAX_FALLBACKS];
+    int n_fallbacks;
+    int has_effect;
+    double effect[3];
     int ref_id_idx = -1;
-    int j;
+    int j, k;
 
     get_next_line(fp, &line);
-    sscanf(line, "%d %d %d", &msg_size_begin, &msg_size_end, &ref_id);
-    ZF_LOGV("range: %d %d %d", msg_size_begin, msg_size_end, ref_id);
+    nchars = 0;
+    sscanf(line, "%lld %lld %d%n", &msg_size_begin, &msg_size_end, &ref_id, &nchars);
+    ZF_LOGV("range: %lld %lld %d", msg_size_begin, msg_size_end, ref_id);
+
+    if( parse_range_qualifiers(line + nchars, &dtype_id, &op_id, &site_id, &skew_us, fallback_refs,
+        &n_fallbacks, &has_effect, effect) != 0 ) {
+      ZF_LOGE("invalid qualifiers for range %d in %s", i, fname);
+      pgmpi_profile_free(profile);
+      profile->range = NULL;
+      profile->n_ranges = 0;
+      ret = -1;
+      goto cleanup;
+    }
 
     for(j=0; j<alg_nb; j++) {
       if( alg_ref_id[j] == ref_id ) {
@@ -168,12 +374,44 @@ int pgmpi_profile_read(const char *fname, pgmpi_profile_t *profile) {
 
     if( ref_id_idx != -1 ) {
       //ZF_LOGV("set alg (%d, %p), for %d", ref_id_idx, alg_names[ref_id_idx], i);
-      pgmpi_profile_set_alg_for_range(profile, i, msg_size_begin, msg_size_end, alg_names[ref_id_idx]);
+      pgmpi_profile_set_alg_for_range(profile, range_idx, msg_size_begin, msg_size_end, alg_names[ref_id_idx]);
+      pgmpi_profile_set_qualifiers_for_range(profile, range_idx, dtype_id, op_id);
+      pgmpi_profile_set_site_for_range(profile, range_idx, site_id);
+      pgmpi_profile_set_skew_for_range(profile, range_idx, skew_us);
+      if( has_effect && pgmpi_profile_set_effect_for_range(profile, range_idx, effect[0], effect[1], effect[2]) != 0 ) {
+        ZF_LOGW("ignoring effect of range %d in %s", i, fname);
+      }
+      for(k=0; k<n_fallbacks; k++) {
+        int fallback_idx = -1;
+        for(j=0; j<alg_nb; j++) {
+          if( alg_ref_id[j] == fallback_refs[k] ) {
+            fallback_idx = j;
+            break;
+          }
+        }
+        if( fallback_idx == -1 ) {
+          ZF_LOGW("cannot find ref id for fallback %d", fallback_refs[k]);
+          continue;
+        }
+        pgmpi_profile_add_fallback_for_range(profile, range_idx, alg_names[fallback_idx]);
+      }
+      range_idx++;
     } else {
       ZF_LOGW("cannot find ref id for %d", ref_id);
     }
   }
+  // ranges with an unknown ref id were skipped
+  profile->n_ranges = range_idx;
+
+  if( pgmpi_profile_normalize(profile) != 0 ) {
+    ZF_LOGE("invalid ranges in profile %s", fname);
+    pgmpi_profile_free(profile);
+    profile->range = NULL;
+    profile->n_ranges = 0;
+    ret = -1;
+  }
 
+cleanup:
   for(i=0; i<alg_nb; i++) {
     free(alg_names[i]);
   }
@@ -239,13 +477,18 @@ int pgmpi_profile_read_many(const char *path, pgmpi_profile_t **profiles, int *n
         strcat(fullpath, "/");
         strcat(fullpath, entry->d_name);
 
-        pgmpi_profile_read(fullpath, &((*profiles)[cur_prof_idx]));
-        cur_prof_idx++;
+        if( pgmpi_profile_read(fullpath, &((*profiles)[cur_prof_idx])) == 0 ) {
+          cur_prof_idx++;
+        } else {
+          ZF_LOGW("ignoring profile %s", fullpath);
+        }
       }
     //}
   }
 
   closedir(dirp);
 
+  *num_profiles = cur_prof_idx;
+
   return ret;
 }
@@ -0,0 +1,128 @@
+/*  PGMPITuneLib - Library for Autotuning MPI Collectives using Performance Guidelines
+ *  
+ *  Copyright 2017 Sascha Hunold, Alexandra Carpen-Amarie
+ *      Research Group for Parallel Computing
+ *      Faculty of Informatics
+ *      Vienna University of Technology, Austria
+ *  
+ *  <license>
+ *      This library is free software; you can redistribute it
+ *      and/or modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *  
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *  
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free
+ *      Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *      Boston, MA 02110-1301 USA
+ *  </license>
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pgmpi_tune.h"
+
+#define ZF_LOG_LEVEL MY_ZF_LOG_LEVEL
+#include "log/zf_log.h"
+
+#include "pgmpi_profile_writer.h"
+#include "collectives/collective_modules.h"
+
+
+int pgmpi_profile_write(const char *fname, const pgmpi_profile_t *profile, const char *header) {
+  FILE *fp;
+  module_t *mod;
+  int *used;
+  int nb_used;
+  int i, j;
+
+  if( fname == NULL || profile == NULL ) {
+    ZF_LOGE("file name or profile is NULL");
+    return -1;
+  }
+
+  mod = pgmpi_modules_get(profile->cid);
+  if( mod == NULL ) {
+    ZF_LOGE("cannot find module with id %d", profile->cid);
+    return -1;
+  }
+
+  if ((fp = fopen(fname, "w")) == NULL) {
+    ZF_LOGE("Can't open %s for writing", fname);
+    return -1;
+  }
+
+  if( header != NULL ) {
+    fprintf(fp, "# %s\n", header);
+  }
+  fprintf(fp, "%s\n", mod->mpiname);
+  if( profile->nb_nodes > 0 ) {
+    fprintf(fp, "%d nodes=%d ppn=%d\n", profile->nb_procs, profile->nb_nodes, profile->ppn);
+  } else {
+    fprintf(fp, "%d\n", profile->nb_procs);
+  }
+
+  // list only the algorithms that are referenced by a range (also as fallback), the alg id serves as ref id
+  used = (int*)calloc(mod->alg_choices->nb_choices, sizeof(int));
+  nb_used = 0;
+  for(i=0; i<mod->alg_choices->nb_choices; i++) {
+    int algid = mod->alg_choices->alg[i].algid;
+    for(j=0; j<profile->n_ranges && !used[i]; j++) {
+      int k;
+      used[i] = (profile->range[j].alg_id == algid);
+      for(k=0; k<profile->range[j].n_fallbacks; k++) {
+        if( profile->range[j].fallback[k] == algid ) {
+          used[i] = 1;
+        }
+      }
+    }
+    nb_used += used[i];
+  }
+  fprintf(fp, "%d\n", nb_used);
+  for(i=0; i<mod->alg_choices->nb_choices; i++) {
+    if( used[i] ) {
+      fprintf(fp, "%d %s\n", mod->alg_choices->alg[i].algid, mod->alg_choices->alg[i].algname);
+    }
+  }
+  free(used);
+
+  fprintf(fp, "%d\n", profile->n_ranges);
+  for(i=0; i<profile->n_ranges; i++) {
+    const pgmpi_range_t *r = &profile->range[i];
+    fprintf(fp, "%lld %lld %d", (long long)r->msg_size_start, (long long)r->msg_size_end, r->alg_id);
+    if( r->dtype_id != PGMPI_QUALIFIER_ANY ) {
+      fprintf(fp, " dtype=%s", pgmpi_qualifier_dtype_name(r->dtype_id));
+    }
+    if( r->op_id != PGMPI_QUALIFIER_ANY ) {
+      fprintf(fp, " op=%s", pgmpi_qualifier_op_name(r->op_id));
+    }
+    if( r->site_id != PGMPI_QUALIFIER_ANY ) {
+      fprintf(fp, " site=0x%08x", r->site_id);
+    }
+    if( r->skew_us != PGMPI_QUALIFIER_ANY ) {
+      fprintf(fp, " skew=%d", r->skew_us);
+    }
+    for(j=0; j<r->n_fallbacks; j++) {
+      fprintf(fp, "%s%d", (j == 0) ? " fallback=" : ",", r->fallback[j]);
+    }
+    if( r->has_effect ) {
+      fprintf(fp, " effect=%.4f ci=%.4f,%.4f", r->effect, r->effect_ci_low, r->effect_ci_high);
+    }
+    fprintf(fp, "\n");
+  }
+
+  if( fclose(fp) != 0 ) {
+    ZF_LOGE("cannot write %s", fname);
+    return -1;
+  }
+
+  return 0;
+}
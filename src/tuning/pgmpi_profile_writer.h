@@ -0,0 +1,41 @@
+/*  PGMPITuneLib - Library for Autotuning MPI Collectives using Performance Guidelines
+ *  
+ *  Copyright 2017 Sascha Hunold, Alexandra Carpen-Amarie
+ *      Research Group for Parallel Computing
+ *      Faculty of Informatics
+ *      Vienna University of Technology, Austria
+ *  
+ *  <license>
+ *      This library is free software; you can redistribute it
+ *      and/or modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *  
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *  
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free
+ *      Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *      Boston, MA 02110-1301 USA
+ *  </license>
+ */
+
+
+#ifndef SRC_TUNING_PGMPI_PROFILE_WRITER_H_
+#define SRC_TUNING_PGMPI_PROFILE_WRITER_H_
+
+
+#include "pgmpi_profile.h"
+
+/*!
+  writes a profile in the text format read by pgmpi_profile_read
+  \param header comment written at the top of the file, may be NULL
+  \return 0 on success, -1 if the file cannot be written
+*/
+int pgmpi_profile_write(const char *fname, const pgmpi_profile_t *profile, const char *header);
+
+
+#endif /* SRC_TUNING_PGMPI_PROFILE_WRITER_H_ */
@@ -0,0 +1,251 @@
+/*  PGMPITuneLib - Library for Autotuning MPI Collectives using Performance Guidelines
+ *  
+ *  Copyright 2017 Sascha Hunold, Alexandra Carpen-Amarie
+ *      Research Group for Parallel Computing
+ *      Faculty of Informatics
+ *      Vienna University of Technology, Austria
+ *  
+ *  <license>
+ *      This library is free software; you can redistribute it
+ *      and/or modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *  
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *  
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free
+ *      Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *      Boston, MA 02110-1301 USA
+ *  </license>
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+#include <mpi.h>
+#include "pgmpi_tune.h"
+
+#define ZF_LOG_LEVEL MY_ZF_LOG_LEVEL
+#include "log/zf_log.h"
+
+#include "pgmpi_range_qualifier.h"
+
+typedef struct {
+  char *name;
+  MPI_Datatype type;
+} dtype_name_t;
+
+typedef struct {
+  char *name;
+  MPI_Op op;
+} op_name_t;
+
+/* ids are indices into these tables, so only append to keep stored ids valid */
+static const dtype_name_t dtype_names[] = {
+    { "MPI_CHAR", MPI_CHAR },
+    { "MPI_SIGNED_CHAR", MPI_SIGNED_CHAR },
+    { "MPI_UNSIGNED_CHAR", MPI_UNSIGNED_CHAR },
+    { "MPI_BYTE", MPI_BYTE },
+    { "MPI_SHORT", MPI_SHORT },
+    { "MPI_UNSIGNED_SHORT", MPI_UNSIGNED_SHORT },
+    { "MPI_INT", MPI_INT },
+    { "MPI_UNSIGNED", MPI_UNSIGNED },
+    { "MPI_LONG", MPI_LONG },
+    { "MPI_UNSIGNED_LONG", MPI_UNSIGNED_LONG },
+    { "MPI_LONG_LONG", MPI_LONG_LONG },
+    { "MPI_UNSIGNED_LONG_LONG", MPI_UNSIGNED_LONG_LONG },
+    { "MPI_FLOAT", MPI_FLOAT },
+    { "MPI_DOUBLE", MPI_DOUBLE },
+    { "MPI_LONG_DOUBLE", MPI_LONG_DOUBLE },
+    { "MPI_C_BOOL", MPI_C_BOOL },
+    { "MPI_INT8_T", MPI_INT8_T },
+    { "MPI_INT16_T", MPI_INT16_T },
+    { "MPI_INT32_T", MPI_INT32_T },
+    { "MPI_INT64_T", MPI_INT64_T },
+    { "MPI_UINT8_T", MPI_UINT8_T },
+    { "MPI_UINT16_T", MPI_UINT16_T },
+    { "MPI_UINT32_T", MPI_UINT32_T },
+    { "MPI_UINT64_T", MPI_UINT64_T },
+    { "MPI_C_FLOAT_COMPLEX", MPI_C_FLOAT_COMPLEX },
+    { "MPI_C_DOUBLE_COMPLEX", MPI_C_DOUBLE_COMPLEX },
+    { "MPI_FLOAT_INT", MPI_FLOAT_INT },
+    { "MPI_DOUBLE_INT", MPI_DOUBLE_INT },
+    { "MPI_LONG_INT", MPI_LONG_INT },
+    { "MPI_2INT", MPI_2INT },
+    { "MPI_SHORT_INT", MPI_SHORT_INT },
+    { "MPI_LONG_DOUBLE_INT", MPI_LONG_DOUBLE_INT }
+};
+
+static const op_name_t op_names[] = {
+    { "MPI_MAX", MPI_MAX },
+    { "MPI_MIN", MPI_MIN },
+    { "MPI_SUM", MPI_SUM },
+    { "MPI_PROD", MPI_PROD },
+    { "MPI_LAND", MPI_LAND },
+    { "MPI_BAND", MPI_BAND },
+    { "MPI_LOR", MPI_LOR },
+    { "MPI_BOR", MPI_BOR },
+    { "MPI_LXOR", MPI_LXOR },
+    { "MPI_BXOR", MPI_BXOR },
+    { "MPI_MAXLOC", MPI_MAXLOC },
+    { "MPI_MINLOC", MPI_MINLOC }
+};
+
+static const int N_DTYPES = sizeof(dtype_names)/sizeof(dtype_name_t);
+static const int N_OPS = sizeof(op_names)/sizeof(op_name_t);
+
+/* pseudo operations for user-defined reductions, ids follow the predefined ones */
+enum {
+  USER_OP_ANY = 0,
+  USER_OP_COMMUTATIVE,
+  USER_OP_NONCOMMUTATIVE
+};
+
+static const char *user_op_names[] = {
+    "user",
+    "user_commutative",
+    "user_noncommutative"
+};
+
+int pgmpi_qualifier_dtype_id_by_name(const char *name) {
+  int i;
+
+  if( strcmp(name, "*") == 0 ) {
+    return PGMPI_QUALIFIER_ANY;
+  }
+  for(i=0; i<N_DTYPES; i++) {
+    if( strcmp(dtype_names[i].name, name) == 0 ) {
+      return i;
+    }
+  }
+  return PGMPI_QUALIFIER_NONE;
+}
+
+int pgmpi_qualifier_op_id_by_name(const char *name) {
+  int i;
+
+  if( strcmp(name, "*") == 0 ) {
+    return PGMPI_QUALIFIER_ANY;
+  }
+  for(i=0; i<N_OPS; i++) {
+    if( strcmp(op_names[i].name, name) == 0 ) {
+      return i;
+    }
+  }
+  for(i=0; i<sizeof(user_op_names)/sizeof(char*); i++) {
+    if( strcmp(user_op_names[i], name) == 0 ) {
+      return N_OPS + i;
+    }
+  }
+  return PGMPI_QUALIFIER_NONE;
+}
+
+int pgmpi_qualifier_site_id_by_name(const char *name) {
+  char *end;
+  unsigned long id;
+
+  if( strcmp(name, "*") == 0 ) {
+    return PGMPI_QUALIFIER_ANY;
+  }
+  id = strtoul(name, &end, 16);
+  if( end == name || *end != '\0' || id > 0x7fffffffUL ) {
+    return PGMPI_QUALIFIER_NONE;
+  }
+  return (int)id;
+}
+
+int pgmpi_qualifier_skew_by_name(const char *name) {
+  char *end;
+  long skew;
+
+  if( strcmp(name, "*") == 0 ) {
+    return PGMPI_QUALIFIER_ANY;
+  }
+  skew = strtol(name, &end, 10);
+  if( end == name || *end != '\0' || skew < 0 || skew > INT_MAX ) {
+    return PGMPI_QUALIFIER_NONE;
+  }
+  return (int)skew;
+}
+
+int pgmpi_qualifier_dtype_id(MPI_Datatype datatype) {
+  int i;
+
+  for(i=0; i<N_DTYPES; i++) {
+    if( dtype_names[i].type == datatype ) {
+      return i;
+    }
+  }
+  return PGMPI_QUALIFIER_NONE;
+}
+
+int pgmpi_qualifier_op_id(MPI_Op op) {
+  int i;
+  int commute;
+
+  if( op == MPI_OP_NULL ) {
+    return PGMPI_QUALIFIER_NONE;
+  }
+  for(i=0; i<N_OPS; i++) {
+    if( op_names[i].op == op ) {
+      return i;
+    }
+  }
+
+  MPI_Op_commutative(op, &commute);
+  return N_OPS + (commute ? USER_OP_COMMUTATIVE : USER_OP_NONCOMMUTATIVE);
+}
+
+const char *pgmpi_qualifier_dtype_name(const int dtype_id) {
+  if( dtype_id == PGMPI_QUALIFIER_ANY ) {
+    return "*";
+  }
+  if( dtype_id >= 0 && dtype_id < N_DTYPES ) {
+    return dtype_names[dtype_id].name;
+  }
+  return NULL;
+}
+
+const char *pgmpi_qualifier_op_name(const int op_id) {
+  if( op_id == PGMPI_QUALIFIER_ANY ) {
+    return "*";
+  }
+  if( op_id >= 0 && op_id < N_OPS ) {
+    return op_names[op_id].name;
+  }
+  if( op_id >= N_OPS && op_id < N_OPS + sizeof(user_op_names)/sizeof(char*) ) {
+    return user_op_names[op_id - N_OPS];
+  }
+  return NULL;
+}
+
+int pgmpi_qualifier_dtype_matches(const int qualifier_id, const int call_id) {
+  return (qualifier_id == PGMPI_QUALIFIER_ANY || qualifier_id == call_id);
+}
+
+int pgmpi_qualifier_op_matches(const int qualifier_id, const int call_id) {
+  if( qualifier_id == PGMPI_QUALIFIER_ANY || qualifier_id == call_id ) {
+    return 1;
+  }
+  // "user" covers both kinds of user-defined operations
+  if( qualifier_id == N_OPS + USER_OP_ANY &&
+      (call_id == N_OPS + USER_OP_COMMUTATIVE || call_id == N_OPS + USER_OP_NONCOMMUTATIVE) ) {
+    return 1;
+  }
+  return 0;
+}
+
+int pgmpi_qualifier_site_matches(const int qualifier_id, const int call_id) {
+  return (qualifier_id == PGMPI_QUALIFIER_ANY || qualifier_id == call_id);
+}
+
+int pgmpi_qualifier_skew_matches(const int qualifier_skew, const int call_skew) {
+  return (qualifier_skew == PGMPI_QUALIFIER_ANY || (call_skew >= 0 && call_skew >= qualifier_skew));
+}
@@ -0,0 +1,108 @@
+/*  PGMPITuneLib - Library for Autotuning MPI Collectives using Performance Guidelines
+ *  
+ *  Copyright 2017 Sascha Hunold, Alexandra Carpen-Amarie
+ *      Research Group for Parallel Computing
+ *      Faculty of Informatics
+ *      Vienna University of Technology, Austria
+ *  
+ *  <license>
+ *      This library is free software; you can redistribute it
+ *      and/or modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *  
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *  
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free
+ *      Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *      Boston, MA 02110-1301 USA
+ *  </license>
+ */
+
+
+#ifndef SRC_TUNING_PGMPI_RANGE_QUALIFIER_H_
+#define SRC_TUNING_PGMPI_RANGE_QUALIFIER_H_
+
+#include <mpi.h>
+
+/*
+ * qualifiers restrict a message size range of a profile to a datatype,
+ * a reduction operation, a call site and/or a minimum arrival skew
+ * datatype and op ids are indices into tables of predefined MPI datatypes and
+ * operations, site ids are the ids of util/pgmpi_callsite.h
+ */
+
+#define PGMPI_QUALIFIER_ANY   -1   /* wildcard used in profiles */
+#define PGMPI_QUALIFIER_NONE  -2   /* call argument without a name, only matches the wildcard */
+
+/*
+ * qualifier ids of a call, matched against the qualifiers of the ranges
+ */
+typedef struct {
+  int dtype_id;
+  int op_id;
+  int site_id;    /* PGMPI_QUALIFIER_NONE without call sites */
+  int skew_us;    /* estimated arrival skew in microseconds, PGMPI_QUALIFIER_NONE if unknown */
+} pgmpi_call_qualifiers_t;
+
+/*!
+  \param name MPI datatype name (e.g., "MPI_DOUBLE") or "*"
+  \return id of the datatype, PGMPI_QUALIFIER_ANY for "*", PGMPI_QUALIFIER_NONE if unknown
+*/
+int pgmpi_qualifier_dtype_id_by_name(const char *name);
+
+/*!
+  \param name MPI operation name (e.g., "MPI_SUM"), "user", "user_commutative",
+              "user_noncommutative" or "*"
+  \return id of the operation, PGMPI_QUALIFIER_ANY for "*", PGMPI_QUALIFIER_NONE if unknown
+*/
+int pgmpi_qualifier_op_id_by_name(const char *name);
+
+/*!
+  \return id of a predefined datatype, PGMPI_QUALIFIER_NONE for derived datatypes
+*/
+int pgmpi_qualifier_dtype_id(MPI_Datatype datatype);
+
+/*!
+  \return id of a predefined operation, the id of "user_commutative" or
+          "user_noncommutative" for user-defined operations, PGMPI_QUALIFIER_NONE for MPI_OP_NULL
+*/
+int pgmpi_qualifier_op_id(MPI_Op op);
+
+/*!
+  \param name call site id as hexadecimal number (e.g., "0x1a2b3c4d") or "*"
+  \return id of the call site, PGMPI_QUALIFIER_ANY for "*", PGMPI_QUALIFIER_NONE if invalid
+*/
+int pgmpi_qualifier_site_id_by_name(const char *name);
+
+/*!
+  \param name minimum arrival skew in microseconds or "*"
+  \return skew, PGMPI_QUALIFIER_ANY for "*", PGMPI_QUALIFIER_NONE if invalid
+*/
+int pgmpi_qualifier_skew_by_name(const char *name);
+
+const char *pgmpi_qualifier_dtype_name(const int dtype_id);
+
+const char *pgmpi_qualifier_op_name(const int op_id);
+
+/*!
+  \param qualifier_id id given in a profile (may be PGMPI_QUALIFIER_ANY)
+  \param call_id id computed for the arguments of a call
+  \return 1 if qualifier_id covers call_id, 0 otherwise
+*/
+int pgmpi_qualifier_dtype_matches(const int qualifier_id, const int call_id);
+
+int pgmpi_qualifier_op_matches(const int qualifier_id, const int call_id);
+
+int pgmpi_qualifier_site_matches(const int qualifier_id, const int call_id);
+
+/*!
+  a skew qualifier covers calls with an estimated skew of at least its value
+*/
+int pgmpi_qualifier_skew_matches(const int qualifier_skew, const int call_skew);
+
+#endif /* SRC_TUNING_PGMPI_RANGE_QUALIFIER_H_ */
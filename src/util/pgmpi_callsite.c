@@ -0,0 +1,379 @@
+/*  PGMPITuneLib - Library for Autotuning MPI Collectives using Performance Guidelines
+ *  
+ *  Copyright 2017 Sascha Hunold, Alexandra Carpen-Amarie
+ *      Research Group for Parallel Computing
+ *      Faculty of Informatics
+ *      Vienna University of Technology, Austria
+ *  
+ *  <license>
+ *      This library is free software; you can redistribute it
+ *      and/or modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *  
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *  
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free
+ *      Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *      Boston, MA 02110-1301 USA
+ *  </license>
+ */
+
+
+#define _GNU_SOURCE   /* dladdr */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <dlfcn.h>
+
+#include "pgmpi_tune.h"
+
+#define ZF_LOG_LEVEL MY_ZF_LOG_LEVEL
+#include "log/zf_log.h"
+
+#include "pgmpi_callsite.h"
+#include "tuning/pgmpi_range_qualifier.h"
+
+typedef struct {
+  int id;
+  char *name;
+} callsite_t;
+
+/*
+ * open addressing with linear probing, maps return addresses to site indices
+ * several addresses may map to the same site (e.g., the same call in a
+ * library that is loaded twice)
+ */
+typedef struct {
+  const void *addr;   /* NULL for empty slots */
+  int index;
+} cache_slot_t;
+
+/*
+ * per-communicator agreement, attached to the communicator as an MPI attribute
+ */
+typedef struct {
+  int disagree;   /* two ranks called from different sites, no site is used anymore */
+} comm_sites_t;
+
+int pgmpi_callsite_enabled = 0;
+
+static callsite_t *sites = NULL;
+static int n_sites = 0;
+static int capacity_sites = 0;
+
+static cache_slot_t *cache = NULL;
+static int cache_size = 0;   /* power of two */
+static int cache_used = 0;
+
+// consecutive calls often come from the same site (e.g., in a loop)
+static const void *last_addr = NULL;
+static int last_index = -1;
+
+static int current_index = -1;
+
+static int comm_keyval = MPI_KEYVAL_INVALID;
+
+static unsigned int hash_addr(const void *addr);
+static uint32_t fnv1a(uint32_t h, const void *data, const size_t len);
+static int resolve_site(const void *addr);
+static void cache_insert(const void *addr, const int index);
+static int comm_sites_delete_fn(MPI_Comm comm, int keyval, void *attribute_val, void *extra_state);
+static comm_sites_t *get_comm_sites(MPI_Comm comm);
+
+
+static unsigned int hash_addr(const void *addr) {
+  uint64_t a = (uint64_t)(uintptr_t)addr;
+
+  a ^= a >> 29;
+  a *= 0x9E3779B97F4A7C15ULL;
+  return (unsigned int)(a >> 32);
+}
+
+static uint32_t fnv1a(uint32_t h, const void *data, const size_t len) {
+  const unsigned char *p = (const unsigned char *)data;
+  size_t i;
+
+  for(i=0; i<len; i++) {
+    h ^= p[i];
+    h *= 16777619U;
+  }
+  return h;
+}
+
+/*
+ * \return index of the site of addr, a new site is added if its id is unknown
+ */
+static int resolve_site(const void *addr) {
+  Dl_info info;
+  const char *object;
+  uint64_t offset;
+  uint32_t h;
+  char name[256];
+  int id, i;
+
+  if( dladdr(addr, &info) != 0 && info.dli_fname != NULL && info.dli_fname[0] != '\0' ) {
+    object = strrchr(info.dli_fname, '/');
+    object = (object != NULL) ? object + 1 : info.dli_fname;
+    offset = (uint64_t)((uintptr_t)addr - (uintptr_t)info.dli_fbase);
+    h = fnv1a(2166136261U, object, strlen(object));
+    h = fnv1a(h, &offset, sizeof(offset));
+    id = (int)(h & 0x7fffffff);
+  } else {
+    // the address differs between ranks and runs, so it cannot key decisions
+    ZF_LOGW("cannot resolve call site %p, calls from it are not keyed by site", addr);
+    object = "?";
+    offset = 0;
+    id = PGMPI_QUALIFIER_NONE;
+  }
+
+  for(i=0; i<n_sites; i++) {
+    if( sites[i].id == id ) {
+      return i;
+    }
+  }
+
+  if( n_sites == capacity_sites ) {
+    capacity_sites = (capacity_sites == 0) ? 16 : 2 * capacity_sites;
+    sites = (callsite_t *)realloc(sites, capacity_sites * sizeof(callsite_t));
+  }
+  snprintf(name, sizeof(name), "%s+0x%llx", object, (unsigned long long)offset);
+  sites[n_sites].id = id;
+  sites[n_sites].name = strdup(name);
+  ZF_LOGV("new call site 0x%08x at %s", id, name);
+
+  return n_sites++;
+}
+
+static void cache_insert(const void *addr, const int index) {
+  unsigned int mask, h;
+
+  // keep the load below 1/2, so that probe sequences stay short
+  if( 2 * (cache_used + 1) > cache_size ) {
+    cache_slot_t *old = cache;
+    int old_size = cache_size;
+    int i;
+
+    cache_size = (cache_size == 0) ? PGMPI_CALLSITE_CACHE_INIT_SIZE : 2 * cache_size;
+    cache = (cache_slot_t *)calloc(cache_size, sizeof(cache_slot_t));
+    cache_used = 0;
+    for(i=0; i<old_size; i++) {
+      if( old[i].addr != NULL ) {
+        cache_insert(old[i].addr, old[i].index);
+      }
+    }
+    free(old);
+  }
+
+  mask = cache_size - 1;
+  h = hash_addr(addr) & mask;
+  while( cache[h].addr != NULL ) {
+    h = (h + 1) & mask;
+  }
+  cache[h].addr = addr;
+  cache[h].index = index;
+  cache_used++;
+}
+
+static int comm_sites_delete_fn(MPI_Comm comm, int keyval, void *attribute_val, void *extra_state) {
+  comm_sites_t *cs = (comm_sites_t *)attribute_val;
+
+  free(cs);
+  return MPI_SUCCESS;
+}
+
+static comm_sites_t *get_comm_sites(MPI_Comm comm) {
+  comm_sites_t *cs = NULL;
+  int flag = 0;
+
+  if( comm_keyval == MPI_KEYVAL_INVALID ) {
+    if( MPI_Comm_create_keyval(MPI_COMM_NULL_COPY_FN, &comm_sites_delete_fn, &comm_keyval, NULL) != MPI_SUCCESS ) {
+      ZF_LOGE("cannot create keyval for call sites");
+      comm_keyval = MPI_KEYVAL_INVALID;
+      return NULL;
+    }
+  }
+
+  MPI_Comm_get_attr(comm, comm_keyval, &cs, &flag);
+  if( flag ) {
+    return cs;
+  }
+
+  cs = (comm_sites_t *)calloc(1, sizeof(comm_sites_t));
+  if( MPI_Comm_set_attr(comm, comm_keyval, cs) != MPI_SUCCESS ) {
+    ZF_LOGE("cannot attach call sites to communicator");
+    comm_sites_delete_fn(comm, comm_keyval, cs, NULL);
+    return NULL;
+  }
+  return cs;
+}
+
+
+int pgmpi_callsite_init(const int enable) {
+  // known sites are kept, as contexts may index their state by site
+  pgmpi_callsite_enabled = enable;
+  return 0;
+}
+
+void pgmpi_callsite_free(void) {
+  void *val;
+  int flag;
+  int i;
+
+  for(i=0; i<n_sites; i++) {
+    free(sites[i].name);
+  }
+  free(sites);
+  sites = NULL;
+  n_sites = 0;
+  capacity_sites = 0;
+
+  free(cache);
+  cache = NULL;
+  cache_size = 0;
+  cache_used = 0;
+
+  last_addr = NULL;
+  last_index = -1;
+  current_index = -1;
+  pgmpi_callsite_enabled = 0;
+
+  if( comm_keyval == MPI_KEYVAL_INVALID ) {
+    return;
+  }
+
+  // attributes of MPI_COMM_WORLD and MPI_COMM_SELF are not necessarily deleted by MPI_Finalize
+  MPI_Comm_get_attr(MPI_COMM_WORLD, comm_keyval, &val, &flag);
+  if( flag ) {
+    MPI_Comm_delete_attr(MPI_COMM_WORLD, comm_keyval);
+  }
+  MPI_Comm_get_attr(MPI_COMM_SELF, comm_keyval, &val, &flag);
+  if( flag ) {
+    MPI_Comm_delete_attr(MPI_COMM_SELF, comm_keyval);
+  }
+
+  MPI_Comm_free_keyval(&comm_keyval);
+}
+
+void pgmpi_callsite_enter(const void *return_addr) {
+  unsigned int mask, h;
+
+  if( return_addr == last_addr ) {
+    current_index = last_index;
+    return;
+  }
+
+  if( cache_size > 0 ) {
+    mask = cache_size - 1;
+    h = hash_addr(return_addr) & mask;
+    while( cache[h].addr != NULL ) {
+      if( cache[h].addr == return_addr ) {
+        current_index = last_index = cache[h].index;
+        last_addr = return_addr;
+        return;
+      }
+      h = (h + 1) & mask;
+    }
+  }
+
+  current_index = last_index = resolve_site(return_addr);
+  last_addr = return_addr;
+  cache_insert(return_addr, current_index);
+}
+
+int pgmpi_callsite_current(void) {
+  return pgmpi_callsite_enabled ? current_index : -1;
+}
+
+int pgmpi_callsite_current_id(void) {
+  if( !pgmpi_callsite_enabled || current_index < 0 ) {
+    return PGMPI_QUALIFIER_NONE;
+  }
+  return sites[current_index].id;
+}
+
+int pgmpi_callsite_agreed_id(MPI_Comm comm) {
+  comm_sites_t *cs;
+  int inter = 0;
+  int id[2], min[2];
+
+  if( !pgmpi_callsite_enabled || current_index < 0 ) {
+    return PGMPI_QUALIFIER_NONE;
+  }
+  MPI_Comm_test_inter(comm, &inter);
+  if( inter ) {
+    return PGMPI_QUALIFIER_NONE;
+  }
+
+  cs = get_comm_sites(comm);
+  if( cs == NULL || cs->disagree ) {
+    return PGMPI_QUALIFIER_NONE;
+  }
+
+  // a memo of agreed sites would let ranks at a known site skip the allreduce
+  // that a rank at a new site enters, so every call compares the sites;
+  // minimum of id and -id gives the minimum and the maximum id in one allreduce
+  // (ids have 31 bits, so -id does not overflow)
+  id[0] = sites[current_index].id;
+  id[1] = -sites[current_index].id;
+  PMPI_Allreduce(id, min, 2, MPI_INT, MPI_MIN, comm);
+  if( min[0] != -min[1] ) {
+    ZF_LOGV("ranks call from different sites (0x%08x to 0x%08x), communicator is not keyed by site anymore",
+        min[0], -min[1]);
+    cs->disagree = 1;
+    return PGMPI_QUALIFIER_NONE;
+  }
+  return id[0];
+}
+
+int pgmpi_callsite_count(void) {
+  return n_sites;
+}
+
+int pgmpi_callsite_get_id(const int index) {
+  if( index < 0 || index >= n_sites ) {
+    return PGMPI_QUALIFIER_NONE;
+  }
+  return sites[index].id;
+}
+
+const char *pgmpi_callsite_get_name(const int index) {
+  if( index < 0 || index >= n_sites ) {
+    return NULL;
+  }
+  return sites[index].name;
+}
+
+int pgmpi_callsite_index_by_id(const int site_id) {
+  int i;
+
+  for(i=0; i<n_sites; i++) {
+    if( sites[i].id == site_id ) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+int pgmpi_callsite_write(const char *fname) {
+  FILE *fp;
+  int i;
+
+  if( (fp = fopen(fname, "w")) == NULL ) {
+    ZF_LOGE("Can't open %s for writing", fname);
+    return -1;
+  }
+  for(i=0; i<n_sites; i++) {
+    fprintf(fp, "0x%08x %s\n", sites[i].id, sites[i].name);
+  }
+  if( fclose(fp) != 0 ) {
+    ZF_LOGE("cannot write %s", fname);
+    return -1;
+  }
+  return 0;
+}
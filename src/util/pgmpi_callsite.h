@@ -0,0 +1,126 @@
+/*  PGMPITuneLib - Library for Autotuning MPI Collectives using Performance Guidelines
+ *  
+ *  Copyright 2017 Sascha Hunold, Alexandra Carpen-Amarie
+ *      Research Group for Parallel Computing
+ *      Faculty of Informatics
+ *      Vienna University of Technology, Austria
+ *  
+ *  <license>
+ *      This library is free software; you can redistribute it
+ *      and/or modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *  
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *  
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free
+ *      Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *      Boston, MA 02110-1301 USA
+ *  </license>
+ */
+
+
+#ifndef SRC_UTIL_PGMPI_CALLSITE_H_
+#define SRC_UTIL_PGMPI_CALLSITE_H_
+
+#include <mpi.h>
+
+/*
+ * call sites identify where the application calls a collective, so that
+ * decisions can be specialized per call site
+ *
+ * a call site is keyed by the return address of the wrapper; its id is a hash
+ * of the name of the object (executable or shared library) containing the
+ * address and the offset of the address in that object, so it is the same
+ * in all runs of the same binary
+ *
+ * ranks may reach the same collective from different sites (e.g., in a
+ * branch on the rank), so decisions use the id the ranks of a communicator
+ * agreed on (pgmpi_callsite_agreed_id)
+ *
+ * ids are non-negative, sites also get a local index in order of first use
+ * addresses that dladdr cannot resolve share one site with id PGMPI_QUALIFIER_NONE
+ */
+
+#define PGMPI_CALLSITE_CACHE_INIT_SIZE 64   /* initial number of slots of the address cache */
+
+extern int pgmpi_callsite_enabled;
+
+/*!
+  to be called in the wrappers (not in helper functions), so that the return
+  address is the one of the wrapper; does nothing unless call sites are enabled
+  wrappers call it again after the mock-up, which may have entered other sites
+*/
+#define PGMPI_CALLSITE_ENTER() \
+  do { \
+    if( pgmpi_callsite_enabled ) { \
+      pgmpi_callsite_enter(__builtin_return_address(0)); \
+    } \
+  } while(0)
+
+/*!
+  may be called again, the sites seen so far keep their index
+  \param enable 1 to key decisions on call sites
+  \return 0 on success, -1 on error
+*/
+int pgmpi_callsite_init(const int enable);
+
+void pgmpi_callsite_free(void);
+
+/*!
+  makes the call site of return_addr the current one, sites seen for the
+  first time are resolved with dladdr
+*/
+void pgmpi_callsite_enter(const void *return_addr);
+
+/*!
+  \return local index of the current call site, -1 if call sites are disabled
+*/
+int pgmpi_callsite_current(void);
+
+/*!
+  the id is local, other ranks may call from other sites
+  \return id of the current call site, PGMPI_QUALIFIER_NONE if call sites are disabled
+*/
+int pgmpi_callsite_current_id(void);
+
+/*!
+  collective over comm: the ranks compare their site ids with an allreduce on
+  every call, as ranks may reach a collective from different sites; once two
+  ranks called from different sites, all later calls on comm get
+  PGMPI_QUALIFIER_NONE without communication, so all ranks take the same
+  branches
+  intercommunicators are not keyed by call site
+  \return id of the current call site if all ranks of comm called from a site
+  with that id, PGMPI_QUALIFIER_NONE otherwise or if call sites are disabled
+*/
+int pgmpi_callsite_agreed_id(MPI_Comm comm);
+
+/*!
+  \return number of call sites seen so far
+*/
+int pgmpi_callsite_count(void);
+
+int pgmpi_callsite_get_id(const int index);
+
+/*!
+  \return object name and offset of the call site, e.g., "a.out+0x11a9"
+*/
+const char *pgmpi_callsite_get_name(const int index);
+
+/*!
+  \return local index of the site with the given id, -1 if not seen
+*/
+int pgmpi_callsite_index_by_id(const int site_id);
+
+/*!
+  writes one line "id name" per call site
+  \return 0 on success, -1 on error
+*/
+int pgmpi_callsite_write(const char *fname);
+
+#endif /* SRC_UTIL_PGMPI_CALLSITE_H_ */
@@ -0,0 +1,270 @@
+/*  PGMPITuneLib - Library for Autotuning MPI Collectives using Performance Guidelines
+ *  
+ *  Copyright 2017 Sascha Hunold, Alexandra Carpen-Amarie
+ *      Research Group for Parallel Computing
+ *      Faculty of Informatics
+ *      Vienna University of Technology, Austria
+ *  
+ *  <license>
+ *      This library is free software; you can redistribute it
+ *      and/or modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *  
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *  
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free
+ *      Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *      Boston, MA 02110-1301 USA
+ *  </license>
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <mpi.h>
+#include "pgmpi_tune.h"
+
+#define ZF_LOG_LEVEL MY_ZF_LOG_LEVEL
+#include "log/zf_log.h"
+
+#include "pgmpi_clock.h"
+
+/*
+ * global time = local time + intercept + slope * local time
+ */
+typedef struct {
+  double intercept;
+  double slope;
+} clock_model_t;
+
+static clock_model_t model = { 0.0, 0.0 };
+
+static int wtime_is_global(void);
+static double model_apply(const clock_model_t *m, const double t);
+static void model_compose(const clock_model_t *outer, const clock_model_t *inner, clock_model_t *result);
+static int serve_pingpongs(const int client, MPI_Comm comm);
+static int learn_model(const int ref, MPI_Comm comm, clock_model_t *m);
+static int sync_leaders(MPI_Comm comm, clock_model_t *m);
+
+
+/*
+ * the attribute is only attached to MPI_COMM_WORLD
+ */
+static int wtime_is_global(void) {
+  int *val;
+  int flag = 0;
+
+  PMPI_Comm_get_attr(MPI_COMM_WORLD, MPI_WTIME_IS_GLOBAL, &val, &flag);
+  return (flag && *val);
+}
+
+static double model_apply(const clock_model_t *m, const double t) {
+  return t + m->intercept + m->slope * t;
+}
+
+/*
+ * result(t) = outer(inner(t))
+ */
+static void model_compose(const clock_model_t *outer, const clock_model_t *inner, clock_model_t *result) {
+  clock_model_t r;
+
+  r.intercept = (1.0 + outer->slope) * inner->intercept + outer->intercept;
+  r.slope = (1.0 + outer->slope) * (1.0 + inner->slope) - 1.0;
+  *result = r;
+}
+
+static int serve_pingpongs(const int client, MPI_Comm comm) {
+  double t_ref;
+  int i;
+
+  for(i=0; i<PGMPI_CLOCK_NB_FITPOINTS * PGMPI_CLOCK_NB_PINGPONGS; i++) {
+    if( PMPI_Recv(NULL, 0, MPI_BYTE, client, 0, comm, MPI_STATUS_IGNORE) != MPI_SUCCESS ) {
+      return -1;
+    }
+    t_ref = PMPI_Wtime();
+    PMPI_Send(&t_ref, 1, MPI_DOUBLE, client, 0, comm);
+  }
+  return 0;
+}
+
+/*
+ * fits the offset to the clock of ref, measured at several points in time
+ * with the round trip of the lowest latency, by least squares; the points are
+ * spread over PGMPI_CLOCK_FIT_SPAN_S, as the error of the drift is about the
+ * error of an offset divided by the span
+ */
+static int learn_model(const int ref, MPI_Comm comm, clock_model_t *m) {
+  double x[PGMPI_CLOCK_NB_FITPOINTS], y[PGMPI_CLOCK_NB_FITPOINTS];
+  double sx = 0, sy = 0, sxx = 0, sxy = 0, d, x0, t_begin;
+  int f, i;
+  const int n = PGMPI_CLOCK_NB_FITPOINTS;
+
+  t_begin = PMPI_Wtime();
+  for(f=0; f<n; f++) {
+    double best_rtt = -1.0;
+    // the reference waits in PMPI_Recv meanwhile
+    while( PMPI_Wtime() < t_begin + f * PGMPI_CLOCK_FIT_SPAN_S / (n - 1) ) {
+    }
+    for(i=0; i<PGMPI_CLOCK_NB_PINGPONGS; i++) {
+      double t_send, t_recv, t_ref;
+      t_send = PMPI_Wtime();
+      PMPI_Send(NULL, 0, MPI_BYTE, ref, 0, comm);
+      if( PMPI_Recv(&t_ref, 1, MPI_DOUBLE, ref, 0, comm, MPI_STATUS_IGNORE) != MPI_SUCCESS ) {
+        return -1;
+      }
+      t_recv = PMPI_Wtime();
+      if( best_rtt < 0.0 || t_recv - t_send < best_rtt ) {
+        best_rtt = t_recv - t_send;
+        x[f] = (t_send + t_recv) / 2.0;
+        y[f] = t_ref - x[f];
+      }
+    }
+  }
+
+  // centered, as the timestamps are large compared to their differences
+  x0 = x[0];
+  for(f=0; f<n; f++) {
+    sx += x[f] - x0;
+    sy += y[f];
+    sxx += (x[f] - x0) * (x[f] - x0);
+    sxy += (x[f] - x0) * y[f];
+  }
+  d = n * sxx - sx * sx;
+  m->slope = (d > 0.0) ? (n * sxy - sx * sy) / d : 0.0;
+  m->intercept = (sy - m->slope * sx) / n - m->slope * x0;
+
+  ZF_LOGV("clock model to rank %d: offset %g s, drift %g", ref, m->intercept + m->slope * x[n - 1], m->slope);
+  return 0;
+}
+
+/*
+ * HCA-like: in round k, the leader i with i % 2^(k+1) == 2^k learns its model
+ * to leader i - 2^k; the models are then composed from rank 0 downwards
+ */
+static int sync_leaders(MPI_Comm comm, clock_model_t *m) {
+  clock_model_t to_ref, ref_model;
+  int rank, size, step, ref = -1;
+
+  PMPI_Comm_rank(comm, &rank);
+  PMPI_Comm_size(comm, &size);
+
+  m->intercept = 0.0;
+  m->slope = 0.0;
+  to_ref = *m;
+
+  for(step=1; step<size; step*=2) {
+    if( rank % (2 * step) == step ) {
+      ref = rank - step;
+      if( learn_model(ref, comm, &to_ref) != 0 ) {
+        return -1;
+      }
+    } else if( rank % (2 * step) == 0 && rank + step < size ) {
+      if( serve_pingpongs(rank + step, comm) != 0 ) {
+        return -1;
+      }
+    }
+  }
+
+  // the models of the references are final in reverse order of the rounds
+  for(step/=2; step>=1; step/=2) {
+    if( rank % (2 * step) == step ) {
+      if( PMPI_Recv(&ref_model, 2, MPI_DOUBLE, ref, 1, comm, MPI_STATUS_IGNORE) != MPI_SUCCESS ) {
+        return -1;
+      }
+      model_compose(&ref_model, &to_ref, m);
+    } else if( rank % (2 * step) == 0 && rank + step < size ) {
+      PMPI_Send(m, 2, MPI_DOUBLE, rank + step, 1, comm);
+    }
+  }
+
+  return 0;
+}
+
+int pgmpi_clock_sync(MPI_Comm comm) {
+  MPI_Comm node_comm;
+  int rank;
+  int ret;
+
+  model.intercept = 0.0;
+  model.slope = 0.0;
+  if( wtime_is_global() ) {
+    ZF_LOGV("MPI_Wtime is global, no clock synchronization");
+    return 0;
+  }
+
+  PMPI_Comm_rank(comm, &rank);
+  if( PMPI_Comm_split_type(comm, MPI_COMM_TYPE_SHARED, rank, MPI_INFO_NULL, &node_comm) != MPI_SUCCESS ) {
+    return -1;
+  }
+  ret = pgmpi_clock_sync_nodes(comm, node_comm);
+  PMPI_Comm_free(&node_comm);
+  return ret;
+}
+
+int pgmpi_clock_sync_nodes(MPI_Comm comm, MPI_Comm node_comm) {
+  MPI_Comm leader_comm;
+  int rank, local_rank;
+  int ret = 0;
+
+  model.intercept = 0.0;
+  model.slope = 0.0;
+
+  PMPI_Comm_rank(comm, &rank);
+  PMPI_Comm_rank(node_comm, &local_rank);
+
+  // the leaders are the processes with the lowest rank on their node, rank 0 is leader 0
+  PMPI_Comm_split(comm, (local_rank == 0) ? 0 : MPI_UNDEFINED, rank, &leader_comm);
+  if( leader_comm != MPI_COMM_NULL ) {
+    ret = sync_leaders(leader_comm, &model);
+    PMPI_Comm_free(&leader_comm);
+  }
+
+  PMPI_Bcast(&ret, 1, MPI_INT, 0, node_comm);
+  PMPI_Bcast(&model, 2, MPI_DOUBLE, 0, node_comm);
+
+  ZF_LOGV("clock offset %g s, drift %g", pgmpi_clock_offset(), model.slope);
+  return ret;
+}
+
+double pgmpi_global_time(void) {
+  return model_apply(&model, PMPI_Wtime());
+}
+
+double pgmpi_clock_offset(void) {
+  const double t = PMPI_Wtime();
+  return model_apply(&model, t) - t;
+}
+
+void pgmpi_clock_window_init(pgmpi_clock_window_t *w, const double window, const double delay, MPI_Comm comm) {
+  int rank;
+
+  PMPI_Comm_rank(comm, &rank);
+  if( rank == 0 ) {
+    w->t_first = pgmpi_global_time() + delay;
+  }
+  PMPI_Bcast(&w->t_first, 1, MPI_DOUBLE, 0, comm);
+  w->window = window;
+  w->next = 0;
+}
+
+int pgmpi_clock_window_wait(pgmpi_clock_window_t *w, double *t_start) {
+  double now;
+  int late;
+
+  *t_start = w->t_first + w->next * w->window;
+  w->next++;
+
+  // a process that arrives after the start of the window (e.g., as the previous repetition overran) is late
+  now = pgmpi_global_time();
+  late = (now > *t_start);
+  while( now < *t_start ) {
+    now = pgmpi_global_time();
+  }
+  return late;
+}
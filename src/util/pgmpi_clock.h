@@ -0,0 +1,98 @@
+/*  PGMPITuneLib - Library for Autotuning MPI Collectives using Performance Guidelines
+ *  
+ *  Copyright 2017 Sascha Hunold, Alexandra Carpen-Amarie
+ *      Research Group for Parallel Computing
+ *      Faculty of Informatics
+ *      Vienna University of Technology, Austria
+ *  
+ *  <license>
+ *      This library is free software; you can redistribute it
+ *      and/or modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *  
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *  
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free
+ *      Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *      Boston, MA 02110-1301 USA
+ *  </license>
+ */
+
+
+#ifndef SRC_UTIL_PGMPI_CLOCK_H_
+#define SRC_UTIL_PGMPI_CLOCK_H_
+
+#include <mpi.h>
+
+/*
+ * global clock, synchronized with rank 0 of a communicator, so that timestamps
+ * taken on different processes can be compared
+ *
+ * the synchronization is hierarchical: the first process of every node learns
+ * a linear model (offset and drift) of its clock against the clock of rank 0
+ * (as in HCA, the node leaders are paired in a binomial tree and the models
+ * are composed along the tree); the other processes of a node share the clock
+ * and thus the model of their leader
+ */
+
+#define PGMPI_CLOCK_NB_PINGPONGS 10   /* round trips per fit point, the fastest one is used */
+#define PGMPI_CLOCK_NB_FITPOINTS 8    /* offset measurements to fit the drift */
+#define PGMPI_CLOCK_FIT_SPAN_S   0.1  /* the fit points are spread over this time, short spans give noisy drifts */
+
+/*
+ * common start of repetitions at global instants: repetition i starts at
+ * t_first + i * window on all processes
+ */
+typedef struct {
+  double t_first;
+  double window;
+  int next;        /* repetition started by the next call to pgmpi_clock_window_wait */
+} pgmpi_clock_window_t;
+
+/*!
+  learns the model of the local clock, collective over comm;
+  if MPI_Wtime is global, the model is the identity
+  \return 0 on success, -1 on error
+*/
+int pgmpi_clock_sync(MPI_Comm comm);
+
+/*!
+  as pgmpi_clock_sync, but the processes that share a clock are given
+  (e.g., to treat the processes of a node as several nodes), and the models
+  are learned even if MPI_Wtime is global
+  \param node_comm processes of comm that share the clock of the caller, in the order of comm;
+         its rank 0 is the leader, and rank 0 of comm must be a leader
+  \return 0 on success, -1 on error
+*/
+int pgmpi_clock_sync_nodes(MPI_Comm comm, MPI_Comm node_comm);
+
+/*!
+  \return local time corrected by the model, in seconds
+*/
+double pgmpi_global_time(void);
+
+/*!
+  \return current offset of the global to the local time
+*/
+double pgmpi_clock_offset(void);
+
+/*!
+  sets the first window to start delay seconds from now (on rank 0 of comm),
+  collective over comm, the clocks must have been synchronized with pgmpi_clock_sync
+  \param window length of a window in seconds
+*/
+void pgmpi_clock_window_init(pgmpi_clock_window_t *w, const double window, const double delay, MPI_Comm comm);
+
+/*!
+  busy-waits for the start of the next window
+  \param t_start set to the start of the window (global time)
+  \return 0 if the window had not yet started, 1 if the process is late
+*/
+int pgmpi_clock_window_wait(pgmpi_clock_window_t *w, double *t_start);
+
+#endif /* SRC_UTIL_PGMPI_CLOCK_H_ */
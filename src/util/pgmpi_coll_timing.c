@@ -0,0 +1,77 @@
+/*  PGMPITuneLib - Library for Autotuning MPI Collectives using Performance Guidelines
+ *  
+ *  Copyright 2017 Sascha Hunold, Alexandra Carpen-Amarie
+ *      Research Group for Parallel Computing
+ *      Faculty of Informatics
+ *      Vienna University of Technology, Austria
+ *  
+ *  <license>
+ *      This library is free software; you can redistribute it
+ *      and/or modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *  
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *  
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free
+ *      Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *      Boston, MA 02110-1301 USA
+ *  </license>
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <mpi.h>
+#include "pgmpi_tune.h"
+
+#include "pgmpi_coll_timing.h"
+
+
+int pgmpi_coll_call(const pgmpi_collectives_t cid, const int msg_size, void *sbuf, void *rbuf, MPI_Comm comm) {
+  switch( cid ) {
+  case CID_MPI_ALLGATHER:
+    return MPI_Allgather(sbuf, msg_size, MPI_UNSIGNED_CHAR, rbuf, msg_size, MPI_UNSIGNED_CHAR, comm);
+  case CID_MPI_ALLREDUCE:
+    return MPI_Allreduce(sbuf, rbuf, msg_size, MPI_UNSIGNED_CHAR, MPI_SUM, comm);
+  case CID_MPI_ALLTOALL:
+    return MPI_Alltoall(sbuf, msg_size, MPI_UNSIGNED_CHAR, rbuf, msg_size, MPI_UNSIGNED_CHAR, comm);
+  case CID_MPI_BCAST:
+    return MPI_Bcast(rbuf, msg_size, MPI_UNSIGNED_CHAR, 0, comm);
+  case CID_MPI_GATHER:
+    return MPI_Gather(sbuf, msg_size, MPI_UNSIGNED_CHAR, rbuf, msg_size, MPI_UNSIGNED_CHAR, 0, comm);
+  case CID_MPI_REDUCE:
+    return MPI_Reduce(sbuf, rbuf, msg_size, MPI_UNSIGNED_CHAR, MPI_SUM, 0, comm);
+  case CID_MPI_REDUCESCATTERBLOCK:
+    return MPI_Reduce_scatter_block(sbuf, rbuf, msg_size, MPI_UNSIGNED_CHAR, MPI_SUM, comm);
+  case CID_MPI_SCAN:
+    return MPI_Scan(sbuf, rbuf, msg_size, MPI_UNSIGNED_CHAR, MPI_SUM, comm);
+  case CID_MPI_SCATTER:
+    return MPI_Scatter(sbuf, msg_size, MPI_UNSIGNED_CHAR, rbuf, msg_size, MPI_UNSIGNED_CHAR, 0, comm);
+  default:
+    return MPI_ERR_OTHER;
+  }
+}
+
+int pgmpi_coll_time_barrier(const pgmpi_collectives_t cid, const int msg_size, const int nrep, void *sbuf, void *rbuf,
+    MPI_Comm comm, double *times) {
+  double *t;
+  int r;
+
+  t = (double *)malloc(nrep * sizeof(double));
+  for(r=0; r<nrep; r++) {
+    PMPI_Barrier(comm);
+    t[r] = PMPI_Wtime();
+    pgmpi_coll_call(cid, msg_size, sbuf, rbuf, comm);
+    t[r] = PMPI_Wtime() - t[r];
+  }
+  PMPI_Allreduce(t, times, nrep, MPI_DOUBLE, MPI_MAX, comm);
+
+  free(t);
+  return nrep;
+}
@@ -0,0 +1,56 @@
+/*  PGMPITuneLib - Library for Autotuning MPI Collectives using Performance Guidelines
+ *  
+ *  Copyright 2017 Sascha Hunold, Alexandra Carpen-Amarie
+ *      Research Group for Parallel Computing
+ *      Faculty of Informatics
+ *      Vienna University of Technology, Austria
+ *  
+ *  <license>
+ *      This library is free software; you can redistribute it
+ *      and/or modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *  
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *  
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free
+ *      Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *      Boston, MA 02110-1301 USA
+ *  </license>
+ */
+
+
+#ifndef SRC_UTIL_PGMPI_COLL_TIMING_H_
+#define SRC_UTIL_PGMPI_COLL_TIMING_H_
+
+#include <mpi.h>
+
+#include "pgmpi_tune.h"
+
+/*
+ * calls and times the collectives in the tools that measure them (pgmpi_bench,
+ * pgchecker); the calls go through the wrappers, so the algorithm is the one
+ * set with the set_algid of the module
+ */
+
+/*!
+  calls the collective with msg_size bytes of MPI_UNSIGNED_CHAR per process
+  (per block for the collectives with one block per process), following the
+  convention of the wrappers; reductions use MPI_SUM, rooted collectives root 0
+  \return result of the call
+*/
+int pgmpi_coll_call(const pgmpi_collectives_t cid, const int msg_size, void *sbuf, void *rbuf, MPI_Comm comm);
+
+/*!
+  the processes leave an MPI_Barrier before every repetition
+  \param times set to the run-time of every repetition, the maximum over all processes
+  \return number of valid repetitions (nrep)
+*/
+int pgmpi_coll_time_barrier(const pgmpi_collectives_t cid, const int msg_size, const int nrep, void *sbuf,
+    void *rbuf, MPI_Comm comm, double *times);
+
+#endif /* SRC_UTIL_PGMPI_COLL_TIMING_H_ */
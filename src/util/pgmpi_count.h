@@ -0,0 +1,56 @@
+/*  PGMPITuneLib - Library for Autotuning MPI Collectives using Performance Guidelines
+ *  
+ *  Copyright 2017 Sascha Hunold, Alexandra Carpen-Amarie
+ *      Research Group for Parallel Computing
+ *      Faculty of Informatics
+ *      Vienna University of Technology, Austria
+ *  
+ *  <license>
+ *      This library is free software; you can redistribute it
+ *      and/or modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *  
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *  
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free
+ *      Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *      Boston, MA 02110-1301 USA
+ *  </license>
+ */
+
+
+#ifndef SRC_UTIL_PGMPI_COUNT_H_
+#define SRC_UTIL_PGMPI_COUNT_H_
+
+#include <limits.h>
+#include <stddef.h>
+#include <mpi.h>
+
+/*
+ * the mock-ups call MPI with int counts and displacements, counts they derive
+ * from the counts of a call (e.g., size * count) may not fit
+ */
+static inline int pgmpi_count_fits_int(const MPI_Count count) {
+  return (count >= 0 && count <= INT_MAX);
+}
+
+/*
+ * bytes of an array with n counts or displacements that a vector mock-up passes
+ * to MPI, if these go up to max_count, the large-count mock-ups of MPI-4 use
+ * MPI_Count counts and MPI_Aint displacements instead of ints
+ */
+static inline size_t pgmpi_count_array_bytes(const MPI_Count max_count, const int n) {
+#if MPI_VERSION >= 4
+  if( !pgmpi_count_fits_int(max_count) ) {
+    return (size_t)n * (sizeof(MPI_Count) > sizeof(MPI_Aint) ? sizeof(MPI_Count) : sizeof(MPI_Aint));
+  }
+#endif
+  return (size_t)n * sizeof(int);
+}
+
+#endif /* SRC_UTIL_PGMPI_COUNT_H_ */
@@ -0,0 +1,56 @@
+/*  PGMPITuneLib - Library for Autotuning MPI Collectives using Performance Guidelines
+ *  
+ *  Copyright 2017 Sascha Hunold, Alexandra Carpen-Amarie
+ *      Research Group for Parallel Computing
+ *      Faculty of Informatics
+ *      Vienna University of Technology, Austria
+ *  
+ *  <license>
+ *      This library is free software; you can redistribute it
+ *      and/or modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *  
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *  
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free
+ *      Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *      Boston, MA 02110-1301 USA
+ *  </license>
+ */
+
+
+
+#ifndef SRC_UTIL_PGMPI_NESTING_H_
+#define SRC_UTIL_PGMPI_NESTING_H_
+
+/*
+ * mock-ups call other collectives, which come back into the wrappers unless
+ * the library uses PMPI; the wrappers count how deeply they are nested, so
+ * that contexts can tell the calls of the application from those of mock-ups
+ */
+
+extern int pgmpi_nesting_depth;
+
+/*!
+  to be called at the entry of each wrapper
+*/
+#define PGMPI_NESTING_ENTER() (pgmpi_nesting_depth++)
+
+/*!
+  to be called before each wrapper returns, after the time has been reported
+*/
+#define PGMPI_NESTING_EXIT() (pgmpi_nesting_depth--)
+
+/*!
+  \return 1 if the current collective was called by a mock-up, 0 if by the application
+*/
+static inline int pgmpi_nesting_is_nested(void) {
+  return pgmpi_nesting_depth > 1;
+}
+
+#endif /* SRC_UTIL_PGMPI_NESTING_H_ */
@@ -0,0 +1,189 @@
+/*  PGMPITuneLib - Library for Autotuning MPI Collectives using Performance Guidelines
+ *  
+ *  Copyright 2017 Sascha Hunold, Alexandra Carpen-Amarie
+ *      Research Group for Parallel Computing
+ *      Faculty of Informatics
+ *      Vienna University of Technology, Austria
+ *  
+ *  <license>
+ *      This library is free software; you can redistribute it
+ *      and/or modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *  
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *  
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free
+ *      Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *      Boston, MA 02110-1301 USA
+ *  </license>
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <mpi.h>
+#include "pgmpi_tune.h"
+
+#define ZF_LOG_LEVEL MY_ZF_LOG_LEVEL
+#include "log/zf_log.h"
+
+#include "pgmpi_pack.h"
+
+static const size_t PACK_BUF_MIN_CAPACITY = 1024;
+
+
+void pgmpi_pack_init(pgmpi_pack_buf_t *buf) {
+  buf->data = NULL;
+  buf->size = 0;
+  buf->capacity = 0;
+  buf->pos = 0;
+}
+
+void pgmpi_pack_free(pgmpi_pack_buf_t *buf) {
+  free(buf->data);
+  pgmpi_pack_init(buf);
+}
+
+void pgmpi_pack_bytes(pgmpi_pack_buf_t *buf, const void *src, const size_t nbytes) {
+  if( buf->size + nbytes > buf->capacity ) {
+    size_t capacity = (buf->capacity < PACK_BUF_MIN_CAPACITY) ? PACK_BUF_MIN_CAPACITY : buf->capacity;
+    while( capacity < buf->size + nbytes ) {
+      capacity *= 2;
+    }
+    buf->data = (char *)realloc(buf->data, capacity);
+    buf->capacity = capacity;
+  }
+  memcpy(buf->data + buf->size, src, nbytes);
+  buf->size += nbytes;
+}
+
+void pgmpi_pack_int(pgmpi_pack_buf_t *buf, const int val) {
+  pgmpi_pack_bytes(buf, &val, sizeof(int));
+}
+
+void pgmpi_pack_count(pgmpi_pack_buf_t *buf, const MPI_Count val) {
+  pgmpi_pack_bytes(buf, &val, sizeof(MPI_Count));
+}
+
+void pgmpi_pack_double(pgmpi_pack_buf_t *buf, const double val) {
+  pgmpi_pack_bytes(buf, &val, sizeof(double));
+}
+
+void pgmpi_pack_string(pgmpi_pack_buf_t *buf, const char *str) {
+  int len = strlen(str);
+  pgmpi_pack_int(buf, len);
+  pgmpi_pack_bytes(buf, str, len);
+}
+
+int pgmpi_unpack_bytes(pgmpi_pack_buf_t *buf, void *dst, const size_t nbytes) {
+  if( buf->pos + nbytes > buf->size ) {
+    ZF_LOGE("cannot unpack %zu bytes, only %zu left", nbytes, buf->size - buf->pos);
+    return -1;
+  }
+  memcpy(dst, buf->data + buf->pos, nbytes);
+  buf->pos += nbytes;
+  return 0;
+}
+
+int pgmpi_unpack_int(pgmpi_pack_buf_t *buf, int *val) {
+  return pgmpi_unpack_bytes(buf, val, sizeof(int));
+}
+
+int pgmpi_unpack_count(pgmpi_pack_buf_t *buf, MPI_Count *val) {
+  return pgmpi_unpack_bytes(buf, val, sizeof(MPI_Count));
+}
+
+int pgmpi_unpack_double(pgmpi_pack_buf_t *buf, double *val) {
+  return pgmpi_unpack_bytes(buf, val, sizeof(double));
+}
+
+int pgmpi_unpack_string(pgmpi_pack_buf_t *buf, char **str) {
+  int len;
+
+  if( pgmpi_unpack_int(buf, &len) != 0 || len < 0 ) {
+    return -1;
+  }
+  *str = (char *)malloc(len + 1);
+  if( pgmpi_unpack_bytes(buf, *str, len) != 0 ) {
+    free(*str);
+    *str = NULL;
+    return -1;
+  }
+  (*str)[len] = '\0';
+  return 0;
+}
+
+void pgmpi_pack_dict(pgmpi_pack_buf_t *buf, const pgmpi_dictionary_t *dict) {
+  int i;
+
+  pgmpi_pack_int(buf, dict->n_elems);
+  for(i=0; i<dict->n_elems; i++) {
+    pgmpi_pack_string(buf, dict->data[i].key);
+    pgmpi_pack_string(buf, dict->data[i].value);
+  }
+}
+
+int pgmpi_unpack_dict(pgmpi_pack_buf_t *buf, pgmpi_dictionary_t *dict) {
+  int i, n;
+
+  if( pgmpi_unpack_int(buf, &n) != 0 ) {
+    return -1;
+  }
+  for(i=0; i<n; i++) {
+    char *key, *val;
+    if( pgmpi_unpack_string(buf, &key) != 0 ) {
+      return -1;
+    }
+    if( pgmpi_unpack_string(buf, &val) != 0 ) {
+      free(key);
+      return -1;
+    }
+    pgmpitune_add_element_to_dict(dict, key, val);
+    free(key);
+    free(val);
+  }
+  return 0;
+}
+
+int pgmpi_pack_bcast(pgmpi_pack_buf_t *buf, const int root, MPI_Comm comm) {
+  int rank;
+  unsigned long nbytes;
+
+  MPI_Comm_rank(comm, &rank);
+
+  nbytes = buf->size;
+  if( PMPI_Bcast(&nbytes, 1, MPI_UNSIGNED_LONG, root, comm) != MPI_SUCCESS ) {
+    ZF_LOGE("cannot broadcast size of packed data");
+    return -1;
+  }
+
+  if( rank != root ) {
+    pgmpi_pack_free(buf);
+    buf->data = (char *)malloc(nbytes > 0 ? nbytes : 1);
+    buf->size = nbytes;
+    buf->capacity = nbytes;
+  }
+
+  // MPI counts are int, large buffers are sent in chunks
+  {
+    size_t off = 0;
+    while( off < nbytes ) {
+      int chunk = (nbytes - off > (size_t)(1 << 30)) ? (1 << 30) : (int)(nbytes - off);
+      if( PMPI_Bcast(buf->data + off, chunk, MPI_BYTE, root, comm) != MPI_SUCCESS ) {
+        ZF_LOGE("cannot broadcast packed data");
+        return -1;
+      }
+      off += chunk;
+    }
+  }
+  buf->pos = 0;
+
+  return 0;
+}
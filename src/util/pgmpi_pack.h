@@ -0,0 +1,91 @@
+/*  PGMPITuneLib - Library for Autotuning MPI Collectives using Performance Guidelines
+ *  
+ *  Copyright 2017 Sascha Hunold, Alexandra Carpen-Amarie
+ *      Research Group for Parallel Computing
+ *      Faculty of Informatics
+ *      Vienna University of Technology, Austria
+ *  
+ *  <license>
+ *      This library is free software; you can redistribute it
+ *      and/or modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *  
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *  
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free
+ *      Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *      Boston, MA 02110-1301 USA
+ *  </license>
+ */
+
+
+#ifndef SRC_UTIL_PGMPI_PACK_H_
+#define SRC_UTIL_PGMPI_PACK_H_
+
+#include <stddef.h>
+#include <mpi.h>
+
+#include "util/keyvalue_store.h"
+
+/*
+ * growable byte buffer used to serialize data that one rank reads from
+ * files and broadcasts to all other ranks
+ */
+typedef struct {
+  char *data;
+  size_t size;      /* number of bytes packed */
+  size_t capacity;
+  size_t pos;       /* read position when unpacking */
+} pgmpi_pack_buf_t;
+
+void pgmpi_pack_init(pgmpi_pack_buf_t *buf);
+
+void pgmpi_pack_free(pgmpi_pack_buf_t *buf);
+
+void pgmpi_pack_bytes(pgmpi_pack_buf_t *buf, const void *src, const size_t nbytes);
+
+void pgmpi_pack_int(pgmpi_pack_buf_t *buf, const int val);
+
+void pgmpi_pack_count(pgmpi_pack_buf_t *buf, const MPI_Count val);
+
+void pgmpi_pack_double(pgmpi_pack_buf_t *buf, const double val);
+
+void pgmpi_pack_string(pgmpi_pack_buf_t *buf, const char *str);
+
+/*!
+  \return 0 on success, -1 if the buffer holds less than nbytes
+*/
+int pgmpi_unpack_bytes(pgmpi_pack_buf_t *buf, void *dst, const size_t nbytes);
+
+int pgmpi_unpack_int(pgmpi_pack_buf_t *buf, int *val);
+
+int pgmpi_unpack_count(pgmpi_pack_buf_t *buf, MPI_Count *val);
+
+int pgmpi_unpack_double(pgmpi_pack_buf_t *buf, double *val);
+
+/*!
+  \param str set to a newly allocated copy of the string
+*/
+int pgmpi_unpack_string(pgmpi_pack_buf_t *buf, char **str);
+
+void pgmpi_pack_dict(pgmpi_pack_buf_t *buf, const pgmpi_dictionary_t *dict);
+
+/*!
+  adds all packed key-value pairs to dict, existing keys are overwritten
+*/
+int pgmpi_unpack_dict(pgmpi_pack_buf_t *buf, pgmpi_dictionary_t *dict);
+
+/*!
+  broadcasts the packed buffer of root, on all other ranks buf is replaced
+  by the received data and rewound for unpacking
+  uses PMPI_Bcast, as MPI_Bcast may be intercepted by a library that is not initialized yet
+  \return 0 on success, -1 on error
+*/
+int pgmpi_pack_bcast(pgmpi_pack_buf_t *buf, const int root, MPI_Comm comm);
+
+#endif /* SRC_UTIL_PGMPI_PACK_H_ */
@@ -134,6 +134,57 @@ void parse_cli_arguments(pgmpi_dictionary_t *dict, int *argc, char ***argv) {
     } else if( strcmp(arg_key, "--ppath") == 0 ) {
       ZF_LOGV("adding profile_path %s", arg_val);
       pgmpitune_add_element_to_dict(dict, "profile_path", arg_val);
+    } else if( strcmp(arg_key, "--pdb") == 0 ) {
+      ZF_LOGV("adding profile_db %s", arg_val);
+      pgmpitune_add_element_to_dict(dict, "profile_db", arg_val);
+    } else if( strcmp(arg_key, "--ppolicy") == 0 ) {
+      ZF_LOGV("adding profile_policy %s", arg_val);
+      pgmpitune_add_element_to_dict(dict, "profile_policy", arg_val);
+    } else if( strcmp(arg_key, "--pconfidence") == 0 ) {
+      ZF_LOGV("adding profile_min_confidence %s", arg_val);
+      pgmpitune_add_element_to_dict(dict, "profile_min_confidence", arg_val);
+    } else if( strcmp(arg_key, "--peffect") == 0 ) {
+      ZF_LOGV("adding profile_min_effect %s", arg_val);
+      pgmpitune_add_element_to_dict(dict, "profile_min_effect", arg_val);
+    } else if( strcmp(arg_key, "--online_trials") == 0 ) {
+      ZF_LOGV("adding online_trials %s", arg_val);
+      pgmpitune_add_element_to_dict(dict, "online_trials", arg_val);
+    } else if( strcmp(arg_key, "--online_out") == 0 ) {
+      ZF_LOGV("adding online_output_path %s", arg_val);
+      pgmpitune_add_element_to_dict(dict, "online_output_path", arg_val);
+    } else if( strcmp(arg_key, "--online_mode") == 0 ) {
+      ZF_LOGV("adding online_mode %s", arg_val);
+      pgmpitune_add_element_to_dict(dict, "online_mode", arg_val);
+    } else if( strcmp(arg_key, "--online_epsilon") == 0 ) {
+      ZF_LOGV("adding online_epsilon %s", arg_val);
+      pgmpitune_add_element_to_dict(dict, "online_epsilon", arg_val);
+    } else if( strcmp(arg_key, "--online_switch_t") == 0 ) {
+      ZF_LOGV("adding online_switch_t %s", arg_val);
+      pgmpitune_add_element_to_dict(dict, "online_switch_t", arg_val);
+    } else if( strcmp(arg_key, "--online_seed") == 0 ) {
+      ZF_LOGV("adding online_seed %s", arg_val);
+      pgmpitune_add_element_to_dict(dict, "online_seed", arg_val);
+    } else if( strcmp(arg_key, "--reload_interval") == 0 ) {
+      ZF_LOGV("adding reload_interval %s", arg_val);
+      pgmpitune_add_element_to_dict(dict, "reload_interval", arg_val);
+    } else if( strcmp(arg_key, "--reload_signal") == 0 ) {
+      ZF_LOGV("adding reload_signal %s", arg_val);
+      pgmpitune_add_element_to_dict(dict, "reload_signal", arg_val);
+    } else if( strcmp(arg_key, "--cost_model") == 0 ) {
+      ZF_LOGV("adding cost_model_file %s", arg_val);
+      pgmpitune_add_element_to_dict(dict, "cost_model_file", arg_val);
+    } else if( strcmp(arg_key, "--dtree") == 0 ) {
+      ZF_LOGV("adding dtree_file %s", arg_val);
+      pgmpitune_add_element_to_dict(dict, "dtree_file", arg_val);
+    } else if( strcmp(arg_key, "--callsites") == 0 ) {
+      ZF_LOGV("adding callsite_mode %s", arg_val);
+      pgmpitune_add_element_to_dict(dict, "callsite_mode", arg_val);
+    } else if( strcmp(arg_key, "--skew_interval") == 0 ) {
+      ZF_LOGV("adding skew_interval %s", arg_val);
+      pgmpitune_add_element_to_dict(dict, "skew_interval", arg_val);
+    } else if( strcmp(arg_key, "--skew_out") == 0 ) {
+      ZF_LOGV("adding skew_output_file %s", arg_val);
+      pgmpitune_add_element_to_dict(dict, "skew_output_file", arg_val);
     }
 
   }
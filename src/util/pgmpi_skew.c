@@ -0,0 +1,275 @@
+/*  PGMPITuneLib - Library for Autotuning MPI Collectives using Performance Guidelines
+ *  
+ *  Copyright 2017 Sascha Hunold, Alexandra Carpen-Amarie
+ *      Research Group for Parallel Computing
+ *      Faculty of Informatics
+ *      Vienna University of Technology, Austria
+ *  
+ *  <license>
+ *      This library is free software; you can redistribute it
+ *      and/or modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *  
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *  
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free
+ *      Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *      Boston, MA 02110-1301 USA
+ *  </license>
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <mpi.h>
+#include "pgmpi_tune.h"
+
+#define ZF_LOG_LEVEL MY_ZF_LOG_LEVEL
+#include "log/zf_log.h"
+
+#include "pgmpi_skew.h"
+#include "pgmpi_clock.h"
+#include "collectives/collective_modules.h"
+#include "tuning/pgmpi_range_qualifier.h"
+
+/*
+ * per-communicator state, attached to the communicator as an MPI attribute
+ */
+typedef struct {
+  unsigned long calls[CID_MARKER_END_DO_NOT_USE_OR_CHANGE];
+  pgmpi_skew_stats_t stat[CID_MARKER_END_DO_NOT_USE_OR_CHANGE];
+} skew_comm_state_t;
+
+/*
+ * sample in flight between entry and exit of a call
+ */
+typedef struct {
+  int active;
+  pgmpi_collectives_t cid;
+  skew_comm_state_t *state;
+  double in[2];     /* entry time, negated entry time */
+  double out[2];    /* latest entry, negated earliest entry */
+  MPI_Request req;
+} skew_sample_t;
+
+int pgmpi_skew_enabled = 0;
+
+static int skew_interval = 0;
+static int skew_keyval = MPI_KEYVAL_INVALID;
+static int depth = 0;                  /* nesting of wrappers, only outermost calls are sampled */
+static int current_us = PGMPI_QUALIFIER_NONE;
+static skew_sample_t sample;
+static pgmpi_skew_stats_t totals[CID_MARKER_END_DO_NOT_USE_OR_CHANGE];   /* all samples of this process */
+
+static int skew_delete_fn(MPI_Comm comm, int keyval, void *attribute_val, void *extra_state);
+static skew_comm_state_t *get_state(MPI_Comm comm);
+static void update_stats(pgmpi_skew_stats_t *stats, const double skew);
+
+
+static int skew_delete_fn(MPI_Comm comm, int keyval, void *attribute_val, void *extra_state) {
+  skew_comm_state_t *state = (skew_comm_state_t *)attribute_val;
+
+  if( sample.active && sample.state == state ) {
+    // cannot happen for valid programs, as a communicator is freed between calls
+    sample.active = 0;
+  }
+  free(state);
+  return MPI_SUCCESS;
+}
+
+static skew_comm_state_t *get_state(MPI_Comm comm) {
+  skew_comm_state_t *state = NULL;
+  int flag = 0;
+
+  if( skew_keyval == MPI_KEYVAL_INVALID ) {
+    return NULL;
+  }
+
+  PMPI_Comm_get_attr(comm, skew_keyval, &state, &flag);
+  if( flag ) {
+    return state;
+  }
+
+  state = (skew_comm_state_t *)calloc(1, sizeof(skew_comm_state_t));
+  if( PMPI_Comm_set_attr(comm, skew_keyval, state) != MPI_SUCCESS ) {
+    ZF_LOGE("cannot attach skew state to communicator");
+    free(state);
+    return NULL;
+  }
+  return state;
+}
+
+static void update_stats(pgmpi_skew_stats_t *stats, const double skew) {
+  if( stats->n_samples == 0 ) {
+    stats->estimate = skew;
+    stats->mean = skew;
+    stats->max = skew;
+  } else {
+    stats->estimate += PGMPI_SKEW_EWMA_WEIGHT * (skew - stats->estimate);
+    stats->mean += (skew - stats->mean) / (stats->n_samples + 1);
+    if( skew > stats->max ) {
+      stats->max = skew;
+    }
+  }
+  stats->last = skew;
+  stats->n_samples++;
+}
+
+
+int pgmpi_skew_init(const int interval) {
+  int ret;
+
+  skew_interval = (interval > 0) ? interval : 0;
+  pgmpi_skew_enabled = (skew_interval > 0);
+  current_us = PGMPI_QUALIFIER_NONE;
+  if( !pgmpi_skew_enabled ) {
+    return 0;
+  }
+
+  if( pgmpi_clock_sync(MPI_COMM_WORLD) != 0 ) {
+    ZF_LOGE("cannot synchronize clocks, skew estimates may be wrong");
+  }
+
+  if( skew_keyval != MPI_KEYVAL_INVALID ) {
+    return 0;
+  }
+  ret = PMPI_Comm_create_keyval(MPI_COMM_NULL_COPY_FN, &skew_delete_fn, &skew_keyval, NULL);
+  if( ret != MPI_SUCCESS ) {
+    ZF_LOGE("cannot create keyval for skew estimation");
+    skew_keyval = MPI_KEYVAL_INVALID;
+    pgmpi_skew_enabled = 0;
+    return -1;
+  }
+  return 0;
+}
+
+void pgmpi_skew_free(void) {
+  void *val;
+  int flag;
+
+  if( sample.active ) {
+    PMPI_Wait(&sample.req, MPI_STATUS_IGNORE);
+    sample.active = 0;
+  }
+  pgmpi_skew_enabled = 0;
+  depth = 0;
+  memset(totals, 0, sizeof(totals));
+
+  if( skew_keyval == MPI_KEYVAL_INVALID ) {
+    return;
+  }
+
+  // attributes of MPI_COMM_WORLD and MPI_COMM_SELF are not necessarily deleted by MPI_Finalize
+  PMPI_Comm_get_attr(MPI_COMM_WORLD, skew_keyval, &val, &flag);
+  if( flag ) {
+    PMPI_Comm_delete_attr(MPI_COMM_WORLD, skew_keyval);
+  }
+  PMPI_Comm_get_attr(MPI_COMM_SELF, skew_keyval, &val, &flag);
+  if( flag ) {
+    PMPI_Comm_delete_attr(MPI_COMM_SELF, skew_keyval);
+  }
+  PMPI_Comm_free_keyval(&skew_keyval);
+  skew_keyval = MPI_KEYVAL_INVALID;
+}
+
+void pgmpi_skew_enter(const pgmpi_collectives_t cid, MPI_Comm comm) {
+  skew_comm_state_t *state;
+  double t;
+
+  t = pgmpi_global_time();
+  if( depth++ > 0 ) {
+    // collective called by a mock-up, its arrival pattern is the one of the outer call
+    return;
+  }
+
+  state = get_state(comm);
+  if( state == NULL ) {
+    current_us = PGMPI_QUALIFIER_NONE;
+    return;
+  }
+
+  if( state->calls[cid]++ % skew_interval == 0 ) {
+    sample.in[0] = t;
+    sample.in[1] = -t;
+    if( PMPI_Iallreduce(sample.in, sample.out, 2, MPI_DOUBLE, MPI_MAX, comm, &sample.req) == MPI_SUCCESS ) {
+      sample.active = 1;
+      sample.cid = cid;
+      sample.state = state;
+    }
+  }
+
+  current_us = (state->stat[cid].n_samples > 0) ? (int)(state->stat[cid].estimate * 1e6 + 0.5) :
+      PGMPI_QUALIFIER_NONE;
+}
+
+void pgmpi_skew_exit(void) {
+  double skew;
+
+  if( depth == 0 || --depth > 0 || !sample.active ) {
+    return;
+  }
+
+  sample.active = 0;
+  if( PMPI_Wait(&sample.req, MPI_STATUS_IGNORE) != MPI_SUCCESS ) {
+    return;
+  }
+  skew = sample.out[0] + sample.out[1];
+  if( skew < 0.0 ) {
+    skew = 0.0;
+  }
+  update_stats(&sample.state->stat[sample.cid], skew);
+  update_stats(&totals[sample.cid], skew);
+  ZF_LOGV("skew sample %g s for cid %d, estimate %g s", skew, sample.cid, sample.state->stat[sample.cid].estimate);
+}
+
+int pgmpi_skew_current_us(void) {
+  return pgmpi_skew_enabled ? current_us : PGMPI_QUALIFIER_NONE;
+}
+
+int pgmpi_skew_get_stats(const pgmpi_collectives_t cid, MPI_Comm comm, pgmpi_skew_stats_t *stats) {
+  skew_comm_state_t *state = NULL;
+  int flag = 0;
+
+  if( skew_keyval == MPI_KEYVAL_INVALID || cid < 0 || cid >= NUM_COLLECTIVES ) {
+    return -1;
+  }
+  PMPI_Comm_get_attr(comm, skew_keyval, &state, &flag);
+  if( !flag || state->stat[cid].n_samples == 0 ) {
+    return -1;
+  }
+  *stats = state->stat[cid];
+  return 0;
+}
+
+int pgmpi_skew_write(const char *fname) {
+  FILE *fp;
+  int i;
+
+  if( (fp = fopen(fname, "w")) == NULL ) {
+    ZF_LOGE("Can't open %s for writing", fname);
+    return -1;
+  }
+  fprintf(fp, "# collective samples last_us mean_us max_us estimate_us\n");
+  for(i=0; i<NUM_COLLECTIVES; i++) {
+    const pgmpi_skew_stats_t *s = &totals[i];
+    module_t *mod;
+    if( s->n_samples == 0 ) {
+      continue;
+    }
+    mod = pgmpi_modules_get(i);
+    fprintf(fp, "%s %d %.3f %.3f %.3f %.3f\n", (mod != NULL) ? mod->mpiname : "?", s->n_samples,
+        s->last * 1e6, s->mean * 1e6, s->max * 1e6, s->estimate * 1e6);
+  }
+  if( fclose(fp) != 0 ) {
+    ZF_LOGE("cannot write %s", fname);
+    return -1;
+  }
+  return 0;
+}
@@ -0,0 +1,100 @@
+/*  PGMPITuneLib - Library for Autotuning MPI Collectives using Performance Guidelines
+ *  
+ *  Copyright 2017 Sascha Hunold, Alexandra Carpen-Amarie
+ *      Research Group for Parallel Computing
+ *      Faculty of Informatics
+ *      Vienna University of Technology, Austria
+ *  
+ *  <license>
+ *      This library is free software; you can redistribute it
+ *      and/or modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *  
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *  
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free
+ *      Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *      Boston, MA 02110-1301 USA
+ *  </license>
+ */
+
+
+#ifndef SRC_UTIL_PGMPI_SKEW_H_
+#define SRC_UTIL_PGMPI_SKEW_H_
+
+#include <mpi.h>
+
+#include "pgmpi_tune.h"
+
+/*
+ * estimates the arrival skew of collectives, i.e., the time between the first
+ * and the last process entering the call
+ *
+ * every skew_interval-th call of a collective on a communicator is sampled:
+ * the entry timestamps (on the synchronized clock) are reduced with a
+ * nonblocking allreduce that is started at the entry and completed at the
+ * exit of the call, so the sample does not synchronize the processes before
+ * the collective; all processes see the same samples and the same estimate
+ */
+
+#define PGMPI_SKEW_EWMA_WEIGHT 0.25   /* weight of a new sample in the estimate */
+
+extern int pgmpi_skew_enabled;
+
+/*!
+  to be called at the entry of each wrapper, before the algorithm is selected
+*/
+#define PGMPI_SKEW_ENTER(cid, comm) \
+  do { \
+    if( pgmpi_skew_enabled ) { \
+      pgmpi_skew_enter(cid, comm); \
+    } \
+  } while(0)
+
+/*!
+  to be called after the collective has completed
+*/
+#define PGMPI_SKEW_EXIT() \
+  do { \
+    if( pgmpi_skew_enabled ) { \
+      pgmpi_skew_exit(); \
+    } \
+  } while(0)
+
+/*!
+  synchronizes the clocks if sampling is enabled, collective over MPI_COMM_WORLD
+  may be called again, statistics are kept
+  \param interval sample every interval-th call of a collective per communicator, 0 disables sampling
+  \return 0 on success, -1 on error
+*/
+int pgmpi_skew_init(const int interval);
+
+void pgmpi_skew_free(void);
+
+void pgmpi_skew_enter(const pgmpi_collectives_t cid, MPI_Comm comm);
+
+void pgmpi_skew_exit(void);
+
+/*!
+  \return estimated skew of the current call (collective and communicator of
+          the last pgmpi_skew_enter) in microseconds, PGMPI_QUALIFIER_NONE if unknown
+*/
+int pgmpi_skew_current_us(void);
+
+/*!
+  \return 0 if stats have been set, -1 if sampling is disabled or comm has no samples of cid
+*/
+int pgmpi_skew_get_stats(const pgmpi_collectives_t cid, MPI_Comm comm, pgmpi_skew_stats_t *stats);
+
+/*!
+  writes the statistics of all samples of this process per collective
+  \return 0 on success, -1 on error
+*/
+int pgmpi_skew_write(const char *fname);
+
+#endif /* SRC_UTIL_PGMPI_SKEW_H_ */
@@ -0,0 +1,203 @@
+/*  PGMPITuneLib - Library for Autotuning MPI Collectives using Performance Guidelines
+ *  
+ *  Copyright 2017 Sascha Hunold, Alexandra Carpen-Amarie
+ *      Research Group for Parallel Computing
+ *      Faculty of Informatics
+ *      Vienna University of Technology, Austria
+ *  
+ *  <license>
+ *      This library is free software; you can redistribute it
+ *      and/or modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *  
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *  
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free
+ *      Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *      Boston, MA 02110-1301 USA
+ *  </license>
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "pgmpi_stats.h"
+
+typedef struct {
+  double value;
+  int sample;   /* 0 for x, 1 for y */
+} ranked_t;
+
+static int compare_doubles(const void *a, const void *b);
+static int compare_ranked(const void *a, const void *b);
+static double quantile(const double *sorted, const int n, const double q);
+static double normal_cdf(const double z);
+static double normal_quantile(const double p);
+
+
+static int compare_doubles(const void *a, const void *b) {
+  const double d1 = *(const double *)a;
+  const double d2 = *(const double *)b;
+  return (d1 > d2) - (d1 < d2);
+}
+
+static int compare_ranked(const void *a, const void *b) {
+  return compare_doubles(&((const ranked_t *)a)->value, &((const ranked_t *)b)->value);
+}
+
+/*
+ * linear interpolation between the closest ranks
+ */
+static double quantile(const double *sorted, const int n, const double q) {
+  const double pos = q * (n - 1);
+  const int i = (int)pos;
+
+  if( i >= n - 1 ) {
+    return sorted[n - 1];
+  }
+  return sorted[i] + (pos - i) * (sorted[i + 1] - sorted[i]);
+}
+
+static double normal_cdf(const double z) {
+  return 0.5 * erfc(-z / sqrt(2.0));
+}
+
+/*
+ * bisection, accurate enough for significance levels
+ */
+static double normal_quantile(const double p) {
+  double lo = -40.0, hi = 40.0;
+  int i;
+
+  for(i=0; i<100; i++) {
+    const double mid = (lo + hi) / 2.0;
+    if( normal_cdf(mid) < p ) {
+      lo = mid;
+    } else {
+      hi = mid;
+    }
+  }
+  return (lo + hi) / 2.0;
+}
+
+
+double pgmpi_stats_median(double *v, const int n) {
+  qsort(v, n, sizeof(double), &compare_doubles);
+  return (n % 2 == 1) ? v[n / 2] : (v[n / 2 - 1] + v[n / 2]) / 2.0;
+}
+
+int pgmpi_stats_filter_outliers(double *v, const int n, const double factor) {
+  double q1, q3, lo, hi;
+  int i, n_kept;
+
+  if( n < 4 ) {
+    qsort(v, n, sizeof(double), &compare_doubles);
+    return n;
+  }
+
+  qsort(v, n, sizeof(double), &compare_doubles);
+  q1 = quantile(v, n, 0.25);
+  q3 = quantile(v, n, 0.75);
+  lo = q1 - factor * (q3 - q1);
+  hi = q3 + factor * (q3 - q1);
+
+  n_kept = 0;
+  for(i=0; i<n; i++) {
+    if( v[i] >= lo && v[i] <= hi ) {
+      v[n_kept++] = v[i];
+    }
+  }
+  return n_kept;
+}
+
+double pgmpi_stats_ranksum_less(const double *x, const int nx, const double *y, const int ny) {
+  const int n = nx + ny;
+  ranked_t *all;
+  double rank_sum_x = 0.0, ties = 0.0;
+  double u, mean, var;
+  int i, j, k;
+
+  if( nx == 0 || ny == 0 ) {
+    return 1.0;
+  }
+
+  all = (ranked_t *)malloc(n * sizeof(ranked_t));
+  for(i=0; i<nx; i++) {
+    all[i].value = x[i];
+    all[i].sample = 0;
+  }
+  for(i=0; i<ny; i++) {
+    all[nx + i].value = y[i];
+    all[nx + i].sample = 1;
+  }
+  qsort(all, n, sizeof(ranked_t), &compare_ranked);
+
+  // tied values get the mean of their ranks
+  for(i=0; i<n; i=j) {
+    double t, rank;
+    j = i + 1;
+    while( j < n && all[j].value == all[i].value ) {
+      j++;
+    }
+    t = j - i;
+    rank = (i + 1 + j) / 2.0;
+    for(k=i; k<j; k++) {
+      if( all[k].sample == 0 ) {
+        rank_sum_x += rank;
+      }
+    }
+    ties += t * t * t - t;
+  }
+  free(all);
+
+  // u counts the pairs with x_i > y_j, it is small if x tends to be smaller
+  u = rank_sum_x - nx * (nx + 1) / 2.0;
+  mean = nx * (double)ny / 2.0;
+  var = nx * (double)ny / 12.0 * ((n + 1) - ties / ((double)n * (n - 1)));
+  if( var <= 0.0 ) {
+    // all values are equal
+    return 1.0;
+  }
+
+  return normal_cdf((u + 0.5 - mean) / sqrt(var));
+}
+
+int pgmpi_stats_shift(const double *x, const int nx, const double *y, const int ny, const double alpha,
+    double *shift, double *low, double *high) {
+  const long n = (long)nx * ny;
+  double *d;
+  long i, j, k;
+
+  if( nx == 0 || ny == 0 ) {
+    return -1;
+  }
+
+  d = (double *)malloc(n * sizeof(double));
+  for(i=0; i<nx; i++) {
+    for(j=0; j<ny; j++) {
+      d[i * ny + j] = y[j] - x[i];
+    }
+  }
+  qsort(d, n, sizeof(double), &compare_doubles);
+
+  *shift = (n % 2 == 1) ? d[n / 2] : (d[n / 2 - 1] + d[n / 2]) / 2.0;
+
+  // the bounds are the k-th smallest and largest differences, k is the critical value of U
+  k = (long)floor(n / 2.0 - normal_quantile(1.0 - alpha) * sqrt(n * (nx + ny + 1) / 12.0));
+  if( k < 1 ) {
+    // too few samples for the level, the interval spans all differences
+    k = 1;
+  }
+  *low = d[k - 1];
+  *high = d[n - k];
+
+  free(d);
+  return 0;
+}
@@ -0,0 +1,64 @@
+/*  PGMPITuneLib - Library for Autotuning MPI Collectives using Performance Guidelines
+ *  
+ *  Copyright 2017 Sascha Hunold, Alexandra Carpen-Amarie
+ *      Research Group for Parallel Computing
+ *      Faculty of Informatics
+ *      Vienna University of Technology, Austria
+ *  
+ *  <license>
+ *      This library is free software; you can redistribute it
+ *      and/or modify it under the terms of the GNU Lesser General Public
+ *      License as published by the Free Software Foundation; either
+ *      version 2.1 of the License, or (at your option) any later version.
+ *  
+ *      This library is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *      Lesser General Public License for more details.
+ *  
+ *      You should have received a copy of the GNU Lesser General Public
+ *      License along with this library; if not, write to the Free
+ *      Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *      Boston, MA 02110-1301 USA
+ *  </license>
+ */
+
+
+#ifndef SRC_UTIL_PGMPI_STATS_H_
+#define SRC_UTIL_PGMPI_STATS_H_
+
+/*
+ * nonparametric statistics on samples of run-times
+ */
+
+#define PGMPI_STATS_OUTLIER_IQR_FACTOR 1.5   /* Tukey's fences */
+
+/*!
+  sorts v
+  \return median of v
+*/
+double pgmpi_stats_median(double *v, const int n);
+
+/*!
+  sorts v and removes the values outside of [q1 - factor * iqr, q3 + factor * iqr]
+  \return number of values kept (at the front of v)
+*/
+int pgmpi_stats_filter_outliers(double *v, const int n, const double factor);
+
+/*!
+  one-sided Wilcoxon rank-sum (Mann-Whitney U) test, normal approximation with
+  correction for ties and continuity
+  \return p-value of the hypothesis that the values of x tend to be smaller than those of y
+*/
+double pgmpi_stats_ranksum_less(const double *x, const int nx, const double *y, const int ny);
+
+/*!
+  Hodges-Lehmann estimate of the shift between y and x (the median of all
+  differences y_j - x_i) and its distribution-free confidence interval
+  \param alpha each bound holds with probability 1 - alpha, i.e., the interval covers 1 - 2 alpha
+  \return 0 on success, -1 if a sample is empty
+*/
+int pgmpi_stats_shift(const double *x, const int nx, const double *y, const int ny, const double alpha,
+    double *shift, double *low, double *high);
+
+#endif /* SRC_UTIL_PGMPI_STATS_H_ */
@@ -0,0 +1,185 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <unistd.h>
+#include <mpi.h>
+
+#include "pgmpi_tune.h"
+#include "util/pgmpi_callsite.h"
+
+/*
+ * the same collective with the same message size is called from two call
+ * sites, a profile restricts one range to the first site
+ * ranks that call from different sites fall back to the ranges without site
+ */
+
+static char dir[64];
+
+static int send[4], recv[4 * 1024];
+
+static void site_a(MPI_Comm comm) {
+  MPI_Allgather(send, 4, MPI_INT, recv, 4, MPI_INT, comm);
+}
+
+static void site_b(void) {
+  MPI_Allgather(send, 4, MPI_INT, recv, 4, MPI_INT, MPI_COMM_WORLD);
+}
+
+static void site_d(MPI_Comm comm) {
+  MPI_Allgather(send, 4, MPI_INT, recv, 4, MPI_INT, comm);
+}
+
+static int get_alg_on(MPI_Comm comm) {
+  int alg_id;
+  pgtune_get_algorithm(CID_MPI_ALLGATHER, 16, MPI_INT, MPI_OP_NULL, comm, &alg_id);
+  return alg_id;
+}
+
+static int get_alg(void) {
+  return get_alg_on(MPI_COMM_WORLD);
+}
+
+static void check_same(int val, const char *what) {
+  int min, max;
+
+  MPI_Allreduce(&val, &min, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+  MPI_Allreduce(&val, &max, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+  if( min != max ) {
+    printf("%s differs between ranks (min %d, max %d)\n", what, min, max);
+    MPI_Abort(MPI_COMM_WORLD, 1);
+  }
+}
+
+static void check_alg(int alg_id, int expected, const char *what) {
+  check_same(alg_id, what);
+  if( alg_id != expected ) {
+    printf("%s: alg %d, expected %d\n", what, alg_id, expected);
+    MPI_Abort(MPI_COMM_WORLD, 1);
+  }
+}
+
+int main(int argc, char *argv[]) {
+  int rank, size;
+  int id_a, id_b;
+  int alg_a, alg_b;
+  char ppath[96], table[96];
+  char fname[128];
+  char *args[3];
+  MPI_Comm dup;
+
+  MPI_Init(&argc, &argv);
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &size);
+  assert( size <= 1024 );
+  MPI_Comm_dup(MPI_COMM_WORLD, &dup);
+
+  if( rank == 0 ) {
+    strcpy(dir, "/tmp/callsitetest1_XXXXXX");
+    assert( mkdtemp(dir) != NULL );
+  }
+  MPI_Bcast(dir, sizeof(dir), MPI_CHAR, 0, MPI_COMM_WORLD);
+
+  args[0] = "callsitetest1";
+  args[1] = "--callsites=on";
+  pgtune_override_argv_parameter(2, args);
+
+  // ids are stable, so they are the same on all ranks
+  site_a(MPI_COMM_WORLD);
+  id_a = pgmpi_callsite_current_id();
+  site_b();
+  id_b = pgmpi_callsite_current_id();
+  assert( id_a >= 0 && id_b >= 0 && id_a != id_b );
+  check_same(id_a, "id of site a");
+  check_same(id_b, "id of site b");
+  site_a(MPI_COMM_WORLD);
+  assert( pgmpi_callsite_current_id() == id_a );
+  assert( pgmpi_callsite_index_by_id(id_a) >= 0 );
+  assert( strstr(pgmpi_callsite_get_name(pgmpi_callsite_index_by_id(id_a)), "callsitetest1+0x") != NULL );
+
+  if( rank == 0 ) {
+    FILE *fp;
+    snprintf(fname, sizeof(fname), "%s/p_allgather.prf", dir);
+    fp = fopen(fname, "w");
+    assert( fp != NULL );
+    fprintf(fp, "MPI_Allgather\n%d\n2\n2 allgather_as_allreduce\n3 allgather_as_alltoall\n2\n", size);
+    fprintf(fp, "16 16 2 site=0x%08x\n16 16 3\n", id_a);
+    fclose(fp);
+  }
+  MPI_Barrier(MPI_COMM_WORLD);
+
+  snprintf(ppath, sizeof(ppath), "--ppath=%s", dir);
+  snprintf(table, sizeof(table), "--callsites=%s/sites.txt", dir);
+  args[1] = ppath;
+  args[2] = table;
+  pgtune_override_argv_parameter(3, args);
+
+  // the decision of the last call site is memoized per communicator, so alternate
+  site_a(MPI_COMM_WORLD);
+  alg_a = get_alg();
+  site_b();
+  alg_b = get_alg();
+  check_alg(alg_a, 2, "site a");
+  check_alg(alg_b, 3, "site b");
+  site_a(MPI_COMM_WORLD);
+  check_alg(get_alg(), 2, "site a again");
+
+  // the first call from a site on a communicator agrees on its id, without
+  // agreement, rank 0 would use the range of site a
+  if( rank == 0 ) {
+    site_a(dup);
+  } else {
+    site_d(dup);
+  }
+  check_alg(get_alg_on(dup), (size > 1) ? 3 : 2, "different sites");
+  site_a(MPI_COMM_WORLD);
+  check_alg(get_alg(), 2, "site a after different sites on another communicator");
+  MPI_Comm_free(&dup);
+
+  // a site known on the communicator on some ranks and new on another one
+  MPI_Comm_dup(MPI_COMM_WORLD, &dup);
+  site_a(dup);
+  check_alg(get_alg_on(dup), 2, "site a on a new communicator");
+  if( rank == 0 ) {
+    site_d(dup);
+  } else {
+    site_a(dup);
+  }
+  check_alg(get_alg_on(dup), 3, "known and new site");
+  MPI_Comm_free(&dup);
+
+  args[2] = "--callsites=off";
+  pgtune_override_argv_parameter(3, args);
+  site_a(MPI_COMM_WORLD);
+  check_alg(get_alg(), 3, "without call sites");
+
+  // the call site table is only written with --callsites=<file>
+  args[2] = table;
+  pgtune_override_argv_parameter(3, args);
+
+  MPI_Finalize();
+
+  if( rank == 0 ) {
+    FILE *fp;
+    char line[256], hex[16];
+    int found = 0;
+
+    snprintf(fname, sizeof(fname), "%s/sites.txt", dir);
+    fp = fopen(fname, "r");
+    assert( fp != NULL );
+    snprintf(hex, sizeof(hex), "0x%08x ", id_a);
+    while( fgets(line, sizeof(line), fp) != NULL ) {
+      if( strncmp(line, hex, strlen(hex)) == 0 ) {
+        found = 1;
+      }
+    }
+    fclose(fp);
+    assert( found );
+    unlink(fname);
+    snprintf(fname, sizeof(fname), "%s/p_allgather.prf", dir);
+    unlink(fname);
+    rmdir(dir);
+    printf("done\n");
+  }
+  return 0;
+}
@@ -0,0 +1,104 @@
+/*
+ * clocktest1.c
+ *
+ *  synchronizes the clocks and checks that the global time is
+ *  consistent across processes and that the windows start in order;
+ *  then treats groups of processes as nodes, so that there are several
+ *  leaders whose drifts are fitted and composed along the tree
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <assert.h>
+#include <mpi.h>
+
+#include "util/pgmpi_clock.h"
+
+#define NB_WINDOWS 10
+#define WINDOW_S 1e-3
+#define MAX_ERROR_S 1e-2   /* loose, the processes may share a core */
+#define DRIFT_WAIT_S 1.0   /* a wrong drift shows up as an offset after some time */
+
+/*
+ * all processes run on the same machine, so the learned offset should stay close to 0
+ * \return 1 if the offset is within MAX_ERROR_S
+ */
+static int check_leaders(const int procs_per_node) {
+  MPI_Comm node_comm;
+  double t_end, offset;
+  int rank, correct = 1;
+
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_split(MPI_COMM_WORLD, rank / procs_per_node, rank, &node_comm);
+  assert( pgmpi_clock_sync_nodes(MPI_COMM_WORLD, node_comm) == 0 );
+  MPI_Comm_free(&node_comm);
+
+  if( rank == 0 ) {
+    assert( pgmpi_clock_offset() == 0.0 );
+  }
+  offset = pgmpi_clock_offset();
+  if( fabs(offset) > MAX_ERROR_S ) {
+    printf("%d: offset %g s with %d processes per node\n", rank, offset, procs_per_node);
+    correct = 0;
+  }
+
+  t_end = MPI_Wtime() + DRIFT_WAIT_S;
+  while( MPI_Wtime() < t_end ) {
+  }
+  offset = pgmpi_clock_offset();
+  if( fabs(offset) > MAX_ERROR_S ) {
+    printf("%d: offset %g s after %g s with %d processes per node\n", rank, offset, DRIFT_WAIT_S, procs_per_node);
+    correct = 0;
+  }
+  return correct;
+}
+
+int main(int argc, char *argv[]) {
+  pgmpi_clock_window_t w;
+  double t, t_min, t_max, t_start, t_prev = 0.0;
+  int rank, i, late, n_late = 0;
+  int correct = 1;
+
+  MPI_Init(&argc, &argv);
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+  assert( pgmpi_clock_sync(MPI_COMM_WORLD) == 0 );
+  if( rank == 0 ) {
+    // rank 0 is the reference
+    assert( pgmpi_clock_offset() == 0.0 );
+  }
+
+  // the global time after leaving a barrier is about the same everywhere
+  MPI_Barrier(MPI_COMM_WORLD);
+  t = pgmpi_global_time();
+  MPI_Allreduce(&t, &t_min, 1, MPI_DOUBLE, MPI_MIN, MPI_COMM_WORLD);
+  MPI_Allreduce(&t, &t_max, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+  if( t_max - t_min > MAX_ERROR_S ) {
+    printf("%d: global times differ by %g s\n", rank, t_max - t_min);
+  }
+
+  pgmpi_clock_window_init(&w, WINDOW_S, 1e-2, MPI_COMM_WORLD);
+  for(i=0; i<NB_WINDOWS; i++) {
+    late = pgmpi_clock_window_wait(&w, &t_start);
+    t = pgmpi_global_time();
+    assert( t >= t_start );
+    assert( i == 0 || fabs(t_start - t_prev - WINDOW_S) < 1e-9 );
+    t_prev = t_start;
+    n_late += late;
+  }
+  assert( w.next == NB_WINDOWS );
+
+  // one leader per process, and two processes per node
+  correct &= check_leaders(1);
+  correct &= check_leaders(2);
+
+  if( correct ) {
+    printf("%d: done (%d late)\n", rank, n_late);
+  } else {
+    printf("%d: incorrect\n", rank);
+  }
+
+  MPI_Finalize();
+  return 0;
+}
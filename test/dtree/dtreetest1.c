@@ -0,0 +1,172 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <mpi.h>
+
+#include "pgmpi_tune.h"
+#include "collectives/collective_modules.h"
+#include "tuning/pgmpi_dtree.h"
+
+/*
+ * run with --dtree=test/dtree/model1.dt on 4 processes
+ * checks the evaluation of the model and the algorithms selected for calls on
+ * MPI_COMM_WORLD, results of the collectives are compared with the PMPI version
+ */
+
+static int expect_alg(pgmpi_collectives_t cid, int msg_size, MPI_Datatype datatype, MPI_Op op, const char *algname) {
+  module_t *mod = pgmpi_modules_get(cid);
+  int alg_id = -1;
+
+  pgtune_get_algorithm(cid, msg_size, datatype, op, MPI_COMM_WORLD, &alg_id);
+  if( alg_id != pgmpi_modules_get_algid_by_algname(mod->alg_choices, algname) ) {
+    printf("%s with %d bytes: alg %d instead of %s\n", mod->mpiname, msg_size, alg_id, algname);
+    return 0;
+  }
+  return 1;
+}
+
+static void user_sum(void *in, void *inout, int *len, MPI_Datatype *datatype) {
+  int i;
+  for(i=0; i<*len; i++) {
+    ((int*)inout)[i] += ((int*)in)[i];
+  }
+}
+
+static int test_model(const char *fname) {
+  pgmpi_dtree_model_t model, model2;
+  pgmpi_pack_buf_t buf;
+  double f[PGMPI_DTREE_NB_FEATURES] = { 4, -1, -1, 0, 4, PGMPI_DTREE_OP_PREDEFINED };
+  int correct = 1;
+
+  pgmpi_dtree_model_init(&model);
+  pgmpi_dtree_model_init(&model2);
+  if( pgmpi_dtree_model_read(fname, &model) != 0 || model.forest[CID_MPI_ALLREDUCE] == NULL ||
+      model.forest[CID_MPI_BCAST] == NULL || model.forest[CID_MPI_GATHER] != NULL ) {
+    printf("cannot read model %s\n", fname);
+    return 0;
+  }
+
+  if( model.forest[CID_MPI_ALLREDUCE]->n_bytes_thresholds != 1 ||
+      pgmpi_dtree_forest_bytes_interval(model.forest[CID_MPI_ALLREDUCE], 1024) != 0 ||
+      pgmpi_dtree_forest_bytes_interval(model.forest[CID_MPI_ALLREDUCE], 1025) != 1 ) {
+    printf("wrong bytes intervals\n");
+    correct = 0;
+  }
+
+  pgmpi_pack_init(&buf);
+  pgmpi_dtree_model_pack(&buf, &model);
+  if( pgmpi_dtree_model_unpack(&buf, &model2) != 0 ) {
+    printf("cannot unpack model\n");
+    correct = 0;
+  } else {
+    // a tie in the ensemble goes to the default algorithm
+    f[PGMPI_DTREE_FEATURE_BYTES] = 100;
+    if( pgmpi_dtree_forest_eval(model2.forest[CID_MPI_BCAST], f) != 0 ) {
+      printf("tie not resolved to default\n");
+      correct = 0;
+    }
+    f[PGMPI_DTREE_FEATURE_P] = 2;
+    f[PGMPI_DTREE_FEATURE_BYTES] = 1000;
+    if( pgmpi_dtree_forest_eval(model2.forest[CID_MPI_BCAST], f) != 0 ) {
+      printf("wrong selection for 2 processes\n");
+      correct = 0;
+    }
+  }
+  pgmpi_pack_free(&buf);
+
+  pgmpi_dtree_model_free(&model);
+  pgmpi_dtree_model_free(&model2);
+  return correct;
+}
+
+static int test_allreduce(int n, MPI_Op op, MPI_Comm comm) {
+  int i, correct = 1;
+  int *sendbuf, *recvbuf, *recvbuf2;
+
+  sendbuf  = (int*) calloc(n, sizeof(int));
+  recvbuf  = (int*) calloc(n, sizeof(int));
+  recvbuf2 = (int*) calloc(n, sizeof(int));
+
+  for (i = 0; i < n; i++) {
+    sendbuf[i] = rand() % 100;
+  }
+  MPI_Allreduce(sendbuf, recvbuf, n, MPI_INT, op, comm);
+  PMPI_Allreduce(sendbuf, recvbuf2, n, MPI_INT, op, comm);
+  for (i = 0; i < n; i++) {
+    if (recvbuf[i] != recvbuf2[i]) {
+      correct = 0;
+    }
+  }
+
+  free(sendbuf);
+  free(recvbuf);
+  free(recvbuf2);
+  return correct;
+}
+
+static int test_bcast(int n, MPI_Comm comm) {
+  int i, rank, correct = 1;
+  char *buf;
+
+  MPI_Comm_rank(comm, &rank);
+  buf = (char*) calloc(n, 1);
+  for (i = 0; i < n; i++) {
+    buf[i] = (rank == 0) ? (char)i : -1;
+  }
+  MPI_Bcast(buf, n, MPI_CHAR, 0, comm);
+  for (i = 0; i < n; i++) {
+    if (buf[i] != (char)i) {
+      correct = 0;
+    }
+  }
+
+  free(buf);
+  return correct;
+}
+
+int main(int argc, char *argv[]) {
+  int rank, size, i, n;
+  int correct = 1;
+  const char *fname = NULL;
+  MPI_Op op;
+
+  MPI_Init(&argc, &argv);
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+  for(i=1; i<argc; i++) {
+    if( strncmp(argv[i], "--dtree=", 8) == 0 ) {
+      fname = argv[i] + 8;
+    }
+  }
+
+  if( rank == 0 && fname != NULL ) {
+    correct = test_model(fname);
+  }
+
+  MPI_Op_create(&user_sum, 1, &op);
+  if( fname != NULL && size == 4 ) {
+    correct &= expect_alg(CID_MPI_ALLREDUCE, 1024, MPI_INT, MPI_SUM, "allreduce_as_reduce_bcast");
+    correct &= expect_alg(CID_MPI_ALLREDUCE, 1025, MPI_INT, MPI_SUM, "default");
+    // same bytes interval, the decision for MPI_SUM must not be reused for a user-defined operation
+    correct &= expect_alg(CID_MPI_ALLREDUCE, 64, MPI_INT, op, "default");
+    correct &= expect_alg(CID_MPI_ALLREDUCE, 64, MPI_INT, MPI_SUM, "allreduce_as_reduce_bcast");
+    correct &= expect_alg(CID_MPI_BCAST, 100, MPI_CHAR, MPI_OP_NULL, "default");
+    correct &= expect_alg(CID_MPI_BCAST, 101, MPI_CHAR, MPI_OP_NULL, "bcast_as_scatter_allgather");
+    correct &= expect_alg(CID_MPI_GATHER, 101, MPI_CHAR, MPI_OP_NULL, "default");
+  }
+
+  for(n=1; n<=(1<<14); n*=8) {
+    if( !test_allreduce(n, MPI_SUM, MPI_COMM_WORLD) || !test_allreduce(n, op, MPI_COMM_WORLD) ||
+        !test_bcast(n, MPI_COMM_WORLD) ) {
+      printf("%d: collectives with count %d wrong\n", rank, n);
+      correct = 0;
+    }
+  }
+
+  MPI_Op_free(&op);
+  printf("%d: %s\n", rank, correct ? "done" : "failed");
+
+  MPI_Finalize();
+  return 0;
+}
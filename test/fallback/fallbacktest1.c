@@ -0,0 +1,130 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <unistd.h>
+#include <mpi.h>
+
+#include "pgmpi_tune.h"
+
+/*
+ * a profile selects allgather_as_allreduce with allgather_as_allgatherv as
+ * fallback; with small message buffers the fallback is used
+ */
+
+#define COUNT 4
+
+static char dir[64];
+
+static int get_alg(const int msg_size) {
+  int alg_id;
+  pgtune_get_algorithm(CID_MPI_ALLGATHER, msg_size, MPI_INT, MPI_OP_NULL, MPI_COMM_WORLD, &alg_id);
+  return alg_id;
+}
+
+static void check_alg(int alg_id, int expected, const char *what) {
+  int min, max;
+
+  MPI_Allreduce(&alg_id, &min, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+  MPI_Allreduce(&alg_id, &max, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+  if( min != max || alg_id != expected ) {
+    printf("%s: alg %d (min %d, max %d), expected %d\n", what, alg_id, min, max, expected);
+    MPI_Abort(MPI_COMM_WORLD, 1);
+  }
+}
+
+static void check_allgather(const int rank, const int size, const char *what) {
+  int send[COUNT], *recv;
+  int i;
+
+  recv = (int *)malloc(size * COUNT * sizeof(int));
+  for(i=0; i<COUNT; i++) {
+    send[i] = rank * COUNT + i;
+  }
+  memset(recv, 0, size * COUNT * sizeof(int));
+  MPI_Allgather(send, COUNT, MPI_INT, recv, COUNT, MPI_INT, MPI_COMM_WORLD);
+  for(i=0; i<size * COUNT; i++) {
+    if( recv[i] != i ) {
+      printf("%s: wrong result at %d (%d)\n", what, i, recv[i]);
+      MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+  }
+  free(recv);
+}
+
+static void write_config(const char *fname, const int msg_bytes, const int int_bytes) {
+  FILE *fp;
+
+  fp = fopen(fname, "w");
+  assert( fp != NULL );
+  fprintf(fp, "# buffers of fallbacktest1\nsize_msg_buffer_bytes %d\nsize_int_buffer_bytes %d\n", msg_bytes, int_bytes);
+  fclose(fp);
+}
+
+int main(int argc, char *argv[]) {
+  int rank, size;
+  char ppath[96], config[96];
+  char fname[128];
+  char *args[3];
+
+  MPI_Init(&argc, &argv);
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &size);
+  assert( size >= 2 );
+
+  if( rank == 0 ) {
+    FILE *fp;
+    strcpy(dir, "/tmp/fallbacktest1_XXXXXX");
+    assert( mkdtemp(dir) != NULL );
+    snprintf(fname, sizeof(fname), "%s/p_allgather.prf", dir);
+    fp = fopen(fname, "w");
+    assert( fp != NULL );
+    fprintf(fp, "MPI_Allgather\n%d\n3\n1 allgather_as_allgatherv\n2 allgather_as_allreduce\n3 allgather_as_alltoall\n2\n", size);
+    fprintf(fp, "1 16 2 fallback=1\n17 1024 3\n");
+    fclose(fp);
+
+    // allreduce needs size * 16 bytes, allgatherv 2 * size ints
+    snprintf(fname, sizeof(fname), "%s/small.cfg", dir);
+    write_config(fname, 8 * size, 2 * size * sizeof(int));
+    snprintf(fname, sizeof(fname), "%s/none.cfg", dir);
+    write_config(fname, 8 * size, 0);
+  }
+  MPI_Bcast(dir, sizeof(dir), MPI_CHAR, 0, MPI_COMM_WORLD);
+
+  snprintf(ppath, sizeof(ppath), "--ppath=%s", dir);
+  args[0] = "fallbacktest1";
+  args[1] = ppath;
+  pgtune_override_argv_parameter(2, args);
+
+  // default buffers are large enough
+  check_alg(get_alg(COUNT * sizeof(int)), 2, "default buffers");
+  check_allgather(rank, size, "default buffers");
+
+  snprintf(config, sizeof(config), "--config=%s/small.cfg", dir);
+  args[2] = config;
+  pgtune_override_argv_parameter(3, args);
+  check_alg(get_alg(COUNT * sizeof(int)), 1, "small message buffers");
+  check_alg(get_alg(2 * sizeof(int)), 2, "small message fits");
+  // no fallback given, the default algorithm is used
+  check_alg(get_alg(64), 0, "range without fallback");
+  check_allgather(rank, size, "small message buffers");
+
+  snprintf(config, sizeof(config), "--config=%s/none.cfg", dir);
+  pgtune_override_argv_parameter(3, args);
+  check_alg(get_alg(COUNT * sizeof(int)), 0, "no buffer fits");
+  check_allgather(rank, size, "no buffer fits");
+
+  MPI_Finalize();
+
+  if( rank == 0 ) {
+    snprintf(fname, sizeof(fname), "%s/p_allgather.prf", dir);
+    unlink(fname);
+    snprintf(fname, sizeof(fname), "%s/small.cfg", dir);
+    unlink(fname);
+    snprintf(fname, sizeof(fname), "%s/none.cfg", dir);
+    unlink(fname);
+    rmdir(dir);
+    printf("done\n");
+  }
+  return 0;
+}
@@ -37,12 +37,19 @@ int main(int argc, char *argv[]) {
   ht_set(map, 5, 4);
   ht_set(map, 4, 5);
 
+  // message sizes beyond 2 GiB
+  ht_set(map, 3000000000LL, 6);
+  ht_get(map, 3000000000LL, &val);
+  assert( val == 6 );
+  assert( ht_get(map, 3000000000LL - (1LL << 32), &val) == -1 );
+
   {
-    int *keys, nkeys;
+    long long *keys;
+    int nkeys;
     int i;
     ht_get_keys(map, &keys, &nkeys);
     for(i=0; i<nkeys; i++) {
-      printf("key %d\n", keys[i]);
+      printf("key %lld\n", keys[i]);
     }
 
   }
@@ -0,0 +1,132 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <mpi.h>
+
+#include "pgmpi_tune.h"
+#include "collectives/collective_modules.h"
+#include "tuning/pgmpi_cost_model.h"
+
+/*
+ * checks the predictions and selections of the cost model and that collectives
+ * are correct under the model context (run with --cost_model=<file> to use a
+ * model written by pgmpi_calibrate)
+ */
+
+#define MODEL_FILE "modeltest1.model"
+
+static int close_to(double a, double b) {
+  return fabs(a - b) <= 1e-9 * fabs(b) + 1e-15;
+}
+
+static int test_model(void) {
+  pgmpi_cost_model_t model, model2;
+  double t;
+  int alg_id, m, correct = 1;
+  module_t *mod;
+
+  pgmpi_cost_model_init(&model);
+
+  pgmpi_cost_model_add_sample(&model, PGMPI_PRIM_BCAST, 4, 200, 2e-5);
+  pgmpi_cost_model_add_sample(&model, PGMPI_PRIM_BCAST, 4, 100, 1e-5);
+  // on the same line, beyond 2 GiB
+  pgmpi_cost_model_add_sample(&model, PGMPI_PRIM_BCAST, 4, 10000000000LL, 1e3);
+  // a very slow MPI_Allreduce, one of the mock-ups has to be selected
+  for(m=1; m<=(1<<20); m*=4) {
+    pgmpi_cost_model_add_sample(&model, PGMPI_PRIM_ALLREDUCE, 4, m, 1.0);
+  }
+  pgmpi_cost_model_sort(&model);
+
+  if( !close_to(pgmpi_cost_model_predict_primitive(&model, PGMPI_PRIM_BCAST, 4, 150), 1.5e-5) ) {
+    printf("wrong interpolation\n");
+    correct = 0;
+  }
+  if( !close_to(pgmpi_cost_model_predict_primitive(&model, PGMPI_PRIM_BCAST, 4, 400), 4e-5) ) {
+    printf("wrong extrapolation\n");
+    correct = 0;
+  }
+  if( !close_to(pgmpi_cost_model_predict_primitive(&model, PGMPI_PRIM_COPY, 4, 1000), 1000 * model.delta) ) {
+    printf("wrong analytical cost of memcpy\n");
+    correct = 0;
+  }
+
+  if( pgmpi_cost_model_predict_alg(&model, CID_MPI_ALLREDUCE, "allreduce_as_reduce_bcast", 4, 1024, &t) != 0 ||
+      t >= 1.0 ) {
+    printf("wrong prediction of allreduce_as_reduce_bcast\n");
+    correct = 0;
+  }
+
+  mod = pgmpi_modules_get(CID_MPI_ALLREDUCE);
+  if( pgmpi_cost_model_select(&model, CID_MPI_ALLREDUCE, 4, 1024, &alg_id) != 0 || alg_id == 0 ) {
+    printf("default allreduce selected\n");
+    correct = 0;
+  } else {
+    printf("model selects %s\n", mod->alg_choices->alg[alg_id].algname);
+  }
+
+  if( pgmpi_cost_model_write(MODEL_FILE, &model) != 0 ) {
+    printf("cannot write model\n");
+    correct = 0;
+  }
+  pgmpi_cost_model_init(&model2);
+  if( pgmpi_cost_model_read(MODEL_FILE, &model2) != 0 || model2.n_samples != model.n_samples ||
+      !close_to(pgmpi_cost_model_predict_primitive(&model2, PGMPI_PRIM_BCAST, 4, 150), 1.5e-5) ||
+      !close_to(pgmpi_cost_model_predict_primitive(&model2, PGMPI_PRIM_BCAST, 4, 5000000000LL), 5e2) ) {
+    printf("cannot read model\n");
+    correct = 0;
+  }
+  remove(MODEL_FILE);
+
+  pgmpi_cost_model_free(&model);
+  pgmpi_cost_model_free(&model2);
+  return correct;
+}
+
+static int test_allreduce(int n, MPI_Comm comm) {
+  int i, correct = 1;
+  int *sendbuf, *recvbuf, *recvbuf2;
+
+  sendbuf  = (int*) calloc(n, sizeof(int));
+  recvbuf  = (int*) calloc(n, sizeof(int));
+  recvbuf2 = (int*) calloc(n, sizeof(int));
+
+  for (i = 0; i < n; i++) {
+    sendbuf[i] = rand() % 100;
+  }
+  MPI_Allreduce(sendbuf, recvbuf, n, MPI_INT, MPI_SUM, comm);
+  PMPI_Allreduce(sendbuf, recvbuf2, n, MPI_INT, MPI_SUM, comm);
+  for (i = 0; i < n; i++) {
+    if (recvbuf[i] != recvbuf2[i]) {
+      correct = 0;
+    }
+  }
+
+  free(sendbuf);
+  free(recvbuf);
+  free(recvbuf2);
+  return correct;
+}
+
+int main(int argc, char *argv[]) {
+  int rank, n;
+  int correct = 1;
+
+  MPI_Init(&argc, &argv);
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+  if( rank == 0 ) {
+    correct = test_model();
+  }
+
+  for(n=1; n<=(1<<16); n*=16) {
+    if( !test_allreduce(n, MPI_COMM_WORLD) ) {
+      printf("%d: allreduce with %d ints wrong\n", rank, n);
+      correct = 0;
+    }
+  }
+
+  printf("%d: %s\n", rank, correct ? "done" : "failed");
+
+  MPI_Finalize();
+  return 0;
+}
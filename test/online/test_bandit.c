@@ -0,0 +1,107 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <mpi.h>
+
+#include "pgmpi_tune.h"
+#include "collectives/collective_modules.h"
+
+/*
+ * feeds synthetic run-times to the online tuner in bandit mode
+ * the default algorithm is the fastest one first, then it becomes slower
+ * - by a large margin: the tuner has to switch to the faster algorithm
+ * - by 1% under 10% noise: the tuner has to keep the default algorithm
+ * - by a large margin with a huge switch threshold: the default algorithm stays
+ * the noise is a fixed periodic pattern per algorithm, so the outcome depends
+ * neither on the machine nor on which calls the schedule picks for exploring
+ */
+
+#define NB_CALLS 2000
+
+#define MAX_ALGS 16
+
+static int n_reported[MAX_ALGS];
+
+static double synthetic_time(int alg_id, int target, double default_time, double target_time) {
+  double noise = 0.1 * ((n_reported[alg_id % MAX_ALGS]++ % 7) - 3) / 3.0;
+
+  if( alg_id == 0 ) {
+    return default_time * (1.0 + noise);
+  } else if( alg_id == target ) {
+    return target_time * (1.0 + noise);
+  }
+  return 4e-3 * (1.0 + noise);
+}
+
+/*
+ * \return the algorithm used by the calls that do not explore
+ */
+static int run_phase(MPI_Count msg_size, int target, double default_time, double target_time) {
+  int i, alg_id;
+
+  for (i = 0; i < NB_CALLS; i++) {
+    if( pgtune_get_algorithm(CID_MPI_BCAST, msg_size, MPI_INT, MPI_OP_NULL, MPI_COMM_WORLD, &alg_id) ==
+        PGMPI_ALG_MEASURE ) {
+      pgtune_report_time(CID_MPI_BCAST, msg_size, MPI_COMM_WORLD, alg_id,
+          synthetic_time(alg_id, target, default_time, target_time));
+    }
+  }
+
+  while( pgtune_get_algorithm(CID_MPI_BCAST, msg_size, MPI_INT, MPI_OP_NULL, MPI_COMM_WORLD, &alg_id) ==
+      PGMPI_ALG_MEASURE ) {
+  }
+  return alg_id;
+}
+
+static int check_drift(const char *what, MPI_Count msg_size, int target, double drift_time, int expected) {
+  int alg_id;
+
+  alg_id = run_phase(msg_size, target, 1e-3, 2e-3);
+  if( alg_id != 0 ) {
+    printf("%s: committed alg %d before the drift, expected 0\n", what, alg_id);
+    return 0;
+  }
+
+  alg_id = run_phase(msg_size, target, drift_time, 2e-3);
+  if( alg_id != expected ) {
+    printf("%s: alg %d after the drift, expected %d\n", what, alg_id, expected);
+    return 0;
+  }
+  return 1;
+}
+
+int main(int argc, char *argv[]) {
+  int rank, target;
+  int correct = 1;
+  module_t *mod;
+  char *args[5];
+
+  MPI_Init(&argc, &argv);
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+  args[0] = "onlinetest2";
+  args[1] = "--online_mode=bandit";
+  args[2] = "--online_epsilon=0.5";
+  args[3] = "--online_trials=5";
+  pgtune_override_argv_parameter(4, args);
+
+  mod = pgmpi_modules_get(CID_MPI_BCAST);
+  target = mod->alg_choices->alg[mod->alg_choices->nb_choices - 1].algid;
+
+  // default at 1ms, target at 2ms, then the default drifts
+  correct &= check_drift("drift", 1 << 10, target, 6e-3, target);
+  correct &= check_drift("no drift", 1 << 12, target, 2.02e-3, 0);
+
+  args[4] = "--online_switch_t=1000";
+  pgtune_override_argv_parameter(5, args);
+  correct &= check_drift("high threshold", 1 << 14, target, 6e-3, 0);
+
+  if (correct == 1) {
+    printf("%d, correct\n", rank);
+  } else {
+    printf("%d, incorrect\n", rank);
+  }
+
+  MPI_Finalize();
+
+  return 0;
+}
@@ -0,0 +1,277 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <mpi.h>
+
+#include "pgmpi_tune.h"
+#include "collectives/collective_modules.h"
+#include "tuning/pgmpi_profile_reader.h"
+#include "util/pgmpi_nesting.h"
+
+/*
+ * calls collectives often enough that the online tuner explores all mock-ups
+ * and commits an algorithm, results are compared with the PMPI version
+ * a bucket tuned with synthetic times must commit the fastest choice, which
+ * is then found in the profile written to --online_out, also if it was
+ * learned on a communicator without rank 0
+ * calls of mock-ups (nested calls) use the committed algorithm without measuring
+ */
+
+#define NB_CALLS 80
+#define SYNTH_MSIZE (1 << 20)
+
+static char dir[64];
+
+static int test_allreduce(int n, MPI_Comm comm) {
+  int i, j, correct = 1;
+  int *sendbuf, *recvbuf, *recvbuf2;
+
+  sendbuf  = (int*) calloc(n, sizeof(int));
+  recvbuf  = (int*) calloc(n, sizeof(int));
+  recvbuf2 = (int*) calloc(n, sizeof(int));
+
+  for (j = 0; j < NB_CALLS; j++) {
+    for (i = 0; i < n; i++) {
+      sendbuf[i] = rand() % 100;
+    }
+    MPI_Allreduce(sendbuf, recvbuf, n, MPI_INT, MPI_SUM, comm);
+    PMPI_Allreduce(sendbuf, recvbuf2, n, MPI_INT, MPI_SUM, comm);
+    for (i = 0; i < n; i++) {
+      if (recvbuf[i] != recvbuf2[i]) {
+        correct = 0;
+      }
+    }
+  }
+
+  free(sendbuf);
+  free(recvbuf);
+  free(recvbuf2);
+  return correct;
+}
+
+static int test_bcast(int n, MPI_Comm comm) {
+  int i, j, rank, correct = 1;
+  int *buf;
+
+  MPI_Comm_rank(comm, &rank);
+  buf = (int*) calloc(n, sizeof(int));
+
+  for (j = 0; j < NB_CALLS; j++) {
+    for (i = 0; i < n; i++) {
+      buf[i] = (rank == 0) ? i + j : -1;
+    }
+    MPI_Bcast(buf, n, MPI_INT, 0, comm);
+    for (i = 0; i < n; i++) {
+      if (buf[i] != i + j) {
+        correct = 0;
+      }
+    }
+  }
+
+  free(buf);
+  return correct;
+}
+
+/*
+ * after NB_CALLS calls, the bucket of msg_size has to be committed, and all
+ * ranks have to use the same algorithm
+ */
+static int check_committed(pgmpi_collectives_t cid, MPI_Count msg_size, MPI_Comm comm, const char *what) {
+  int alg_id, min, max;
+
+  if( pgtune_get_algorithm(cid, msg_size, MPI_INT, MPI_SUM, comm, &alg_id) == PGMPI_ALG_MEASURE ) {
+    printf("%s: no algorithm committed\n", what);
+    return 0;
+  }
+  PMPI_Allreduce(&alg_id, &min, 1, MPI_INT, MPI_MIN, comm);
+  PMPI_Allreduce(&alg_id, &max, 1, MPI_INT, MPI_MAX, comm);
+  if( min != max ) {
+    printf("%s: committed algorithm differs between ranks (min %d, max %d)\n", what, min, max);
+    return 0;
+  }
+  return 1;
+}
+
+/*
+ * the last alg choice of MPI_Bcast is reported as the fastest one
+ * \return the alg id that was committed, -1 on error
+ */
+static int tune_synthetic(MPI_Comm comm, int *expected) {
+  module_t *mod;
+  int i, alg_id;
+
+  mod = pgmpi_modules_get(CID_MPI_BCAST);
+  *expected = mod->alg_choices->alg[mod->alg_choices->nb_choices - 1].algid;
+
+  for (i = 0; i < NB_CALLS; i++) {
+    if( pgtune_get_algorithm(CID_MPI_BCAST, SYNTH_MSIZE, MPI_INT, MPI_OP_NULL, comm, &alg_id) !=
+        PGMPI_ALG_MEASURE ) {
+      break;
+    }
+    pgtune_report_time(CID_MPI_BCAST, SYNTH_MSIZE, comm, alg_id, (alg_id == *expected) ? 1e-5 : 1e-3);
+  }
+
+  if( pgtune_get_algorithm(CID_MPI_BCAST, SYNTH_MSIZE, MPI_INT, MPI_OP_NULL, comm, &alg_id) ==
+      PGMPI_ALG_MEASURE ) {
+    printf("synthetic: no algorithm committed\n");
+    return -1;
+  }
+  return alg_id;
+}
+
+/*
+ * a bucket that was never explored uses the default, a committed one its algorithm
+ */
+static int check_nested(int committed) {
+  int alg_id, measure, correct = 1;
+
+  // as if called by a mock-up of a collective called by the application
+  pgmpi_nesting_depth = 2;
+  measure = pgtune_get_algorithm(CID_MPI_SCAN, 64, MPI_INT, MPI_SUM, MPI_COMM_WORLD, &alg_id);
+  if( measure == PGMPI_ALG_MEASURE || alg_id != 0 ) {
+    printf("nested: unexplored bucket measured or alg %d instead of the default\n", alg_id);
+    correct = 0;
+  }
+  measure = pgtune_get_algorithm(CID_MPI_BCAST, SYNTH_MSIZE, MPI_INT, MPI_OP_NULL, MPI_COMM_WORLD, &alg_id);
+  if( measure == PGMPI_ALG_MEASURE || alg_id != committed ) {
+    printf("nested: committed bucket measured or alg %d instead of %d\n", alg_id, committed);
+    correct = 0;
+  }
+  pgmpi_nesting_depth = 0;
+
+  if( pgtune_get_algorithm(CID_MPI_SCAN, 64, MPI_INT, MPI_SUM, MPI_COMM_WORLD, &alg_id) != PGMPI_ALG_MEASURE ) {
+    printf("nested: the unexplored bucket is not explored by a call of the application\n");
+    correct = 0;
+  }
+  return correct;
+}
+
+/*
+ * the profile written by rank 0 when the library is finalized has to hold
+ * the synthetic decision
+ */
+static int check_profile(const char *fname, int expected) {
+  pgmpi_profile_t profile;
+  int i, found = 0;
+
+  if( pgmpi_profile_read(fname, &profile) != 0 ) {
+    printf("cannot read learned profile %s\n", fname);
+    return 0;
+  }
+  for (i = 0; i < profile.n_ranges; i++) {
+    if( profile.range[i].msg_size_start <= SYNTH_MSIZE && SYNTH_MSIZE <= profile.range[i].msg_size_end &&
+        profile.range[i].alg_id == expected ) {
+      found = 1;
+    }
+  }
+  pgmpi_profile_free(&profile);
+  if( !found ) {
+    printf("%s does not use alg %d for %d bytes\n", fname, expected, SYNTH_MSIZE);
+  }
+  return found;
+}
+
+static void remove_dir(const char *path) {
+  DIR *d;
+  struct dirent *e;
+  char *fname;
+
+  d = opendir(path);
+  if( d != NULL ) {
+    while( (e = readdir(d)) != NULL ) {
+      if( strcmp(e->d_name, ".") != 0 && strcmp(e->d_name, "..") != 0 ) {
+        fname = (char *)malloc(strlen(path) + strlen(e->d_name) + 2);
+        sprintf(fname, "%s/%s", path, e->d_name);
+        unlink(fname);
+        free(fname);
+      }
+    }
+    closedir(d);
+  }
+  rmdir(path);
+}
+
+int main(int argc, char *argv[]) {
+  int rank, size, correct;
+  int expected, committed;
+  MPI_Comm half, others;
+  char out[96];
+  char fname[256], fname_others[256];
+  char *args[2];
+
+  MPI_Init(&argc, &argv);
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+  if( rank == 0 ) {
+    strcpy(dir, "/tmp/onlinetest1_XXXXXX");
+    if( mkdtemp(dir) == NULL ) {
+      MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+  }
+  MPI_Bcast(dir, sizeof(dir), MPI_CHAR, 0, MPI_COMM_WORLD);
+
+  snprintf(out, sizeof(out), "--online_out=%s", dir);
+  args[0] = "onlinetest1";
+  args[1] = out;
+  pgtune_override_argv_parameter(2, args);
+
+  srand(1);
+  MPI_Comm_split(MPI_COMM_WORLD, rank % 2, rank, &half);
+
+  correct = test_allreduce(1, MPI_COMM_WORLD);
+  correct &= test_allreduce(256, MPI_COMM_WORLD);
+  correct &= test_allreduce(4096, half);
+  correct &= test_bcast(16, MPI_COMM_WORLD);
+  correct &= test_bcast(1024, half);
+
+  correct &= check_committed(CID_MPI_ALLREDUCE, 256 * sizeof(int), MPI_COMM_WORLD, "allreduce");
+  correct &= check_committed(CID_MPI_ALLREDUCE, 4096 * sizeof(int), half, "allreduce (half)");
+  correct &= check_committed(CID_MPI_BCAST, 1024 * sizeof(int), half, "bcast (half)");
+
+  committed = tune_synthetic(MPI_COMM_WORLD, &expected);
+  if( committed != expected ) {
+    printf("synthetic: committed alg %d, expected %d\n", committed, expected);
+    correct = 0;
+  }
+  correct &= check_nested(committed);
+
+  MPI_Comm_split(MPI_COMM_WORLD, (rank == 0) ? MPI_UNDEFINED : 0, rank, &others);
+  if( others != MPI_COMM_NULL ) {
+    committed = tune_synthetic(others, &expected);
+    if( committed != expected ) {
+      printf("synthetic without rank 0: committed alg %d, expected %d\n", committed, expected);
+      correct = 0;
+    }
+    MPI_Comm_free(&others);
+  }
+
+  snprintf(fname, sizeof(fname), "%s/online_%s_p%d.%s", dir, pgmpi_modules_get(CID_MPI_BCAST)->cli_prefix, size,
+      pgmpi_get_profile_file_suffix());
+  snprintf(fname_others, sizeof(fname_others), "%s/online_%s_p%d.%s", dir,
+      pgmpi_modules_get(CID_MPI_BCAST)->cli_prefix, size - 1, pgmpi_get_profile_file_suffix());
+
+  MPI_Comm_free(&half);
+  MPI_Finalize();
+
+  // the profiles are written by MPI_Finalize, which also frees the modules
+  if( rank == 0 ) {
+    pgmpi_modules_init();
+    correct &= check_profile(fname, expected);
+    if( size > 1 ) {
+      correct &= check_profile(fname_others, expected);
+    }
+    pgmpi_modules_free();
+    remove_dir(dir);
+  }
+
+  if (correct == 1) {
+    printf("%d, correct\n", rank);
+  } else {
+    printf("%d, incorrect\n", rank);
+  }
+
+  return 0;
+}
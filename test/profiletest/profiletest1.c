@@ -0,0 +1,491 @@
+/*
+ * profiletest1.c
+ *
+ *  checks sorting, merging and lookup of message size ranges,
+ *  range qualifiers, node layouts, profile match policies, the binary profile database
+ *  the extrapolation of profiles to other process counts and measured effects
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <assert.h>
+#include <limits.h>
+
+#include "pgmpi_tune.h"
+#include "collectives/collective_modules.h"
+#include "tuning/pgmpi_profile.h"
+#include "tuning/pgmpi_function_replacer.h"
+#include "tuning/pgmpi_profile_reader.h"
+#include "tuning/pgmpi_profile_db.h"
+#include "tuning/pgmpi_profile_extrapolate.h"
+
+static void test_match_policies(void) {
+  alg_lookup_table_t tab;
+  pgmpi_profile_t profiles[2];
+  pgmpi_profile_t *prof;
+
+  pgmpi_allocate_replacement_table(&tab);
+
+  pgmpi_profile_allocate(&profiles[0], "MPI_Allreduce", 16, 1);
+  pgmpi_profile_set_alg_for_range(&profiles[0], 0, 8, 8, "allreduce_as_reduce_bcast");
+  pgmpi_profile_allocate(&profiles[1], "MPI_Allreduce", 4, 1);
+  pgmpi_profile_set_alg_for_range(&profiles[1], 0, 8, 8, "allreduce_as_reduce_bcast");
+  pgmpi_add_profile_to_table(&tab, &profiles[0]);
+  pgmpi_add_profile_to_table(&tab, &profiles[1]);
+
+  pgmpi_set_profile_match_policy(&tab, PROFILE_MATCH_EXACT);
+  pgmpi_get_profile_for_comm_size(&tab, CID_MPI_ALLREDUCE, 4, &prof);
+  assert( prof == &profiles[1] );
+  pgmpi_get_profile_for_comm_size(&tab, CID_MPI_ALLREDUCE, 8, &prof);
+  assert( prof == NULL );
+  pgmpi_get_profile_for_comm_size(&tab, CID_MPI_ALLGATHER, 4, &prof);
+  assert( prof == NULL );
+
+  pgmpi_set_profile_match_policy(&tab, PROFILE_MATCH_NEAREST);
+  pgmpi_get_profile_for_comm_size(&tab, CID_MPI_ALLREDUCE, 8, &prof);
+  assert( prof == &profiles[1] );
+  pgmpi_get_profile_for_comm_size(&tab, CID_MPI_ALLREDUCE, 12, &prof);
+  assert( prof == &profiles[0] );
+  pgmpi_get_profile_for_comm_size(&tab, CID_MPI_ALLREDUCE, 2, &prof);
+  assert( prof == &profiles[1] );
+
+  pgmpi_set_profile_match_policy(&tab, PROFILE_MATCH_FLOOR);
+  pgmpi_get_profile_for_comm_size(&tab, CID_MPI_ALLREDUCE, 15, &prof);
+  assert( prof == &profiles[1] );
+  pgmpi_get_profile_for_comm_size(&tab, CID_MPI_ALLREDUCE, 64, &prof);
+  assert( prof == &profiles[0] );
+  pgmpi_get_profile_for_comm_size(&tab, CID_MPI_ALLREDUCE, 2, &prof);
+  assert( prof == NULL );
+
+  pgmpi_free_replacement_table(&tab);
+}
+
+static void test_extrapolation(void) {
+  alg_lookup_table_t tab;
+  pgmpi_profile_t profiles[5];
+  pgmpi_profile_t *prof, *prof2;
+  module_t *mod = pgmpi_modules_get(CID_MPI_ALLREDUCE);
+  int alg1 = pgmpi_modules_get_algid_by_algname(mod->alg_choices, "allreduce_as_reduce_bcast");
+  int alg2 = pgmpi_modules_get_algid_by_algname(mod->alg_choices, "allreduce_as_reducescatterblock_allgather");
+  int algid, i, p;
+
+  pgmpi_allocate_replacement_table(&tab);
+  pgmpi_set_profile_match_policy(&tab, PROFILE_MATCH_EXTRAPOLATE);
+
+  // the crossover between the two mock-ups grows linearly with p
+  for(i=0, p=16; i<3; i++, p*=4) {
+    pgmpi_profile_allocate(&profiles[i], "MPI_Allreduce", p, 2);
+    pgmpi_profile_set_alg_for_range(&profiles[i], 0, 0, 64 * p - 1, "allreduce_as_reduce_bcast");
+    pgmpi_profile_set_alg_for_range(&profiles[i], 1, 64 * p, 1 << 20, "allreduce_as_reducescatterblock_allgather");
+    pgmpi_profile_normalize(&profiles[i]);
+    pgmpi_add_profile_to_table(&tab, &profiles[i]);
+  }
+
+  // profiles that disagree on the algorithms
+  pgmpi_profile_allocate(&profiles[3], "MPI_Bcast", 4, 1);
+  pgmpi_profile_set_alg_for_range(&profiles[3], 0, 16, 64, "bcast_as_allgatherv");
+  pgmpi_profile_allocate(&profiles[4], "MPI_Bcast", 8, 1);
+  pgmpi_profile_set_alg_for_range(&profiles[4], 0, 16, 64, "bcast_as_scatter_allgather");
+  pgmpi_profile_normalize(&profiles[3]);
+  pgmpi_profile_normalize(&profiles[4]);
+  pgmpi_add_profile_to_table(&tab, &profiles[3]);
+  pgmpi_add_profile_to_table(&tab, &profiles[4]);
+
+  pgmpi_get_profile_for_comm_size(&tab, CID_MPI_ALLREDUCE, 64, &prof);
+  assert( prof == &profiles[1] );
+
+  // interpolation
+  pgmpi_get_profile_for_comm_size(&tab, CID_MPI_ALLREDUCE, 128, &prof);
+  assert( prof != NULL && prof->nb_procs == 128 );
+  // a range that starts at 0 everywhere still starts at 0
+  assert( pgmpi_profile_find_alg(prof, 0, PGMPI_QUALIFIER_NONE, PGMPI_QUALIFIER_NONE, &algid) == 0 &&
+      algid == alg1 );
+  assert( pgmpi_profile_find_alg(prof, 8000, PGMPI_QUALIFIER_NONE, PGMPI_QUALIFIER_NONE, &algid) == 0 &&
+      algid == alg1 );
+  assert( pgmpi_profile_find_alg(prof, 8400, PGMPI_QUALIFIER_NONE, PGMPI_QUALIFIER_NONE, &algid) == 0 &&
+      algid == alg2 );
+
+  // extrapolation, derived profiles are kept
+  pgmpi_get_profile_for_comm_size(&tab, CID_MPI_ALLREDUCE, 1024, &prof);
+  assert( prof != NULL );
+  assert( pgmpi_profile_find_alg(prof, 60000, PGMPI_QUALIFIER_NONE, PGMPI_QUALIFIER_NONE, &algid) == 0 &&
+      algid == alg1 );
+  assert( pgmpi_profile_find_alg(prof, 70000, PGMPI_QUALIFIER_NONE, PGMPI_QUALIFIER_NONE, &algid) == 0 &&
+      algid == alg2 );
+  pgmpi_get_profile_for_comm_size(&tab, CID_MPI_ALLREDUCE, 1024, &prof2);
+  assert( prof2 == prof );
+
+  // too far from the measured process counts
+  pgmpi_get_profile_for_comm_size(&tab, CID_MPI_ALLREDUCE, 1 << 20, &prof);
+  assert( prof == NULL );
+  pgmpi_set_profile_min_confidence(&tab, 0.1);
+  pgmpi_get_profile_for_comm_size(&tab, CID_MPI_ALLREDUCE, 1 << 19, &prof);
+  assert( prof != NULL );
+
+  // no common structure
+  pgmpi_get_profile_for_comm_size(&tab, CID_MPI_BCAST, 16, &prof);
+  assert( prof == NULL );
+  // a single process count
+  pgmpi_get_profile_for_comm_size(&tab, CID_MPI_GATHER, 16, &prof);
+  assert( prof == NULL );
+
+  pgmpi_free_replacement_table(&tab);
+}
+
+static void test_shapes(void) {
+  alg_lookup_table_t tab;
+  pgmpi_profile_t profiles[3];
+  pgmpi_profile_t *prof;
+  pgmpi_comm_shape_t shape;
+
+  pgmpi_allocate_replacement_table(&tab);
+
+  pgmpi_profile_allocate(&profiles[0], "MPI_Bcast", 256, 1);
+  pgmpi_profile_set_alg_for_range(&profiles[0], 0, 8, 8, "bcast_as_scatter_allgather");
+  pgmpi_profile_allocate(&profiles[1], "MPI_Bcast", 256, 1);
+  pgmpi_profile_set_alg_for_range(&profiles[1], 0, 8, 8, "bcast_as_scatter_allgather");
+  assert( pgmpi_profile_set_shape(&profiles[1], 8, 32) == 0 );
+  pgmpi_profile_allocate(&profiles[2], "MPI_Bcast", 256, 1);
+  pgmpi_profile_set_alg_for_range(&profiles[2], 0, 8, 8, "bcast_as_scatter_allgather");
+  assert( pgmpi_profile_set_shape(&profiles[2], 64, 3) == -1 );
+  assert( pgmpi_profile_set_shape(&profiles[2], 64, 4) == 0 );
+  pgmpi_add_profile_to_table(&tab, &profiles[0]);
+  pgmpi_add_profile_to_table(&tab, &profiles[1]);
+  pgmpi_add_profile_to_table(&tab, &profiles[2]);
+  assert( tab.has_shapes == 1 );
+
+  // layout unknown: shaped profiles are skipped
+  pgmpi_get_profile_for_comm_size(&tab, CID_MPI_BCAST, 256, &prof);
+  assert( prof == &profiles[0] );
+
+  shape.nb_procs = 256;
+  shape.nb_nodes = 8;
+  shape.ppn = 32;
+  pgmpi_get_profile_for_comm_shape(&tab, CID_MPI_BCAST, &shape, &prof);
+  assert( prof == &profiles[1] );
+  shape.nb_nodes = 64;
+  shape.ppn = 4;
+  pgmpi_get_profile_for_comm_shape(&tab, CID_MPI_BCAST, &shape, &prof);
+  assert( prof == &profiles[2] );
+  shape.nb_nodes = 128;
+  shape.ppn = 2;
+  pgmpi_get_profile_for_comm_shape(&tab, CID_MPI_BCAST, &shape, &prof);
+  assert( prof == &profiles[0] );
+
+  // with nearest, the layout takes precedence at equal distance only
+  pgmpi_set_profile_match_policy(&tab, PROFILE_MATCH_NEAREST);
+  shape.nb_procs = 512;
+  shape.nb_nodes = 16;
+  shape.ppn = 32;
+  pgmpi_get_profile_for_comm_shape(&tab, CID_MPI_BCAST, &shape, &prof);
+  assert( prof == &profiles[1] );
+
+  pgmpi_free_replacement_table(&tab);
+}
+
+static void test_profile_db(void) {
+  pgmpi_profile_t profiles[2];
+  pgmpi_profile_db_t db;
+  alg_lookup_table_t tab;
+  pgmpi_profile_t *prof;
+  char fname[] = "/tmp/profiletest1_db_XXXXXX";
+  int algid, ret, fd;
+  int dbl = pgmpi_qualifier_dtype_id_by_name("MPI_DOUBLE");
+
+  pgmpi_profile_allocate(&profiles[0], "MPI_Allgather", 4, 2);
+  pgmpi_profile_set_alg_for_range(&profiles[0], 0, 64, 128, "allgather_as_alltoall");
+  pgmpi_profile_set_alg_for_range(&profiles[0], 1, 16, 63, "allgather_as_allreduce");
+  pgmpi_profile_normalize(&profiles[0]);
+  pgmpi_profile_allocate(&profiles[1], "MPI_Allreduce", 8, 2);
+  pgmpi_profile_set_alg_for_range(&profiles[1], 0, 1, 1024, "allreduce_as_reduce_bcast");
+  pgmpi_profile_set_alg_for_range(&profiles[1], 1, 1, 1024, "allreduce_as_reducescatterblock_allgather");
+  pgmpi_profile_set_qualifiers_for_range(&profiles[1], 1, dbl, PGMPI_QUALIFIER_ANY);
+  pgmpi_profile_set_shape(&profiles[1], 2, 4);
+  pgmpi_profile_normalize(&profiles[1]);
+
+  fd = mkstemp(fname);
+  assert( fd >= 0 );
+  close(fd);
+  ret = pgmpi_profile_db_write(fname, profiles, 2);
+  assert( ret == 0 );
+  pgmpi_profile_free(&profiles[0]);
+  pgmpi_profile_free(&profiles[1]);
+
+  ret = pgmpi_profile_db_open(fname, &db);
+  unlink(fname);
+  assert( ret == 0 && db.n_profiles == 2 );
+  assert( db.profiles[1].nb_nodes == 2 && db.profiles[1].ppn == 4 );
+
+  ret = pgmpi_profile_find_alg(&db.profiles[0], 100, PGMPI_QUALIFIER_NONE, PGMPI_QUALIFIER_NONE, &algid);
+  assert( ret == 0 && algid == 3 );
+  ret = pgmpi_profile_find_alg(&db.profiles[1], 100, dbl, PGMPI_QUALIFIER_NONE, &algid);
+  assert( ret == 0 && algid == 2 );
+  ret = pgmpi_profile_find_alg(&db.profiles[1], 100, PGMPI_QUALIFIER_NONE, PGMPI_QUALIFIER_NONE, &algid);
+  assert( ret == 0 && algid == 1 );
+
+  // mapped profiles are not freed by the table
+  pgmpi_allocate_replacement_table(&tab);
+  pgmpi_add_profile_to_table(&tab, &db.profiles[0]);
+  pgmpi_add_profile_to_table(&tab, &db.profiles[1]);
+  pgmpi_get_profile_for_comm_size(&tab, CID_MPI_ALLGATHER, 4, &prof);
+  assert( prof == &db.profiles[0] );
+  pgmpi_free_replacement_table(&tab);
+
+  pgmpi_profile_db_close(&db);
+
+  // corrupt algorithm ids and groups are rejected
+  pgmpi_profile_allocate(&profiles[0], "MPI_Allgather", 4, 1);
+  pgmpi_profile_set_alg_for_range(&profiles[0], 0, 64, 128, "allgather_as_alltoall");
+  pgmpi_profile_normalize(&profiles[0]);
+  strcpy(fname, "/tmp/profiletest1_db_XXXXXX");
+  fd = mkstemp(fname);
+  close(fd);
+  profiles[0].range[0].alg_id = 99;
+  assert( pgmpi_profile_db_write(fname, profiles, 1) == 0 );
+  assert( pgmpi_profile_db_open(fname, &db) == -1 );
+  profiles[0].range[0].alg_id = 3;
+  profiles[0].group[0].n = 2;
+  assert( pgmpi_profile_db_write(fname, profiles, 1) == 0 );
+  assert( pgmpi_profile_db_open(fname, &db) == -1 );
+  profiles[0].group[0].n = 1;
+  unlink(fname);
+  pgmpi_profile_free(&profiles[0]);
+
+  // truncated files are rejected
+  {
+    FILE *fp;
+    strcpy(fname, "/tmp/profiletest1_db_XXXXXX");
+    fd = mkstemp(fname);
+    fp = fdopen(fd, "w");
+    fprintf(fp, "PGMPIPDB");
+    fclose(fp);
+    ret = pgmpi_profile_db_open(fname, &db);
+    unlink(fname);
+    assert( ret == -1 );
+  }
+}
+
+static void test_qualifiers(void) {
+  pgmpi_profile_t profile;
+  int algid, ret, i, lo, hi;
+  int dbl, integer, sum, max, user, user_nc;
+  char fname[] = "/tmp/profiletest1_XXXXXX";
+  FILE *fp;
+  int fd;
+
+  dbl     = pgmpi_qualifier_dtype_id_by_name("MPI_DOUBLE");
+  integer = pgmpi_qualifier_dtype_id_by_name("MPI_INT");
+  sum     = pgmpi_qualifier_op_id_by_name("MPI_SUM");
+  max     = pgmpi_qualifier_op_id_by_name("MPI_MAX");
+  user    = pgmpi_qualifier_op_id_by_name("user");
+  user_nc = pgmpi_qualifier_op_id_by_name("user_noncommutative");
+  assert( dbl >= 0 && integer >= 0 && sum >= 0 && max >= 0 && user >= 0 && user_nc >= 0 );
+  assert( pgmpi_qualifier_dtype_id_by_name("MPI_FOO") == PGMPI_QUALIFIER_NONE );
+  assert( pgmpi_qualifier_op_id_by_name("*") == PGMPI_QUALIFIER_ANY );
+
+  fd = mkstemp(fname);
+  assert( fd >= 0 );
+  fp = fdopen(fd, "w");
+  fprintf(fp, "MPI_Allreduce\n4\n2\n1 allreduce_as_reduce_bcast\n2 allreduce_as_reducescatterblock_allgather\n");
+  fprintf(fp, "4\n");
+  fprintf(fp, "1024 65536 1\n");
+  fprintf(fp, "1024 4096 2 dtype=MPI_DOUBLE\n");
+  fprintf(fp, "1024 65536 2 dtype=MPI_DOUBLE op=MPI_SUM # comment\n");
+  fprintf(fp, "1024 65536 1 dtype=* op=user\n");
+  fclose(fp);
+
+  ret = pgmpi_profile_read(fname, &profile);
+  unlink(fname);
+  assert( ret == 0 );
+  assert( profile.n_ranges == 4 && profile.n_groups == 4 );
+
+  // unqualified range
+  ret = pgmpi_profile_find_alg(&profile, 2048, integer, max, &algid);
+  assert( ret == 0 && algid == 1 );
+  // dtype qualifier, falls back to the unqualified range outside of its ranges
+  ret = pgmpi_profile_find_alg(&profile, 2048, dbl, max, &algid);
+  assert( ret == 0 && algid == 2 );
+  ret = pgmpi_profile_find_alg(&profile, 8192, dbl, max, &algid);
+  assert( ret == 0 && algid == 1 );
+  // op and dtype qualifier
+  ret = pgmpi_profile_find_alg(&profile, 8192, dbl, sum, &algid);
+  assert( ret == 0 && algid == 2 );
+  ret = pgmpi_profile_find_alg(&profile, 8192, integer, sum, &algid);
+  assert( ret == 0 && algid == 1 );
+  // "user" covers non-commutative user operations
+  ret = pgmpi_profile_find_alg(&profile, 2048, dbl, user_nc, &algid);
+  assert( ret == 0 && algid == 1 );
+  ret = pgmpi_profile_find_alg(&profile, 512, dbl, sum, &algid);
+  assert( ret == -1 );
+
+  pgmpi_profile_free(&profile);
+
+  // ranges with different qualifiers may overlap, ranges with the same may not
+  pgmpi_profile_allocate(&profile, "MPI_Allreduce", 4, 3);
+  pgmpi_profile_set_alg_for_range(&profile, 0, 16, 64, "allreduce_as_reduce_bcast");
+  pgmpi_profile_set_alg_for_range(&profile, 1, 16, 64, "allreduce_as_reduce_bcast");
+  pgmpi_profile_set_qualifiers_for_range(&profile, 1, dbl, PGMPI_QUALIFIER_ANY);
+  pgmpi_profile_set_alg_for_range(&profile, 2, 32, 128, "allreduce_as_reduce_bcast");
+  pgmpi_profile_set_qualifiers_for_range(&profile, 2, dbl, PGMPI_QUALIFIER_ANY);
+  ret = pgmpi_profile_normalize(&profile);
+  assert( ret == -1 );
+  pgmpi_profile_free(&profile);
+
+  // skews between two skew qualifiers match the same ranges
+  pgmpi_profile_allocate(&profile, "MPI_Allreduce", 4, 3);
+  for(i=0; i<3; i++) {
+    pgmpi_profile_set_alg_for_range(&profile, i, 16, 64, "allreduce_as_reduce_bcast");
+  }
+  pgmpi_profile_set_skew_for_range(&profile, 1, 1000);
+  pgmpi_profile_set_skew_for_range(&profile, 2, 5000);
+  ret = pgmpi_profile_normalize(&profile);
+  assert( ret == 0 );
+  pgmpi_profile_skew_interval(&profile, 500, &lo, &hi);
+  assert( lo == 0 && hi == 1000 );
+  pgmpi_profile_skew_interval(&profile, 1000, &lo, &hi);
+  assert( lo == 1000 && hi == 5000 );
+  pgmpi_profile_skew_interval(&profile, 7000, &lo, &hi);
+  assert( lo == 5000 && hi == INT_MAX );
+  pgmpi_profile_skew_interval(&profile, PGMPI_QUALIFIER_NONE, &lo, &hi);
+  assert( lo == PGMPI_QUALIFIER_NONE && hi == PGMPI_QUALIFIER_NONE + 1 );
+  pgmpi_profile_free(&profile);
+}
+
+static void test_large_sizes(void) {
+  pgmpi_profile_t profile;
+  int algid, ret;
+  char fname[] = "/tmp/profiletest1_XXXXXX";
+  FILE *fp;
+  int fd;
+
+  // message sizes beyond INT_MAX
+  fd = mkstemp(fname);
+  assert( fd >= 0 );
+  fp = fdopen(fd, "w");
+  fprintf(fp, "MPI_Bcast\n4\n2\n1 bcast_as_allgatherv\n2 bcast_as_scatter_allgather\n");
+  fprintf(fp, "2\n");
+  fprintf(fp, "1024 2147483647 1\n");
+  fprintf(fp, "2147483648 8589934592 2\n");
+  fclose(fp);
+
+  ret = pgmpi_profile_read(fname, &profile);
+  unlink(fname);
+  assert( ret == 0 );
+  assert( profile.range[1].msg_size_start == 2147483648LL );
+  assert( profile.range[1].msg_size_end == 8589934592LL );
+
+  ret = pgmpi_profile_find_alg(&profile, 2000000000, PGMPI_QUALIFIER_NONE, PGMPI_QUALIFIER_NONE, &algid);
+  assert( ret == 0 && algid == 1 );
+  ret = pgmpi_profile_find_alg(&profile, 4000000000LL, PGMPI_QUALIFIER_NONE, PGMPI_QUALIFIER_NONE, &algid);
+  assert( ret == 0 && algid == 2 );
+  ret = pgmpi_profile_find_alg(&profile, 8589934593LL, PGMPI_QUALIFIER_NONE, PGMPI_QUALIFIER_NONE, &algid);
+  assert( ret == -1 );
+
+  pgmpi_profile_free(&profile);
+}
+
+static void test_effects(void) {
+  pgmpi_profile_t profile;
+  alg_lookup_table_t tab;
+  int ret;
+  char fname[] = "/tmp/profiletest1_XXXXXX";
+  FILE *fp;
+  int fd;
+
+  fd = mkstemp(fname);
+  assert( fd >= 0 );
+  fp = fdopen(fd, "w");
+  fprintf(fp, "MPI_Bcast\n4\n2\n1 bcast_as_allgatherv\n2 bcast_as_scatter_allgather\n");
+  fprintf(fp, "3\n");
+  fprintf(fp, "1 15 1 effect=0.2000 ci=0.1000,0.3000\n");
+  fprintf(fp, "16 31 1 effect=0.0500 ci=-0.0100,0.0800\n");
+  fprintf(fp, "32 63 2\n");
+  fclose(fp);
+
+  ret = pgmpi_profile_read(fname, &profile);
+  unlink(fname);
+  assert( ret == 0 );
+
+  // adjacent ranges of the same algorithm are merged with the smaller effect
+  assert( profile.n_ranges == 2 );
+  assert( profile.range[0].has_effect );
+  assert( profile.range[0].effect == 0.05 );
+  assert( profile.range[0].effect_ci_low == -0.01 );
+  assert( profile.range[0].effect_ci_high == 0.3 );
+  assert( !profile.range[1].has_effect );
+
+  pgmpi_allocate_replacement_table(&tab);
+  assert( !pgmpi_range_is_effective(&tab, &profile.range[0]) );
+  assert( pgmpi_range_is_effective(&tab, &profile.range[1]) );
+  pgmpi_set_profile_min_effect(&tab, -0.05);
+  assert( pgmpi_range_is_effective(&tab, &profile.range[0]) );
+  pgmpi_free_replacement_table(&tab);
+
+  // the effect must lie within its interval
+  ret = pgmpi_profile_set_effect_for_range(&profile, 1, 0.5, 0.1, 0.3);
+  assert( ret == -1 );
+
+  pgmpi_profile_free(&profile);
+}
+
+int main(int argc, char *argv[]) {
+
+  pgmpi_profile_t profile;
+  int algid, ret;
+
+  pgmpi_modules_init();
+
+  // unsorted, with two adjacent ranges using the same algorithm
+  pgmpi_profile_allocate(&profile, "MPI_Allgather", 4, 4);
+  pgmpi_profile_set_alg_for_range(&profile, 0, 1024, 2048, "allgather_as_gather_bcast");
+  pgmpi_profile_set_alg_for_range(&profile, 1, 16, 16, "allgather_as_allreduce");
+  pgmpi_profile_set_alg_for_range(&profile, 2, 64, 128, "allgather_as_alltoall");
+  pgmpi_profile_set_alg_for_range(&profile, 3, 17, 63, "allgather_as_allreduce");
+
+  ret = pgmpi_profile_normalize(&profile);
+  assert( ret == 0 );
+  assert( profile.n_ranges == 3 );
+  assert( profile.range[0].msg_size_start == 16 );
+  assert( profile.range[0].msg_size_end == 63 );
+
+  ret = pgmpi_profile_find_alg(&profile, 16, PGMPI_QUALIFIER_NONE, PGMPI_QUALIFIER_NONE, &algid);
+  assert( ret == 0 && algid == 2 );
+  ret = pgmpi_profile_find_alg(&profile, 40, PGMPI_QUALIFIER_NONE, PGMPI_QUALIFIER_NONE, &algid);
+  assert( ret == 0 && algid == 2 );
+  ret = pgmpi_profile_find_alg(&profile, 128, PGMPI_QUALIFIER_NONE, PGMPI_QUALIFIER_NONE, &algid);
+  assert( ret == 0 && algid == 3 );
+  ret = pgmpi_profile_find_alg(&profile, 2048, PGMPI_QUALIFIER_NONE, PGMPI_QUALIFIER_NONE, &algid);
+  assert( ret == 0 && algid == 4 );
+  ret = pgmpi_profile_find_alg(&profile, 8, PGMPI_QUALIFIER_NONE, PGMPI_QUALIFIER_NONE, &algid);
+  assert( ret == -1 );
+  ret = pgmpi_profile_find_alg(&profile, 512, PGMPI_QUALIFIER_NONE, PGMPI_QUALIFIER_NONE, &algid);
+  assert( ret == -1 );
+  ret = pgmpi_profile_find_alg(&profile, 4096, PGMPI_QUALIFIER_NONE, PGMPI_QUALIFIER_NONE, &algid);
+  assert( ret == -1 );
+
+  pgmpi_profile_free(&profile);
+
+  // overlapping ranges are rejected
+  pgmpi_profile_allocate(&profile, "MPI_Allgather", 4, 2);
+  pgmpi_profile_set_alg_for_range(&profile, 0, 16, 64, "allgather_as_allreduce");
+  pgmpi_profile_set_alg_for_range(&profile, 1, 64, 128, "allgather_as_alltoall");
+  ret = pgmpi_profile_normalize(&profile);
+  assert( ret == -1 );
+  pgmpi_profile_free(&profile);
+
+  test_match_policies();
+  test_extrapolation();
+  test_qualifiers();
+  test_large_sizes();
+  test_effects();
+  test_shapes();
+  test_profile_db();
+
+  pgmpi_modules_free();
+
+  printf("done\n");
+
+  return 0;
+}
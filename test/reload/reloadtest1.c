@@ -0,0 +1,123 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <mpi.h>
+
+#include "pgmpi_tune.h"
+
+/*
+ * profiles are replaced while the job runs, all ranks must switch together
+ */
+
+static char dir[64];
+
+/*
+ * replaces the profile atomically, the temporary file must not end with .prf
+ */
+static void write_profile_for_size(const char *algname, int size) {
+  char fname[128], tmpname[128];
+  FILE *fp;
+
+  snprintf(fname, sizeof(fname), "%s/p_allgather.prf", dir);
+  snprintf(tmpname, sizeof(tmpname), "%s/p_allgather.tmp", dir);
+  fp = fopen(tmpname, "w");
+  assert( fp != NULL );
+  fprintf(fp, "MPI_Allgather\n%d\n1\n1 %s\n1\n16 16 1\n", size, algname);
+  fclose(fp);
+  rename(tmpname, fname);
+}
+
+static int get_alg(void) {
+  int alg_id;
+  pgtune_get_algorithm(CID_MPI_ALLGATHER, 16, MPI_INT, MPI_OP_NULL, MPI_COMM_WORLD, &alg_id);
+  return alg_id;
+}
+
+static void check_alg(int expected, const char *what) {
+  int alg_id, min, max;
+
+  alg_id = get_alg();
+  MPI_Allreduce(&alg_id, &min, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+  MPI_Allreduce(&alg_id, &max, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+  if( min != max || alg_id != expected ) {
+    printf("%s: alg %d (min %d, max %d), expected %d\n", what, alg_id, min, max, expected);
+    MPI_Abort(MPI_COMM_WORLD, 1);
+  }
+}
+
+int main(int argc, char *argv[]) {
+  int rank, size;
+  char ppath[96];
+  char *args[4];
+
+  MPI_Init(&argc, &argv);
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+  if( rank == 0 ) {
+    strcpy(dir, "/tmp/reloadtest1_XXXXXX");
+    assert( mkdtemp(dir) != NULL );
+    write_profile_for_size("allgather_as_allreduce", size);
+  }
+  MPI_Bcast(dir, sizeof(dir), MPI_CHAR, 0, MPI_COMM_WORLD);
+
+  snprintf(ppath, sizeof(ppath), "--ppath=%s", dir);
+  args[0] = "reloadtest1";
+  args[1] = ppath;
+  args[2] = "--reload_interval=1";
+  args[3] = "--reload_signal=USR1";
+  pgtune_override_argv_parameter(4, args);
+
+  check_alg(2, "initial profile");
+
+  // the watcher notices the new profile
+  if( rank == 0 ) {
+    write_profile_for_size("allgather_as_alltoall", size);
+  }
+  MPI_Barrier(MPI_COMM_WORLD);
+  check_alg(3, "changed profile");
+
+  // a request from a single rank is enough
+  if( rank == 0 ) {
+    struct timespec old[2] = { { 1, 0 }, { 1, 0 } };
+    write_profile_for_size("allgather_as_gather_bcast", size);
+    // hide the change from the watcher
+    utimensat(AT_FDCWD, dir, old, 0);
+  }
+  MPI_Barrier(MPI_COMM_WORLD);
+  check_alg(3, "hidden change");
+  if( rank == size - 1 ) {
+    pgtune_request_reload();
+  }
+  check_alg(4, "requested reload");
+
+  if( rank == 0 ) {
+    struct timespec old[2] = { { 1, 0 }, { 1, 0 } };
+    write_profile_for_size("allgather_as_allreduce", size);
+    utimensat(AT_FDCWD, dir, old, 0);
+  }
+  MPI_Barrier(MPI_COMM_WORLD);
+  if( rank == size - 1 ) {
+    raise(SIGUSR1);
+  }
+  check_alg(2, "signal");
+
+  if( rank == 0 ) {
+    char fname[128];
+    snprintf(fname, sizeof(fname), "%s/p_allgather.prf", dir);
+    unlink(fname);
+    rmdir(dir);
+  }
+
+  MPI_Finalize();
+
+  if( rank == 0 ) {
+    printf("done\n");
+  }
+  return 0;
+}
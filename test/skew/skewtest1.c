@@ -0,0 +1,147 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <unistd.h>
+#include <mpi.h>
+
+#include "pgmpi_tune.h"
+
+/*
+ * ranks enter a collective one after the other, a profile selects another
+ * algorithm for calls with an arrival skew of at least 10ms
+ */
+
+#define DELAY_US 20000
+
+static char dir[64];
+
+static int send[4], recv[4 * 1024];
+
+static void call(const int delay_us) {
+  if( delay_us > 0 ) {
+    usleep(delay_us);
+  }
+  MPI_Allgather(send, 4, MPI_INT, recv, 4, MPI_INT, MPI_COMM_WORLD);
+}
+
+static int get_alg(void) {
+  int alg_id;
+  pgtune_get_algorithm(CID_MPI_ALLGATHER, 16, MPI_INT, MPI_OP_NULL, MPI_COMM_WORLD, &alg_id);
+  return alg_id;
+}
+
+static void check_same(double val, const char *what) {
+  double min, max;
+
+  MPI_Allreduce(&val, &min, 1, MPI_DOUBLE, MPI_MIN, MPI_COMM_WORLD);
+  MPI_Allreduce(&val, &max, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+  if( min != max ) {
+    printf("%s differs between ranks (min %g, max %g)\n", what, min, max);
+    MPI_Abort(MPI_COMM_WORLD, 1);
+  }
+}
+
+static void check_alg(int alg_id, int expected, const char *what) {
+  check_same(alg_id, what);
+  if( alg_id != expected ) {
+    printf("%s: alg %d, expected %d\n", what, alg_id, expected);
+    MPI_Abort(MPI_COMM_WORLD, 1);
+  }
+}
+
+int main(int argc, char *argv[]) {
+  int rank, size, i;
+  pgmpi_skew_stats_t stats;
+  char ppath[96], out[96];
+  char fname[128];
+  char *args[4];
+
+  MPI_Init(&argc, &argv);
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &size);
+  assert( size >= 2 && size <= 1024 );
+
+  if( rank == 0 ) {
+    FILE *fp;
+    strcpy(dir, "/tmp/skewtest1_XXXXXX");
+    assert( mkdtemp(dir) != NULL );
+    snprintf(fname, sizeof(fname), "%s/p_allgather.prf", dir);
+    fp = fopen(fname, "w");
+    assert( fp != NULL );
+    fprintf(fp, "MPI_Allgather\n%d\n2\n2 allgather_as_allreduce\n3 allgather_as_alltoall\n2\n", size);
+    fprintf(fp, "16 16 2 skew=10000\n16 16 3\n");
+    fclose(fp);
+  }
+  MPI_Bcast(dir, sizeof(dir), MPI_CHAR, 0, MPI_COMM_WORLD);
+
+  snprintf(ppath, sizeof(ppath), "--ppath=%s", dir);
+  snprintf(out, sizeof(out), "--skew_out=%s/skew.txt", dir);
+  args[0] = "skewtest1";
+  args[1] = ppath;
+  args[2] = "--skew_interval=1";
+  args[3] = out;
+  pgtune_override_argv_parameter(4, args);
+
+  // no sample yet, the skew is unknown
+  assert( pgtune_get_skew_stats(CID_MPI_ALLGATHER, MPI_COMM_WORLD, &stats) != 0 );
+  call(0);
+  check_alg(get_alg(), 3, "no skew estimate");
+
+  for(i=0; i<4; i++) {
+    call(rank * DELAY_US);
+  }
+  assert( pgtune_get_skew_stats(CID_MPI_ALLGATHER, MPI_COMM_WORLD, &stats) == 0 );
+  check_same(stats.n_samples, "number of samples");
+  check_same(stats.estimate, "skew estimate");
+  check_same(stats.max, "max skew");
+  if( stats.n_samples != 5 || stats.max < 0.5e-6 * (size - 1) * DELAY_US ) {
+    printf("unexpected skew stats: %d samples, max %g s\n", stats.n_samples, stats.max);
+    MPI_Abort(MPI_COMM_WORLD, 1);
+  }
+  call(0);
+  check_alg(get_alg(), 2, "skewed calls");
+
+  // the estimate decays once the processes arrive together
+  for(i=0; i<30; i++) {
+    MPI_Barrier(MPI_COMM_WORLD);
+    call(0);
+  }
+  check_alg(get_alg(), 3, "balanced calls");
+
+  args[2] = "--skew_interval=0";
+  pgtune_override_argv_parameter(3, args);
+  for(i=0; i<4; i++) {
+    call(rank * DELAY_US);
+  }
+  check_alg(get_alg(), 3, "without skew estimation");
+
+  // statistics are only written while sampling is enabled
+  args[2] = "--skew_interval=1";
+  pgtune_override_argv_parameter(4, args);
+
+  MPI_Finalize();
+
+  if( rank == 0 ) {
+    FILE *fp;
+    char line[256];
+    int found = 0;
+
+    snprintf(fname, sizeof(fname), "%s/skew.txt", dir);
+    fp = fopen(fname, "r");
+    assert( fp != NULL );
+    while( fgets(line, sizeof(line), fp) != NULL ) {
+      if( strncmp(line, "MPI_Allgather ", 14) == 0 ) {
+        found = 1;
+      }
+    }
+    fclose(fp);
+    assert( found );
+    unlink(fname);
+    snprintf(fname, sizeof(fname), "%s/p_allgather.prf", dir);
+    unlink(fname);
+    rmdir(dir);
+    printf("done\n");
+  }
+  return 0;
+}
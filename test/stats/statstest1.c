@@ -0,0 +1,67 @@
+/*
+ * statstest1.c
+ *
+ *  checks the outlier filter, the rank-sum test and the shift estimate
+ *  on small samples with known results
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <assert.h>
+
+#include "util/pgmpi_stats.h"
+
+#define N 20
+
+int main(int argc, char *argv[]) {
+  double x[N], y[N];
+  double v[] = { 5.0, 1.0, 3.0, 2.0, 4.0, 100.0 };
+  double p, shift, low, high;
+  int i, n;
+
+  assert( pgmpi_stats_median(v, 5) == 3.0 );
+
+  // 100 is far outside of the fences
+  n = pgmpi_stats_filter_outliers(v, 6, PGMPI_STATS_OUTLIER_IQR_FACTOR);
+  assert( n == 5 );
+  assert( v[0] == 1.0 && v[4] == 5.0 );
+
+  // too few values to tell outliers
+  v[0] = 1.0; v[1] = 1000.0; v[2] = 2.0;
+  n = pgmpi_stats_filter_outliers(v, 3, PGMPI_STATS_OUTLIER_IQR_FACTOR);
+  assert( n == 3 );
+
+  // x is faster than y by 1.0
+  for(i=0; i<N; i++) {
+    x[i] = 10.0 + 0.1 * (i % 7);
+    y[i] = 11.0 + 0.1 * ((i * 3) % 7);
+  }
+  p = pgmpi_stats_ranksum_less(x, N, y, N);
+  assert( p < 1e-6 );
+  p = pgmpi_stats_ranksum_less(y, N, x, N);
+  assert( p > 0.99 );
+
+  assert( pgmpi_stats_shift(x, N, y, N, 0.05, &shift, &low, &high) == 0 );
+  assert( fabs(shift - 1.0) < 1e-9 );
+  assert( low <= shift && shift <= high );
+  assert( low > 0.5 && high < 1.5 );
+
+  // identical samples, no difference
+  p = pgmpi_stats_ranksum_less(x, N, x, N);
+  assert( p > 0.4 );
+  assert( pgmpi_stats_shift(x, N, x, N, 0.05, &shift, &low, &high) == 0 );
+  assert( shift == 0.0 && low < 0.0 && high > 0.0 );
+
+  // all values tie
+  for(i=0; i<N; i++) {
+    y[i] = 1.0;
+  }
+  assert( pgmpi_stats_ranksum_less(y, N, y, N) == 1.0 );
+
+  assert( pgmpi_stats_shift(x, 0, y, N, 0.05, &shift, &low, &high) == -1 );
+
+  printf("done\n");
+
+  return 0;
+}